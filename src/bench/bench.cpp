@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <bench.h>
+
+#include <common/path.h>
+#include <common/version.h>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <numeric>
+
+namespace eka2l1::bench {
+    std::vector<benchmark_info> &get_registered_benchmarks() {
+        static std::vector<benchmark_info> benchmarks;
+        return benchmarks;
+    }
+
+    static double time_iterations(const std::function<void()> &body, const std::uint64_t iterations) {
+        const auto start = std::chrono::steady_clock::now();
+
+        for (std::uint64_t i = 0; i < iterations; i++) {
+            body();
+        }
+
+        const auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count();
+    }
+
+    bool run_benchmark(const benchmark_info &info, const run_options &options, benchmark_result &result) {
+        context ctx;
+        info.func_(ctx);
+
+        const std::function<void()> &body = ctx.body();
+
+        if (!body) {
+            return false;
+        }
+
+        // Warm up caches and lazily initialized state, then grow the iteration count until one
+        // sample is long enough to not be dominated by timer resolution.
+        body();
+
+        const double min_sample_ns = options.min_sample_time_ms_ * 1000000.0;
+        std::uint64_t iterations = 1;
+
+        while (true) {
+            const double elapsed = time_iterations(body, iterations);
+
+            if (elapsed >= min_sample_ns) {
+                break;
+            }
+
+            if (elapsed <= 0.0) {
+                iterations *= 10;
+                continue;
+            }
+
+            // Aim a bit over the target so this usually settles in one more round
+            const double scale = std::min(min_sample_ns * 1.2 / elapsed, 10.0);
+            iterations = std::max<std::uint64_t>(iterations + 1, static_cast<std::uint64_t>(static_cast<double>(iterations) * scale));
+        }
+
+        std::vector<double> per_iteration;
+
+        for (std::uint32_t i = 0; i < std::max<std::uint32_t>(options.samples_, 1); i++) {
+            per_iteration.push_back(time_iterations(body, iterations) / static_cast<double>(iterations));
+        }
+
+        std::sort(per_iteration.begin(), per_iteration.end());
+
+        result.group_ = info.group_;
+        result.name_ = info.name_;
+        result.iterations_ = iterations;
+        result.samples_ = static_cast<std::uint32_t>(per_iteration.size());
+        result.ns_per_iteration_min_ = per_iteration.front();
+        result.ns_per_iteration_median_ = per_iteration[per_iteration.size() / 2];
+        result.ns_per_iteration_mean_ = std::accumulate(per_iteration.begin(), per_iteration.end(), 0.0) / static_cast<double>(per_iteration.size());
+
+        // Throughput from the median, so one noisy sample doesn't skew it
+        const double seconds_per_iteration = result.ns_per_iteration_median_ / 1000000000.0;
+
+        result.bytes_per_second_ = (seconds_per_iteration > 0.0) ? static_cast<double>(ctx.bytes_per_iteration()) / seconds_per_iteration : 0.0;
+        result.items_per_second_ = (seconds_per_iteration > 0.0) ? static_cast<double>(ctx.items_per_iteration()) / seconds_per_iteration : 0.0;
+
+        return true;
+    }
+
+    bool write_results_json(const std::string &path, const std::vector<benchmark_result> &results) {
+        const std::string directory = eka2l1::file_directory(path);
+
+        if (!directory.empty()) {
+            eka2l1::create_directories(directory);
+        }
+
+        std::ofstream stream(path);
+
+        if (stream.fail()) {
+            return false;
+        }
+
+#ifdef GIT_COMMIT_HASH
+        const char *commit = GIT_COMMIT_HASH;
+#else
+        const char *commit = "";
+#endif
+
+        const auto now = std::chrono::system_clock::now().time_since_epoch();
+
+        stream << "{\n";
+        stream << fmt::format("    \"commit\": \"{}\",\n", commit);
+        stream << fmt::format("    \"timestamp\": {},\n", std::chrono::duration_cast<std::chrono::seconds>(now).count());
+        stream << "    \"benchmarks\": [";
+
+        for (std::size_t i = 0; i < results.size(); i++) {
+            const benchmark_result &res = results[i];
+
+            stream << ((i == 0) ? "\n" : ",\n");
+            stream << fmt::format("        {{\"group\": \"{}\", \"name\": \"{}\", \"iterations\": {}, \"samples\": {}, "
+                                  "\"ns_per_iteration_min\": {:.3f}, \"ns_per_iteration_median\": {:.3f}, \"ns_per_iteration_mean\": {:.3f}, "
+                                  "\"bytes_per_second\": {:.1f}, \"items_per_second\": {:.1f}}}",
+                res.group_, res.name_, res.iterations_, res.samples_, res.ns_per_iteration_min_, res.ns_per_iteration_median_,
+                res.ns_per_iteration_mean_, res.bytes_per_second_, res.items_per_second_);
+        }
+
+        stream << "\n    ]\n}\n";
+        return !stream.fail();
+    }
+}
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace eka2l1::bench {
+    /**
+     * \brief Passed to a benchmark, used to time its measured body.
+     */
+    class context {
+        std::function<void()> body_;
+
+        std::uint64_t bytes_per_iteration_ = 0;
+        std::uint64_t items_per_iteration_ = 0;
+
+    public:
+        /**
+         * \brief Set the code to measure.
+         *
+         * Everything a benchmark does outside of this body is setup, and is not timed.
+         */
+        void measure(std::function<void()> body) {
+            body_ = std::move(body);
+        }
+
+        /**
+         * \brief Set the number of bytes one run of the body processes, to report throughput.
+         */
+        void set_bytes_per_iteration(const std::uint64_t bytes) {
+            bytes_per_iteration_ = bytes;
+        }
+
+        /**
+         * \brief Set the number of items one run of the body processes, to report item rate.
+         */
+        void set_items_per_iteration(const std::uint64_t items) {
+            items_per_iteration_ = items;
+        }
+
+        const std::function<void()> &body() const {
+            return body_;
+        }
+
+        std::uint64_t bytes_per_iteration() const {
+            return bytes_per_iteration_;
+        }
+
+        std::uint64_t items_per_iteration() const {
+            return items_per_iteration_;
+        }
+    };
+
+    using benchmark_function = std::function<void(context &)>;
+
+    struct benchmark_info {
+        std::string group_;
+        std::string name_;
+        benchmark_function func_;
+    };
+
+    struct benchmark_result {
+        std::string group_;
+        std::string name_;
+
+        std::uint64_t iterations_;          ///< Iterations in each sample.
+        std::uint32_t samples_;
+
+        double ns_per_iteration_min_;
+        double ns_per_iteration_median_;
+        double ns_per_iteration_mean_;
+
+        double bytes_per_second_;           ///< Zero if the benchmark doesn't report bytes.
+        double items_per_second_;           ///< Zero if the benchmark doesn't report items.
+    };
+
+    struct run_options {
+        std::string filter_;                ///< Only run benchmarks whose full name contains this.
+        double min_sample_time_ms_ = 50.0;  ///< Iteration count is calibrated so a sample takes at least this long.
+        std::uint32_t samples_ = 7;
+    };
+
+    std::vector<benchmark_info> &get_registered_benchmarks();
+
+    /**
+     * \brief Run one benchmark.
+     *
+     * \returns False if the benchmark did not set a body to measure.
+     */
+    bool run_benchmark(const benchmark_info &info, const run_options &options, benchmark_result &result);
+
+    /**
+     * \brief Write results as JSON, to track them across builds.
+     */
+    bool write_results_json(const std::string &path, const std::vector<benchmark_result> &results);
+
+    struct registrar {
+        explicit registrar(const char *group, const char *name, benchmark_function func) {
+            get_registered_benchmarks().push_back({ group, name, std::move(func) });
+        }
+    };
+
+    /**
+     * \brief Prevent the compiler from optimizing away a value computed in a measured body.
+     */
+    template <typename T>
+    inline void do_not_optimize(const T &value) {
+#if defined(_MSC_VER)
+        static volatile const void *sink;
+        sink = &value;
+#else
+        asm volatile(""
+                     :
+                     : "r,m"(value)
+                     : "memory");
+#endif
+    }
+}
+
+#define EKA2L1_BENCHMARK_CONCAT_IMPL(a, b) a##b
+#define EKA2L1_BENCHMARK_CONCAT(a, b) EKA2L1_BENCHMARK_CONCAT_IMPL(a, b)
+
+#define EKA2L1_BENCHMARK(group, name)                                                                               \
+    static void EKA2L1_BENCHMARK_CONCAT(bench_func_, name)(eka2l1::bench::context & ctx);                           \
+    static eka2l1::bench::registrar EKA2L1_BENCHMARK_CONCAT(bench_registrar_, name)(group, #name,                   \
+        EKA2L1_BENCHMARK_CONCAT(bench_func_, name));                                                                \
+    static void EKA2L1_BENCHMARK_CONCAT(bench_func_, name)(eka2l1::bench::context & ctx)
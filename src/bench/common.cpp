@@ -0,0 +1,469 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <bench.h>
+
+#include <common/allocator.h>
+#include <common/buffer.h>
+#include <common/bytepair.h>
+#include <common/chunkyseri.h>
+#include <common/cvt.h>
+#include <common/flate.h>
+#include <common/path.h>
+#include <common/runlen.h>
+
+#include <array>
+#include <memory>
+#include <random>
+
+using namespace eka2l1;
+
+/**
+ * \brief Make data that looks like ARM code: words picked from a small dictionary, with some noise.
+ *
+ * Only bytes below 0xA0 are used, so the bytepair encoder has free bytes left for its tokens.
+ */
+static std::vector<std::uint8_t> make_code_like_data(const std::size_t size) {
+    std::mt19937 rng(0xE4A2);
+    std::uniform_int_distribution<int> byte_dist(0, 0x9F);
+    std::uniform_int_distribution<int> pick_dist(0, 99);
+
+    std::array<std::array<std::uint8_t, 4>, 64> dictionary;
+
+    for (auto &word : dictionary) {
+        for (auto &b : word) {
+            b = static_cast<std::uint8_t>(byte_dist(rng));
+        }
+    }
+
+    std::vector<std::uint8_t> data;
+    data.reserve(size);
+
+    while (data.size() < size) {
+        if (pick_dist(rng) < 80) {
+            const auto &word = dictionary[pick_dist(rng) % dictionary.size()];
+            data.insert(data.end(), word.begin(), word.end());
+        } else {
+            for (int i = 0; i < 4; i++) {
+                data.push_back(static_cast<std::uint8_t>(byte_dist(rng)));
+            }
+        }
+    }
+
+    data.resize(size);
+    return data;
+}
+
+/**
+ * \brief Make a 24bpp image with horizontal runs, like UI skins and icons.
+ */
+static std::vector<std::uint8_t> make_image_data(const int width, const int height) {
+    std::mt19937 rng(0x5EED);
+    std::uniform_int_distribution<int> run_dist(1, 40);
+    std::uniform_int_distribution<int> color_dist(0, 0xFFFFFF);
+
+    std::vector<std::uint8_t> data;
+    data.reserve(width * height * 3);
+
+    const std::size_t total_pixels = static_cast<std::size_t>(width) * height;
+    std::size_t pixels = 0;
+
+    while (pixels < total_pixels) {
+        const int color = color_dist(rng);
+        const std::size_t run = std::min<std::size_t>(run_dist(rng), total_pixels - pixels);
+
+        for (std::size_t i = 0; i < run; i++) {
+            data.push_back(static_cast<std::uint8_t>(color & 0xFF));
+            data.push_back(static_cast<std::uint8_t>((color >> 8) & 0xFF));
+            data.push_back(static_cast<std::uint8_t>((color >> 16) & 0xFF));
+        }
+
+        pixels += run;
+    }
+
+    return data;
+}
+
+/**
+ * \brief Compress one page in the format bytepair_decompress reads.
+ *
+ * Greedy encoder: keep replacing the most frequent pair with a byte the data doesn't use. Good enough
+ * to produce realistic input for measuring the decoder.
+ */
+static std::vector<std::uint8_t> bytepair_compress(const std::vector<std::uint8_t> &source) {
+    std::vector<std::uint8_t> data = source;
+    std::array<bool, 256> used{};
+
+    for (const std::uint8_t b : data) {
+        used[b] = true;
+    }
+
+    auto take_unused = [&]() -> int {
+        for (int b = 0; b < 256; b++) {
+            if (!used[b]) {
+                used[b] = true;
+                return b;
+            }
+        }
+
+        return -1;
+    };
+
+    const int marker = take_unused();
+    std::vector<std::array<std::uint8_t, 3>> pairs;
+
+    while ((marker >= 0) && (pairs.size() < 255)) {
+        std::vector<std::uint32_t> counts(0x10000, 0);
+
+        for (std::size_t i = 0; i + 1 < data.size(); i++) {
+            counts[(data[i] << 8) | data[i + 1]]++;
+        }
+
+        const auto best = std::max_element(counts.begin(), counts.end());
+
+        if (*best < 4) {
+            break;
+        }
+
+        const int token = take_unused();
+
+        if (token < 0) {
+            break;
+        }
+
+        const std::uint8_t first = static_cast<std::uint8_t>((best - counts.begin()) >> 8);
+        const std::uint8_t second = static_cast<std::uint8_t>((best - counts.begin()) & 0xFF);
+
+        std::vector<std::uint8_t> replaced;
+        replaced.reserve(data.size());
+
+        for (std::size_t i = 0; i < data.size();) {
+            if ((i + 1 < data.size()) && (data[i] == first) && (data[i + 1] == second)) {
+                replaced.push_back(static_cast<std::uint8_t>(token));
+                i += 2;
+            } else {
+                replaced.push_back(data[i++]);
+            }
+        }
+
+        data = std::move(replaced);
+        pairs.push_back({ static_cast<std::uint8_t>(token), first, second });
+    }
+
+    std::vector<std::uint8_t> result;
+    result.push_back(static_cast<std::uint8_t>(pairs.size()));
+
+    if (!pairs.empty()) {
+        result.push_back(static_cast<std::uint8_t>(marker));
+
+        if (pairs.size() < 32) {
+            for (const auto &pair : pairs) {
+                result.insert(result.end(), pair.begin(), pair.end());
+            }
+        } else {
+            std::sort(pairs.begin(), pairs.end());
+            std::array<std::uint8_t, 32> mask{};
+
+            for (const auto &pair : pairs) {
+                mask[pair[0] >> 3] |= static_cast<std::uint8_t>(1 << (pair[0] & 7));
+            }
+
+            result.insert(result.end(), mask.begin(), mask.end());
+
+            for (const auto &pair : pairs) {
+                result.push_back(pair[1]);
+                result.push_back(pair[2]);
+            }
+        }
+    }
+
+    result.insert(result.end(), data.begin(), data.end());
+    return result;
+}
+
+EKA2L1_BENCHMARK("compression", bytepair_decompress_page) {
+    const std::vector<std::uint8_t> original = make_code_like_data(common::BYTEPAIR_PAGE_SIZE);
+    auto compressed = std::make_shared<std::vector<std::uint8_t>>(bytepair_compress(original));
+    auto dest = std::make_shared<std::vector<std::uint8_t>>(original.size());
+
+    ctx.set_bytes_per_iteration(original.size());
+    ctx.measure([compressed, dest]() {
+        const int written = common::bytepair_decompress(dest->data(), static_cast<unsigned int>(dest->size()),
+            compressed->data(), static_cast<unsigned int>(compressed->size()));
+
+        bench::do_not_optimize(written);
+    });
+}
+
+EKA2L1_BENCHMARK("compression", inflate_256kb) {
+    const std::vector<std::uint8_t> original = make_code_like_data(256 * 1024);
+
+    mz_ulong compressed_size = mz_compressBound(static_cast<mz_ulong>(original.size()));
+    auto compressed = std::make_shared<std::vector<std::uint8_t>>(compressed_size);
+
+    if (mz_compress(compressed->data(), &compressed_size, original.data(), static_cast<mz_ulong>(original.size())) != MZ_OK) {
+        return;
+    }
+
+    compressed->resize(compressed_size);
+
+    // inflate_data always offers the maximum chunk size as output space
+    auto dest = std::make_shared<std::vector<std::uint8_t>>(CHUNK_MAX_INFLATED_SIZE);
+
+    ctx.set_bytes_per_iteration(original.size());
+    ctx.measure([compressed, dest]() {
+        mz_stream stream{};
+
+        if (inflateInit(&stream) != MZ_OK) {
+            return;
+        }
+
+        std::uint32_t inflated_size = 0;
+        flate::inflate_data(&stream, compressed->data(), dest->data(), static_cast<std::uint32_t>(compressed->size()), &inflated_size);
+        inflateEnd(&stream);
+
+        bench::do_not_optimize(inflated_size);
+    });
+}
+
+EKA2L1_BENCHMARK("compression", rle_compress_24bpp_stream) {
+    auto image = std::make_shared<std::vector<std::uint8_t>>(make_image_data(240, 320));
+    auto dest = std::make_shared<std::vector<std::uint8_t>>(image->size() * 2);
+
+    ctx.set_bytes_per_iteration(image->size());
+    ctx.measure([image, dest]() {
+        common::ro_buf_stream source_stream(image->data(), image->size());
+        common::wo_buf_stream dest_stream(dest->data(), dest->size());
+
+        std::size_t compressed_size = 0;
+        compress_rle<24>(&source_stream, &dest_stream, compressed_size);
+
+        bench::do_not_optimize(compressed_size);
+    });
+}
+
+EKA2L1_BENCHMARK("compression", rle_compress_24bpp_buffer) {
+    auto image = std::make_shared<std::vector<std::uint8_t>>(make_image_data(240, 320));
+    auto dest = std::make_shared<std::vector<std::uint8_t>>();
+
+    ctx.set_bytes_per_iteration(image->size());
+    ctx.measure([image, dest]() {
+        const bool result = compress_rle<24>(image->data(), image->size(), *dest, image->size());
+        bench::do_not_optimize(result);
+    });
+}
+
+EKA2L1_BENCHMARK("compression", rle_decompress_24bpp) {
+    const std::vector<std::uint8_t> image = make_image_data(240, 320);
+    auto compressed = std::make_shared<std::vector<std::uint8_t>>();
+
+    if (!compress_rle<24>(image.data(), image.size(), *compressed, image.size())) {
+        return;
+    }
+
+    auto dest = std::make_shared<std::vector<std::uint8_t>>(image.size());
+
+    ctx.set_bytes_per_iteration(image.size());
+    ctx.measure([compressed, dest]() {
+        common::ro_buf_stream source_stream(compressed->data(), compressed->size());
+        common::wo_buf_stream dest_stream(dest->data(), dest->size());
+
+        decompress_rle<24>(&source_stream, &dest_stream);
+        bench::do_not_optimize(dest->data());
+    });
+}
+
+static std::string make_mixed_text() {
+    // Mostly ASCII like most resource strings, with some Latin, Vietnamese and Chinese text
+    static const char *PARTS[] = {
+        "Options", "Back", "Select", "Phone memory", "Memory card", "Tiếng Việt", "Français", "设置", "Ứng dụng", "C:\\sys\\bin\\"
+    };
+
+    std::string text;
+
+    for (int i = 0; text.size() < 4096; i++) {
+        text += PARTS[i % (sizeof(PARTS) / sizeof(PARTS[0]))];
+        text += ' ';
+    }
+
+    return text;
+}
+
+EKA2L1_BENCHMARK("string", utf8_to_ucs2) {
+    auto text = std::make_shared<std::string>(make_mixed_text());
+
+    ctx.set_bytes_per_iteration(text->size());
+    ctx.measure([text]() {
+        const std::u16string converted = common::utf8_to_ucs2(*text);
+        bench::do_not_optimize(converted.data());
+    });
+}
+
+EKA2L1_BENCHMARK("string", ucs2_to_utf8) {
+    const std::string text = make_mixed_text();
+    auto text16 = std::make_shared<std::u16string>(common::utf8_to_ucs2(text));
+
+    ctx.set_bytes_per_iteration(text16->size() * sizeof(char16_t));
+    ctx.measure([text16]() {
+        const std::string converted = common::ucs2_to_utf8(*text16);
+        bench::do_not_optimize(converted.data());
+    });
+}
+
+EKA2L1_BENCHMARK("path", resolve_symbian_path) {
+    static const std::u16string PATHS[] = {
+        u"..\\sys\\bin\\euser.dll",
+        u"resource\\apps\\calendar.rsc",
+        u"z:\\private\\10003a3f\\apps\\..\\import\\apps\\Calendar_reg.rsc",
+        u".\\data\\skins\\default\\..\\..\\icons.mif"
+    };
+
+    static const std::u16string CURRENT_DIR = u"c:\\private\\10003a3f\\import\\";
+
+    ctx.set_items_per_iteration(sizeof(PATHS) / sizeof(PATHS[0]));
+    ctx.measure([]() {
+        for (const std::u16string &path : PATHS) {
+            const std::u16string resolved = eka2l1::absolute_path(path, CURRENT_DIR, true);
+            bench::do_not_optimize(resolved.data());
+        }
+    });
+}
+
+EKA2L1_BENCHMARK("path", add_and_split_path) {
+    ctx.set_items_per_iteration(1);
+    ctx.measure([]() {
+        const std::u16string joined = eka2l1::add_path(u"e:\\private\\20004c45\\", u"data\\levels\\level01.dat", true);
+        const std::u16string directory = eka2l1::file_directory(joined, true);
+        const std::u16string name = eka2l1::filename(joined, true);
+
+        bench::do_not_optimize(directory.data());
+        bench::do_not_optimize(name.data());
+    });
+}
+
+EKA2L1_BENCHMARK("allocator", block_allocator_alloc_free) {
+    static constexpr std::size_t SPACE_SIZE = 16 * 1024 * 1024;
+    static constexpr std::size_t ALLOCATION_COUNT = 256;
+
+    auto space = std::make_shared<std::vector<std::uint8_t>>(SPACE_SIZE);
+    auto allocator = std::make_shared<common::block_allocator>(space->data(), SPACE_SIZE);
+    auto pointers = std::make_shared<std::vector<void *>>(ALLOCATION_COUNT);
+
+    ctx.set_items_per_iteration(ALLOCATION_COUNT);
+    ctx.measure([allocator, pointers]() {
+        for (std::size_t i = 0; i < ALLOCATION_COUNT; i++) {
+            // Mix of small objects and bitmap sized blocks
+            (*pointers)[i] = allocator->allocate(((i % 7) + 1) * ((i % 3 == 0) ? 4096 : 64));
+        }
+
+        // Free every other block first to leave holes, like a real heap
+        for (std::size_t i = 0; i < ALLOCATION_COUNT; i += 2) {
+            allocator->free((*pointers)[i]);
+        }
+
+        for (std::size_t i = 1; i < ALLOCATION_COUNT; i += 2) {
+            allocator->free((*pointers)[i]);
+        }
+    });
+}
+
+EKA2L1_BENCHMARK("allocator", bitmap_allocator_alloc_free) {
+    static constexpr std::size_t TOTAL_BITS = 65536;
+    static constexpr std::size_t ALLOCATION_COUNT = 256;
+
+    auto allocator = std::make_shared<common::bitmap_allocator>(TOTAL_BITS);
+    auto allocations = std::make_shared<std::vector<std::pair<int, int>>>(ALLOCATION_COUNT);
+
+    ctx.set_items_per_iteration(ALLOCATION_COUNT);
+    ctx.measure([allocator, allocations]() {
+        for (std::size_t i = 0; i < ALLOCATION_COUNT; i++) {
+            int size = static_cast<int>((i % 5) + 1) * 16;
+            const int offset = allocator->allocate_from(0, size);
+
+            (*allocations)[i] = { offset, size };
+        }
+
+        for (const auto &[offset, size] : *allocations) {
+            if (offset >= 0) {
+                allocator->free(static_cast<std::uint32_t>(offset), size);
+            }
+        }
+    });
+}
+
+struct bench_state_record {
+    std::uint32_t uid_;
+    std::string name_;
+    std::u16string path_;
+    std::vector<std::uint32_t> values_;
+
+    void do_state(common::chunkyseri &seri) {
+        seri.absorb(uid_);
+        seri.absorb(name_);
+        seri.absorb(path_);
+        seri.absorb_container(values_);
+    }
+};
+
+EKA2L1_BENCHMARK("serialization", chunkyseri_round_trip) {
+    static constexpr std::size_t RECORD_COUNT = 64;
+
+    auto records = std::make_shared<std::vector<bench_state_record>>();
+
+    for (std::size_t i = 0; i < RECORD_COUNT; i++) {
+        bench_state_record record;
+        record.uid_ = static_cast<std::uint32_t>(0x10000000 + i);
+        record.name_ = "Record" + std::to_string(i);
+        record.path_ = u"c:\\private\\10003a3f\\import\\apps\\record.rsc";
+        record.values_.resize(64, static_cast<std::uint32_t>(i));
+
+        records->push_back(std::move(record));
+    }
+
+    auto buffer = std::make_shared<std::vector<std::uint8_t>>();
+    auto read_back = std::make_shared<std::vector<bench_state_record>>(RECORD_COUNT);
+
+    auto absorb_all = [](common::chunkyseri &seri, std::vector<bench_state_record> &target) {
+        auto s = seri.section("BenchRecords", 1);
+
+        if (!s) {
+            return;
+        }
+
+        for (bench_state_record &record : target) {
+            record.do_state(seri);
+        }
+    };
+
+    ctx.set_items_per_iteration(RECORD_COUNT);
+    ctx.measure([records, buffer, read_back, absorb_all]() {
+        common::chunkyseri measure_seri(nullptr, 0, common::SERI_MODE_MEASURE);
+        absorb_all(measure_seri, *records);
+
+        buffer->resize(measure_seri.size());
+
+        common::chunkyseri write_seri(buffer->data(), buffer->size(), common::SERI_MODE_WRITE);
+        absorb_all(write_seri, *records);
+
+        common::chunkyseri read_seri(buffer->data(), buffer->size(), common::SERI_MODE_READ);
+        absorb_all(read_seri, *read_back);
+
+        bench::do_not_optimize(read_back->back().uid_);
+    });
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <bench.h>
+
+#include <config/config.h>
+#include <kernel/kernel.h>
+#include <kernel/timing.h>
+
+#include <atomic>
+#include <memory>
+
+using namespace eka2l1;
+
+static constexpr std::uint32_t BENCH_CPU_HZ = 484000000;
+static constexpr std::size_t BENCH_OBJECT_COUNT = 256;
+
+/**
+ * \brief A kernel with no system, CPU or ROM attached. Enough for object bookkeeping.
+ */
+struct bench_kernel {
+    config::state conf_;
+
+    // Kernel objects still use the timer while being destroyed, so the kernel has to go first
+    std::unique_ptr<ntimer> timing_;
+    std::unique_ptr<kernel_system> kern_;
+
+    std::vector<kernel::handle> handles_;
+    std::vector<kernel::uid> uids_;
+    std::vector<std::string> names_;
+
+    explicit bench_kernel(const std::size_t object_count) {
+        timing_ = std::make_unique<ntimer>(BENCH_CPU_HZ);
+        kern_ = std::make_unique<kernel_system>(nullptr, timing_.get(), nullptr, &conf_, nullptr, nullptr, nullptr);
+
+        for (std::size_t i = 0; i < object_count; i++) {
+            names_.push_back("BenchMutex" + std::to_string(i));
+
+            kernel::mutex *mut = kern_->create<kernel::mutex>(timing_.get(), names_.back(), false,
+                kernel::access_type::global_access);
+
+            handles_.push_back(kern_->open_handle_with_thread(nullptr, mut, kernel::owner_type::kernel));
+            uids_.push_back(mut->unique_id());
+        }
+    }
+
+    ~bench_kernel() {
+        kern_.reset();
+        timing_.reset();
+    }
+};
+
+EKA2L1_BENCHMARK("kernel", object_lookup_by_handle) {
+    auto state = std::make_shared<bench_kernel>(BENCH_OBJECT_COUNT);
+
+    ctx.set_items_per_iteration(BENCH_OBJECT_COUNT);
+    ctx.measure([state]() {
+        for (const kernel::handle h : state->handles_) {
+            bench::do_not_optimize(state->kern_->get<kernel::mutex>(h));
+        }
+    });
+}
+
+EKA2L1_BENCHMARK("kernel", object_lookup_by_id) {
+    auto state = std::make_shared<bench_kernel>(BENCH_OBJECT_COUNT);
+
+    ctx.set_items_per_iteration(BENCH_OBJECT_COUNT);
+    ctx.measure([state]() {
+        for (const kernel::uid id : state->uids_) {
+            bench::do_not_optimize(state->kern_->get_by_id<kernel::mutex>(id));
+        }
+    });
+}
+
+EKA2L1_BENCHMARK("kernel", object_lookup_by_name) {
+    auto state = std::make_shared<bench_kernel>(BENCH_OBJECT_COUNT);
+
+    ctx.set_items_per_iteration(BENCH_OBJECT_COUNT);
+    ctx.measure([state]() {
+        for (const std::string &name : state->names_) {
+            bench::do_not_optimize(state->kern_->get_by_name<kernel::mutex>(name));
+        }
+    });
+}
+
+EKA2L1_BENCHMARK("timing", schedule_unschedule_pending) {
+    static constexpr std::size_t EVENT_COUNT = 64;
+
+    auto timing = std::make_shared<ntimer>(BENCH_CPU_HZ);
+    const int event_type = timing->register_event("BenchPendingEvent", [](std::uint64_t, int) {});
+
+    ctx.set_items_per_iteration(EVENT_COUNT);
+    ctx.measure([timing, event_type]() {
+        // Far enough in the future that the timer thread never fires them
+        for (std::size_t i = 0; i < EVENT_COUNT; i++) {
+            timing->schedule_event(60000000 + static_cast<std::int64_t>(i) * 1000, event_type, i);
+        }
+
+        for (std::size_t i = 0; i < EVENT_COUNT; i++) {
+            timing->unschedule_event(event_type, i);
+        }
+    });
+}
+
+EKA2L1_BENCHMARK("timing", schedule_and_fire) {
+    static constexpr std::size_t EVENT_COUNT = 64;
+
+    auto timing = std::make_shared<ntimer>(BENCH_CPU_HZ);
+    auto fired = std::make_shared<std::atomic<std::size_t>>(0);
+
+    const int event_type = timing->register_event("BenchFireEvent", [fired](std::uint64_t, int) {
+        (*fired)++;
+    });
+
+    ctx.set_items_per_iteration(EVENT_COUNT);
+    ctx.measure([timing, fired, event_type]() {
+        fired->store(0);
+
+        for (std::size_t i = 0; i < EVENT_COUNT; i++) {
+            timing->schedule_event(0, event_type, i);
+        }
+
+        // Help the timer thread drain the queue, whichever gets to an event first fires it
+        while (fired->load() < EVENT_COUNT) {
+            timing->advance();
+        }
+    });
+}
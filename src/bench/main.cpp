@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <bench.h>
+
+#include <common/arghandler.h>
+#include <common/log.h>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+using namespace eka2l1;
+
+struct bench_options {
+    bench::run_options run_;
+    std::string json_path_;
+    bool list_only_ = false;
+};
+
+static bool value_option(common::arg_parser *parser, std::string *err, const char *option, std::string &value) {
+    const char *token = parser->next_token();
+
+    if (!token) {
+        *err = fmt::format("No value given to {}", option);
+        return false;
+    }
+
+    value = token;
+    return true;
+}
+
+static bool filter_option_handler(common::arg_parser *parser, void *userdata, std::string *err) {
+    return value_option(parser, err, "--filter", reinterpret_cast<bench_options *>(userdata)->run_.filter_);
+}
+
+static bool json_option_handler(common::arg_parser *parser, void *userdata, std::string *err) {
+    return value_option(parser, err, "--json", reinterpret_cast<bench_options *>(userdata)->json_path_);
+}
+
+static bool min_time_option_handler(common::arg_parser *parser, void *userdata, std::string *err) {
+    std::string value;
+
+    if (!value_option(parser, err, "--min-time", value)) {
+        return false;
+    }
+
+    reinterpret_cast<bench_options *>(userdata)->run_.min_sample_time_ms_ = std::max(std::atof(value.c_str()), 1.0);
+    return true;
+}
+
+static bool samples_option_handler(common::arg_parser *parser, void *userdata, std::string *err) {
+    std::string value;
+
+    if (!value_option(parser, err, "--samples", value)) {
+        return false;
+    }
+
+    reinterpret_cast<bench_options *>(userdata)->run_.samples_ = static_cast<std::uint32_t>(std::max(std::atoi(value.c_str()), 1));
+    return true;
+}
+
+static bool list_option_handler(common::arg_parser *parser, void *userdata, std::string *err) {
+    reinterpret_cast<bench_options *>(userdata)->list_only_ = true;
+    return true;
+}
+
+static bool help_option_handler(common::arg_parser *parser, void *userdata, std::string *err) {
+    std::cout << parser->get_help_string();
+    return false;
+}
+
+static std::string format_rate(const double rate, const char *unit) {
+    if (rate <= 0.0) {
+        return "";
+    }
+
+    if (rate >= 1000000000.0) {
+        return fmt::format("{:.2f} G{}/s", rate / 1000000000.0, unit);
+    }
+
+    if (rate >= 1000000.0) {
+        return fmt::format("{:.2f} M{}/s", rate / 1000000.0, unit);
+    }
+
+    return fmt::format("{:.2f} K{}/s", rate / 1000.0, unit);
+}
+
+int main(int argc, char **argv) {
+    log::setup_log(nullptr);
+
+    bench_options options;
+    common::arg_parser parser(argc, argv);
+
+    parser.add("--help, --h", "Display helps menu", help_option_handler);
+    parser.add("--list", "List all benchmarks without running them.", list_option_handler);
+    parser.add("--filter", "Only run benchmarks whose group/name contains the given text.", filter_option_handler);
+    parser.add("--json", "Write results as JSON to the given file.", json_option_handler);
+    parser.add("--min-time", "Minimum duration of one sample in milliseconds. Default is 50.", min_time_option_handler);
+    parser.add("--samples", "Number of timed samples for each benchmark. Default is 7.", samples_option_handler);
+
+    if (argc > 1) {
+        std::string err;
+
+        if (!parser.parse(&options, &err)) {
+            if (!err.empty()) {
+                std::cout << err << std::endl;
+                return 1;
+            }
+
+            return 0;
+        }
+    }
+
+    std::vector<bench::benchmark_result> results;
+
+    for (const bench::benchmark_info &info : bench::get_registered_benchmarks()) {
+        const std::string full_name = info.group_ + "/" + info.name_;
+
+        if (!options.run_.filter_.empty() && (full_name.find(options.run_.filter_) == std::string::npos)) {
+            continue;
+        }
+
+        if (options.list_only_) {
+            std::cout << full_name << std::endl;
+            continue;
+        }
+
+        bench::benchmark_result result;
+
+        if (!bench::run_benchmark(info, options.run_, result)) {
+            std::cout << fmt::format("{:<48} skipped, nothing to measure", full_name) << std::endl;
+            continue;
+        }
+
+        std::cout << fmt::format("{:<48} {:>14.1f} ns {:>16} {:>16}", full_name, result.ns_per_iteration_median_,
+                         format_rate(result.bytes_per_second_, "B"), format_rate(result.items_per_second_, "item"))
+                  << std::endl;
+
+        results.push_back(std::move(result));
+    }
+
+    if (!options.json_path_.empty()) {
+        if (!bench::write_results_json(options.json_path_, results)) {
+            std::cout << "Unable to write results to " << options.json_path_ << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
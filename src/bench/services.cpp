@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <bench.h>
+
+#include <services/fbs/bitmap.h>
+#include <services/window/bitmap_cache.h>
+
+#include <common/algorithm.h>
+
+#include <memory>
+#include <random>
+
+using namespace eka2l1;
+
+static constexpr int BENCH_BITMAP_WIDTH = 240;
+static constexpr int BENCH_BITMAP_HEIGHT = 320;
+
+/**
+ * \brief A bitmap header describing pixel data kept outside of any chunk, as the converters only need the header.
+ */
+static std::shared_ptr<epoc::bitwise_bitmap> make_bench_bitmap(const epoc::display_mode mode, const int bpp,
+    const int byte_width) {
+    auto bmp = std::make_shared<epoc::bitwise_bitmap>();
+
+    bmp->header_.size_pixels = eka2l1::vec2(BENCH_BITMAP_WIDTH, BENCH_BITMAP_HEIGHT);
+    bmp->header_.bit_per_pixels = bpp;
+    bmp->byte_width_ = byte_width;
+    bmp->settings_.current_display_mode(mode);
+    bmp->settings_.initial_display_mode(mode);
+
+    return bmp;
+}
+
+static std::shared_ptr<std::vector<std::uint32_t>> make_random_words(const std::size_t byte_count) {
+    std::mt19937 rng(0xB17);
+    auto data = std::make_shared<std::vector<std::uint32_t>>((byte_count + 3) / 4);
+
+    for (std::uint32_t &word : *data) {
+        word = rng();
+    }
+
+    return data;
+}
+
+EKA2L1_BENCHMARK("bitmap", convert_1bpp_to_24bpp) {
+    const int byte_width = ((BENCH_BITMAP_WIDTH + 31) / 32) * 4;
+
+    auto bmp = make_bench_bitmap(epoc::display_mode::gray2, 1, byte_width);
+    auto source = make_random_words(byte_width * BENCH_BITMAP_HEIGHT);
+    auto converted = std::make_shared<std::vector<char>>();
+
+    ctx.set_items_per_iteration(BENCH_BITMAP_WIDTH * BENCH_BITMAP_HEIGHT);
+    ctx.measure([bmp, source, converted]() {
+        bench::do_not_optimize(epoc::converted_one_bpp_to_twenty_four_bpp_bitmap(bmp.get(), source->data(), *converted));
+    });
+}
+
+EKA2L1_BENCHMARK("bitmap", convert_12bpp_to_24bpp) {
+    const int byte_width = static_cast<int>(common::align(BENCH_BITMAP_WIDTH * 2, 4));
+
+    auto bmp = make_bench_bitmap(epoc::display_mode::color4k, 12, byte_width);
+    auto source = make_random_words(byte_width * BENCH_BITMAP_HEIGHT);
+    auto converted = std::make_shared<std::vector<char>>();
+
+    ctx.set_items_per_iteration(BENCH_BITMAP_WIDTH * BENCH_BITMAP_HEIGHT);
+    ctx.measure([bmp, source, converted]() {
+        bench::do_not_optimize(epoc::convert_twelve_bpp_to_twenty_four_bpp_bitmap(bmp.get(), source->data(), *converted));
+    });
+}
+
+EKA2L1_BENCHMARK("bitmap", convert_palette_256_to_24bpp) {
+    const int byte_width = static_cast<int>(common::align(BENCH_BITMAP_WIDTH, 4));
+
+    auto bmp = make_bench_bitmap(epoc::display_mode::color256, 8, byte_width);
+    auto source = make_random_words(byte_width * BENCH_BITMAP_HEIGHT);
+    auto converted = std::make_shared<std::vector<char>>();
+
+    ctx.set_items_per_iteration(BENCH_BITMAP_WIDTH * BENCH_BITMAP_HEIGHT);
+    ctx.measure([bmp, source, converted]() {
+        bench::do_not_optimize(epoc::converted_palette_bitmap_to_twenty_four_bitmap(bmp.get(),
+            reinterpret_cast<const std::uint8_t *>(source->data()), *converted));
+    });
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <common/configure.h>
+
+#include <cstdint>
+#include <string>
+
+namespace eka2l1::common::profile {
+    /**
+     * \brief Start recording profile zones.
+     *
+     * Zones that are entered before this call are not recorded.
+     */
+    void start_capture();
+
+    /**
+     * \brief Stop recording, and write everything recorded so far as a Chrome trace JSON file.
+     *
+     * The file can be loaded in chrome://tracing or Perfetto. Recorded zones are discarded after this call.
+     *
+     * \param trace_path    Path to the JSON file to write. Parent directories are created if needed.
+     * \returns True on success.
+     */
+    bool stop_capture(const std::string &trace_path);
+
+    /**
+     * \brief Check if zones are being recorded.
+     */
+    bool is_capturing();
+
+    /**
+     * \brief Give the calling thread a name in the trace.
+     */
+    void set_thread_name(const char *name);
+
+    /**
+     * \brief Get a name pointer that stays valid until the process exits.
+     *
+     * Use this for zone names that are built at runtime, such as server names.
+     */
+    const char *intern_name(const std::string &name);
+
+    /**
+     * \brief Record the time spent in a scope as a zone of the calling thread.
+     *
+     * Nothing is recorded if no capture is running when the zone is entered.
+     */
+    class scoped_zone {
+        const char *category_;
+        const char *name_;
+        std::uint64_t start_;
+        bool active_;
+
+    public:
+        explicit scoped_zone(const char *category, const char *name);
+        ~scoped_zone();
+    };
+}
+
+#define EKA2L1_PROFILE_CONCAT_IMPL(a, b) a##b
+#define EKA2L1_PROFILE_CONCAT(a, b) EKA2L1_PROFILE_CONCAT_IMPL(a, b)
+
+#if ENABLE_PROFILING == 1
+// Zone with a string literal as name
+#define EKA2L1_PROFILE_SCOPE(category, name) \
+    eka2l1::common::profile::scoped_zone EKA2L1_PROFILE_CONCAT(profile_zone_, __LINE__)(category, name)
+
+// Zone with a std::string name. The name is only evaluated while a capture is running.
+#define EKA2L1_PROFILE_SCOPE_DYNAMIC(category, name)                                                      \
+    eka2l1::common::profile::scoped_zone EKA2L1_PROFILE_CONCAT(profile_zone_, __LINE__)(category,        \
+        eka2l1::common::profile::is_capturing() ? eka2l1::common::profile::intern_name(name) : nullptr)
+#else
+#define EKA2L1_PROFILE_SCOPE(category, name)
+#define EKA2L1_PROFILE_SCOPE_DYNAMIC(category, name)
+#endif
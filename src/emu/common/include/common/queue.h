@@ -1,11 +1,16 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <queue>
+#include <type_traits>
 
 namespace eka2l1 {
     /*! \brief A modified queue from std::priority_queue.
@@ -188,6 +193,24 @@ namespace eka2l1 {
             queue_empty_cond_.notify_one();
         }
 
+        void push(T &&item) {
+            {
+                std::unique_lock<std::mutex> ulock(queue_mut_);
+
+                while (!abort_ && queue_.size() == max_pending_count_) {
+                    queue_cond_.wait(ulock);
+                }
+
+                if (abort_) {
+                    return;
+                }
+
+                queue_.push(std::move(item));
+            }
+
+            queue_empty_cond_.notify_one();
+        }
+
         std::optional<T> pop(const int ms = 0) {
             T item{ T() };
 
@@ -208,7 +231,7 @@ namespace eka2l1 {
                     return std::nullopt;
                 }
 
-                item = queue_.front();
+                item = std::move(queue_.front());
                 queue_.pop();
             }
 
@@ -227,4 +250,213 @@ namespace eka2l1 {
             abort_ = false;
         }
     };
+
+    /**
+     * \brief A fixed-capacity queue that is safe between one producer thread and one consumer thread.
+     *
+     * Push and pop never take a lock. Only the producer may call push, and only the consumer
+     * may call pop and front.
+     *
+     * \tparam CAPACITY    Maximum number of elements. Must be a power of two.
+     */
+    template <typename T, std::size_t CAPACITY>
+    class spsc_ring_queue {
+        static_assert((CAPACITY != 0) && ((CAPACITY & (CAPACITY - 1)) == 0), "Capacity must be a power of two");
+
+        static constexpr std::size_t INDEX_MASK = CAPACITY - 1;
+
+        std::array<T, CAPACITY> items_;
+
+        alignas(64) std::atomic<std::size_t> head_; ///< Next index to pop. Written by the consumer.
+        alignas(64) std::atomic<std::size_t> tail_; ///< Next index to push. Written by the producer.
+
+    public:
+        explicit spsc_ring_queue()
+            : head_(0)
+            , tail_(0) {
+        }
+
+        /**
+         * \brief Push an element to the back of the queue.
+         * \returns False if the queue is full.
+         */
+        bool push(const T &item) {
+            const std::size_t tail = tail_.load(std::memory_order_relaxed);
+
+            if (tail - head_.load(std::memory_order_acquire) == CAPACITY) {
+                return false;
+            }
+
+            items_[tail & INDEX_MASK] = item;
+            tail_.store(tail + 1, std::memory_order_release);
+
+            return true;
+        }
+
+        /**
+         * \brief Get the element at the front of the queue without popping it.
+         * \returns Pointer to the element, or nullptr if the queue is empty.
+         */
+        T *front() {
+            const std::size_t head = head_.load(std::memory_order_relaxed);
+
+            if (head == tail_.load(std::memory_order_acquire)) {
+                return nullptr;
+            }
+
+            return &items_[head & INDEX_MASK];
+        }
+
+        /**
+         * \brief Pop an element from the front of the queue.
+         * \returns The element, or nullopt if the queue is empty.
+         */
+        std::optional<T> pop() {
+            const std::size_t head = head_.load(std::memory_order_relaxed);
+
+            if (head == tail_.load(std::memory_order_acquire)) {
+                return std::nullopt;
+            }
+
+            T item = std::move(items_[head & INDEX_MASK]);
+            head_.store(head + 1, std::memory_order_release);
+
+            return item;
+        }
+
+        bool empty() const {
+            return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+        }
+
+        std::size_t size() const {
+            return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+        }
+
+        constexpr std::size_t capacity() const {
+            return CAPACITY;
+        }
+    };
+
+    /**
+     * \brief A ring of plain items that is safe between one producer thread and one consumer thread.
+     *
+     * Unlike spsc_ring_queue, items are copied in and out in bulk, and the storage is allocated once
+     * on resize. Positions count every item ever written or read, so they can be used to tell how far
+     * the consumer is.
+     */
+    template <typename T>
+    class spsc_ring_buffer {
+        static_assert(std::is_trivially_copyable_v<T>, "Items are copied with memcpy");
+
+        std::unique_ptr<T[]> data_;
+        std::size_t capacity_;
+
+        alignas(64) std::atomic<std::size_t> read_pos_; ///< Written by the consumer.
+        alignas(64) std::atomic<std::size_t> write_pos_; ///< Written by the producer.
+
+    public:
+        explicit spsc_ring_buffer(const std::size_t min_capacity = 0)
+            : capacity_(0)
+            , read_pos_(0)
+            , write_pos_(0) {
+            resize(min_capacity);
+        }
+
+        /**
+         * \brief Reallocate the ring, discarding all items.
+         *
+         * This is not thread-safe. Neither side may use the ring during the call.
+         *
+         * \param min_capacity     Minimum number of items. Rounded up to a power of two.
+         */
+        void resize(const std::size_t min_capacity) {
+            capacity_ = 0;
+
+            if (min_capacity != 0) {
+                capacity_ = 1;
+
+                while (capacity_ < min_capacity) {
+                    capacity_ <<= 1;
+                }
+            }
+
+            data_ = capacity_ ? std::make_unique<T[]>(capacity_) : nullptr;
+
+            read_pos_.store(0);
+            write_pos_.store(0);
+        }
+
+        std::size_t capacity() const {
+            return capacity_;
+        }
+
+        std::size_t size() const {
+            return write_pos_.load(std::memory_order_acquire) - read_pos_.load(std::memory_order_acquire);
+        }
+
+        std::size_t free_space() const {
+            return capacity_ - size();
+        }
+
+        std::size_t read_position() const {
+            return read_pos_.load(std::memory_order_acquire);
+        }
+
+        std::size_t write_position() const {
+            return write_pos_.load(std::memory_order_acquire);
+        }
+
+        /**
+         * \brief Write all given items to the ring. Producer only.
+         * \returns False if there is not enough space, nothing is written in that case.
+         */
+        bool write(const T *items, const std::size_t count) {
+            const std::size_t write_pos = write_pos_.load(std::memory_order_relaxed);
+
+            if (capacity_ - (write_pos - read_pos_.load(std::memory_order_acquire)) < count) {
+                return false;
+            }
+
+            const std::size_t start = write_pos & (capacity_ - 1);
+            const std::size_t first_part = std::min(count, capacity_ - start);
+
+            std::memcpy(data_.get() + start, items, first_part * sizeof(T));
+            std::memcpy(data_.get(), items + first_part, (count - first_part) * sizeof(T));
+
+            write_pos_.store(write_pos + count, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * \brief Read items from the ring. Consumer only.
+         * \returns Number of items read, which may be less than requested.
+         */
+        std::size_t read(T *dest, const std::size_t max_count) {
+            const std::size_t read_pos = read_pos_.load(std::memory_order_relaxed);
+            const std::size_t count = std::min(max_count, write_pos_.load(std::memory_order_acquire) - read_pos);
+
+            const std::size_t start = read_pos & (capacity_ - 1);
+            const std::size_t first_part = std::min(count, capacity_ - start);
+
+            if (count != 0) {
+                std::memcpy(dest, data_.get() + start, first_part * sizeof(T));
+                std::memcpy(dest + first_part, data_.get(), (count - first_part) * sizeof(T));
+            }
+
+            read_pos_.store(read_pos + count, std::memory_order_release);
+            return count;
+        }
+
+        /**
+         * \brief Drop items from the ring without reading them. Consumer only.
+         * \returns Number of items dropped.
+         */
+        std::size_t skip(const std::size_t max_count) {
+            const std::size_t read_pos = read_pos_.load(std::memory_order_relaxed);
+            const std::size_t count = std::min(max_count, write_pos_.load(std::memory_order_acquire) - read_pos);
+
+            read_pos_.store(read_pos + count, std::memory_order_release);
+            return count;
+        }
+    };
 }
@@ -40,6 +40,24 @@ namespace eka2l1 {
     template <size_t BIT>
     bool compress_rle(common::ro_stream *source, common::wo_stream *dest, std::size_t &dest_size);
 
+    /**
+     * \brief Compress a memory buffer to RLEd in a single pass.
+     *
+     * Produce the same encoding as the stream version, but without a separate size estimation pass.
+     * The encoder gives up as soon as the output grows past the given limit, so data that does not
+     * compress well costs as little as possible.
+     *
+     * \param source        Pointer to the pixel data. Trailing bytes that don't form a whole pixel are ignored.
+     * \param source_size   Size of the pixel data in bytes.
+     * \param dest          Vector that receives the compressed data. Its previous content is discarded.
+     * \param max_dest_size Largest output size accepted.
+     *
+     * \returns True if the data was compressed within the limit.
+     */
+    template <size_t BIT>
+    bool compress_rle(const std::uint8_t *source, const std::size_t source_size, std::vector<std::uint8_t> &dest,
+        const std::size_t max_dest_size);
+
     /**
      * \brief Decompress RLE compressed data.
      * 
@@ -19,7 +19,14 @@
 
 #pragma once
 
+#include <condition_variable>
 #include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
 
 namespace eka2l1::common {
     /**
@@ -28,4 +35,45 @@ namespace eka2l1::common {
      * \param thread_name       New name of the thread.
      */
     void set_thread_name(const char *thread_name);
+
+    /**
+     * \brief A fixed set of worker threads that execute queued tasks.
+     */
+    class thread_pool {
+        std::vector<std::thread> workers_;
+        std::queue<std::function<void()>> tasks_;
+
+        std::mutex lock_;
+        std::condition_variable task_cond_;
+        std::condition_variable done_cond_;
+
+        std::size_t busy_count_;
+        bool should_stop_;
+
+        void worker_loop();
+
+    public:
+        /**
+         * \brief Create the pool and start its workers.
+         *
+         * \param worker_count      Number of worker threads. Use 0 to use one worker per host core.
+         * \param name              Name given to the worker threads.
+         */
+        explicit thread_pool(const std::size_t worker_count = 0, const std::string &name = "Worker thread");
+        ~thread_pool();
+
+        /**
+         * \brief Queue a task to be executed on one of the workers.
+         */
+        void enqueue(std::function<void()> task);
+
+        /**
+         * \brief Block until every queued task has finished executing.
+         */
+        void wait_all();
+
+        std::size_t worker_count() const {
+            return workers_.size();
+        }
+    };
 }
\ No newline at end of file
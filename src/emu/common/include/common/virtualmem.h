@@ -98,9 +98,12 @@ namespace eka2l1::common {
     /**
      * \brief Unmap a file mapped to memory
      *
+     * \param ptr  Pointer returned by map_file.
+     * \param size Size of the mapping. Required to release the mapping on POSIX platforms, where 0 leaves it mapped.
+     *
      * \returns True on success.
     */
-    bool unmap_file(void *ptr);
+    bool unmap_file(void *ptr, const std::size_t size = 0);
 
     /**
      * \brief Returns true if the platform doesn't allow write and executable memory at the same time.
@@ -20,16 +20,48 @@
 
 #pragma once
 
-#include <common/algorithm.h>
-#include <regex>
+#include <string>
+#include <string_view>
 
 namespace eka2l1::common {
     /**
-     * \brief Convert a wildcard string to regex 
+     * \brief Match strings against a Symbian wildcard pattern.
+     *
+     * '*' matches any sequence of characters (including none), '?' matches exactly one character.
+     * The pattern is prepared once on construction, matching does not allocate.
      */
     template <typename T>
-    std::basic_string<T> wildcard_to_regex_string(std::basic_string<T> regexstr);
+    class basic_wildcard_matcher {
+        std::basic_string<T> pattern_;
+        std::size_t first_literal_;
+        bool is_fold_;
 
+    public:
+        explicit basic_wildcard_matcher(const std::basic_string_view<T> pattern, const bool is_fold = true);
+
+        /**
+         * \brief Match the whole string against the pattern.
+         *
+         * \returns npos if the string does not match. Else, the position in the string where the
+         *          first non-star part of the pattern was matched.
+         */
+        std::size_t match_pos(const std::basic_string_view<T> str) const;
+
+        bool match(const std::basic_string_view<T> str) const {
+            return match_pos(str) != std::basic_string_view<T>::npos;
+        }
+    };
+
+    using wildcard_matcher = basic_wildcard_matcher<char>;
+    using wildcard_matcher16 = basic_wildcard_matcher<char16_t>;
+
+    /**
+     * \brief Match a string with a wildcard pattern, the way TDesC::Match does.
+     *
+     * Use basic_wildcard_matcher when matching many strings against the same pattern.
+     *
+     * \returns npos if the string does not match, else the position of the match.
+     */
     template <typename T>
     std::size_t match_wildcard_in_string(const std::basic_string<T> &reference, const std::basic_string<T> &match_pattern,
         const bool is_fold);
@@ -53,6 +53,10 @@ namespace eka2l1::common {
     }
 
     bool chunkyseri::expect(const std::uint8_t *dat, const std::size_t s) {
+        if (buf + s > end && mode != SERI_MODE_MEASURE) {
+            return false;
+        }
+
         switch (mode) {
         case SERI_MODE_MEASURE:
             break;
@@ -83,6 +87,12 @@ namespace eka2l1::common {
         absorb_impl(reinterpret_cast<std::uint8_t *>(&s), sizeof(std::uint32_t));
 
         if (mode == SERI_MODE_READ) {
+            // Don't trust the length of a truncated buffer
+            if (static_cast<std::size_t>(end - buf) < static_cast<std::size_t>(s)) {
+                dat.clear();
+                return;
+            }
+
             dat.resize(s);
         }
 
@@ -94,6 +104,12 @@ namespace eka2l1::common {
         absorb_impl(reinterpret_cast<std::uint8_t *>(&s), sizeof(std::uint32_t));
 
         if (mode == SERI_MODE_READ) {
+            // Don't trust the length of a truncated buffer
+            if (static_cast<std::size_t>(end - buf) < static_cast<std::size_t>(s * 2)) {
+                dat.clear();
+                return;
+            }
+
             dat.resize(s);
         }
 
@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <common/log.h>
+#include <common/path.h>
+#include <common/profile.h>
+
+#include <fmt/format.h>
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+namespace eka2l1::common::profile {
+    // Stop recording a thread past this many zones, so a forgotten capture can't eat all memory
+    static constexpr std::size_t MAX_ZONES_PER_THREAD = 1 << 22;
+
+    struct zone_record {
+        const char *category_;
+        const char *name_;
+        std::uint64_t start_;
+        std::uint64_t duration_;
+    };
+
+    struct thread_record {
+        std::mutex lock_;
+        std::vector<zone_record> zones_;
+        std::string name_;
+        std::uint32_t id_;
+        bool overflowed_ = false;
+    };
+
+    struct profile_state {
+        std::atomic<bool> capturing_{ false };
+        std::chrono::steady_clock::time_point epoch_ = std::chrono::steady_clock::now();
+
+        // Records are never freed, thread local pointers to them stay valid even after a thread exits
+        std::vector<std::unique_ptr<thread_record>> threads_;
+        std::mutex threads_lock_;
+
+        std::unordered_set<std::string> names_;
+        std::mutex names_lock_;
+    };
+
+    static profile_state &get_state() {
+        static profile_state state;
+        return state;
+    }
+
+    static thread_record *get_thread_record() {
+        static thread_local thread_record *record = nullptr;
+
+        if (!record) {
+            profile_state &state = get_state();
+            const std::lock_guard<std::mutex> guard(state.threads_lock_);
+
+            state.threads_.push_back(std::make_unique<thread_record>());
+            record = state.threads_.back().get();
+            record->id_ = static_cast<std::uint32_t>(state.threads_.size());
+            record->name_ = "Thread " + std::to_string(record->id_);
+        }
+
+        return record;
+    }
+
+    static std::uint64_t get_timestamp(profile_state &state) {
+        const auto elapsed = std::chrono::steady_clock::now() - state.epoch_;
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+    }
+
+    static std::string escape_json(const char *str) {
+        std::string result;
+
+        for (; *str; str++) {
+            const char c = *str;
+
+            switch (c) {
+            case '"':
+                result += "\\\"";
+                break;
+
+            case '\\':
+                result += "\\\\";
+                break;
+
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    result += fmt::format("\\u{:04x}", static_cast<int>(c));
+                } else {
+                    result += c;
+                }
+
+                break;
+            }
+        }
+
+        return result;
+    }
+
+    void start_capture() {
+        profile_state &state = get_state();
+
+        {
+            const std::lock_guard<std::mutex> guard(state.threads_lock_);
+
+            for (auto &thread : state.threads_) {
+                const std::lock_guard<std::mutex> thread_guard(thread->lock_);
+                thread->zones_.clear();
+                thread->overflowed_ = false;
+            }
+        }
+
+        state.capturing_ = true;
+    }
+
+    bool stop_capture(const std::string &trace_path) {
+        profile_state &state = get_state();
+        state.capturing_ = false;
+
+        const std::string directory = eka2l1::file_directory(trace_path);
+
+        if (!directory.empty()) {
+            eka2l1::create_directories(directory);
+        }
+
+        std::ofstream stream(trace_path);
+
+        if (stream.fail()) {
+            LOG_ERROR("Unable to open profile trace file {}", trace_path);
+            return false;
+        }
+
+        stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool first = true;
+
+        const std::lock_guard<std::mutex> guard(state.threads_lock_);
+
+        for (auto &thread : state.threads_) {
+            const std::lock_guard<std::mutex> thread_guard(thread->lock_);
+
+            if (thread->zones_.empty()) {
+                continue;
+            }
+
+            stream << (first ? "" : ",") << fmt::format("{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},\"args\":{{\"name\":\"{}\"}}}}",
+                thread->id_, escape_json(thread->name_.c_str()));
+
+            first = false;
+
+            for (const zone_record &zone : thread->zones_) {
+                stream << fmt::format(",{{\"name\":\"{}\",\"cat\":\"{}\",\"ph\":\"X\",\"ts\":{},\"dur\":{},\"pid\":1,\"tid\":{}}}",
+                    escape_json(zone.name_), escape_json(zone.category_), zone.start_, zone.duration_, thread->id_);
+            }
+
+            if (thread->overflowed_) {
+                LOG_WARN("Profile zones of thread {} exceeded the limit, later zones were dropped", thread->name_);
+            }
+
+            thread->zones_.clear();
+            thread->zones_.shrink_to_fit();
+        }
+
+        stream << "]}";
+        LOG_INFO("Profile trace written to {}", trace_path);
+
+        return !stream.fail();
+    }
+
+    bool is_capturing() {
+        return get_state().capturing_.load(std::memory_order_relaxed);
+    }
+
+    void set_thread_name(const char *name) {
+        thread_record *record = get_thread_record();
+
+        const std::lock_guard<std::mutex> guard(record->lock_);
+        record->name_ = name;
+    }
+
+    const char *intern_name(const std::string &name) {
+        profile_state &state = get_state();
+        const std::lock_guard<std::mutex> guard(state.names_lock_);
+
+        // Node based set, the string address doesn't change on later inserts
+        return state.names_.insert(name).first->c_str();
+    }
+
+    scoped_zone::scoped_zone(const char *category, const char *name)
+        : category_(category)
+        , name_(name)
+        , start_(0)
+        , active_(false) {
+        if (name_ && is_capturing()) {
+            start_ = get_timestamp(get_state());
+            active_ = true;
+        }
+    }
+
+    scoped_zone::~scoped_zone() {
+        if (!active_) {
+            return;
+        }
+
+        profile_state &state = get_state();
+        const std::uint64_t end = get_timestamp(state);
+
+        thread_record *record = get_thread_record();
+        const std::lock_guard<std::mutex> guard(record->lock_);
+
+        if (record->zones_.size() >= MAX_ZONES_PER_THREAD) {
+            record->overflowed_ = true;
+            return;
+        }
+
+        record->zones_.push_back({ category_, name_, start_, end - start_ });
+    }
+}
@@ -70,25 +70,27 @@ namespace eka2l1::common {
                 return false;
             }
 
-            eka2l1::rect intersector;
-            intersector = rect.intersect(rects_[i]);
+            // Keep the existing rectangle, and only add the parts of the new one that lie outside it.
+            // Those parts may still overlap other rectangles, so add them through here again.
+            const eka2l1::rect intersector = rect.intersect(rects_[i]);
+            const eka2l1::vec2 rect_br = rect.bottom_right();
+            const eka2l1::vec2 intersector_br = intersector.bottom_right();
 
-            if (intersector.top.y + intersector.size.y != rect.top.y + rect.size.y)
-                rects_.push_back(eka2l1::rect( { rect.top.x, intersector.top.y }, { rect.size.x, rect.size.y + rect.top.y - intersector.top.y }));
+            bool modified = false;
 
             if (intersector.top.y != rect.top.y)
-                rects_.push_back(eka2l1::rect( { rect.top.x, rect.top.y }, { rect.size.x, intersector.top.y - rect.top.y }));
+                modified |= add_rect(eka2l1::rect(rect.top, { rect.size.x, intersector.top.y - rect.top.y }));
 
-			if (intersector.top.x + intersector.size.x != rect.top.x + rect.size.x)
-				rects_.push_back(eka2l1::rect({ intersector.top.x + intersector.size.x, intersector.top.y },
-                    { rect.top.x + rect.size.x - intersector.top.x - intersector.size.x, intersector.size.y }));
+            if (intersector_br.y != rect_br.y)
+                modified |= add_rect(eka2l1::rect({ rect.top.x, intersector_br.y }, { rect.size.x, rect_br.y - intersector_br.y }));
 
             if (intersector.top.x != rect.top.x)
-                rects_.push_back(eka2l1::rect( { rect.top.x, intersector.top.y }, { intersector.top.x - rect.top.x,
-                    intersector.size.y}));
+                modified |= add_rect(eka2l1::rect({ rect.top.x, intersector.top.y }, { intersector.top.x - rect.top.x, intersector.size.y }));
 
-            rects_.erase(rects_.begin() + i);
-            return true;
+            if (intersector_br.x != rect_br.x)
+                modified |= add_rect(eka2l1::rect({ intersector_br.x, intersector.top.y }, { rect_br.x - intersector_br.x, intersector.size.y }));
+
+            return modified;
         }
 
         rects_.push_back(rect);
@@ -100,9 +102,11 @@ namespace eka2l1::common {
             return;
         }
 
+        // Pieces left over are appended after the limit, so they are not visited again
         std::size_t limit = rects_.size();
+        std::size_t i = 0;
 
-        for (std::size_t i = 0; i < limit; i++) {
+        while (i < limit) {
             if ((rect.top == rects_[i].top) && (rect.size == rects_[i].size)) {
                 rects_.erase(rects_.begin() + i);
                 return;
@@ -110,7 +114,9 @@ namespace eka2l1::common {
             
             const eka2l1::rect intersection_reg = rect.intersect(rects_[i]);
 
-            if (!intersection_reg.empty()) {
+            if (intersection_reg.empty()) {
+                i++;
+            } else {
                 const eka2l1::rect original_iterate = rects_[i];
                 rects_.erase(rects_.begin() + i);
 
@@ -23,6 +23,8 @@
 #include <common/log.h>
 #include <common/runlen.h>
 
+#include <cstring>
+
 namespace eka2l1 {
     template <size_t BIT>
     bool compress_rle(common::ro_stream *source, common::wo_stream *dest, std::size_t &dest_size) {
@@ -121,6 +123,69 @@ namespace eka2l1 {
         return true;
     }
 
+    template <size_t BIT>
+    bool compress_rle(const std::uint8_t *source, const std::size_t source_size, std::vector<std::uint8_t> &dest,
+        const std::size_t max_dest_size) {
+        static_assert(BIT % 8 == 0, "This RLE compress function don't support unaligned bit decompress!");
+        static constexpr std::size_t BYTE_COUNT = BIT / 8;
+
+        const std::size_t total_pixels = source_size / BYTE_COUNT;
+
+        dest.clear();
+        dest.reserve(common::min(max_dest_size, source_size) + 1);
+
+        auto pixel_equal = [source](const std::size_t lhs, const std::size_t rhs) {
+            return std::memcmp(source + lhs * BYTE_COUNT, source + rhs * BYTE_COUNT, BYTE_COUNT) == 0;
+        };
+
+        std::size_t pos = 0;
+
+        while (pos < total_pixels) {
+            std::size_t end = pos + 1;
+
+            if ((end < total_pixels) && pixel_equal(pos, end)) {
+                while ((end < total_pixels) && pixel_equal(pos, end)) {
+                    end++;
+                }
+
+                std::size_t total_pair = end - pos;
+
+                while (total_pair > 0) {
+                    const std::size_t total_this_session = common::min<std::size_t>(total_pair, 128);
+
+                    dest.push_back(static_cast<std::uint8_t>(total_this_session - 1));
+                    dest.insert(dest.end(), source + pos * BYTE_COUNT, source + (pos + 1) * BYTE_COUNT);
+
+                    total_pair -= total_this_session;
+                }
+            } else {
+                // Like the stream version, the literal run also takes the first pixel of the next repeat
+                while ((end < total_pixels) && !pixel_equal(end - 1, end)) {
+                    end++;
+                }
+
+                std::size_t copy_pos = pos;
+
+                while (copy_pos < end) {
+                    const std::size_t total_this_session = common::min<std::size_t>(end - copy_pos, 128);
+
+                    dest.push_back(static_cast<std::uint8_t>(-static_cast<std::int32_t>(total_this_session)));
+                    dest.insert(dest.end(), source + copy_pos * BYTE_COUNT, source + (copy_pos + total_this_session) * BYTE_COUNT);
+
+                    copy_pos += total_this_session;
+                }
+            }
+
+            if (dest.size() > max_dest_size) {
+                return false;
+            }
+
+            pos = end;
+        }
+
+        return true;
+    }
+
     template <size_t BIT>
     void decompress_rle(common::ro_stream *source, common::wo_stream *dest) {
         static_assert(BIT % 8 == 0, "This RLE decompress function don't support unaligned bit decompress!");
@@ -185,6 +250,11 @@ namespace eka2l1 {
     template bool compress_rle<24>(common::ro_stream *source, common::wo_stream *dest, std::size_t &dest_size);
     template bool compress_rle<32>(common::ro_stream *source, common::wo_stream *dest, std::size_t &dest_size);
 
+    template bool compress_rle<8>(const std::uint8_t *source, const std::size_t source_size, std::vector<std::uint8_t> &dest, const std::size_t max_dest_size);
+    template bool compress_rle<16>(const std::uint8_t *source, const std::size_t source_size, std::vector<std::uint8_t> &dest, const std::size_t max_dest_size);
+    template bool compress_rle<24>(const std::uint8_t *source, const std::size_t source_size, std::vector<std::uint8_t> &dest, const std::size_t max_dest_size);
+    template bool compress_rle<32>(const std::uint8_t *source, const std::size_t source_size, std::vector<std::uint8_t> &dest, const std::size_t max_dest_size);
+
     template void decompress_rle<8>(common::ro_stream *source, common::wo_stream *dest);
     template void decompress_rle<16>(common::ro_stream *source, common::wo_stream *dest);
     template void decompress_rle<24>(common::ro_stream *source, common::wo_stream *dest);
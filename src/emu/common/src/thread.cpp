@@ -27,6 +27,7 @@
 #endif
 
 #include <common/cvt.h>
+#include <common/profile.h>
 #include <common/thread.h>
 
 namespace eka2l1::common {
@@ -65,6 +66,10 @@ namespace eka2l1::common {
     }
 
     void set_thread_name(const char *thread_name) {
+#if ENABLE_PROFILING == 1
+        profile::set_thread_name(thread_name);
+#endif
+
         if (!thread_funcs_loaded) {
             load_thread_funcs();
         }
@@ -88,6 +93,10 @@ namespace eka2l1::common {
     }
 #else
     void set_thread_name(const char *thread_name) {
+#if ENABLE_PROFILING == 1
+        profile::set_thread_name(thread_name);
+#endif
+
 #if EKA2L1_PLATFORM(DARWIN)
         pthread_setname_np(thread_name);
 #else
@@ -95,4 +104,84 @@ namespace eka2l1::common {
 #endif
     }
 #endif
-}
\ No newline at end of file
+
+    thread_pool::thread_pool(const std::size_t worker_count, const std::string &name)
+        : busy_count_(0)
+        , should_stop_(false) {
+        std::size_t total = worker_count;
+
+        if (total == 0) {
+            total = std::thread::hardware_concurrency();
+
+            if (total == 0) {
+                total = 1;
+            }
+        }
+
+        for (std::size_t i = 0; i < total; i++) {
+            workers_.emplace_back([this, name]() {
+                set_thread_name(name.c_str());
+                worker_loop();
+            });
+        }
+    }
+
+    thread_pool::~thread_pool() {
+        {
+            const std::lock_guard<std::mutex> guard(lock_);
+            should_stop_ = true;
+        }
+
+        task_cond_.notify_all();
+
+        for (std::thread &worker : workers_) {
+            worker.join();
+        }
+    }
+
+    void thread_pool::worker_loop() {
+        while (true) {
+            std::function<void()> task;
+
+            {
+                std::unique_lock<std::mutex> ulock(lock_);
+                task_cond_.wait(ulock, [this]() { return should_stop_ || !tasks_.empty(); });
+
+                if (tasks_.empty()) {
+                    // Only get here when the pool is stopping
+                    return;
+                }
+
+                task = std::move(tasks_.front());
+                tasks_.pop();
+
+                busy_count_++;
+            }
+
+            task();
+
+            {
+                const std::lock_guard<std::mutex> guard(lock_);
+                busy_count_--;
+
+                if (tasks_.empty() && (busy_count_ == 0)) {
+                    done_cond_.notify_all();
+                }
+            }
+        }
+    }
+
+    void thread_pool::enqueue(std::function<void()> task) {
+        {
+            const std::lock_guard<std::mutex> guard(lock_);
+            tasks_.push(std::move(task));
+        }
+
+        task_cond_.notify_one();
+    }
+
+    void thread_pool::wait_all() {
+        std::unique_lock<std::mutex> ulock(lock_);
+        done_cond_.wait(ulock, [this]() { return tasks_.empty() && (busy_count_ == 0); });
+    }
+}
@@ -18,50 +18,113 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <common/algorithm.h>
 #include <common/wildcard.h>
 
+#include <cctype>
+#include <cwctype>
+
 namespace eka2l1::common {
-    template <>
-    std::basic_string<char> wildcard_to_regex_string(std::basic_string<char> regexstr) {
-        regexstr = replace_all<char>(regexstr, "\\", "\\\\");
-        regexstr = replace_all<char>(regexstr, ".", std::string("\\") + ".");
-        regexstr = replace_all<char>(regexstr, "?", ".");
-        regexstr = replace_all<char>(regexstr, "*", ".*");
-        regexstr = replace_all<char>(regexstr, "[", "(");
-        regexstr = replace_all<char>(regexstr, "]", ")");
-
-        return regexstr;
+    static inline char fold_wildcard_char(const char c) {
+        return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
     }
 
-    template <>
-    std::basic_string<wchar_t> wildcard_to_regex_string(std::basic_string<wchar_t> regexstr) {
-        regexstr = replace_all<wchar_t>(regexstr, L"\\", L"\\\\");
-        regexstr = replace_all<wchar_t>(regexstr, L".", std::wstring(L"\\") + L".");
-        regexstr = replace_all<wchar_t>(regexstr, L"?", L".");
-        regexstr = replace_all<wchar_t>(regexstr, L"*", L".*");
-        regexstr = replace_all<wchar_t>(regexstr, L"[", L"(");
-        regexstr = replace_all<wchar_t>(regexstr, L"]", L")");
+    static inline wchar_t fold_wildcard_char(const wchar_t c) {
+        return static_cast<wchar_t>(std::towlower(c));
+    }
 
-        return regexstr;
+    static inline char16_t fold_wildcard_char(const char16_t c) {
+        return static_cast<char16_t>(std::towlower(c));
     }
 
     template <typename T>
-    std::size_t match_wildcard_in_string(const std::basic_string<T> &reference, const std::basic_string<T> &match_pattern,
-        const bool is_fold) {  
-        std::basic_regex<T> reg(wildcard_to_regex_string(match_pattern), (is_fold ? std::regex_constants::icase :
-            std::regex_constants::basic));
+    basic_wildcard_matcher<T>::basic_wildcard_matcher(const std::basic_string_view<T> pattern, const bool is_fold)
+        : pattern_(pattern)
+        , first_literal_(0)
+        , is_fold_(is_fold) {
+        if (is_fold_) {
+            for (T &c : pattern_) {
+                c = fold_wildcard_char(c);
+            }
+        }
 
-        std::match_results<typename std::basic_string<T>::const_iterator> match_result;
-        if (std::regex_search(reference, match_result, reg)) {
-            return static_cast<std::size_t>(match_result.position());
+        while ((first_literal_ < pattern_.length()) && (pattern_[first_literal_] == static_cast<T>('*'))) {
+            first_literal_++;
         }
+    }
+
+    template <typename T>
+    std::size_t basic_wildcard_matcher<T>::match_pos(const std::basic_string_view<T> str) const {
+        static constexpr std::size_t npos = std::basic_string_view<T>::npos;
+
+        std::size_t si = 0;
+        std::size_t pi = 0;
+
+        // Position to resume from when the part after the last star fails to match
+        std::size_t star_pi = npos;
+        std::size_t star_si = 0;
+
+        std::size_t first_literal_pos = 0;
+
+        while (si < str.length()) {
+            if (pi < pattern_.length()) {
+                const T pc = pattern_[pi];
+
+                if (pc == static_cast<T>('*')) {
+                    star_pi = pi++;
+                    star_si = si;
+
+                    continue;
+                }
+
+                const T sc = is_fold_ ? fold_wildcard_char(str[si]) : str[si];
+
+                if ((pc == static_cast<T>('?')) || (pc == sc)) {
+                    if (pi == first_literal_) {
+                        first_literal_pos = si;
+                    }
+
+                    pi++;
+                    si++;
 
-        return std::basic_string<T>::npos;
+                    continue;
+                }
+            }
+
+            if (star_pi == npos) {
+                return npos;
+            }
+
+            // Let the last star eat one more character and retry
+            pi = star_pi + 1;
+            si = ++star_si;
+        }
+
+        while ((pi < pattern_.length()) && (pattern_[pi] == static_cast<T>('*'))) {
+            pi++;
+        }
+
+        if (pi != pattern_.length()) {
+            return npos;
+        }
+
+        // A pattern of only stars matches from the start
+        return (first_literal_ < pattern_.length()) ? first_literal_pos : 0;
     }
-    
+
+    template <typename T>
+    std::size_t match_wildcard_in_string(const std::basic_string<T> &reference, const std::basic_string<T> &match_pattern,
+        const bool is_fold) {
+        return basic_wildcard_matcher<T>(match_pattern, is_fold).match_pos(reference);
+    }
+
+    template class basic_wildcard_matcher<char>;
+    template class basic_wildcard_matcher<wchar_t>;
+    template class basic_wildcard_matcher<char16_t>;
+
     template std::size_t match_wildcard_in_string<char>(const std::string &reference, const std::string &match_pattern,
         const bool is_fold);
     template std::size_t match_wildcard_in_string<wchar_t>(const std::wstring &reference, const std::wstring &match_pattern,
         const bool is_fold);
+    template std::size_t match_wildcard_in_string<char16_t>(const std::u16string &reference, const std::u16string &match_pattern,
+        const bool is_fold);
 }
@@ -82,7 +82,8 @@ namespace eka2l1::config {
         bool enable_srv_cdl{ true };
         bool enable_srv_socket{ true };
 
-        bool fbs_enable_compression_queue{ false };
+        bool fbs_enable_compression_queue{ true };
+        int audio_decode_ahead_ms{ 200 };
         bool accurate_ipc_timing{ false };
         bool enable_btrace{ false };
 
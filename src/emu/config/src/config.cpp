@@ -107,6 +107,7 @@ namespace eka2l1::config {
         config_file_emit_single(emitter, "enable-srv-cdl", enable_srv_cdl);
         config_file_emit_single(emitter, "enable-srv-socket", enable_srv_socket);
         config_file_emit_single(emitter, "fbs-enable-compression-queue", fbs_enable_compression_queue);
+        config_file_emit_single(emitter, "audio-decode-ahead-ms", audio_decode_ahead_ms);
         config_file_emit_single(emitter, "accurate-ipc-timing", accurate_ipc_timing);
         config_file_emit_single(emitter, "enable-btrace", enable_btrace);
         config_file_emit_single(emitter, "stop-warn-touchscreen-disabled", stop_warn_touch_disabled);
@@ -170,7 +171,8 @@ namespace eka2l1::config {
         get_yaml_value(node, "enable-srv-akn-skin", &enable_srv_akn_skin, true);
         get_yaml_value(node, "enable-srv-cdl", &enable_srv_cdl, true);
         get_yaml_value(node, "enable-srv-socket", &enable_srv_socket, false);
-        get_yaml_value(node, "fbs-enable-compression-queue", &fbs_enable_compression_queue, false);
+        get_yaml_value(node, "fbs-enable-compression-queue", &fbs_enable_compression_queue, true);
+        get_yaml_value(node, "audio-decode-ahead-ms", &audio_decode_ahead_ms, 200);
         get_yaml_value(node, "accurate-ipc-timing", &accurate_ipc_timing, false);
         get_yaml_value(node, "enable-btrace", &enable_btrace, false);
         get_yaml_value(node, "stop-warn-touchscreen-disabled", &stop_warn_touch_disabled, false);
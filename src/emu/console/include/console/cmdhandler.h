@@ -34,6 +34,14 @@ bool rpkg_unpack_option_handler(eka2l1::common::arg_parser *parser, void *userda
 bool list_app_option_handler(eka2l1::common::arg_parser *parser, void *userdata, std::string *err);
 bool list_devices_option_handler(eka2l1::common::arg_parser *parser, void *userdata, std::string *err);
 bool fullscreen_option_handler(eka2l1::common::arg_parser *parser, void *userdata, std::string *err);
+bool headless_option_handler(eka2l1::common::arg_parser *parser, void *userdata, std::string *err);
+bool headless_frame_limit_option_handler(eka2l1::common::arg_parser *parser, void *userdata, std::string *err);
+bool headless_time_limit_option_handler(eka2l1::common::arg_parser *parser, void *userdata, std::string *err);
+bool audio_capture_option_handler(eka2l1::common::arg_parser *parser, void *userdata, std::string *err);
+bool record_ipc_option_handler(eka2l1::common::arg_parser *parser, void *userdata, std::string *err);
+
+// Options can be given in any order, so their combination is checked once all are parsed
+bool check_option_combination(void *userdata, std::string *err);
 
 #if ENABLE_SCRIPTING
 bool python_docgen_option_handler(eka2l1::common::arg_parser *parser, void *userdata, std::string *err);
@@ -24,6 +24,7 @@
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <string>
 #include <thread>
 
 #include <common/queue.h>
@@ -36,6 +37,8 @@
 #include <drivers/graphics/emu_window.h>
 #include <drivers/input/emu_controller.h>
 
+#include <kernel/ipctrace.h>
+
 #include <imgui.h>
 
 namespace eka2l1 {
@@ -45,6 +48,7 @@ namespace eka2l1 {
     namespace drivers {
         class graphics_driver;
         class audio_driver;
+        class capture_audio_driver;
     }
 
     class window_server;
@@ -74,6 +78,19 @@ namespace eka2l1::desktop {
         bool first_time;
         bool init_fullscreen;
 
+        bool headless; ///< Run without window, UI and host audio.
+        std::uint64_t headless_frame_limit; ///< Quit after this many screen frames. 0 for no limit.
+        std::uint64_t headless_time_limit_us; ///< Quit after this much guest time. 0 for no limit.
+        std::uint32_t launched_app_uid; ///< UID of the app launched from command line. 0 if none.
+
+        bool audio_capture; ///< Pull audio on the guest clock instead of playing it on the host.
+        std::string audio_capture_path; ///< WAV file to write the captured audio to. Empty to discard.
+        drivers::capture_audio_driver *audio_capture_driver; ///< Backend of the audio driver, when capturing.
+        std::uint64_t audio_capture_last_us; ///< Guest time of the last capture advance.
+
+        std::string ipc_trace_path; ///< Host file to record IPC messages to. Empty to not record.
+        std::unique_ptr<kernel::ipc_trace_recorder> ipc_recorder;
+
         common::semaphore graphics_sema;
 
         config::state conf;
@@ -93,5 +110,16 @@ namespace eka2l1::desktop {
 
         void stage_one();
         bool stage_two();
+
+        /**
+         * \brief Create the audio driver for the current options, and give it to the system.
+         */
+        void create_audio_driver();
+        void report_audio_capture();
+
+        /**
+         * \brief Start recording IPC messages to the trace path, if one was given.
+         */
+        void start_ipc_recording();
     };
 }
\ No newline at end of file
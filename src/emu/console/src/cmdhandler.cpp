@@ -23,6 +23,7 @@
 #include <common/pystr.h>
 #include <console/cmdhandler.h>
 #include <console/state.h>
+#include <drivers/audio/audio.h>
 #include <manager/device_manager.h>
 #include <manager/manager.h>
 #include <manager/package_manager.h>
@@ -128,6 +129,7 @@ bool app_specifier_option_handler(eka2l1::common::arg_parser *parser, void *user
         eka2l1::apa_app_registry *registry = svr->get_registration(uid);
 
         if (registry) {
+            emu->launched_app_uid = uid;
             emu->symsys->load(registry->mandatory_info.app_path.to_std_string(nullptr), common::utf8_to_ucs2(cmdlinestr));
             return true;
         }
@@ -143,6 +145,7 @@ bool app_specifier_option_handler(eka2l1::common::arg_parser *parser, void *user
             if (!pr) {
                 LOG_ERROR("Unable to launch process: {}", tokstr);
             } else {
+                emu->launched_app_uid = pr->get_uid();
                 pr->run();
             }
 
@@ -159,6 +162,7 @@ bool app_specifier_option_handler(eka2l1::common::arg_parser *parser, void *user
                 epoc::apa::command_line cmdline;
                 cmdline.launch_cmd_ = epoc::apa::command_create;
 
+                emu->launched_app_uid = reg.mandatory_info.uid;
                 svr->launch_app(reg, cmdline);
                 return true;
             }
@@ -271,6 +275,114 @@ bool fullscreen_option_handler(eka2l1::common::arg_parser *parser, void *userdat
     return true;
 }
 
+bool headless_option_handler(eka2l1::common::arg_parser *parser, void *userdata, std::string *err) {
+    desktop::emulator *emu = reinterpret_cast<desktop::emulator *>(userdata);
+    emu->headless = true;
+
+    // An app given before this option already brought up the host audio backend. Swap it out
+    // before any guest code gets the chance to open a stream.
+    if (emu->stage_two_inited) {
+        emu->create_audio_driver();
+    }
+
+    *err = "";
+    return true;
+}
+
+bool audio_capture_option_handler(eka2l1::common::arg_parser *parser, void *userdata, std::string *err) {
+    const char *path = parser->next_token();
+
+    if (!path) {
+        *err = "Audio capture requested, but no output path given";
+        return false;
+    }
+
+    desktop::emulator *emu = reinterpret_cast<desktop::emulator *>(userdata);
+    emu->audio_capture = true;
+
+    // A dash means pull the streams, but do not write anything
+    emu->audio_capture_path = (std::string(path) == "-") ? "" : path;
+
+    if (emu->stage_two_inited) {
+        emu->create_audio_driver();
+    }
+
+    *err = "";
+    return true;
+}
+
+bool record_ipc_option_handler(eka2l1::common::arg_parser *parser, void *userdata, std::string *err) {
+    const char *path = parser->next_token();
+
+    if (!path) {
+        *err = "IPC recording requested, but no trace path given";
+        return false;
+    }
+
+    desktop::emulator *emu = reinterpret_cast<desktop::emulator *>(userdata);
+    emu->ipc_trace_path = path;
+
+    // Device may already be loaded by an app given before this option
+    if (emu->stage_two_inited) {
+        emu->start_ipc_recording();
+    }
+
+    *err = "";
+    return true;
+}
+
+bool headless_frame_limit_option_handler(eka2l1::common::arg_parser *parser, void *userdata, std::string *err) {
+    const char *frames = parser->next_token();
+
+    if (!frames) {
+        *err = "Frame limit requested, but number of frames not given";
+        return false;
+    }
+
+    desktop::emulator *emu = reinterpret_cast<desktop::emulator *>(userdata);
+    emu->headless_frame_limit = common::pystr(frames).as_int<std::uint64_t>();
+
+    if (emu->headless_frame_limit == 0) {
+        *err = "Frame limit must be a positive number of frames";
+        return false;
+    }
+
+    return true;
+}
+
+bool headless_time_limit_option_handler(eka2l1::common::arg_parser *parser, void *userdata, std::string *err) {
+    const char *seconds = parser->next_token();
+
+    if (!seconds) {
+        *err = "Time limit requested, but number of seconds not given";
+        return false;
+    }
+
+    desktop::emulator *emu = reinterpret_cast<desktop::emulator *>(userdata);
+    const double seconds_limit = common::pystr(seconds).as_fp<double>();
+
+    if (seconds_limit <= 0.0) {
+        *err = "Time limit must be a positive number of seconds";
+        return false;
+    }
+
+    emu->headless_time_limit_us = static_cast<std::uint64_t>(seconds_limit * 1000000.0);
+
+    return true;
+}
+
+bool check_option_combination(void *userdata, std::string *err) {
+    desktop::emulator *emu = reinterpret_cast<desktop::emulator *>(userdata);
+
+    // The limits are only checked by the headless loop, they would do nothing with a window
+    if (!emu->headless && ((emu->headless_frame_limit != 0) || (emu->headless_time_limit_us != 0))) {
+        *err = "--frames and --seconds only work together with --headless";
+        return false;
+    }
+
+    return true;
+}
+
 #if ENABLE_SCRIPTING
 bool python_docgen_option_handler(eka2l1::common::arg_parser *parser, void *userdata, std::string *err) {
     try {
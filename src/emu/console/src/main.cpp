@@ -110,6 +110,18 @@ int main(int argc, char **argv) {
         parser.add("--install, --i", "Install a SIS.", app_install_option_handler);
         parser.add("--remove, --r", "Remove an package.", package_remove_option_handler);
         parser.add("--fullscreen", "Display the emulator in fullscreen.", fullscreen_option_handler);
+        parser.add("--headless", "Run without window, UI and audio output. Quit when the launched app exits.",
+            headless_option_handler);
+        parser.add("--frames", "In headless mode, quit after the given number of screen frames.",
+            headless_frame_limit_option_handler);
+        parser.add("--seconds", "In headless mode, quit after the given number of guest seconds.",
+            headless_time_limit_option_handler);
+        parser.add("--audio-capture", "Play audio on the guest clock and write it to the given WAV file, instead of\n"
+                                      "\t\t\t  the host device. Give - to discard it. Stats are logged on exit.",
+            audio_capture_option_handler);
+        parser.add("--record-ipc", "Record IPC messages sent to servers into the given trace file.\n"
+                                   "\t\t\t  Replay it later with the ipcreplay tool.",
+            record_ipc_option_handler);
 
 #if ENABLE_SCRIPTING
         parser.add("--gendocs", "Generate Python documentation", python_docgen_option_handler);
@@ -117,7 +129,7 @@ int main(int argc, char **argv) {
 
         if (argc > 1) {
             std::string err;
-            state->should_emu_quit = !parser.parse(state.get(), &err);
+            state->should_emu_quit = !parser.parse(state.get(), &err) || !check_option_combination(state.get(), &err);
 
             if (state->should_emu_quit) {
                 std::cout << err << std::endl;
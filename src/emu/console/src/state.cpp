@@ -27,6 +27,8 @@
 #include <debugger/imgui_debugger.h>
 #include <debugger/logger.h>
 #include <drivers/audio/audio.h>
+#include <drivers/audio/backend/capture/audio_capture.h>
+#include <drivers/audio/mixer.h>
 #include <drivers/graphics/graphics.h>
 
 #include <manager/device_manager.h>
@@ -34,6 +36,7 @@
 
 #include <kernel/kernel.h>
 #include <kernel/libmanager.h>
+#include <kernel/timing.h>
 
 #include <services/window/window.h>
 
@@ -49,6 +52,13 @@ namespace eka2l1::desktop {
         , window(nullptr)
         , joystick_controller(nullptr)
         , init_fullscreen(false)
+        , headless(false)
+        , headless_frame_limit(0)
+        , headless_time_limit_us(0)
+        , launched_app_uid(0)
+        , audio_capture(false)
+        , audio_capture_driver(nullptr)
+        , audio_capture_last_us(0)
         , winserv(nullptr)
         , normal_font(nullptr) {
     }
@@ -124,8 +134,7 @@ namespace eka2l1::desktop {
                 eka2l1::add_path(conf.storage, "/drives/z/"), io_attrib_internal | io_attrib_write_protected);
 
             // Create audio driver
-            audio_driver = drivers::make_audio_driver(drivers::audio_driver_backend::cubeb);
-            symsys->set_audio_driver(audio_driver.get());
+            create_audio_driver();
 
             // Load patch libraries
             kernel_system *kern = symsys->get_kernel_system();
@@ -134,8 +143,86 @@ namespace eka2l1::desktop {
 
             libmngr->load_patch_libraries(".//patch//");
             stage_two_inited = true;
+
+            start_ipc_recording();
         }
 
         return true;
     }
-}
\ No newline at end of file
+
+    static constexpr std::int64_t AUDIO_CAPTURE_PERIOD_US = 10000;
+
+    void emulator::create_audio_driver() {
+        drivers::audio_driver_backend backend = drivers::audio_driver_backend::cubeb;
+
+        if (audio_capture) {
+            backend = drivers::audio_driver_backend::capture;
+        } else if (headless) {
+            backend = drivers::audio_driver_backend::null;
+        }
+
+        // Stop pumping the old driver before it goes away
+        audio_capture_driver = nullptr;
+
+        audio_driver = drivers::make_audio_driver(backend, audio_capture_path);
+        symsys->set_audio_driver(audio_driver.get());
+
+        if (!audio_capture || !audio_driver) {
+            return;
+        }
+
+        audio_capture_driver = static_cast<drivers::capture_audio_driver *>(
+            static_cast<drivers::mixer_audio_driver *>(audio_driver.get())->backend());
+
+        if (!audio_capture_driver->is_capture_valid()) {
+            LOG_WARN("Audio capture file can't be written, captured audio will be discarded");
+        }
+
+        ntimer *timing = symsys->get_ntimer();
+        audio_capture_last_us = timing->microseconds();
+
+        int pump_evt = timing->get_register_event("audio_capture_pump_evt");
+
+        if (pump_evt == -1) {
+            pump_evt = timing->register_event("audio_capture_pump_evt", [this, timing](std::uint64_t userdata, int cycles_late) {
+                const std::uint64_t now_us = timing->microseconds();
+
+                if (audio_capture_driver) {
+                    // Advance by what really passed, so the virtual clock stays on the guest clock
+                    audio_capture_driver->advance(now_us - audio_capture_last_us);
+                }
+
+                audio_capture_last_us = now_us;
+                timing->schedule_event(AUDIO_CAPTURE_PERIOD_US, timing->get_register_event("audio_capture_pump_evt"), 0);
+            });
+
+            timing->schedule_event(AUDIO_CAPTURE_PERIOD_US, pump_evt, 0);
+        }
+    }
+
+    void emulator::report_audio_capture() {
+        if (!audio_capture_driver) {
+            return;
+        }
+
+        // Count the guest streams, the capture backend only sees the mixed output
+        const drivers::audio_stream_stats stats = static_cast<drivers::mixer_audio_driver *>(audio_driver.get())->stats();
+        const std::uint64_t average_us = stats.callback_count_ ? (stats.callback_total_us_ / stats.callback_count_) : 0;
+
+        LOG_INFO("Audio capture: {} callbacks, {} of {} frames received, {} underruns", stats.callback_count_,
+            stats.frames_received_, stats.frames_requested_, stats.underrun_count_);
+        LOG_INFO("Audio capture: callback latency average {} us, max {} us", average_us, stats.callback_max_us_);
+    }
+
+    void emulator::start_ipc_recording() {
+        if (ipc_trace_path.empty() || ipc_recorder) {
+            return;
+        }
+
+        ipc_recorder = std::make_unique<kernel::ipc_trace_recorder>(symsys->get_kernel_system(), symsys->get_ntimer());
+
+        if (!ipc_recorder->start(ipc_trace_path)) {
+            ipc_recorder.reset();
+        }
+    }
+}
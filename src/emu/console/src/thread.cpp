@@ -39,6 +39,9 @@
 #include <drivers/input/emu_controller.h>
 
 #include <e32keys.h>
+#include <kernel/kernel.h>
+#include <kernel/timing.h>
+#include <services/window/screen.h>
 #include <services/window/window.h>
 
 void set_mouse_down(void *userdata, const int button, const bool op) {
@@ -526,6 +529,28 @@ namespace eka2l1::desktop {
         }
     }
 
+    static bool headless_limit_reached(emulator &state, const std::uint64_t start_us) {
+        if (state.headless_time_limit_us != 0) {
+            const std::uint64_t elapsed_us = state.symsys->get_ntimer()->microseconds() - start_us;
+
+            if (elapsed_us >= state.headless_time_limit_us) {
+                LOG_INFO("Headless run reached its time limit ({} guest microseconds)", elapsed_us);
+                return true;
+            }
+        }
+
+        if ((state.headless_frame_limit != 0) && state.winserv) {
+            epoc::screen *scr = state.winserv->get_screens();
+
+            if (scr && (scr->frame_count >= state.headless_frame_limit)) {
+                LOG_INFO("Headless run reached its frame limit ({} frames)", scr->frame_count);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
     void os_thread(emulator &state) {
         eka2l1::common::set_thread_name(os_thread_name);
         state.graphics_sema.wait();
@@ -535,6 +560,8 @@ namespace eka2l1::desktop {
         _set_se_translator(seh_handler_translator_func);
 #endif
 
+        const std::uint64_t headless_start_us = state.headless ? state.symsys->get_ntimer()->microseconds() : 0;
+
         while (!state.should_emu_quit) {
 #if !defined(NDEBUG)
             try {
@@ -549,16 +576,88 @@ namespace eka2l1::desktop {
             }
 #endif
 
+            if (state.headless && headless_limit_reached(state, headless_start_us)) {
+                state.should_emu_quit = true;
+                break;
+            }
+
             if (state.should_emu_pause && !state.should_emu_quit) {
                 state.debugger->wait_for_debugger();
             }
         }
 
+        state.report_audio_capture();
+
+        // Flush the trace while the kernel it listens to is still alive
+        state.ipc_recorder.reset();
         state.symsys.reset();
+
+        if (state.headless) {
+            // There is no UI thread to stop the driver in headless mode
+            state.graphics_driver->abort();
+        }
+
         state.graphics_sema.notify();
     }
 
+    static int headless_entry(emulator &state) {
+        eka2l1::common::set_thread_name(graphics_driver_thread_name);
+
+        if (!state.stage_two()) {
+            LOG_ERROR("Headless run aborted, the device could not be loaded");
+            return -1;
+        }
+
+        if (!state.launched_app_uid && !state.headless_frame_limit && !state.headless_time_limit_us) {
+            LOG_WARN("Headless run has no app and no limit to wait for, it will run until killed");
+        }
+
+        if (!drivers::init_window_library(drivers::window_api::null)) {
+            return -1;
+        }
+
+        state.window = drivers::new_emu_window(drivers::window_api::null);
+        state.window->init("EKA2L1", eka2l1::vec2(1080, 720), 0);
+        state.window->set_userdata(&state);
+
+        state.graphics_driver = drivers::create_graphics_driver(drivers::graphic_api::software);
+        state.symsys->set_graphics_driver(state.graphics_driver.get());
+
+        if (state.launched_app_uid != 0) {
+            // Quit once the last thread of the launched app is gone
+            state.symsys->get_kernel_system()->register_thread_kill_callback([&state](kernel::thread *target,
+                                                                                 const std::string &category, const std::int32_t reason) {
+                kernel::process *pr = target->owning_process();
+
+                if (pr && (pr->get_uid() == state.launched_app_uid) && (pr->get_exit_type() != kernel::entity_exit_type::pending)) {
+                    LOG_INFO("Headless run finished, app exited with category: {} and reason: {}", category, reason);
+                    state.should_emu_quit = true;
+                }
+            });
+        }
+
+        std::thread os_thread_obj(os_thread, std::ref(state));
+        state.graphics_sema.notify();
+
+        // Software driver keeps running on the main thread until the OS thread is done
+        state.graphics_driver->run();
+        os_thread_obj.join();
+
+        state.graphics_driver.reset();
+        state.window->shutdown();
+
+        if (!drivers::destroy_window_library(drivers::window_api::null)) {
+            return -1;
+        }
+
+        return 0;
+    }
+
     int emulator_entry(emulator &state) {
+        if (state.headless) {
+            return headless_entry(state);
+        }
+
         const bool result = state.stage_two();
 
         // Instantiate UI and High-level interface threads
@@ -19,6 +19,7 @@
 
 #include <dispatch/audio.h>
 #include <dispatch/dispatcher.h>
+#include <config/config.h>
 #include <vfs/vfs.h>
 
 #include <epoc/epoc.h>
@@ -35,6 +36,8 @@
 
 #include <utils/des.h>
 
+#include <algorithm>
+
 namespace eka2l1::dispatch {
     dsp_epoc_stream::dsp_epoc_stream(std::unique_ptr<drivers::dsp_stream> &stream)
         : ll_stream_(std::move(stream)) {
@@ -417,6 +420,9 @@ namespace eka2l1::dispatch {
             return 0;
         }
 
+        const int decode_ahead_ms = sys->get_config()->audio_decode_ahead_ms;
+        static_cast<drivers::dsp_output_stream &>(*ll_stream).decode_ahead(static_cast<std::uint32_t>(std::max(decode_ahead_ms, 0)));
+
         drivers::dsp_stream *ll_stream_ptr = ll_stream.get();
         auto stream_new = std::make_unique<dsp_epoc_stream>(ll_stream);
 
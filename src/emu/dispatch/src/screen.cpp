@@ -17,7 +17,9 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <common/algorithm.h>
 #include <common/log.h>
+#include <common/region.h>
 #include <dispatch/dispatcher.h>
 #include <dispatch/screen.h>
 
@@ -32,6 +34,53 @@
 namespace eka2l1::dispatch {
     static constexpr std::uint32_t FPS_LIMIT = 60;
 
+    // Past this much of the screen being dirty, one full upload is cheaper than many small ones.
+    static constexpr std::uint32_t FULL_UPLOAD_DIRTY_PERCENTAGE = 60;
+    static constexpr std::size_t MAX_PARTIAL_UPLOAD_RECTS = 16;
+
+    /**
+     * \brief Merge the guest dirty rectangles into a non-overlapping region.
+     * 
+     * \param dirty        The region to fill.
+     * \param screen_size  Size of the screen, dirty rectangles are clipped to it.
+     * \param num_rects    Number of rectangles in the list.
+     * \param rect_list    List of rectangles, in Symbian TRect form (top left and bottom right).
+     * 
+     * \returns True if uploading only the dirty region is worth it.
+     */
+    static bool build_dirty_region(common::region &dirty, const eka2l1::vec2 &screen_size, const std::uint32_t num_rects,
+        const eka2l1::rect *rect_list) {
+        if (!rect_list || (num_rects == 0)) {
+            return false;
+        }
+
+        const eka2l1::rect screen_rect({ 0, 0 }, screen_size);
+
+        for (std::uint32_t i = 0; i < num_rects; i++) {
+            eka2l1::rect dirty_rect = rect_list[i];
+            dirty_rect.transform_from_symbian_rectangle();
+
+            if (!dirty_rect.valid()) {
+                continue;
+            }
+
+            dirty.add_rect(dirty_rect.intersect(screen_rect));
+
+            if (dirty.rects_.size() > MAX_PARTIAL_UPLOAD_RECTS) {
+                return false;
+            }
+        }
+
+        std::uint64_t dirty_area = 0;
+
+        for (const eka2l1::rect &dirty_rect : dirty.rects_) {
+            dirty_area += static_cast<std::uint64_t>(dirty_rect.size.x) * dirty_rect.size.y;
+        }
+
+        const std::uint64_t screen_area = static_cast<std::uint64_t>(screen_size.x) * screen_size.y;
+        return dirty_area * 100 < screen_area * FULL_UPLOAD_DIRTY_PERCENTAGE;
+    }
+
     BRIDGE_FUNC_DISPATCHER(void, update_screen, const std::uint32_t screen_number, const std::uint32_t num_rects, const eka2l1::rect *rect_list) {
         dispatch::dispatcher *dispatcher = sys->get_dispatcher();
         drivers::graphics_driver *driver = sys->get_graphics_driver();
@@ -43,10 +92,12 @@ namespace eka2l1::dispatch {
             if (scr->number == screen_number) {
                 // Update the DSA screen texture
                 const eka2l1::vec2 screen_size = scr->size();
-                const std::size_t buffer_size = scr->size().x * scr->size().y * 4;
 
                 const std::lock_guard<std::mutex> guard(scr->screen_mutex);
 
+                // A newly created texture has no content yet, it must be filled completely
+                bool partial_upload = (scr->dsa_texture != 0);
+
                 if (!scr->dsa_texture) {
                     scr->dsa_texture = drivers::create_bitmap(driver, screen_size);
                 }
@@ -54,9 +105,35 @@ namespace eka2l1::dispatch {
                 auto command_list = driver->new_command_list();
                 auto command_builder = driver->new_command_builder(command_list.get());
 
-                command_builder->update_bitmap(scr->dsa_texture, epoc::get_bpp_from_display_mode(scr->disp_mode),
-                    reinterpret_cast<const char *>(scr->screen_buffer_chunk->host_base()), buffer_size,
-                    { 0, 0 }, screen_size);
+                const int bpp = epoc::get_bpp_from_display_mode(scr->disp_mode);
+                const char *buffer_base = reinterpret_cast<const char *>(scr->screen_buffer_chunk->host_base());
+
+                // Rows are laid out as Symbian does. 12bpp pixels take 2 bytes, and pixels smaller than
+                // a byte can't be uploaded from the middle of a row.
+                const std::size_t bytes_per_pixel = (bpp + 7) / 8;
+                const std::size_t stride = epoc::get_byte_width(screen_size.x, static_cast<std::uint8_t>(bpp));
+
+                common::region dirty;
+                partial_upload = partial_upload && (bpp >= 8) && (stride % bytes_per_pixel == 0)
+                    && build_dirty_region(dirty, screen_size, num_rects, rect_list);
+
+                if (partial_upload) {
+                    // The driver takes the row length in pixels
+                    const std::size_t pixels_per_line = stride / bytes_per_pixel;
+
+                    for (const eka2l1::rect &dirty_rect : dirty.rects_) {
+                        const std::size_t span_offset = dirty_rect.top.y * stride + dirty_rect.top.x * bytes_per_pixel;
+                        const std::size_t span_size = (dirty_rect.size.y - 1) * stride + dirty_rect.size.x * bytes_per_pixel;
+
+                        // The guest keeps drawing to the buffer while the driver runs, so the spans
+                        // are copied into the command arena rather than read from the chunk later.
+                        command_builder->update_bitmap(scr->dsa_texture, bpp, buffer_base + span_offset, span_size,
+                            dirty_rect.top, dirty_rect.size, pixels_per_line);
+                    }
+                } else {
+                    const std::size_t buffer_size = scr->size().x * scr->size().y * 4;
+                    command_builder->update_bitmap(scr->dsa_texture, bpp, buffer_base, buffer_size, { 0, 0 }, screen_size);
+                }
 
                 command_builder->set_swizzle(scr->dsa_texture, drivers::channel_swizzle::red, drivers::channel_swizzle::green,
                     drivers::channel_swizzle::blue, drivers::channel_swizzle::one);
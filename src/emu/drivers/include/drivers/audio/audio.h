@@ -23,8 +23,21 @@
 #include <drivers/driver.h>
 
 #include <cstdint>
+#include <string>
 
 namespace eka2l1::drivers {
+    /**
+     * \brief Counters of data pulled from stream callbacks.
+     */
+    struct audio_stream_stats {
+        std::uint64_t callback_count_ = 0; ///< Number of data callbacks made.
+        std::uint64_t frames_requested_ = 0; ///< Frames asked from the streams.
+        std::uint64_t frames_received_ = 0; ///< Frames the streams actually gave back.
+        std::uint64_t underrun_count_ = 0; ///< Callbacks that gave back less than asked.
+        std::uint64_t callback_total_us_ = 0; ///< Host time spent in data callbacks.
+        std::uint64_t callback_max_us_ = 0; ///< Longest single data callback, in host time.
+    };
+
     class audio_driver : public driver {
     public:
         virtual ~audio_driver() {}
@@ -51,8 +64,17 @@ namespace eka2l1::drivers {
     };
 
     enum class audio_driver_backend {
-        cubeb
+        cubeb,
+        null,
+        capture ///< Pulled by the owner on a virtual clock. See capture_audio_driver.
     };
 
-    std::unique_ptr<audio_driver> make_audio_driver(const audio_driver_backend backend);
+    /**
+     * \brief Create an audio driver.
+     *
+     * \param backend           The backend that outputs the audio.
+     * \param capture_path      For the capture backend, the WAV file to write. Empty to discard.
+     */
+    std::unique_ptr<audio_driver> make_audio_driver(const audio_driver_backend backend,
+        const std::string &capture_path = std::string{});
 }
\ No newline at end of file
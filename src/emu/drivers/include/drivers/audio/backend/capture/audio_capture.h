@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <drivers/audio/audio.h>
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace eka2l1::drivers {
+    class capture_audio_driver;
+
+    /**
+     * \brief Output stream of the capture driver. It is only pulled when the driver is advanced.
+     */
+    struct capture_audio_output_stream : public audio_output_stream {
+    private:
+        friend class capture_audio_driver;
+
+        capture_audio_driver *driver_;
+        std::uint32_t sample_rate_;
+        std::uint8_t channels_;
+        data_callback callback_;
+
+        std::atomic<bool> playing_;
+
+        std::uint64_t elapsed_us_; ///< Virtual time played since start.
+        std::uint64_t frames_pulled_; ///< Frames pulled since start.
+
+    public:
+        explicit capture_audio_output_stream(capture_audio_driver *driver, const std::uint32_t sample_rate,
+            const std::uint8_t channels, data_callback callback);
+
+        ~capture_audio_output_stream() override;
+
+        bool start() override;
+        bool stop() override;
+
+        bool is_playing() override;
+
+        bool set_volume(const float volume) override;
+    };
+
+    /**
+     * \brief Audio driver with no device. Streams are pulled on a virtual clock instead.
+     *
+     * The owner calls advance() with elapsed (guest) time, and every playing stream is pulled for
+     * exactly that many frames. Output of the first stream opened in the native format is written
+     * to a 16-bit PCM WAV file, with silence while it is stopped, so captures of the same run are
+     * identical. With no path given, the output is discarded.
+     *
+     * make_audio_driver puts the mixer in front of this, so normally there is only one stream, and
+     * stats() describe pulls of the mixed output. Use the mixer stats for the guest streams.
+     */
+    class capture_audio_driver : public audio_driver {
+    private:
+        friend struct capture_audio_output_stream;
+
+        std::mutex lock_;
+        std::vector<capture_audio_output_stream *> streams_;
+        capture_audio_output_stream *recorded_;
+
+        std::ofstream wav_;
+        bool wav_requested_;
+        std::uint64_t wav_data_size_;
+        std::uint64_t wav_elapsed_us_;
+        std::uint64_t wav_frames_written_;
+
+        audio_stream_stats stats_;
+        std::vector<std::int16_t> scratch_;
+
+        void add_stream(capture_audio_output_stream *stream);
+        void remove_stream(capture_audio_output_stream *stream);
+
+        std::size_t pull(capture_audio_output_stream &stream, const std::size_t frame_count);
+
+        void write_wav_header();
+        void write_wav_silence(const std::size_t frame_count);
+
+    public:
+        static constexpr std::uint32_t CAPTURE_SAMPLE_RATE = 44100;
+        static constexpr std::uint8_t CAPTURE_CHANNELS = 2;
+
+        /**
+         * \param wav_path      Path of the WAV file to write. Empty to discard the output.
+         */
+        explicit capture_audio_driver(const std::string &wav_path = std::string{});
+        ~capture_audio_driver() override;
+
+        std::unique_ptr<audio_output_stream> new_output_stream(const std::uint32_t sample_rate,
+            const std::uint8_t channels, data_callback callback) override;
+
+        std::uint32_t native_sample_rate() override;
+
+        /**
+         * \brief Move the virtual clock forward, pulling samples from all playing streams.
+         *
+         * \param elapsed_us        Time passed since the last advance, in microseconds.
+         */
+        void advance(const std::uint64_t elapsed_us);
+
+        /**
+         * \brief Check if the WAV file could be opened, when one was asked for.
+         */
+        bool is_capture_valid() const;
+
+        audio_stream_stats stats();
+    };
+}
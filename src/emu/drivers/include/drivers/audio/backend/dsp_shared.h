@@ -24,7 +24,11 @@
 
 #include <common/queue.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <mutex>
+#include <thread>
 #include <vector>
 
 namespace eka2l1::drivers {
@@ -32,26 +36,95 @@ namespace eka2l1::drivers {
 
     struct dsp_output_stream_shared : public dsp_output_stream {
     protected:
+        /**
+         * \brief Where a written buffer starts in the sample ring.
+         */
+        struct buffer_marker {
+            std::size_t start_; ///< Position of the first sample of the buffer.
+            std::uint64_t timestamp_; ///< Decoder timestamp of the buffer.
+        };
+
+        static constexpr std::uint32_t RING_DURATION_SECS = 2;
+        static constexpr std::size_t MAX_PENDING_BUFFERS = 64;
+        static constexpr std::uint32_t DEFAULT_DECODE_AHEAD_MS = 200;
+        static constexpr std::uint32_t DECODE_POLL_INTERVAL_MS = 5;
+
         drivers::audio_driver *aud_;
         std::unique_ptr<drivers::audio_output_stream> stream_;
 
-        threadsafe_cn_queue<dsp_buffer> buffers_;
+        spsc_ring_buffer<std::int16_t> samples_; ///< Decoded PCM16 samples, waiting to be played.
+        spsc_ring_queue<buffer_marker, MAX_PENDING_BUFFERS> markers_;
+
+        dsp_buffer decoded_; ///< Decode destination, reused between writes.
+        std::uint64_t decoded_timestamp_; ///< Timestamp of the last decoded buffer. Set by decode_data.
 
-        dsp_buffer decoded_;
-        std::size_t pointer_;
+        std::atomic<std::size_t> discard_until_; ///< Samples before this position are dropped by the callback.
+        std::atomic<std::uint64_t> played_timestamp_; ///< Timestamp of the buffer being played.
+        std::atomic<std::uint64_t> underrun_count_;
+
+        std::uint32_t pending_copied_notifies_; ///< Audio thread only.
 
         std::int16_t last_frame_[2];
         std::mutex callback_lock_;
 
-        bool virtual_stop;
-        
+        std::atomic<bool> virtual_stop;
+
+        std::thread decode_thread_;
+        std::mutex decode_lock_;
+        std::condition_variable decode_cond_; ///< Signalled when there is work, or when the worker should look again.
+        std::condition_variable decode_idle_cond_; ///< Signalled when the worker finishes a buffer.
+
+        std::deque<dsp_buffer> decode_queue_; ///< Compressed buffers waiting to be decoded, or PCM16 ones waiting for room.
+        std::vector<dsp_buffer> decode_free_buffers_; ///< Recycled storage for the decode queue.
+        std::uint64_t decode_generation_; ///< Bumped on flush, so the worker drops what it is decoding.
+
+        bool decode_busy_;
+        bool decode_quit_;
+
+        std::atomic<std::uint32_t> decode_ahead_ms_;
+
         virtual std::uint64_t position_non_pcm16() = 0;
 
+        /**
+         * \brief Drop the decoder state, after a flush. Called with the worker idle.
+         */
+        virtual void reset_decoder() {}
+
+        void notify_buffer_copied(const std::uint32_t count);
+        void notify_buffer_copied_now();
+
+        /**
+         * \brief Put PCM16 samples to the ring, as one buffer.
+         *
+         * \returns False if the ring or the marker queue has no room for it.
+         */
+        bool queue_samples(const std::int16_t *samples, const std::size_t sample_count);
+        std::size_t decode_ahead_samples() const;
+
+        void decode_worker_loop();
+
+        /**
+         * \brief Drop all buffers waiting for decode, and wait until the worker is idle.
+         */
+        void flush_decode_worker();
+
+        /**
+         * \brief Stop and join the decode worker.
+         *
+         * Backends must call this in their destructor before freeing the decoder.
+         */
+        void stop_decode_worker();
+
     public:
         explicit dsp_output_stream_shared(drivers::audio_driver *aud);
         ~dsp_output_stream_shared() override;
 
-        virtual void decode_data(dsp_buffer &original, std::vector<std::uint8_t> &dest) = 0;
+        /**
+         * \brief Decode a buffer of the current format to PCM16.
+         *
+         * This is called from the decode worker thread, one buffer at a time. Never called for PCM16.
+         */
+        virtual void decode_data(const std::uint8_t *data, const std::uint32_t data_size, std::vector<std::uint8_t> &dest) = 0;
         std::size_t data_callback(std::int16_t *buffer, const std::size_t frame_count);
 
         bool write(const std::uint8_t *data, const std::uint32_t data_size) override;
@@ -68,5 +141,14 @@ namespace eka2l1::drivers {
         virtual bool stop() override;
 
         std::uint64_t position() override;
+
+        void decode_ahead(const std::uint32_t duration_ms) override;
+
+        /**
+         * \brief Get the number of times the backend asked for samples, and not enough were there.
+         */
+        std::uint64_t underrun_count() const {
+            return underrun_count_.load(std::memory_order_relaxed);
+        }
     };
 }
\ No newline at end of file
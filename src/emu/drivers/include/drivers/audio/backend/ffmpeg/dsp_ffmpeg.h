@@ -23,15 +23,37 @@
 
 extern "C" {
 #include <libavcodec/avcodec.h>
+#include <libswresample/swresample.h>
 }
 
 namespace eka2l1::drivers {
     struct dsp_output_stream_ffmpeg : public dsp_output_stream_shared {
     protected:
         AVCodecContext *codec_;
-        std::uint64_t timestamp_in_base_;
+        AVFrame *frame_;
+        bool codec_opened_;
+
+        // Stream properties the decoder was opened with
+        std::uint32_t codec_channels_;
+        std::uint32_t codec_freq_;
+
+        // Resampler is kept for the whole stream, and only rebuilt when the formats change
+        SwrContext *swr_;
+        std::uint64_t swr_in_layout_;
+        int swr_in_format_;
+        int swr_in_rate_;
+        std::uint32_t swr_out_channels_;
+        std::uint32_t swr_out_rate_;
 
         std::uint64_t position_non_pcm16() override;
+        void reset_decoder() override;
+
+        /**
+         * \brief Open the decoder, or open it again if the stream properties have changed since.
+         */
+        bool open_codec();
+        bool prepare_resampler(const AVFrame *frame);
+        void append_frame(const AVFrame *frame, std::vector<std::uint8_t> &dest);
 
     public:
         explicit dsp_output_stream_ffmpeg(drivers::audio_driver *aud);
@@ -40,6 +62,6 @@ namespace eka2l1::drivers {
         bool format(const four_cc fmt) override;
 
         void get_supported_formats(std::vector<four_cc> &cc_list) override;
-        void decode_data(dsp_buffer &original, std::vector<std::uint8_t> &dest) override;
+        void decode_data(const std::uint8_t *data, const std::uint32_t data_size, std::vector<std::uint8_t> &dest) override;
     };
 }
\ No newline at end of file
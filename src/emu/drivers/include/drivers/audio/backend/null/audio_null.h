@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <drivers/audio/audio.h>
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace eka2l1::drivers {
+    /**
+     * \brief Output stream that pulls samples at the stream rate and throws them away.
+     * 
+     * Pacing is kept to the sample rate so that guest code waiting on buffer completion sees
+     * the same timing it would see with a real backend.
+     */
+    struct null_audio_output_stream : public audio_output_stream {
+    private:
+        std::uint32_t sample_rate_;
+        std::uint8_t channels_;
+        data_callback callback_;
+
+        std::unique_ptr<std::thread> consumer_;
+        std::atomic<bool> playing_;
+        std::vector<std::int16_t> scratch_;
+
+        void consume_loop();
+        void join_consumer();
+
+    public:
+        explicit null_audio_output_stream(const std::uint32_t sample_rate, const std::uint8_t channels,
+            data_callback callback);
+
+        ~null_audio_output_stream() override;
+
+        bool start() override;
+        bool stop() override;
+
+        bool is_playing() override;
+
+        bool set_volume(const float volume) override;
+    };
+
+    struct null_audio_driver : public audio_driver {
+    public:
+        std::unique_ptr<audio_output_stream> new_output_stream(const std::uint32_t sample_rate,
+            const std::uint8_t channels, data_callback callback) override;
+        std::uint32_t native_sample_rate() override;
+    };
+}
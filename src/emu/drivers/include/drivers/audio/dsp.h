@@ -115,6 +115,15 @@ namespace eka2l1::drivers {
         virtual std::uint32_t max_volume() const {
             return 100;
         }
+
+        /**
+         * \brief Set how much decoded audio the stream may keep ahead of playback.
+         *
+         * Only meaningful for streams that decode compressed formats.
+         *
+         * \param duration_ms      Decode-ahead duration, in milliseconds.
+         */
+        virtual void decode_ahead(const std::uint32_t duration_ms) {}
     };
 
     enum dsp_stream_backend {
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <drivers/audio/audio.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace eka2l1::drivers {
+    class audio_mixer;
+
+    /**
+     * \brief Stream handed out by the mixer driver.
+     * 
+     * It has no device stream of its own. The mixer pulls samples from its callback, converts them
+     * to the output rate and adds them to the final mix.
+     */
+    struct mixer_output_stream : public audio_output_stream {
+    private:
+        friend class audio_mixer;
+
+        audio_mixer *mixer_;
+        data_callback callback_;
+
+        std::uint32_t sample_rate_;
+        std::uint8_t channels_;
+
+        std::atomic<bool> playing_;
+        std::atomic<bool> reset_requested_;
+        std::atomic<float> volume_;
+
+        std::mutex render_lock_; ///< Held by the mix while it calls back into this stream.
+        std::atomic<std::thread::id> render_thread_;
+
+        // Only touched by the thread doing the mix
+        std::vector<std::int16_t> pull_buffer_;
+        std::vector<float> pending_; ///< Stereo frames pulled from the callback. The first one is history for interpolation.
+        double position_; ///< Position of the next output frame in pending_, in input frames.
+
+    public:
+        explicit mixer_output_stream(audio_mixer *mixer, const std::uint32_t sample_rate, const std::uint8_t channels,
+            data_callback callback);
+
+        ~mixer_output_stream() override;
+
+        bool start() override;
+
+        /**
+         * \brief Stop pulling from the callback.
+         * 
+         * Returns once no mix is running the callback anymore, unless called from the callback itself.
+         */
+        bool stop() override;
+
+        bool is_playing() override;
+
+        bool set_volume(const float volume) override;
+    };
+
+    /**
+     * \brief Mix many streams into one stereo signed 16-bit stream.
+     * 
+     * The mixer has no device. Something has to call mix() to pull the result, which is usually the
+     * callback of one backend stream, but can also be a test.
+     */
+    class audio_mixer {
+        std::mutex streams_lock_;
+        std::vector<mixer_output_stream *> streams_;
+
+        std::uint32_t output_rate_;
+
+        std::vector<float> mix_buffer_;
+        std::vector<float> stream_buffer_;
+
+        audio_stream_stats stats_; ///< Guarded by streams_lock_.
+
+        void pull(mixer_output_stream &stream, const std::size_t frame_count);
+        void render_stream(mixer_output_stream &stream, const std::size_t frame_count);
+
+    public:
+        static constexpr std::uint8_t OUTPUT_CHANNELS = 2;
+
+        explicit audio_mixer(const std::uint32_t output_rate);
+
+        void add_stream(mixer_output_stream *stream);
+        void remove_stream(mixer_output_stream *stream);
+
+        std::uint32_t output_rate() const {
+            return output_rate_;
+        }
+
+        /**
+         * \brief Mix all playing streams.
+         * 
+         * \param output        Destination for interleaved stereo samples.
+         * \param frame_count   Number of frames to produce.
+         * 
+         * \returns Number of frames written, which is always frame_count.
+         */
+        std::size_t mix(std::int16_t *output, const std::size_t frame_count);
+
+        /**
+         * \brief Get counters of the callbacks of all streams, summed.
+         * 
+         * An underrun is a stream callback that gave back less than asked, even if other streams
+         * filled the mix.
+         */
+        audio_stream_stats stats();
+    };
+
+    /**
+     * \brief Audio driver that routes every stream through one mixer and one backend stream.
+     */
+    struct mixer_audio_driver : public audio_driver {
+    private:
+        std::unique_ptr<audio_driver> backend_;
+        std::unique_ptr<audio_mixer> mixer_;
+        std::unique_ptr<audio_output_stream> output_;
+
+    public:
+        explicit mixer_audio_driver(std::unique_ptr<audio_driver> backend);
+        ~mixer_audio_driver() override;
+
+        std::unique_ptr<audio_output_stream> new_output_stream(const std::uint32_t sample_rate,
+            const std::uint8_t channels, data_callback callback) override;
+
+        std::uint32_t native_sample_rate() override;
+
+        /**
+         * \brief Get the driver that plays the mixed output.
+         */
+        audio_driver *backend() {
+            return backend_.get();
+        }
+
+        audio_stream_stats stats() {
+            return mixer_->stats();
+        }
+    };
+}
@@ -19,6 +19,8 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 
 namespace eka2l1::drivers {
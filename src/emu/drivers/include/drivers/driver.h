@@ -21,31 +21,79 @@
 #pragma once
 
 #include <common/queue.h>
+
 #include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
 
 namespace eka2l1::drivers {
-    static constexpr std::uint32_t MAX_COMMAND_DATA_SIZE = 80;
+    static constexpr std::size_t COMMAND_ARENA_BLOCK_SIZE = 0x10000;
+
+    /**
+     * \brief Linear allocator that backs a command list.
+     *
+     * Commands and their payloads are bump-allocated from big blocks. Resetting the arena
+     * rewinds all blocks without freeing them, so a recycled arena does not touch the heap
+     * in steady state. Payloads bigger than a block get their own block, which is dropped on reset.
+     */
+    class command_arena {
+        struct block {
+            std::unique_ptr<std::uint8_t[]> data_;
+            std::size_t size_;
+            std::size_t cursor_;
+        };
+
+        std::vector<block> blocks_;
+        std::vector<block> oversized_;
+        std::size_t current_;
+
+        static block make_block(const std::size_t block_size);
+
+    public:
+        explicit command_arena();
+
+        void *allocate(const std::size_t size, const std::size_t alignment = alignof(std::max_align_t));
+        void *copy(const void *source, const std::size_t size);
+
+        void reset();
+    };
+
+    /**
+     * \brief Keep reset arenas around so that new command lists can reuse their memory.
+     */
+    class command_arena_pool {
+        std::vector<std::unique_ptr<command_arena>> free_;
+        std::mutex lock_;
+
+    public:
+        std::size_t max_free_count_ = 16;
+
+        std::unique_ptr<command_arena> acquire();
+        void release(std::unique_ptr<command_arena> arena);
+    };
 
     /**
      * \brief Represent a command for driver.
+     *
+     * The command's arguments are packed right after the command itself, in the arena
+     * of the list that owns the command.
      */
     struct command {
         std::uint16_t opcode_;
-        std::uint8_t data_[MAX_COMMAND_DATA_SIZE];
+        std::uint16_t data_size_;
+        std::uint8_t *data_;
 
         command *next_;
         int *status_;
 
-        explicit command()
-            : opcode_(0)
-            , data_()
-            , next_(nullptr)
-            , status_(nullptr) {
-        }
-
-        explicit command(const std::uint16_t opcode, int *status = nullptr)
+        explicit command(const std::uint16_t opcode, std::uint8_t *data, const std::uint16_t data_size, int *status = nullptr)
             : opcode_(opcode)
-            , data_()
+            , data_size_(data_size)
+            , data_(data)
             , next_(nullptr)
             , status_(status) {
         }
@@ -61,7 +109,7 @@ namespace eka2l1::drivers {
         }
 
         bool push(const std::uint8_t *data, const std::uint16_t data_size) {
-            if (cursor_ + data_size > MAX_COMMAND_DATA_SIZE) {
+            if (cursor_ + data_size > todo_->data_size_) {
                 // Data full, abort
                 return false;
             }
@@ -73,7 +121,7 @@ namespace eka2l1::drivers {
         }
 
         bool pop(std::uint8_t *dest, const std::uint16_t dest_size) {
-            if (cursor_ + dest_size > MAX_COMMAND_DATA_SIZE) {
+            if (cursor_ + dest_size > todo_->data_size_) {
                 // Not possible to pop, abort
                 return false;
             }
@@ -147,26 +195,56 @@ namespace eka2l1::drivers {
         }
     }
 
-    template <typename... Args>
-    command *make_command(const std::uint16_t opcode, int *status, Args... arguments) {
-        command *cmd = new command(opcode, status);
-        command_helper helper(cmd);
-
-        if constexpr (sizeof...(Args) > 0)
-            push_arguments(helper, arguments...);
-
-        return cmd;
-    }
-
     /**
-     * \brief A linked list of command.
+     * \brief A linked list of command, living in a command arena.
+     *
+     * The list owns the arena. Moving the list moves the storage of all its commands and payloads.
      */
     struct command_list {
         command *first_;
         command *last_;
 
+        std::unique_ptr<command_arena> arena_;
+
         explicit command_list()
-            : first_(nullptr) {
+            : first_(nullptr)
+            , last_(nullptr) {
+        }
+
+        command_list(command_list &&other)
+            : first_(other.first_)
+            , last_(other.last_)
+            , arena_(std::move(other.arena_)) {
+            other.first_ = nullptr;
+            other.last_ = nullptr;
+        }
+
+        command_list &operator=(command_list &&other) {
+            first_ = other.first_;
+            last_ = other.last_;
+            arena_ = std::move(other.arena_);
+
+            other.first_ = nullptr;
+            other.last_ = nullptr;
+
+            return *this;
+        }
+
+        command_arena &get_arena() {
+            if (!arena_) {
+                arena_ = std::make_unique<command_arena>();
+            }
+
+            return *arena_;
+        }
+
+        /**
+         * \brief Copy a payload into the list's storage.
+         *
+         * The copy lives until the list has been consumed by the driver.
+         */
+        void *copy_payload(const void *source, const std::size_t size) {
+            return get_arena().copy(source, size);
         }
 
         void add(command *cmd_) {
@@ -180,8 +258,38 @@ namespace eka2l1::drivers {
             last_->next_ = cmd_;
             last_ = cmd_;
         }
+
+        /**
+         * \brief Forget all commands and rewind the arena, keeping its memory for reuse.
+         */
+        void reset() {
+            first_ = nullptr;
+            last_ = nullptr;
+
+            if (arena_) {
+                arena_->reset();
+            }
+        }
     };
 
+    template <typename... Args>
+    command *make_command(command_list &list, const std::uint16_t opcode, int *status, Args... arguments) {
+        constexpr std::size_t data_size = (sizeof(Args) + ... + 0);
+        static_assert(data_size <= 0xFFFF, "Command arguments are too large");
+
+        std::uint8_t *mem = reinterpret_cast<std::uint8_t *>(list.get_arena().allocate(sizeof(command) + data_size,
+            alignof(command)));
+
+        command *cmd = new (mem) command(opcode, mem + sizeof(command), static_cast<std::uint16_t>(data_size), status);
+        command_helper helper(cmd);
+
+        if constexpr (sizeof...(Args) > 0)
+            push_arguments(helper, arguments...);
+
+        list.add(cmd);
+        return cmd;
+    }
+
     class driver {
     public:
         std::mutex mut_;
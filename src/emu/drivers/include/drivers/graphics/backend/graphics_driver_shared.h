@@ -57,6 +57,8 @@ namespace eka2l1::drivers {
         std::vector<bitmap_ptr> bmp_textures;
         std::vector<graphics_object_instance> graphic_objects;
 
+        command_arena_pool arena_pool;
+
         bitmap *binding;
         bitmap *get_bitmap(const drivers::handle h);
 
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <drivers/graphics/common.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace eka2l1::drivers {
+    /**
+     * \brief Blend state of the software rasterizer.
+     *
+     * Mirrors the subset of fixed-function blending that the graphics command builder exposes.
+     */
+    struct software_blend_state {
+        bool enabled_ = false;
+
+        blend_equation rgb_equation_ = blend_equation::add;
+        blend_equation a_equation_ = blend_equation::add;
+
+        blend_factor rgb_frag_out_factor_ = blend_factor::one;
+        blend_factor rgb_current_factor_ = blend_factor::zero;
+        blend_factor a_frag_out_factor_ = blend_factor::one;
+        blend_factor a_current_factor_ = blend_factor::zero;
+    };
+
+    /**
+     * \brief Pack four 8-bit channels into a software pixel.
+     *
+     * Software pixels are stored as R, G, B, A bytes in memory order.
+     */
+    inline std::uint32_t make_software_pixel(const std::uint8_t r, const std::uint8_t g, const std::uint8_t b, const std::uint8_t a) {
+        const std::uint8_t bytes[4] = { r, g, b, a };
+        std::uint32_t result = 0;
+
+        std::memcpy(&result, bytes, sizeof(result));
+        return result;
+    }
+
+    /**
+     * \brief Compose a row of pixels on top of the destination.
+     *
+     * Each source pixel is multiplied with the tint color and, if present, with the mask pixel, then blended
+     * into the destination with the given state. When blending is disabled, the result is written as is.
+     *
+     * \param dest          Destination row.
+     * \param source        Source row.
+     * \param mask          Mask row. Can be null.
+     * \param count         Number of pixels to compose.
+     * \param tint          Tint pixel, multiplied with each source pixel. Use 0xFFFFFFFF for no tint.
+     * \param invert_mask   Use (1 - mask) instead of the mask.
+     * \param state         The blend state.
+     */
+    void software_blit_row(std::uint32_t *dest, const std::uint32_t *source, const std::uint32_t *mask, const std::size_t count,
+        const std::uint32_t tint, const bool invert_mask, const software_blend_state &state);
+
+    /**
+     * \brief Compose a row of pixels without the SIMD kernels.
+     *
+     * Gives the same result as software_blit_row, and is its reference. Useful to check the SIMD path against.
+     *
+     * \see software_blit_row
+     */
+    void software_blit_row_scalar(std::uint32_t *dest, const std::uint32_t *source, const std::uint32_t *mask, const std::size_t count,
+        const std::uint32_t tint, const bool invert_mask, const software_blend_state &state);
+
+    /**
+     * \brief Fill a row with a color, blending it with the destination.
+     */
+    void software_fill_row(std::uint32_t *dest, const std::uint32_t color, const std::size_t count, const software_blend_state &state);
+}
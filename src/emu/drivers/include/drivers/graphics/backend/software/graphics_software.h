@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <drivers/graphics/backend/software/blit_software.h>
+#include <drivers/graphics/graphics.h>
+
+#include <common/queue.h>
+#include <common/thread.h>
+#include <common/vecx.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace eka2l1::drivers {
+    /**
+     * \brief A bitmap living in host memory.
+     *
+     * Pixels are kept in RGBA order. The swizzle is applied when the bitmap is sampled.
+     */
+    struct software_bitmap {
+        eka2l1::vec2 size;
+        std::vector<std::uint32_t> pixels;
+        channel_swizzles swizzle;
+
+        explicit software_bitmap(const eka2l1::vec2 &initial_size = { 0, 0 });
+
+        void resize(const eka2l1::vec2 &new_size);
+        bool has_identity_swizzle() const;
+
+        std::uint32_t *row(const int y) {
+            return pixels.data() + y * size.x;
+        }
+
+        const std::uint32_t *row(const int y) const {
+            return pixels.data() + y * size.x;
+        }
+    };
+
+    using software_bitmap_ptr = std::unique_ptr<software_bitmap>;
+
+    /**
+     * \brief Rasterizer state kept by the backup and restore commands.
+     *
+     * Same set as the GL backend keeps: blending, viewport and scissor.
+     */
+    struct software_state_backup {
+        software_blend_state blend_state;
+
+        bool clipping = false;
+        eka2l1::rect clip;
+        eka2l1::rect viewport;
+    };
+
+    /**
+     * \brief Graphics driver that rasterizes everything on the CPU.
+     *
+     * Executes the immediate 2D command set (bitmap, clear, clip, blend, swizzle and rectangle drawing) into
+     * host memory. Big blits are split into bands of rows and composed on a pool of worker threads.
+     *
+     * Programs, textures, buffers and stencil/depth operations are not supported. Creation of these objects fails.
+     */
+    class software_graphics_driver : public graphics_driver {
+        eka2l1::request_queue<server_graphics_command_list> list_queue;
+        command_arena_pool arena_pool;
+
+        std::vector<software_bitmap_ptr> bmp_textures;
+        software_bitmap swapchain;
+        software_bitmap *binding;
+
+        common::thread_pool blit_pool;
+
+        eka2l1::vecx<float, 4> brush_color;
+        software_blend_state blend_state;
+
+        bool clipping;
+        eka2l1::rect clip;
+        eka2l1::rect viewport;
+
+        software_state_backup backup;
+
+        std::atomic_bool should_stop;
+        bool warned_unsupported;
+
+        software_bitmap *get_bitmap(const drivers::handle h);
+        eka2l1::rect get_target_area();
+
+        void run_bands(const int row_count, const std::size_t pixel_count, std::function<void(int, int)> func);
+        void warn_unsupported(const std::uint16_t opcode);
+
+        void create_bitmap(command_helper &helper);
+        void bind_bitmap(command_helper &helper);
+        void update_bitmap(command_helper &helper);
+        void resize_bitmap(command_helper &helper);
+        void destroy_bitmap(command_helper &helper);
+        void draw_bitmap(command_helper &helper);
+        void draw_rectangle(command_helper &helper);
+        void clear(command_helper &helper);
+        void set_brush_color(command_helper &helper);
+        void set_clipping(command_helper &helper);
+        void clip_rect(command_helper &helper);
+        void set_blend(command_helper &helper);
+        void blend_formula(command_helper &helper);
+        void set_swizzle(command_helper &helper);
+        void set_swapchain_size(command_helper &helper);
+        void set_viewport(command_helper &helper);
+        void display(command_helper &helper);
+        void backup_state();
+        void restore_state();
+        void fail_creation(command_helper &helper);
+
+    public:
+        /**
+         * \brief Create the software driver.
+         *
+         * \param worker_count Number of blitting threads. Use 0 to use one per host core.
+         */
+        explicit software_graphics_driver(const std::size_t worker_count = 0);
+        ~software_graphics_driver() override {}
+
+        void update_bitmap(drivers::handle h, const std::size_t size, const eka2l1::vec2 &offset,
+            const eka2l1::vec2 &dim, const int bpp, const void *data, const std::size_t pixels_per_line = 0) override;
+
+        void attach_descriptors(drivers::handle h, const int stride, const bool instance_move, const attribute_descriptor *descriptors,
+            const int descriptor_count) override;
+
+        void set_viewport(const eka2l1::rect &viewport) override;
+
+        std::unique_ptr<graphics_command_list> new_command_list() override;
+        std::unique_ptr<graphics_command_list_builder> new_command_builder(graphics_command_list *list) override;
+        void submit_command_list(graphics_command_list &command_list) override;
+
+        void run() override;
+        void abort() override;
+
+        void dispatch(command *cmd);
+
+        /**
+         * \brief Get the image the swapchain holds.
+         *
+         * Only safe to access from the graphics driver thread, for example inside the display hook.
+         */
+        const software_bitmap &get_swapchain_image() const {
+            return swapchain;
+        }
+    };
+}
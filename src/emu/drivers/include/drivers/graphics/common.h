@@ -31,7 +31,8 @@ namespace eka2l1::drivers {
 
     enum class graphic_api {
         opengl,
-        vulkan
+        vulkan,
+        software
     };
 
     class graphics_object {
@@ -142,7 +143,8 @@ namespace eka2l1::drivers {
     };
 
     enum class window_api {
-        glfw
+        glfw,
+        null
     };
 
     using channel_swizzles = std::array<channel_swizzle, 4>;
@@ -130,7 +130,8 @@ namespace eka2l1::drivers {
         /**
          * \brief Submit a command list.
          * 
-         * The list object will be copied within the function, and can be safely delete after.
+         * The storage of the list is taken over by the driver, and will be recycled once the list has been executed.
+         * The list object is left empty after the call, and can be safely deleted or reused.
          *
          * \param command_list     Command list to submit.
          */
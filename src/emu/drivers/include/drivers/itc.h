@@ -111,8 +111,12 @@ namespace eka2l1::drivers {
     bool open_native_dialog(graphics_driver *driver, const char *filter, drivers::graphics_driver_dialog_callback callback, const bool is_folder = false);
 
     struct graphics_command_list {
+        virtual ~graphics_command_list() {}
     };
 
+    /**
+     * \brief Command list whose commands and payloads are packed in an arena.
+     */
     struct server_graphics_command_list : public graphics_command_list {
         command_list list_;
     };
@@ -185,6 +189,22 @@ namespace eka2l1::drivers {
             const eka2l1::vec2 &offset, const eka2l1::vec2 &dim, const std::size_t pixels_per_line = 0)
             = 0;
 
+        /**
+         * \brief Update a bitmap's data without copying it into the command list.
+         *
+         * The data is referenced by pointer, and must stay alive and unchanged until the fence is signaled.
+         * Wait on the fence with graphics_driver::wait_for before reusing the memory.
+         *
+         * Use this for big uploads, where the copy costs more than the wait.
+         *
+         * \param fence             Pointer to the fence status. Can be null if the data outlives the driver.
+         *
+         * \see update_bitmap
+         */
+        virtual void update_bitmap_no_copy(drivers::handle h, const int bpp, const char *data, const std::size_t size,
+            const eka2l1::vec2 &offset, const eka2l1::vec2 &dim, int *fence, const std::size_t pixels_per_line = 0)
+            = 0;
+
         /**
          * \brief Draw a bitmap to currently binded bitmap.
          *
@@ -422,6 +442,9 @@ namespace eka2l1::drivers {
         void update_bitmap(drivers::handle h, const int bpp, const char *data, const std::size_t size, const eka2l1::vec2 &offset,
             const eka2l1::vec2 &dim, const std::size_t pixels_per_line = 0) override;
 
+        void update_bitmap_no_copy(drivers::handle h, const int bpp, const char *data, const std::size_t size, const eka2l1::vec2 &offset,
+            const eka2l1::vec2 &dim, int *fence, const std::size_t pixels_per_line = 0) override;
+
         void draw_bitmap(drivers::handle h, drivers::handle maskh, const eka2l1::rect &dest_rect, const eka2l1::rect &source_rect, const std::uint32_t flags = 0) override;
 
         void draw_rectangle(const eka2l1::rect &target_rect) override;
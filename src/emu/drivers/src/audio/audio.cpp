@@ -18,19 +18,42 @@
  */
 
 #include <drivers/audio/audio.h>
+#include <drivers/audio/backend/capture/audio_capture.h>
 #include <drivers/audio/backend/cubeb/audio_cubeb.h>
+#include <drivers/audio/backend/null/audio_null.h>
+#include <drivers/audio/mixer.h>
 
 namespace eka2l1::drivers {
-    std::unique_ptr<audio_driver> make_audio_driver(const audio_driver_backend backend) {
+    static std::unique_ptr<audio_driver> make_backend_audio_driver(const audio_driver_backend backend,
+        const std::string &capture_path) {
         switch (backend) {
         case audio_driver_backend::cubeb: {
             return std::make_unique<cubeb_audio_driver>();
         }
 
+        case audio_driver_backend::null: {
+            return std::make_unique<null_audio_driver>();
+        }
+
+        case audio_driver_backend::capture: {
+            return std::make_unique<capture_audio_driver>(capture_path);
+        }
+
         default:
             break;
         }
 
         return nullptr;
     }
+
+    std::unique_ptr<audio_driver> make_audio_driver(const audio_driver_backend backend, const std::string &capture_path) {
+        std::unique_ptr<audio_driver> backend_driver = make_backend_audio_driver(backend, capture_path);
+
+        if (!backend_driver) {
+            return nullptr;
+        }
+
+        // All streams share one device stream through the mixer
+        return std::make_unique<mixer_audio_driver>(std::move(backend_driver));
+    }
 }
\ No newline at end of file
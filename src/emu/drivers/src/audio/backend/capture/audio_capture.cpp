@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <common/log.h>
+#include <drivers/audio/backend/capture/audio_capture.h>
+
+#include <algorithm>
+#include <chrono>
+
+namespace eka2l1::drivers {
+    static constexpr std::uint64_t MICROSECONDS_PER_SECOND = 1000000;
+    static constexpr std::uint32_t WAV_HEADER_SIZE = 44;
+
+    capture_audio_output_stream::capture_audio_output_stream(capture_audio_driver *driver, const std::uint32_t sample_rate,
+        const std::uint8_t channels, data_callback callback)
+        : driver_(driver)
+        , sample_rate_(sample_rate)
+        , channels_(channels)
+        , callback_(callback)
+        , playing_(false)
+        , elapsed_us_(0)
+        , frames_pulled_(0) {
+        driver_->add_stream(this);
+    }
+
+    capture_audio_output_stream::~capture_audio_output_stream() {
+        driver_->remove_stream(this);
+    }
+
+    bool capture_audio_output_stream::start() {
+        if (playing_) {
+            return true;
+        }
+
+        if (!callback_ || (sample_rate_ == 0) || (channels_ == 0)) {
+            return false;
+        }
+
+        // The stream clock restarts with the stream. The driver only reads these while holding its lock.
+        const std::lock_guard<std::mutex> guard(driver_->lock_);
+
+        elapsed_us_ = 0;
+        frames_pulled_ = 0;
+        playing_ = true;
+
+        return true;
+    }
+
+    bool capture_audio_output_stream::stop() {
+        playing_ = false;
+        return true;
+    }
+
+    bool capture_audio_output_stream::is_playing() {
+        return playing_;
+    }
+
+    bool capture_audio_output_stream::set_volume(const float volume) {
+        return true;
+    }
+
+    capture_audio_driver::capture_audio_driver(const std::string &wav_path)
+        : recorded_(nullptr)
+        , wav_requested_(!wav_path.empty())
+        , wav_data_size_(0)
+        , wav_elapsed_us_(0)
+        , wav_frames_written_(0) {
+        if (wav_requested_) {
+            wav_.open(wav_path, std::ios::binary | std::ios::trunc);
+
+            if (!wav_) {
+                LOG_ERROR("Unable to open audio capture file {}", wav_path);
+            } else {
+                write_wav_header();
+            }
+        }
+    }
+
+    capture_audio_driver::~capture_audio_driver() {
+        if (wav_.is_open()) {
+            // Sizes are only known now
+            wav_.seekp(0, std::ios::beg);
+            write_wav_header();
+        }
+    }
+
+    static void write_le(std::ofstream &stream, const std::uint32_t value, const std::size_t size) {
+        char bytes[4];
+
+        for (std::size_t i = 0; i < size; i++) {
+            bytes[i] = static_cast<char>((value >> (i * 8)) & 0xFF);
+        }
+
+        stream.write(bytes, size);
+    }
+
+    void capture_audio_driver::write_wav_header() {
+        const std::uint32_t data_size = static_cast<std::uint32_t>(std::min<std::uint64_t>(wav_data_size_,
+            0xFFFFFFFF - WAV_HEADER_SIZE));
+        const std::uint32_t block_align = CAPTURE_CHANNELS * sizeof(std::int16_t);
+
+        wav_.write("RIFF", 4);
+        write_le(wav_, WAV_HEADER_SIZE - 8 + data_size, 4);
+        wav_.write("WAVE", 4);
+
+        wav_.write("fmt ", 4);
+        write_le(wav_, 16, 4);
+        write_le(wav_, 1, 2); // PCM
+        write_le(wav_, CAPTURE_CHANNELS, 2);
+        write_le(wav_, CAPTURE_SAMPLE_RATE, 4);
+        write_le(wav_, CAPTURE_SAMPLE_RATE * block_align, 4);
+        write_le(wav_, block_align, 2);
+        write_le(wav_, 16, 2);
+
+        wav_.write("data", 4);
+        write_le(wav_, data_size, 4);
+    }
+
+    void capture_audio_driver::write_wav_silence(const std::size_t frame_count) {
+        static const std::int16_t silence[256 * CAPTURE_CHANNELS] = {};
+
+        for (std::size_t left = frame_count; left != 0;) {
+            const std::size_t to_write = std::min<std::size_t>(left, 256);
+            wav_.write(reinterpret_cast<const char *>(silence), to_write * CAPTURE_CHANNELS * sizeof(std::int16_t));
+
+            left -= to_write;
+        }
+
+        wav_frames_written_ += frame_count;
+        wav_data_size_ += frame_count * CAPTURE_CHANNELS * sizeof(std::int16_t);
+    }
+
+    void capture_audio_driver::add_stream(capture_audio_output_stream *stream) {
+        const std::lock_guard<std::mutex> guard(lock_);
+        streams_.push_back(stream);
+
+        if (!recorded_ && (stream->sample_rate_ == CAPTURE_SAMPLE_RATE) && (stream->channels_ == CAPTURE_CHANNELS)) {
+            recorded_ = stream;
+        }
+    }
+
+    void capture_audio_driver::remove_stream(capture_audio_output_stream *stream) {
+        const std::lock_guard<std::mutex> guard(lock_);
+        streams_.erase(std::remove(streams_.begin(), streams_.end(), stream), streams_.end());
+
+        if (recorded_ == stream) {
+            recorded_ = nullptr;
+        }
+    }
+
+    std::size_t capture_audio_driver::pull(capture_audio_output_stream &stream, const std::size_t frame_count) {
+        const std::size_t sample_count = frame_count * stream.channels_;
+
+        if (scratch_.size() < sample_count) {
+            scratch_.resize(sample_count);
+        }
+
+        const auto callback_start = std::chrono::steady_clock::now();
+        const std::size_t frame_got = std::min(stream.callback_(scratch_.data(), frame_count), frame_count);
+        const auto callback_end = std::chrono::steady_clock::now();
+
+        const std::uint64_t callback_us = std::chrono::duration_cast<std::chrono::microseconds>(callback_end - callback_start).count();
+
+        stats_.callback_count_++;
+        stats_.frames_requested_ += frame_count;
+        stats_.frames_received_ += frame_got;
+        stats_.callback_total_us_ += callback_us;
+        stats_.callback_max_us_ = std::max(stats_.callback_max_us_, callback_us);
+
+        if (frame_got < frame_count) {
+            stats_.underrun_count_++;
+            std::fill(scratch_.begin() + frame_got * stream.channels_, scratch_.begin() + sample_count, 0);
+        }
+
+        return frame_got;
+    }
+
+    void capture_audio_driver::advance(const std::uint64_t elapsed_us) {
+        const std::lock_guard<std::mutex> guard(lock_);
+
+        wav_elapsed_us_ += elapsed_us;
+        const std::uint64_t wav_frames_target = wav_elapsed_us_ * CAPTURE_SAMPLE_RATE / MICROSECONDS_PER_SECOND;
+
+        for (capture_audio_output_stream *stream : streams_) {
+            if (!stream->playing_) {
+                continue;
+            }
+
+            // Count from the start of the stream, so rounding never accumulates
+            stream->elapsed_us_ += elapsed_us;
+
+            const std::uint64_t frames_target = stream->elapsed_us_ * stream->sample_rate_ / MICROSECONDS_PER_SECOND;
+            const std::size_t frame_count = static_cast<std::size_t>(frames_target - stream->frames_pulled_);
+
+            if (frame_count == 0) {
+                continue;
+            }
+
+            pull(*stream, frame_count);
+            stream->frames_pulled_ = frames_target;
+
+            if ((stream == recorded_) && wav_.is_open()) {
+                const std::uint64_t frames_after = wav_frames_written_ + frame_count;
+
+                if (frames_after < wav_frames_target) {
+                    // The stream started in the middle of this period
+                    write_wav_silence(static_cast<std::size_t>(wav_frames_target - frames_after));
+                }
+
+                const std::size_t byte_count = frame_count * CAPTURE_CHANNELS * sizeof(std::int16_t);
+                wav_.write(reinterpret_cast<const char *>(scratch_.data()), byte_count);
+
+                wav_frames_written_ += frame_count;
+                wav_data_size_ += byte_count;
+            }
+        }
+
+        if (wav_.is_open() && (wav_frames_written_ < wav_frames_target)) {
+            write_wav_silence(static_cast<std::size_t>(wav_frames_target - wav_frames_written_));
+        }
+    }
+
+    bool capture_audio_driver::is_capture_valid() const {
+        return !wav_requested_ || (wav_.is_open() && wav_.good());
+    }
+
+    audio_stream_stats capture_audio_driver::stats() {
+        const std::lock_guard<std::mutex> guard(lock_);
+        return stats_;
+    }
+
+    std::unique_ptr<audio_output_stream> capture_audio_driver::new_output_stream(const std::uint32_t sample_rate,
+        const std::uint8_t channels, data_callback callback) {
+        return std::make_unique<capture_audio_output_stream>(this, sample_rate, channels, callback);
+    }
+
+    std::uint32_t capture_audio_driver::native_sample_rate() {
+        return CAPTURE_SAMPLE_RATE;
+    }
+}
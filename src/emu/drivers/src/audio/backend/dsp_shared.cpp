@@ -18,26 +18,152 @@
  */
 
 #include <common/log.h>
+#include <common/profile.h>
 #include <drivers/audio/backend/dsp_shared.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <limits>
+
 namespace eka2l1::drivers {
     dsp_output_stream_shared::dsp_output_stream_shared(drivers::audio_driver *aud)
         : aud_(aud)
-        , pointer_(0)
-        , virtual_stop(true) {
+        , decoded_timestamp_(0)
+        , discard_until_(0)
+        , played_timestamp_(0)
+        , underrun_count_(0)
+        , pending_copied_notifies_(0)
+        , virtual_stop(true)
+        , decode_generation_(0)
+        , decode_busy_(false)
+        , decode_quit_(false)
+        , decode_ahead_ms_(DEFAULT_DECODE_AHEAD_MS) {
         last_frame_[0] = 0;
         last_frame_[1] = 0;
     }
 
     dsp_output_stream_shared::~dsp_output_stream_shared() {
+        // The backend stream calls into the sample ring, which is destroyed before it otherwise
         if (stream_) {
             stream_->stop();
+            stream_.reset();
+        }
+
+        stop_decode_worker();
+    }
+
+    void dsp_output_stream_shared::decode_ahead(const std::uint32_t duration_ms) {
+        decode_ahead_ms_ = duration_ms;
+
+        // The worker may be waiting with a different target
+        decode_cond_.notify_one();
+    }
+
+    std::size_t dsp_output_stream_shared::decode_ahead_samples() const {
+        const std::uint32_t duration_ms = decode_ahead_ms_.load(std::memory_order_relaxed);
+
+        if (duration_ms == 0) {
+            // No limit, decode as soon as there is room
+            return std::numeric_limits<std::size_t>::max();
+        }
+
+        const std::size_t target = static_cast<std::size_t>(freq_) * channels_ * duration_ms / 1000;
+        return std::min(std::max<std::size_t>(target, channels_), samples_.capacity());
+    }
+
+    void dsp_output_stream_shared::decode_worker_loop() {
+        const auto poll_interval = std::chrono::milliseconds(DECODE_POLL_INTERVAL_MS);
+        std::unique_lock<std::mutex> guard(decode_lock_);
+
+        while (true) {
+            decode_cond_.wait(guard, [this]() { return decode_quit_ || !decode_queue_.empty(); });
+
+            if (decode_quit_) {
+                break;
+            }
+
+            if ((format_ != PCM16_FOUR_CC_CODE) && (samples_.size() >= decode_ahead_samples())) {
+                // Enough is decoded. Look again after some of it has been played.
+                decode_cond_.wait_for(guard, poll_interval);
+                continue;
+            }
+
+            dsp_buffer buffer = std::move(decode_queue_.front());
+            decode_queue_.pop_front();
+
+            const std::uint64_t generation = decode_generation_;
+            decode_busy_ = true;
+
+            guard.unlock();
+
+            if (format_ == PCM16_FOUR_CC_CODE) {
+                // Already PCM16, it only waited here for room in the ring
+                std::swap(buffer, decoded_);
+            } else {
+                decode_data(buffer.data(), static_cast<std::uint32_t>(buffer.size()), decoded_);
+            }
+
+            const std::int16_t *samples = reinterpret_cast<const std::int16_t *>(decoded_.data());
+            std::size_t sample_count = decoded_.size() / sizeof(std::int16_t);
+
+            // Keep whole frames
+            sample_count -= sample_count % channels_;
+
+            if (sample_count == 0) {
+                notify_buffer_copied_now();
+            }
+
+            guard.lock();
+
+            if (sample_count != 0) {
+                // The audio thread frees up room as it plays. Give up if the stream is flushed meanwhile.
+                while ((generation == decode_generation_) && !decode_quit_ && !queue_samples(samples, sample_count)) {
+                    decode_cond_.wait_for(guard, poll_interval);
+                }
+            }
+
+            buffer.clear();
+            decode_free_buffers_.push_back(std::move(buffer));
+
+            decode_busy_ = false;
+            decode_idle_cond_.notify_all();
+        }
+    }
+
+    void dsp_output_stream_shared::flush_decode_worker() {
+        std::unique_lock<std::mutex> guard(decode_lock_);
+
+        for (dsp_buffer &buffer : decode_queue_) {
+            buffer.clear();
+            decode_free_buffers_.push_back(std::move(buffer));
+        }
+
+        decode_queue_.clear();
+        decode_generation_++;
+
+        decode_cond_.notify_all();
+        decode_idle_cond_.wait(guard, [this]() { return !decode_busy_; });
+
+        reset_decoder();
+    }
+
+    void dsp_output_stream_shared::stop_decode_worker() {
+        {
+            const std::lock_guard<std::mutex> guard(decode_lock_);
+            decode_quit_ = true;
+        }
+
+        decode_cond_.notify_all();
+
+        if (decode_thread_.joinable()) {
+            decode_thread_.join();
         }
     }
 
     bool dsp_output_stream_shared::set_properties(const std::uint32_t freq, const std::uint8_t channels) {
         // Doc said: Writing to the stream must have stopped before you call this function.
-        if (buffers_.size() > 0) {
+        if ((samples_.size() != 0) && (samples_.write_position() > discard_until_.load())) {
             return false;
         }
 
@@ -45,6 +171,12 @@ namespace eka2l1::drivers {
             return true;
         }
 
+        const std::lock_guard<std::mutex> decode_guard(decode_lock_);
+
+        if (decode_busy_ || !decode_queue_.empty()) {
+            return false;
+        }
+
         if (stream_) {
             stream_->stop();
             stream_.reset();
@@ -53,6 +185,13 @@ namespace eka2l1::drivers {
         channels_ = channels;
         freq_ = freq;
 
+        // The backend is gone, so the ring can be reallocated safely
+        while (markers_.pop()) {
+        }
+
+        samples_.resize(freq * channels * RING_DURATION_SECS);
+        discard_until_ = 0;
+
         stream_ = aud_->new_output_stream(freq, channels, [this](std::int16_t *buffer, const std::size_t nb_frames) {
             return data_callback(buffer, nb_frames);
         });
@@ -90,6 +229,10 @@ namespace eka2l1::drivers {
         if (!stream_)
             return true;
 
+        // Pending compressed buffers are discarded too. Do this before taking the callback lock,
+        // the worker may need it to finish.
+        flush_decode_worker();
+
         const std::lock_guard<std::mutex> guard(callback_lock_);
 
         // Call the finish callback
@@ -100,9 +243,8 @@ namespace eka2l1::drivers {
         buffer_copied_callback_ = nullptr;
         virtual_stop = true;
 
-        // Discard all buffers
-        while (auto buffer = buffers_.pop()) {
-        }
+        // Discard all buffers. Only the audio thread may read the ring, so let it drop them.
+        discard_until_.store(samples_.write_position(), std::memory_order_release);
 
         return true;
     }
@@ -144,65 +286,148 @@ namespace eka2l1::drivers {
         return nullptr;
     }
 
+    bool dsp_output_stream_shared::queue_samples(const std::int16_t *samples, const std::size_t sample_count) {
+        if ((samples_.free_space() < sample_count) || (markers_.size() >= markers_.capacity())) {
+            return false;
+        }
+
+        markers_.push(buffer_marker{ samples_.write_position(), decoded_timestamp_ });
+        samples_.write(samples, sample_count);
+
+        return true;
+    }
+
     bool dsp_output_stream_shared::write(const std::uint8_t *data, const std::uint32_t data_size) {
-        // Copy buffer to queue
+        if (samples_.capacity() == 0) {
+            // Properties have not been set yet
+            return false;
+        }
+
+        const bool is_pcm16 = (format_ == PCM16_FOUR_CC_CODE);
+        std::size_t sample_count = 0;
+
+        if (is_pcm16) {
+            sample_count = data_size / sizeof(std::int16_t);
+
+            // Keep whole frames
+            sample_count -= sample_count % channels_;
+
+            if (sample_count == 0) {
+                // Nothing will be played from this buffer, so it is done with right away
+                notify_buffer_copied_now();
+                return true;
+            }
+        }
+
+        const std::lock_guard<std::mutex> guard(decode_lock_);
+
+        // PCM16 goes straight to the ring, unless earlier buffers are still waiting for room
+        if (is_pcm16 && decode_queue_.empty() && !decode_busy_
+            && queue_samples(reinterpret_cast<const std::int16_t *>(data), sample_count)) {
+            return true;
+        }
+
+        // Hand it to the worker, which decodes compressed data and waits for room in the ring.
+        // Neither this thread nor the audio thread has to. The buffer counts as copied once it plays.
+        if (!decode_thread_.joinable()) {
+            decode_thread_ = std::thread([this]() { decode_worker_loop(); });
+        }
+
         dsp_buffer buffer;
-        buffer.resize(data_size);
 
-        std::memcpy(&buffer[0], data, data_size);
+        if (!decode_free_buffers_.empty()) {
+            buffer = std::move(decode_free_buffers_.back());
+            decode_free_buffers_.pop_back();
+        }
 
-        // Push it to the queue
-        buffers_.push(buffer);
+        buffer.assign(data, data + (is_pcm16 ? sample_count * sizeof(std::int16_t) : data_size));
+        decode_queue_.push_back(std::move(buffer));
 
+        decode_cond_.notify_one();
         return true;
     }
 
+    void dsp_output_stream_shared::notify_buffer_copied_now() {
+        const std::lock_guard<std::mutex> guard(callback_lock_);
+
+        if (buffer_copied_callback_) {
+            buffer_copied_callback_(buffer_copied_userdata_);
+        }
+    }
+
+    void dsp_output_stream_shared::notify_buffer_copied(const std::uint32_t count) {
+        pending_copied_notifies_ += count;
+
+        if (pending_copied_notifies_ == 0) {
+            return;
+        }
+
+        // Never wait on the audio thread. If someone else has the lock, notify next time.
+        std::unique_lock<std::mutex> guard(callback_lock_, std::try_to_lock);
+
+        if (!guard.owns_lock()) {
+            return;
+        }
+
+        if (buffer_copied_callback_) {
+            for (; pending_copied_notifies_ > 0; pending_copied_notifies_--) {
+                buffer_copied_callback_(buffer_copied_userdata_);
+            }
+        }
+
+        pending_copied_notifies_ = 0;
+    }
+
     std::size_t dsp_output_stream_shared::data_callback(std::int16_t *buffer, const std::size_t frame_count) {
-        std::size_t frame_wrote = 0;
+        EKA2L1_PROFILE_SCOPE("audio", "DSP output callback");
 
-        while (frame_wrote < frame_count) {
-            std::optional<dsp_buffer> encoded;
+        // Drop what was discarded by stop
+        const std::size_t discard_until = discard_until_.load(std::memory_order_acquire);
+        const std::size_t read_pos = samples_.read_position();
 
-            if ((decoded_.size() == 0) || (decoded_.size() == pointer_)) {
-                encoded = buffers_.pop();
+        if (discard_until > read_pos) {
+            samples_.skip(discard_until - read_pos);
 
-                if (!encoded) {
+            while (buffer_marker *marker = markers_.front()) {
+                if (marker->start_ >= discard_until) {
                     break;
                 }
 
-                // Callback that internal buffer has been copied
-                {
-                    const std::lock_guard<std::mutex> guard(callback_lock_);
-                    if (buffer_copied_callback_) {
-                        buffer_copied_callback_(buffer_copied_userdata_);
-                    }
-                }
+                markers_.pop();
+            }
+        }
 
-                pointer_ = 0;
+        const std::size_t frame_wrote = samples_.read(buffer, frame_count * channels_) / channels_;
+        const std::size_t new_read_pos = samples_.read_position();
 
-                if (format_ == PCM16_FOUR_CC_CODE) {
-                    decoded_ = encoded.value();
-                } else {
-                    decode_data(encoded.value(), decoded_);
-                }
+        // Every buffer that started playing counts as copied
+        std::uint32_t copied_count = 0;
+
+        while (buffer_marker *marker = markers_.front()) {
+            if (marker->start_ >= new_read_pos) {
+                break;
             }
 
-            // We want to decode more
-            std::size_t frame_to_wrote = ((decoded_.size() - pointer_) / channels_ / sizeof(std::int16_t));
-            frame_to_wrote = std::min<std::size_t>(frame_to_wrote, frame_count - frame_wrote);
+            played_timestamp_.store(marker->timestamp_, std::memory_order_relaxed);
+            markers_.pop();
 
-            std::memcpy(&buffer[frame_wrote * channels_], &decoded_[pointer_], frame_to_wrote * channels_ * sizeof(std::int16_t));
+            copied_count++;
+        }
+
+        notify_buffer_copied(copied_count);
 
+        if (frame_wrote != 0) {
             // Set last frame
-            std::memcpy(last_frame_, &decoded_[pointer_ + (frame_to_wrote - 1) * channels_ * sizeof(std::int16_t)], channels_ * sizeof(std::int16_t));
+            std::memcpy(last_frame_, &buffer[(frame_wrote - 1) * channels_], channels_ * sizeof(std::int16_t));
+        }
 
-            pointer_ += frame_to_wrote * channels_ * sizeof(std::int16_t);
-            frame_wrote += frame_to_wrote;
+        if ((frame_wrote < frame_count) && !virtual_stop) {
+            underrun_count_.fetch_add(1, std::memory_order_relaxed);
         }
 
-        for (; frame_wrote < frame_count; frame_wrote++) {
+        for (std::size_t i = frame_wrote; i < frame_count; i++) {
             // We dont want to drain the audio driver, so fill it with last frame
-            std::memcpy(&buffer[frame_wrote * channels_], last_frame_, channels_ * sizeof(std::int16_t));
+            std::memcpy(&buffer[i * channels_], last_frame_, channels_ * sizeof(std::int16_t));
         }
 
         // TODO: What? Is this right
@@ -23,9 +23,7 @@
 #include <common/algorithm.h>
 #include <common/log.h>
 
-extern "C" {
-#include <libswresample/swresample.h>
-}
+#include <cstring>
 
 namespace eka2l1::drivers {
     static std::map<four_cc, AVCodecID> FOUR_CC_TO_FFMPEG_CODEC_MAP = {
@@ -38,11 +36,32 @@ namespace eka2l1::drivers {
     dsp_output_stream_ffmpeg::dsp_output_stream_ffmpeg(drivers::audio_driver *aud)
         : dsp_output_stream_shared(aud)
         , codec_(nullptr)
-        , timestamp_in_base_(0) {
+        , frame_(nullptr)
+        , codec_opened_(false)
+        , codec_channels_(0)
+        , codec_freq_(0)
+        , swr_(nullptr)
+        , swr_in_layout_(0)
+        , swr_in_format_(AV_SAMPLE_FMT_NONE)
+        , swr_in_rate_(0)
+        , swr_out_channels_(0)
+        , swr_out_rate_(0) {
+        frame_ = av_frame_alloc();
         format(PCM16_FOUR_CC_CODE);
     }
 
     dsp_output_stream_ffmpeg::~dsp_output_stream_ffmpeg() {
+        // The worker may still be using the codec
+        stop_decode_worker();
+
+        if (swr_) {
+            swr_free(&swr_);
+        }
+
+        if (frame_) {
+            av_frame_free(&frame_);
+        }
+
         if (codec_) {
             avcodec_free_context(&codec_);
         }
@@ -62,6 +81,15 @@ namespace eka2l1::drivers {
             return false;
         }
 
+        // Buffers of the old format must not reach the new decoder
+        flush_decode_worker();
+
+        if (codec_ && (codec_->codec_id == find_result->second)) {
+            // Same decoder, the flush has reset it already
+            format_ = fmt;
+            return true;
+        }
+
         AVCodec *decoder = avcodec_find_decoder(find_result->second);
 
         if (!decoder) {
@@ -69,67 +97,183 @@ namespace eka2l1::drivers {
             return false;
         }
 
-        codec_ = avcodec_alloc_context3(decoder);
+        AVCodecContext *new_codec = avcodec_alloc_context3(decoder);
 
-        if (!codec_) {
+        if (!new_codec) {
             LOG_ERROR("Can't alloc decode context!");
             return false;
         }
 
+        if (codec_) {
+            avcodec_free_context(&codec_);
+        }
+
+        codec_ = new_codec;
+        codec_opened_ = false;
+
         format_ = fmt;
         return true;
     }
 
-    void dsp_output_stream_ffmpeg::decode_data(dsp_buffer &original, std::vector<std::uint8_t> &dest) {
-        AVPacket packet;
-        av_init_packet(&packet);
+    bool dsp_output_stream_ffmpeg::open_codec() {
+        if (codec_opened_) {
+            if ((codec_channels_ == channels_) && (codec_freq_ == freq_)) {
+                return true;
+            }
+
+            // The layout is only read on open, so start over with a fresh context of the same decoder
+            AVCodecContext *new_codec = avcodec_alloc_context3(codec_->codec);
 
-        packet.size = original.size();
-        packet.data = original.data();
+            if (!new_codec) {
+                LOG_ERROR("Can't alloc decode context!");
+                return false;
+            }
+
+            avcodec_free_context(&codec_);
 
-        if (avcodec_send_packet(codec_, &packet) >= 0) {
-            AVFrame *frame = av_frame_alloc();
+            codec_ = new_codec;
+            codec_opened_ = false;
 
-            if (avcodec_receive_frame(codec_, frame) < 0) {
-                av_frame_free(&frame);
-                return;
+            // Samples buffered in the resampler are of the old layout
+            if (swr_) {
+                swr_free(&swr_);
             }
+        }
+
+        // Raw PCM carries no header, so the decoder must be told the layout
+        if (codec_->channels == 0) {
+            codec_->channels = channels_;
+            codec_->channel_layout = av_get_default_channel_layout(channels_);
+        }
+
+        if (codec_->sample_rate == 0) {
+            codec_->sample_rate = freq_;
+        }
+
+        if (avcodec_open2(codec_, codec_->codec, nullptr) < 0) {
+            LOG_ERROR("Unable to open decoder!");
+            return false;
+        }
+
+        codec_opened_ = true;
+        codec_channels_ = channels_;
+        codec_freq_ = freq_;
 
-            dest.resize(2 * frame->nb_samples * sizeof(std::uint16_t));
-            timestamp_in_base_ = frame->best_effort_timestamp;
+        return true;
+    }
 
-            if ((channels_ != codec_->channels) || (frame->format != AV_SAMPLE_FMT_S16)) {
-                SwrContext *swr = swr_alloc_set_opts(nullptr,
-                    AV_CH_LAYOUT_STEREO, AV_SAMPLE_FMT_S16, freq_,
-                    frame->channel_layout, static_cast<AVSampleFormat>(frame->format), frame->sample_rate,
-                    0, nullptr);
+    void dsp_output_stream_ffmpeg::reset_decoder() {
+        if (codec_opened_) {
+            avcodec_flush_buffers(codec_);
+        }
+
+        if (swr_) {
+            // Drop the samples buffered inside the resampler
+            swr_close(swr_);
+            swr_init(swr_);
+        }
+    }
 
-                if (swr_init(swr) < 0) {
-                    LOG_ERROR("Error initializing SWR context");
-                    av_frame_free(&frame);
+    bool dsp_output_stream_ffmpeg::prepare_resampler(const AVFrame *frame) {
+        const std::uint64_t in_layout = frame->channel_layout ? frame->channel_layout
+                                                              : av_get_default_channel_layout(frame->channels);
 
-                    return;
-                }
+        if (swr_ && (swr_in_layout_ == in_layout) && (swr_in_format_ == frame->format) && (swr_in_rate_ == frame->sample_rate)
+            && (swr_out_channels_ == channels_) && (swr_out_rate_ == freq_)) {
+            return true;
+        }
 
-                std::uint8_t *output = &dest[0];
-                const std::uint8_t *source = frame->data[0];
+        swr_ = swr_alloc_set_opts(swr_,
+            av_get_default_channel_layout(channels_), AV_SAMPLE_FMT_S16, freq_,
+            in_layout, static_cast<AVSampleFormat>(frame->format), frame->sample_rate,
+            0, nullptr);
 
-                const int result = swr_convert(swr, &output, frame->nb_samples, &source, frame->nb_samples);
-                swr_free(&swr);
+        if (!swr_ || (swr_init(swr_) < 0)) {
+            LOG_ERROR("Error initializing SWR context");
 
-                if (result < 0) {
-                    LOG_ERROR("Error resample audio data!");
-                    return;
-                }
-            } else {
-                std::memcpy(&dest[0], frame->data[0], dest.size());
+            if (swr_) {
+                swr_free(&swr_);
             }
+
+            return false;
+        }
+
+        swr_in_layout_ = in_layout;
+        swr_in_format_ = frame->format;
+        swr_in_rate_ = frame->sample_rate;
+        swr_out_channels_ = channels_;
+        swr_out_rate_ = freq_;
+
+        return true;
+    }
+
+    void dsp_output_stream_ffmpeg::append_frame(const AVFrame *frame, std::vector<std::uint8_t> &dest) {
+        const std::size_t frame_size = channels_ * sizeof(std::int16_t);
+        const std::size_t old_size = dest.size();
+
+        if ((frame->channels == static_cast<int>(channels_)) && (frame->format == AV_SAMPLE_FMT_S16)
+            && (frame->sample_rate == static_cast<int>(freq_))) {
+            dest.resize(old_size + frame->nb_samples * frame_size);
+            std::memcpy(&dest[old_size], frame->data[0], frame->nb_samples * frame_size);
+
+            return;
+        }
+
+        if (!prepare_resampler(frame)) {
+            return;
+        }
+
+        const int max_out_samples = swr_get_out_samples(swr_, frame->nb_samples);
+
+        if (max_out_samples <= 0) {
+            return;
+        }
+
+        dest.resize(old_size + max_out_samples * frame_size);
+        std::uint8_t *output = &dest[old_size];
+
+        const int result = swr_convert(swr_, &output, max_out_samples, const_cast<const std::uint8_t **>(frame->extended_data),
+            frame->nb_samples);
+
+        if (result < 0) {
+            LOG_ERROR("Error resample audio data!");
+            dest.resize(old_size);
+
+            return;
+        }
+
+        dest.resize(old_size + result * frame_size);
+    }
+
+    void dsp_output_stream_ffmpeg::decode_data(const std::uint8_t *data, const std::uint32_t data_size, std::vector<std::uint8_t> &dest) {
+        dest.clear();
+
+        if (!open_codec()) {
+            return;
+        }
+
+        AVPacket packet;
+        av_init_packet(&packet);
+
+        packet.size = static_cast<int>(data_size);
+        packet.data = const_cast<std::uint8_t *>(data);
+
+        if (avcodec_send_packet(codec_, &packet) < 0) {
+            return;
+        }
+
+        // A packet may hold more than one frame
+        while (avcodec_receive_frame(codec_, frame_) >= 0) {
+            decoded_timestamp_ = frame_->best_effort_timestamp;
+            append_frame(frame_, dest);
+
+            av_frame_unref(frame_);
         }
     }
 
     std::uint64_t dsp_output_stream_ffmpeg::position_non_pcm16() {
         // Time in base multiply with time spend per frame in microseconds
-        return common::multiply_and_divide_qwords(timestamp_in_base_, codec_->time_base.num * AV_TIME_BASE,
+        return common::multiply_and_divide_qwords(played_timestamp_.load(), codec_->time_base.num * AV_TIME_BASE,
             codec_->time_base.den);
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <common/algorithm.h>
+#include <common/thread.h>
+#include <drivers/audio/backend/null/audio_null.h>
+
+#include <chrono>
+
+namespace eka2l1::drivers {
+    static constexpr std::uint32_t NULL_AUDIO_NATIVE_SAMPLE_RATE = 44100;
+    static constexpr std::uint32_t NULL_AUDIO_PERIOD_MS = 10;
+
+    null_audio_output_stream::null_audio_output_stream(const std::uint32_t sample_rate, const std::uint8_t channels,
+        data_callback callback)
+        : sample_rate_(sample_rate)
+        , channels_(channels)
+        , callback_(callback)
+        , consumer_(nullptr)
+        , playing_(false) {
+    }
+
+    null_audio_output_stream::~null_audio_output_stream() {
+        stop();
+    }
+
+    void null_audio_output_stream::consume_loop() {
+        common::set_thread_name("Null audio stream");
+
+        const std::size_t frames_per_period = common::max<std::size_t>(sample_rate_ * NULL_AUDIO_PERIOD_MS / 1000, 1);
+        scratch_.resize(frames_per_period * channels_);
+
+        auto next_period = std::chrono::steady_clock::now();
+
+        while (playing_) {
+            callback_(scratch_.data(), frames_per_period);
+
+            next_period += std::chrono::milliseconds(NULL_AUDIO_PERIOD_MS);
+            std::this_thread::sleep_until(next_period);
+        }
+    }
+
+    void null_audio_output_stream::join_consumer() {
+        if (consumer_ && (consumer_->get_id() != std::this_thread::get_id())) {
+            consumer_->join();
+            consumer_.reset();
+        }
+    }
+
+    bool null_audio_output_stream::start() {
+        if (playing_) {
+            return true;
+        }
+
+        if (!callback_ || (sample_rate_ == 0) || (channels_ == 0)) {
+            return false;
+        }
+
+        if (consumer_ && (consumer_->get_id() == std::this_thread::get_id())) {
+            // Stopped and started again from the data callback, the loop has not seen the stop yet
+            playing_ = true;
+            return true;
+        }
+
+        // A stop from the data callback leaves the thread finishing by itself
+        join_consumer();
+
+        playing_ = true;
+        consumer_ = std::make_unique<std::thread>([this]() { consume_loop(); });
+
+        return true;
+    }
+
+    bool null_audio_output_stream::stop() {
+        playing_ = false;
+
+        // The data callback is allowed to stop the stream. The consumer can't join itself, so it just
+        // leaves the loop, and the thread is joined by the next start, stop or the destructor.
+        join_consumer();
+
+        return true;
+    }
+
+    bool null_audio_output_stream::is_playing() {
+        return playing_;
+    }
+
+    bool null_audio_output_stream::set_volume(const float volume) {
+        return true;
+    }
+
+    std::unique_ptr<audio_output_stream> null_audio_driver::new_output_stream(const std::uint32_t sample_rate,
+        const std::uint8_t channels, data_callback callback) {
+        return std::make_unique<null_audio_output_stream>(sample_rate, channels, callback);
+    }
+
+    std::uint32_t null_audio_driver::native_sample_rate() {
+        return NULL_AUDIO_NATIVE_SAMPLE_RATE;
+    }
+}
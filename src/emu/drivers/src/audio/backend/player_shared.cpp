@@ -23,9 +23,12 @@
 #include <common/algorithm.h>
 #include <common/cvt.h>
 #include <common/log.h>
+#include <common/profile.h>
 
 namespace eka2l1::drivers {
     std::size_t player_shared::data_supply_callback(std::int16_t *data, std::size_t size) {
+        EKA2L1_PROFILE_SCOPE("audio", "Player supply callback");
+
         // Get the oldest request
         const std::lock_guard<std::mutex> guard(request_queue_lock_);
         player_request_instance &request = requests_.front();
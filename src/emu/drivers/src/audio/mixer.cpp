@@ -0,0 +1,320 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <drivers/audio/mixer.h>
+
+#include <common/log.h>
+#include <common/platform.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if EKA2L1_ARCH(X64)
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#define AUDIO_MIXER_SSE2 1
+#endif
+
+namespace eka2l1::drivers {
+    static constexpr std::uint32_t FALLBACK_OUTPUT_RATE = 44100;
+    static constexpr float SAMPLE_TO_FLOAT = 1.0f / 32768.0f;
+
+    mixer_output_stream::mixer_output_stream(audio_mixer *mixer, const std::uint32_t sample_rate, const std::uint8_t channels,
+        data_callback callback)
+        : mixer_(mixer)
+        , callback_(callback)
+        , sample_rate_(sample_rate)
+        , channels_(channels)
+        , playing_(false)
+        , reset_requested_(true)
+        , volume_(1.0f)
+        , render_thread_(std::thread::id())
+        , position_(0.0) {
+        mixer_->add_stream(this);
+    }
+
+    mixer_output_stream::~mixer_output_stream() {
+        // Once removed, the mixer will not call back into this stream anymore
+        mixer_->remove_stream(this);
+    }
+
+    bool mixer_output_stream::start() {
+        if (!playing_) {
+            reset_requested_ = true;
+            playing_ = true;
+        }
+
+        return true;
+    }
+
+    bool mixer_output_stream::stop() {
+        playing_ = false;
+
+        // A mix may be in the callback right now. Wait for it, the caller may free what the callback uses.
+        if (render_thread_.load() != std::this_thread::get_id()) {
+            const std::lock_guard<std::mutex> guard(render_lock_);
+        }
+
+        return true;
+    }
+
+    bool mixer_output_stream::is_playing() {
+        return playing_;
+    }
+
+    bool mixer_output_stream::set_volume(const float volume) {
+        volume_ = std::clamp(volume, 0.0f, 1.0f);
+        return true;
+    }
+
+    audio_mixer::audio_mixer(const std::uint32_t output_rate)
+        : output_rate_(output_rate ? output_rate : FALLBACK_OUTPUT_RATE) {
+    }
+
+    void audio_mixer::add_stream(mixer_output_stream *stream) {
+        const std::lock_guard<std::mutex> guard(streams_lock_);
+        streams_.push_back(stream);
+    }
+
+    void audio_mixer::remove_stream(mixer_output_stream *stream) {
+        const std::lock_guard<std::mutex> guard(streams_lock_);
+        streams_.erase(std::remove(streams_.begin(), streams_.end(), stream), streams_.end());
+    }
+
+    void audio_mixer::pull(mixer_output_stream &stream, const std::size_t frame_count) {
+        const std::size_t sample_count = frame_count * stream.channels_;
+
+        if (stream.pull_buffer_.size() < sample_count) {
+            stream.pull_buffer_.resize(sample_count);
+        }
+
+        std::int16_t *pulled = stream.pull_buffer_.data();
+
+        const auto callback_start = std::chrono::steady_clock::now();
+        const std::size_t frame_got = std::min(stream.callback_(pulled, frame_count), frame_count);
+        const auto callback_end = std::chrono::steady_clock::now();
+
+        const std::uint64_t callback_us = std::chrono::duration_cast<std::chrono::microseconds>(callback_end - callback_start).count();
+
+        stats_.callback_count_++;
+        stats_.frames_requested_ += frame_count;
+        stats_.frames_received_ += frame_got;
+        stats_.callback_total_us_ += callback_us;
+        stats_.callback_max_us_ = std::max(stats_.callback_max_us_, callback_us);
+
+        if (frame_got < frame_count) {
+            stats_.underrun_count_++;
+        }
+
+        // Not enough data is silence
+        std::fill(pulled + frame_got * stream.channels_, pulled + sample_count, 0);
+
+        const std::size_t old_size = stream.pending_.size();
+        stream.pending_.resize(old_size + frame_count * OUTPUT_CHANNELS);
+
+        float *dest = stream.pending_.data() + old_size;
+
+        if (stream.channels_ == 1) {
+            for (std::size_t i = 0; i < frame_count; i++) {
+                dest[i * 2] = dest[i * 2 + 1] = pulled[i] * SAMPLE_TO_FLOAT;
+            }
+        } else {
+            for (std::size_t i = 0; i < frame_count; i++) {
+                dest[i * 2] = pulled[i * stream.channels_] * SAMPLE_TO_FLOAT;
+                dest[i * 2 + 1] = pulled[i * stream.channels_ + 1] * SAMPLE_TO_FLOAT;
+            }
+        }
+    }
+
+    void audio_mixer::render_stream(mixer_output_stream &stream, const std::size_t frame_count) {
+        if (stream.reset_requested_.exchange(false)) {
+            // Start with one silent frame as the history of the first interpolation
+            stream.pending_.assign(OUTPUT_CHANNELS, 0.0f);
+            stream.position_ = 1.0;
+        }
+
+        if (stream.sample_rate_ == output_rate_) {
+            // Nothing to resample. Keep the history frame so switching does not need special care.
+            stream.pending_.resize(OUTPUT_CHANNELS);
+            pull(stream, frame_count);
+
+            std::copy(stream.pending_.begin() + OUTPUT_CHANNELS, stream.pending_.end(), stream_buffer_.begin());
+            std::copy(stream.pending_.end() - OUTPUT_CHANNELS, stream.pending_.end(), stream.pending_.begin());
+
+            stream.pending_.resize(OUTPUT_CHANNELS);
+            stream.position_ = 1.0;
+
+            return;
+        }
+
+        const double step = static_cast<double>(stream.sample_rate_) / output_rate_;
+
+        // Cubic interpolation reads one frame before and two frames after the position
+        const std::size_t frames_needed = static_cast<std::size_t>(stream.position_ + (frame_count - 1) * step) + 3;
+        const std::size_t frames_have = stream.pending_.size() / OUTPUT_CHANNELS;
+
+        if (frames_have < frames_needed) {
+            pull(stream, frames_needed - frames_have);
+        }
+
+        const float *input = stream.pending_.data();
+        float *output = stream_buffer_.data();
+
+        for (std::size_t i = 0; i < frame_count; i++) {
+            const double position = stream.position_ + i * step;
+            const std::size_t index = static_cast<std::size_t>(position);
+            const float t = static_cast<float>(position - index);
+
+            for (std::size_t channel = 0; channel < OUTPUT_CHANNELS; channel++) {
+                const float s0 = input[(index - 1) * OUTPUT_CHANNELS + channel];
+                const float s1 = input[index * OUTPUT_CHANNELS + channel];
+                const float s2 = input[(index + 1) * OUTPUT_CHANNELS + channel];
+                const float s3 = input[(index + 2) * OUTPUT_CHANNELS + channel];
+
+                // Catmull-Rom spline between s1 and s2
+                const float a = -0.5f * s0 + 1.5f * s1 - 1.5f * s2 + 0.5f * s3;
+                const float b = s0 - 2.5f * s1 + 2.0f * s2 - 0.5f * s3;
+                const float c = -0.5f * s0 + 0.5f * s2;
+
+                output[i * OUTPUT_CHANNELS + channel] = ((a * t + b) * t + c) * t + s1;
+            }
+        }
+
+        // Drop frames that are behind, but keep one for history
+        stream.position_ += frame_count * step;
+
+        const std::size_t consumed = static_cast<std::size_t>(stream.position_) - 1;
+
+        if (consumed > 0) {
+            stream.pending_.erase(stream.pending_.begin(), stream.pending_.begin() + consumed * OUTPUT_CHANNELS);
+            stream.position_ -= static_cast<double>(consumed);
+        }
+    }
+
+    static void accumulate_scaled(float *dest, const float *source, const std::size_t count, const float gain) {
+        std::size_t i = 0;
+
+#if AUDIO_MIXER_SSE2
+        const __m128 gain_vec = _mm_set1_ps(gain);
+
+        for (; i + 4 <= count; i += 4) {
+            const __m128 mixed = _mm_add_ps(_mm_loadu_ps(dest + i), _mm_mul_ps(_mm_loadu_ps(source + i), gain_vec));
+            _mm_storeu_ps(dest + i, mixed);
+        }
+#endif
+
+        for (; i < count; i++) {
+            dest[i] += source[i] * gain;
+        }
+    }
+
+    static void convert_to_s16(std::int16_t *dest, const float *source, const std::size_t count) {
+        std::size_t i = 0;
+
+#if AUDIO_MIXER_SSE2
+        const __m128 scale = _mm_set1_ps(32768.0f);
+        const __m128 max_val = _mm_set1_ps(32767.0f);
+        const __m128 min_val = _mm_set1_ps(-32768.0f);
+
+        for (; i + 8 <= count; i += 8) {
+            const __m128 lo = _mm_max_ps(_mm_min_ps(_mm_mul_ps(_mm_loadu_ps(source + i), scale), max_val), min_val);
+            const __m128 hi = _mm_max_ps(_mm_min_ps(_mm_mul_ps(_mm_loadu_ps(source + i + 4), scale), max_val), min_val);
+
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i), _mm_packs_epi32(_mm_cvtps_epi32(lo), _mm_cvtps_epi32(hi)));
+        }
+#endif
+
+        for (; i < count; i++) {
+            dest[i] = static_cast<std::int16_t>(std::clamp(std::lrint(source[i] * 32768.0f), -32768L, 32767L));
+        }
+    }
+
+    std::size_t audio_mixer::mix(std::int16_t *output, const std::size_t frame_count) {
+        const std::size_t sample_count = frame_count * OUTPUT_CHANNELS;
+
+        if (mix_buffer_.size() < sample_count) {
+            mix_buffer_.resize(sample_count);
+            stream_buffer_.resize(sample_count);
+        }
+
+        std::fill(mix_buffer_.begin(), mix_buffer_.begin() + sample_count, 0.0f);
+
+        {
+            const std::lock_guard<std::mutex> guard(streams_lock_);
+
+            for (mixer_output_stream *stream : streams_) {
+                const std::lock_guard<std::mutex> render_guard(stream->render_lock_);
+
+                // Checked under the render lock, so nothing is pulled once stop returns
+                if (!stream->playing_) {
+                    continue;
+                }
+
+                stream->render_thread_ = std::this_thread::get_id();
+                render_stream(*stream, frame_count);
+                stream->render_thread_ = std::thread::id();
+
+                accumulate_scaled(mix_buffer_.data(), stream_buffer_.data(), sample_count, stream->volume_);
+            }
+        }
+
+        convert_to_s16(output, mix_buffer_.data(), sample_count);
+        return frame_count;
+    }
+
+    audio_stream_stats audio_mixer::stats() {
+        const std::lock_guard<std::mutex> guard(streams_lock_);
+        return stats_;
+    }
+
+    mixer_audio_driver::mixer_audio_driver(std::unique_ptr<audio_driver> backend)
+        : backend_(std::move(backend)) {
+        mixer_ = std::make_unique<audio_mixer>(backend_->native_sample_rate());
+        output_ = backend_->new_output_stream(mixer_->output_rate(), audio_mixer::OUTPUT_CHANNELS,
+            [this](std::int16_t *buffer, const std::size_t frame_count) {
+                return mixer_->mix(buffer, frame_count);
+            });
+
+        if (!output_ || !output_->start()) {
+            LOG_ERROR("Unable to open the mixer output stream, audio will be silent");
+        }
+    }
+
+    mixer_audio_driver::~mixer_audio_driver() {
+        if (output_) {
+            output_->stop();
+            output_.reset();
+        }
+    }
+
+    std::unique_ptr<audio_output_stream> mixer_audio_driver::new_output_stream(const std::uint32_t sample_rate,
+        const std::uint8_t channels, data_callback callback) {
+        if ((sample_rate == 0) || (channels == 0)) {
+            return nullptr;
+        }
+
+        return std::make_unique<mixer_output_stream>(mixer_.get(), sample_rate, channels, callback);
+    }
+
+    std::uint32_t mixer_audio_driver::native_sample_rate() {
+        return mixer_->output_rate();
+    }
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <drivers/driver.h>
+
+#include <algorithm>
+
+namespace eka2l1::drivers {
+    command_arena::command_arena()
+        : current_(0) {
+    }
+
+    command_arena::block command_arena::make_block(const std::size_t block_size) {
+        block new_block;
+        new_block.size_ = block_size;
+        new_block.data_ = std::make_unique<std::uint8_t[]>(new_block.size_);
+        new_block.cursor_ = 0;
+
+        return new_block;
+    }
+
+    void *command_arena::allocate(const std::size_t size, const std::size_t alignment) {
+        if (size + alignment > COMMAND_ARENA_BLOCK_SIZE) {
+            // Oversized payloads get a block of their own. The current block stays open for
+            // the commands that come after.
+            oversized_.push_back(make_block(size + alignment));
+            block &blk = oversized_.back();
+
+            const std::size_t aligned_cursor = (alignment - reinterpret_cast<std::uintptr_t>(blk.data_.get()) % alignment) % alignment;
+            blk.cursor_ = aligned_cursor + size;
+
+            return blk.data_.get() + aligned_cursor;
+        }
+
+        while (true) {
+            if (current_ == blocks_.size()) {
+                blocks_.push_back(make_block(COMMAND_ARENA_BLOCK_SIZE));
+            }
+
+            block &blk = blocks_[current_];
+            const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(blk.data_.get());
+            const std::size_t aligned_cursor = ((base + blk.cursor_ + alignment - 1) & ~(alignment - 1)) - base;
+
+            if (aligned_cursor + size <= blk.size_) {
+                blk.cursor_ = aligned_cursor + size;
+                return blk.data_.get() + aligned_cursor;
+            }
+
+            current_++;
+        }
+    }
+
+    void *command_arena::copy(const void *source, const std::size_t size) {
+        void *dest = allocate(size);
+        std::copy(reinterpret_cast<const std::uint8_t *>(source), reinterpret_cast<const std::uint8_t *>(source) + size,
+            reinterpret_cast<std::uint8_t *>(dest));
+
+        return dest;
+    }
+
+    void command_arena::reset() {
+        // Oversized blocks are usually one-time uploads, don't keep them around
+        oversized_.clear();
+
+        for (block &blk : blocks_) {
+            blk.cursor_ = 0;
+        }
+
+        current_ = 0;
+    }
+
+    std::unique_ptr<command_arena> command_arena_pool::acquire() {
+        const std::lock_guard<std::mutex> guard(lock_);
+
+        if (free_.empty()) {
+            return std::make_unique<command_arena>();
+        }
+
+        std::unique_ptr<command_arena> arena = std::move(free_.back());
+        free_.pop_back();
+
+        return arena;
+    }
+
+    void command_arena_pool::release(std::unique_ptr<command_arena> arena) {
+        if (!arena) {
+            return;
+        }
+
+        arena->reset();
+
+        const std::lock_guard<std::mutex> guard(lock_);
+
+        if (free_.size() < max_free_count_) {
+            free_.push_back(std::move(arena));
+        }
+    }
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <drivers/graphics/backend/emu_window_null.h>
+
+namespace eka2l1 {
+    namespace drivers {
+        emu_window_null::emu_window_null()
+            : size_(0, 0)
+            , userdata_(nullptr)
+            , cursor_visible_(true) {
+        }
+
+        bool emu_window_null::get_mouse_button_hold(const int mouse_btt) {
+            return false;
+        }
+
+        void emu_window_null::change_title(std::string new_title) {
+        }
+
+        void emu_window_null::init(std::string title, vec2 size, const std::uint32_t flags) {
+            size_ = size;
+        }
+
+        void emu_window_null::make_current() {
+        }
+
+        void emu_window_null::done_current() {
+        }
+
+        void emu_window_null::swap_buffer() {
+        }
+
+        void emu_window_null::poll_events() {
+        }
+
+        void emu_window_null::set_userdata(void *userdata) {
+            userdata_ = userdata;
+        }
+
+        void *emu_window_null::get_userdata() {
+            return userdata_;
+        }
+
+        void emu_window_null::set_fullscreen(const bool is_fullscreen) {
+        }
+
+        bool emu_window_null::should_quit() {
+            return false;
+        }
+
+        void emu_window_null::shutdown() {
+        }
+
+        vec2 emu_window_null::window_size() {
+            return size_;
+        }
+
+        vec2 emu_window_null::window_fb_size() {
+            return size_;
+        }
+
+        vec2d emu_window_null::get_mouse_pos() {
+            return vec2d{ 0.0, 0.0 };
+        }
+
+        bool emu_window_null::set_cursor(cursor *cur) {
+            return true;
+        }
+
+        void emu_window_null::cursor_visiblity(const bool visi) {
+            cursor_visible_ = visi;
+        }
+
+        bool emu_window_null::cursor_visiblity() {
+            return cursor_visible_;
+        }
+    }
+}
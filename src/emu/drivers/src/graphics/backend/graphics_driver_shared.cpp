@@ -245,7 +245,10 @@ namespace eka2l1::drivers {
 
         update_bitmap(handle, size, offset, dim, bpp, data, pixels_per_line);
 
-        delete data;
+        if (helper.todo_->status_) {
+            // The data is referenced, signal the fence so the owner can reuse it
+            helper.finish(this, 0);
+        }
     }
 
     void shared_graphics_driver::create_bitmap(command_helper &helper) {
@@ -493,8 +496,6 @@ namespace eka2l1::drivers {
         }
 
         shobj->set(this, binding, var_type, data);
-
-        delete data;
     }
 
     void shared_graphics_driver::set_swizzle(command_helper &helper) {
@@ -587,8 +588,6 @@ namespace eka2l1::drivers {
         }
 
         bufobj->update_data(this, data, offset, size);
-
-        delete data;
     }
 
     void shared_graphics_driver::attach_descriptors(drivers::handle h, const int stride, const bool instance_move,
@@ -616,8 +615,6 @@ namespace eka2l1::drivers {
         helper.pop(descriptor_count);
 
         attach_descriptors(h, stride, instance_move, descriptors, descriptor_count);
-
-        delete descriptors;
     }
 
     void shared_graphics_driver::destroy_object(command_helper &helper) {
@@ -19,6 +19,7 @@
 
 #include <common/algorithm.h>
 #include <common/log.h>
+#include <common/profile.h>
 #include <common/platform.h>
 #include <fstream>
 #include <sstream>
@@ -705,7 +706,10 @@ namespace eka2l1::drivers {
     }
 
     std::unique_ptr<graphics_command_list> ogl_graphics_driver::new_command_list() {
-        return std::make_unique<server_graphics_command_list>();
+        auto list = std::make_unique<server_graphics_command_list>();
+        list->list_.arena_ = arena_pool.acquire();
+
+        return list;
     }
 
     std::unique_ptr<graphics_command_list_builder> ogl_graphics_driver::new_command_builder(graphics_command_list *list) {
@@ -713,7 +717,7 @@ namespace eka2l1::drivers {
     }
 
     void ogl_graphics_driver::submit_command_list(graphics_command_list &command_list) {
-        list_queue.push(static_cast<server_graphics_command_list &>(command_list));
+        list_queue.push(std::move(static_cast<server_graphics_command_list &>(command_list)));
     }
 
     void ogl_graphics_driver::display(command_helper &helper) {
@@ -826,18 +830,16 @@ namespace eka2l1::drivers {
                 break;
             }
 
+            EKA2L1_PROFILE_SCOPE("graphics", "Execute command list");
             command *cmd = list->list_.first_;
-            command *next = nullptr;
 
             while (cmd) {
                 dispatch(cmd);
-                next = cmd->next_;
-
-                // TODO: If any command list requires not rebuilding the buffer, dont delete the command.
-                // For now, not likely
-                delete cmd;
-                cmd = next;
+                cmd = cmd->next_;
             }
+
+            // Commands and payloads live in the arena, give it back for the next lists
+            arena_pool.release(std::move(list->list_.arena_));
         }
     }
 
@@ -0,0 +1,306 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <common/platform.h>
+#include <drivers/graphics/backend/software/blit_software.h>
+
+#include <algorithm>
+#include <cstring>
+
+#if EKA2L1_ARCH(X64)
+#include <emmintrin.h>
+#define SOFTWARE_BLIT_SSE2 1
+#endif
+
+namespace eka2l1::drivers {
+    static constexpr std::uint32_t WHITE_PIXEL = 0xFFFFFFFF;
+
+    static inline std::uint32_t div_255(const std::uint32_t val) {
+        return (val + 128 + ((val + 128) >> 8)) >> 8;
+    }
+
+    static inline std::uint32_t get_channel(const std::uint32_t pixel, const int channel) {
+        return reinterpret_cast<const std::uint8_t *>(&pixel)[channel];
+    }
+
+    static inline std::uint32_t get_blend_factor(const blend_factor factor, const std::uint32_t frag_alpha, const std::uint32_t current_alpha) {
+        switch (factor) {
+        case blend_factor::one:
+            return 255;
+
+        case blend_factor::zero:
+            return 0;
+
+        case blend_factor::frag_out_alpha:
+            return frag_alpha;
+
+        case blend_factor::one_minus_frag_out_alpha:
+            return 255 - frag_alpha;
+
+        case blend_factor::current_alpha:
+            return current_alpha;
+
+        case blend_factor::one_minus_current_alpha:
+            return 255 - current_alpha;
+
+        default:
+            break;
+        }
+
+        return 0;
+    }
+
+    static inline std::uint32_t apply_blend_equation(const blend_equation equation, const std::uint32_t frag_term,
+        const std::uint32_t current_term) {
+        switch (equation) {
+        case blend_equation::add:
+            return std::min<std::uint32_t>(255, frag_term + current_term);
+
+        case blend_equation::sub:
+            return (frag_term > current_term) ? (frag_term - current_term) : 0;
+
+        case blend_equation::isub:
+            return (current_term > frag_term) ? (current_term - frag_term) : 0;
+
+        default:
+            break;
+        }
+
+        return frag_term;
+    }
+
+    static inline std::uint32_t blend_pixel(const std::uint32_t frag, const std::uint32_t current, const software_blend_state &state) {
+        const std::uint32_t frag_alpha = get_channel(frag, 3);
+        const std::uint32_t current_alpha = get_channel(current, 3);
+
+        std::uint8_t result[4];
+
+        for (int i = 0; i < 4; i++) {
+            const bool is_alpha = (i == 3);
+
+            const std::uint32_t frag_factor = get_blend_factor(is_alpha ? state.a_frag_out_factor_ : state.rgb_frag_out_factor_,
+                frag_alpha, current_alpha);
+            const std::uint32_t current_factor = get_blend_factor(is_alpha ? state.a_current_factor_ : state.rgb_current_factor_,
+                frag_alpha, current_alpha);
+
+            result[i] = static_cast<std::uint8_t>(apply_blend_equation(is_alpha ? state.a_equation_ : state.rgb_equation_,
+                div_255(get_channel(frag, i) * frag_factor), div_255(get_channel(current, i) * current_factor)));
+        }
+
+        std::uint32_t packed = 0;
+        std::memcpy(&packed, result, sizeof(packed));
+
+        return packed;
+    }
+
+    static inline std::uint32_t modulate_pixel(const std::uint32_t source, const std::uint32_t modulator) {
+        std::uint8_t result[4];
+
+        for (int i = 0; i < 4; i++) {
+            result[i] = static_cast<std::uint8_t>(div_255(get_channel(source, i) * get_channel(modulator, i)));
+        }
+
+        std::uint32_t packed = 0;
+        std::memcpy(&packed, result, sizeof(packed));
+
+        return packed;
+    }
+
+    static void blit_row_scalar(std::uint32_t *dest, const std::uint32_t *source, const std::uint32_t *mask, const std::size_t count,
+        const std::uint32_t tint, const bool invert_mask, const software_blend_state &state) {
+        for (std::size_t i = 0; i < count; i++) {
+            std::uint32_t frag = source[i];
+
+            if (tint != WHITE_PIXEL) {
+                frag = modulate_pixel(frag, tint);
+            }
+
+            if (mask) {
+                frag = modulate_pixel(frag, invert_mask ? ~mask[i] : mask[i]);
+            }
+
+            dest[i] = state.enabled_ ? blend_pixel(frag, dest[i], state) : frag;
+        }
+    }
+
+#if SOFTWARE_BLIT_SSE2
+    // Each 128-bit lane holds two pixels, one 16-bit integer per channel.
+    static inline __m128i div_255_epu16(const __m128i val) {
+        const __m128i rounded = _mm_add_epi16(val, _mm_set1_epi16(128));
+        return _mm_srli_epi16(_mm_add_epi16(rounded, _mm_srli_epi16(rounded, 8)), 8);
+    }
+
+    static inline __m128i modulate_epu16(const __m128i val, const __m128i modulator) {
+        return div_255_epu16(_mm_mullo_epi16(val, modulator));
+    }
+
+    static inline __m128i broadcast_alpha_epu16(const __m128i val) {
+        return _mm_shufflehi_epi16(_mm_shufflelo_epi16(val, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    }
+
+    static inline __m128i get_blend_factor_epu16(const blend_factor factor, const __m128i frag_alpha, const __m128i current_alpha) {
+        const __m128i full = _mm_set1_epi16(255);
+
+        switch (factor) {
+        case blend_factor::one:
+            return full;
+
+        case blend_factor::frag_out_alpha:
+            return frag_alpha;
+
+        case blend_factor::one_minus_frag_out_alpha:
+            return _mm_sub_epi16(full, frag_alpha);
+
+        case blend_factor::current_alpha:
+            return current_alpha;
+
+        case blend_factor::one_minus_current_alpha:
+            return _mm_sub_epi16(full, current_alpha);
+
+        default:
+            break;
+        }
+
+        return _mm_setzero_si128();
+    }
+
+    static inline __m128i apply_blend_equation_epu16(const blend_equation equation, const __m128i frag_term, const __m128i current_term) {
+        switch (equation) {
+        case blend_equation::add:
+            return _mm_adds_epu16(frag_term, current_term);
+
+        case blend_equation::sub:
+            return _mm_subs_epu16(frag_term, current_term);
+
+        case blend_equation::isub:
+            return _mm_subs_epu16(current_term, frag_term);
+
+        default:
+            break;
+        }
+
+        return frag_term;
+    }
+
+    static inline __m128i select_alpha_epu16(const __m128i rgb, const __m128i alpha) {
+        const __m128i alpha_mask = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+        return _mm_or_si128(_mm_andnot_si128(alpha_mask, rgb), _mm_and_si128(alpha_mask, alpha));
+    }
+
+    static inline __m128i blend_epu16(const __m128i frag, const __m128i current, const software_blend_state &state) {
+        const __m128i frag_alpha = broadcast_alpha_epu16(frag);
+        const __m128i current_alpha = broadcast_alpha_epu16(current);
+
+        const __m128i frag_factor = select_alpha_epu16(get_blend_factor_epu16(state.rgb_frag_out_factor_, frag_alpha, current_alpha),
+            get_blend_factor_epu16(state.a_frag_out_factor_, frag_alpha, current_alpha));
+        const __m128i current_factor = select_alpha_epu16(get_blend_factor_epu16(state.rgb_current_factor_, frag_alpha, current_alpha),
+            get_blend_factor_epu16(state.a_current_factor_, frag_alpha, current_alpha));
+
+        const __m128i frag_term = modulate_epu16(frag, frag_factor);
+        const __m128i current_term = modulate_epu16(current, current_factor);
+
+        const __m128i rgb_result = apply_blend_equation_epu16(state.rgb_equation_, frag_term, current_term);
+
+        if (state.rgb_equation_ == state.a_equation_) {
+            return rgb_result;
+        }
+
+        return select_alpha_epu16(rgb_result, apply_blend_equation_epu16(state.a_equation_, frag_term, current_term));
+    }
+
+    static void blit_row_sse2(std::uint32_t *dest, const std::uint32_t *source, const std::uint32_t *mask, const std::size_t count,
+        const std::uint32_t tint, const bool invert_mask, const software_blend_state &state) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i tint_epu16 = _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(tint)), zero);
+        const __m128i invert_xor = invert_mask ? _mm_set1_epi32(-1) : zero;
+        const bool use_tint = (tint != WHITE_PIXEL);
+
+        std::size_t i = 0;
+
+        for (; i + 4 <= count; i += 4) {
+            const __m128i frag_raw = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i));
+
+            __m128i frag_lo = _mm_unpacklo_epi8(frag_raw, zero);
+            __m128i frag_hi = _mm_unpackhi_epi8(frag_raw, zero);
+
+            if (use_tint) {
+                frag_lo = modulate_epu16(frag_lo, tint_epu16);
+                frag_hi = modulate_epu16(frag_hi, tint_epu16);
+            }
+
+            if (mask) {
+                const __m128i mask_raw = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(mask + i)), invert_xor);
+
+                frag_lo = modulate_epu16(frag_lo, _mm_unpacklo_epi8(mask_raw, zero));
+                frag_hi = modulate_epu16(frag_hi, _mm_unpackhi_epi8(mask_raw, zero));
+            }
+
+            if (state.enabled_) {
+                const __m128i current_raw = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dest + i));
+
+                frag_lo = blend_epu16(frag_lo, _mm_unpacklo_epi8(current_raw, zero), state);
+                frag_hi = blend_epu16(frag_hi, _mm_unpackhi_epi8(current_raw, zero), state);
+            }
+
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i), _mm_packus_epi16(frag_lo, frag_hi));
+        }
+
+        if (i < count) {
+            blit_row_scalar(dest + i, source + i, mask ? (mask + i) : nullptr, count - i, tint, invert_mask, state);
+        }
+    }
+#endif
+
+    void software_blit_row(std::uint32_t *dest, const std::uint32_t *source, const std::uint32_t *mask, const std::size_t count,
+        const std::uint32_t tint, const bool invert_mask, const software_blend_state &state) {
+        if (!state.enabled_ && !mask && (tint == WHITE_PIXEL)) {
+            std::memcpy(dest, source, count * sizeof(std::uint32_t));
+            return;
+        }
+
+#if SOFTWARE_BLIT_SSE2
+        blit_row_sse2(dest, source, mask, count, tint, invert_mask, state);
+#else
+        blit_row_scalar(dest, source, mask, count, tint, invert_mask, state);
+#endif
+    }
+
+    void software_blit_row_scalar(std::uint32_t *dest, const std::uint32_t *source, const std::uint32_t *mask, const std::size_t count,
+        const std::uint32_t tint, const bool invert_mask, const software_blend_state &state) {
+        blit_row_scalar(dest, source, mask, count, tint, invert_mask, state);
+    }
+
+    void software_fill_row(std::uint32_t *dest, const std::uint32_t color, const std::size_t count, const software_blend_state &state) {
+        if (!state.enabled_) {
+            std::fill(dest, dest + count, color);
+            return;
+        }
+
+        // Blend a solid row by using the color as the source of a regular blit, in small batches
+        static constexpr std::size_t FILL_BATCH_SIZE = 64;
+        std::uint32_t batch[FILL_BATCH_SIZE];
+
+        std::fill(batch, batch + FILL_BATCH_SIZE, color);
+
+        for (std::size_t i = 0; i < count; i += FILL_BATCH_SIZE) {
+            software_blit_row(dest + i, batch, nullptr, std::min<std::size_t>(FILL_BATCH_SIZE, count - i), WHITE_PIXEL, false, state);
+        }
+    }
+}
@@ -0,0 +1,795 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <common/algorithm.h>
+#include <common/log.h>
+#include <common/profile.h>
+
+#include <drivers/graphics/backend/software/graphics_software.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace eka2l1::drivers {
+#define HANDLE_BITMAP (1ULL << 32)
+
+    // Blits smaller than this run on the driver thread, the rest are split into bands
+    static constexpr std::size_t MIN_PIXELS_FOR_PARALLEL_BLIT = 128 * 128;
+    static constexpr int BAND_ROW_COUNT = 32;
+
+    software_bitmap::software_bitmap(const eka2l1::vec2 &initial_size)
+        : size(0, 0)
+        , swizzle({ channel_swizzle::red, channel_swizzle::green, channel_swizzle::blue, channel_swizzle::alpha }) {
+        resize(initial_size);
+    }
+
+    void software_bitmap::resize(const eka2l1::vec2 &new_size) {
+        std::vector<std::uint32_t> new_pixels(new_size.x * new_size.y, 0);
+
+        const int copy_width = common::min<int>(size.x, new_size.x);
+        const int copy_height = common::min<int>(size.y, new_size.y);
+
+        for (int y = 0; y < copy_height; y++) {
+            std::copy(row(y), row(y) + copy_width, new_pixels.data() + y * new_size.x);
+        }
+
+        pixels = std::move(new_pixels);
+        size = new_size;
+    }
+
+    bool software_bitmap::has_identity_swizzle() const {
+        return (swizzle[0] == channel_swizzle::red) && (swizzle[1] == channel_swizzle::green)
+            && (swizzle[2] == channel_swizzle::blue) && (swizzle[3] == channel_swizzle::alpha);
+    }
+
+    static std::uint8_t swizzle_channel(const std::uint8_t *source, const channel_swizzle swizzle) {
+        switch (swizzle) {
+        case channel_swizzle::red:
+            return source[0];
+
+        case channel_swizzle::green:
+            return source[1];
+
+        case channel_swizzle::blue:
+            return source[2];
+
+        case channel_swizzle::alpha:
+            return source[3];
+
+        case channel_swizzle::one:
+            return 255;
+
+        default:
+            break;
+        }
+
+        return 0;
+    }
+
+    /**
+     * \brief Produce a contiguous source row, scaled to the destination width and swizzled.
+     *
+     * \returns Pointer to the row. Either points into the bitmap, or into the scratch buffer.
+     */
+    static const std::uint32_t *fetch_source_row(const software_bitmap &bmp, const eka2l1::rect &source_rect, const int source_y,
+        const int dest_width, std::vector<std::uint32_t> &scratch) {
+        const std::uint32_t *source_row = bmp.row(source_y) + source_rect.top.x;
+        const bool identity = bmp.has_identity_swizzle();
+
+        if ((source_rect.size.x == dest_width) && identity) {
+            return source_row;
+        }
+
+        scratch.resize(dest_width);
+
+        for (int x = 0; x < dest_width; x++) {
+            const int source_x = (source_rect.size.x == dest_width) ? x : static_cast<int>((static_cast<std::int64_t>(x) * source_rect.size.x) / dest_width);
+            scratch[x] = source_row[source_x];
+        }
+
+        if (!identity) {
+            for (int x = 0; x < dest_width; x++) {
+                const std::uint8_t *channels = reinterpret_cast<const std::uint8_t *>(&scratch[x]);
+
+                scratch[x] = make_software_pixel(swizzle_channel(channels, bmp.swizzle[0]), swizzle_channel(channels, bmp.swizzle[1]),
+                    swizzle_channel(channels, bmp.swizzle[2]), swizzle_channel(channels, bmp.swizzle[3]));
+            }
+        }
+
+        return scratch.data();
+    }
+
+    static void convert_to_software_pixels(const int bpp, const std::uint8_t *source, std::uint32_t *dest, const int count) {
+        switch (bpp) {
+        case 8:
+            for (int i = 0; i < count; i++) {
+                dest[i] = make_software_pixel(source[i], 0, 0, 255);
+            }
+
+            break;
+
+        case 12:
+            // EColor4K, xxxxRRRRGGGGBBBB in 2 bytes
+            for (int i = 0; i < count; i++) {
+                const std::uint16_t val = static_cast<std::uint16_t>(source[i * 2] | (source[i * 2 + 1] << 8));
+
+                const std::uint8_t r = static_cast<std::uint8_t>((val >> 8) & 0xF);
+                const std::uint8_t g = static_cast<std::uint8_t>((val >> 4) & 0xF);
+                const std::uint8_t b = static_cast<std::uint8_t>(val & 0xF);
+
+                dest[i] = make_software_pixel(r * 17, g * 17, b * 17, 255);
+            }
+
+            break;
+
+        case 16:
+            for (int i = 0; i < count; i++) {
+                const std::uint16_t val = static_cast<std::uint16_t>(source[i * 2] | (source[i * 2 + 1] << 8));
+
+                const std::uint8_t r = static_cast<std::uint8_t>(val >> 11);
+                const std::uint8_t g = static_cast<std::uint8_t>((val >> 5) & 0x3F);
+                const std::uint8_t b = static_cast<std::uint8_t>(val & 0x1F);
+
+                dest[i] = make_software_pixel((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2), 255);
+            }
+
+            break;
+
+        case 24:
+            for (int i = 0; i < count; i++) {
+                dest[i] = make_software_pixel(source[i * 3 + 2], source[i * 3 + 1], source[i * 3], 255);
+            }
+
+            break;
+
+        case 32:
+            for (int i = 0; i < count; i++) {
+                dest[i] = make_software_pixel(source[i * 4 + 2], source[i * 4 + 1], source[i * 4], source[i * 4 + 3]);
+            }
+
+            break;
+
+        default:
+            LOG_ERROR("Unsupported bitmap bpp {} for software upload", bpp);
+            break;
+        }
+    }
+
+    software_graphics_driver::software_graphics_driver(const std::size_t worker_count)
+        : graphics_driver(graphic_api::software)
+        , binding(nullptr)
+        , blit_pool(worker_count, "Software blitter")
+        , brush_color({ 255.0f, 255.0f, 255.0f, 255.0f })
+        , clipping(false)
+        , should_stop(false)
+        , warned_unsupported(false) {
+        list_queue.max_pending_count_ = 128;
+        binding = &swapchain;
+    }
+
+    software_bitmap *software_graphics_driver::get_bitmap(const drivers::handle h) {
+        if ((h & HANDLE_BITMAP) == 0) {
+            return nullptr;
+        }
+
+        if (((h & ~HANDLE_BITMAP) == 0) || ((h & ~HANDLE_BITMAP) > bmp_textures.size())) {
+            return nullptr;
+        }
+
+        return bmp_textures[(h & ~HANDLE_BITMAP) - 1].get();
+    }
+
+    eka2l1::rect software_graphics_driver::get_target_area() {
+        eka2l1::rect area({ 0, 0 }, binding->size);
+
+        if (clipping) {
+            area = area.intersect(clip);
+        }
+
+        return area;
+    }
+
+    void software_graphics_driver::run_bands(const int row_count, const std::size_t pixel_count, std::function<void(int, int)> func) {
+        if ((pixel_count < MIN_PIXELS_FOR_PARALLEL_BLIT) || (row_count <= BAND_ROW_COUNT) || (blit_pool.worker_count() <= 1)) {
+            func(0, row_count);
+            return;
+        }
+
+        for (int start = 0; start < row_count; start += BAND_ROW_COUNT) {
+            const int end = common::min<int>(start + BAND_ROW_COUNT, row_count);
+            blit_pool.enqueue([&func, start, end]() {
+                func(start, end);
+            });
+        }
+
+        blit_pool.wait_all();
+    }
+
+    void software_graphics_driver::warn_unsupported(const std::uint16_t opcode) {
+        if (!warned_unsupported) {
+            LOG_WARN("Opcode {} is not supported by the software graphics driver, ignored", opcode);
+            warned_unsupported = true;
+        }
+    }
+
+    void software_graphics_driver::update_bitmap(drivers::handle h, const std::size_t size, const eka2l1::vec2 &offset,
+        const eka2l1::vec2 &dim, const int bpp, const void *data, const std::size_t pixels_per_line) {
+        software_bitmap *bmp = get_bitmap(h);
+
+        if (!bmp || !data) {
+            return;
+        }
+
+        // Same unpack rules as GL: row length in pixels, rows aligned to 4 bytes. 12bpp pixels take 2 bytes.
+        const std::size_t bytes_per_pixel = (bpp + 7) / 8;
+        const std::size_t stride = common::align((pixels_per_line ? pixels_per_line : dim.x) * bytes_per_pixel, 4);
+
+        const int copy_width = common::min<int>(dim.x, bmp->size.x - offset.x);
+        const int copy_height = common::min<int>(dim.y, bmp->size.y - offset.y);
+
+        if ((offset.x < 0) || (offset.y < 0) || (copy_width <= 0) || (copy_height <= 0)) {
+            LOG_ERROR("Bitmap update region is out of bounds");
+            return;
+        }
+
+        const std::uint8_t *source = reinterpret_cast<const std::uint8_t *>(data);
+
+        for (int y = 0; y < copy_height; y++) {
+            if (y * stride + copy_width * bytes_per_pixel > size) {
+                // Not enough data provided
+                break;
+            }
+
+            convert_to_software_pixels(bpp, source + y * stride, bmp->row(offset.y + y) + offset.x, copy_width);
+        }
+
+        // Mirror the swizzle the GL backend applies for each format
+        switch (bpp) {
+        case 8:
+            bmp->swizzle = { channel_swizzle::red, channel_swizzle::red, channel_swizzle::red, channel_swizzle::red };
+            break;
+
+        case 12:
+        case 16:
+            bmp->swizzle = { channel_swizzle::red, channel_swizzle::green, channel_swizzle::blue, channel_swizzle::one };
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    void software_graphics_driver::attach_descriptors(drivers::handle h, const int stride, const bool instance_move,
+        const attribute_descriptor *descriptors, const int descriptor_count) {
+        warn_unsupported(graphics_driver_attach_descriptors);
+    }
+
+    void software_graphics_driver::set_viewport(const eka2l1::rect &new_viewport) {
+        viewport = new_viewport;
+    }
+
+    void software_graphics_driver::create_bitmap(command_helper &helper) {
+        eka2l1::vec2 size;
+        drivers::handle *result = nullptr;
+
+        helper.pop(size);
+        helper.pop(result);
+
+        auto slot_free = std::find(bmp_textures.begin(), bmp_textures.end(), nullptr);
+
+        if (slot_free != bmp_textures.end()) {
+            *slot_free = std::make_unique<software_bitmap>(size);
+            *result = std::distance(bmp_textures.begin(), slot_free) + 1;
+        } else {
+            bmp_textures.push_back(std::make_unique<software_bitmap>(size));
+            *result = bmp_textures.size();
+        }
+
+        *result |= HANDLE_BITMAP;
+
+        helper.finish(this, 0);
+    }
+
+    void software_graphics_driver::bind_bitmap(command_helper &helper) {
+        drivers::handle h = 0;
+        helper.pop(h);
+
+        if (h == 0) {
+            binding = &swapchain;
+            return;
+        }
+
+        software_bitmap *bmp = get_bitmap(h);
+
+        if (!bmp) {
+            LOG_ERROR("Bitmap handle invalid to be binded");
+            return;
+        }
+
+        binding = bmp;
+        viewport = eka2l1::rect({ 0, 0 }, bmp->size);
+    }
+
+    void software_graphics_driver::update_bitmap(command_helper &helper) {
+        drivers::handle handle = 0;
+        std::uint8_t *data = nullptr;
+        int bpp = 0;
+        std::size_t size = 0;
+        eka2l1::vec2 offset;
+        eka2l1::vec2 dim;
+        std::size_t pixels_per_line = 0;
+
+        helper.pop(handle);
+        helper.pop(data);
+        helper.pop(bpp);
+        helper.pop(size);
+        helper.pop(offset);
+        helper.pop(dim);
+        helper.pop(pixels_per_line);
+
+        update_bitmap(handle, size, offset, dim, bpp, data, pixels_per_line);
+
+        if (helper.todo_->status_) {
+            helper.finish(this, 0);
+        }
+    }
+
+    void software_graphics_driver::resize_bitmap(command_helper &helper) {
+        drivers::handle h = 0;
+        vec2 new_size = { 0, 0 };
+
+        helper.pop(h);
+        helper.pop(new_size);
+
+        software_bitmap *bmp = get_bitmap(h);
+
+        if (!bmp) {
+            LOG_ERROR("Bitmap handle invalid to be resized");
+            return;
+        }
+
+        bmp->resize(new_size);
+    }
+
+    void software_graphics_driver::destroy_bitmap(command_helper &helper) {
+        drivers::handle h = 0;
+        helper.pop(h);
+
+        software_bitmap *bmp = get_bitmap(h);
+
+        if (!bmp) {
+            LOG_ERROR("Invalid bitmap handle to destroy");
+            return;
+        }
+
+        if (binding == bmp) {
+            binding = &swapchain;
+        }
+
+        bmp_textures[(h & ~HANDLE_BITMAP) - 1].reset();
+    }
+
+    void software_graphics_driver::draw_bitmap(command_helper &helper) {
+        drivers::handle to_draw = 0;
+        drivers::handle mask_to_use = 0;
+        eka2l1::rect dest_rect;
+        eka2l1::rect source_rect;
+        std::uint32_t flags = 0;
+
+        helper.pop(to_draw);
+        helper.pop(mask_to_use);
+        helper.pop(dest_rect);
+        helper.pop(source_rect);
+        helper.pop(flags);
+
+        software_bitmap *bmp = get_bitmap(to_draw);
+
+        if (!bmp) {
+            LOG_ERROR("Invalid bitmap handle to draw");
+            return;
+        }
+
+        software_bitmap *mask_bmp = nullptr;
+
+        if (mask_to_use) {
+            mask_bmp = get_bitmap(mask_to_use);
+
+            if (!mask_bmp) {
+                LOG_ERROR("Mask handle was provided but invalid!");
+                return;
+            }
+        }
+
+        if (source_rect.size.x == 0) {
+            source_rect.size.x = bmp->size.x;
+        }
+
+        if (source_rect.size.y == 0) {
+            source_rect.size.y = bmp->size.y;
+        }
+
+        if (dest_rect.size.x == 0) {
+            dest_rect.size.x = source_rect.size.x;
+        }
+
+        if (dest_rect.size.y == 0) {
+            dest_rect.size.y = source_rect.size.y;
+        }
+
+        // Keep the source inside the bitmap
+        source_rect = source_rect.intersect(eka2l1::rect({ 0, 0 }, bmp->size));
+
+        if (mask_bmp) {
+            source_rect = source_rect.intersect(eka2l1::rect({ 0, 0 }, mask_bmp->size));
+        }
+
+        const eka2l1::rect area = get_target_area().intersect(dest_rect);
+
+        if ((area.size.x <= 0) || (area.size.y <= 0) || (source_rect.size.x <= 0) || (source_rect.size.y <= 0)) {
+            return;
+        }
+
+        const std::uint32_t tint = (flags & bitmap_draw_flag_use_brush) ? make_software_pixel(static_cast<std::uint8_t>(brush_color[0]),
+                                                                               static_cast<std::uint8_t>(brush_color[1]), static_cast<std::uint8_t>(brush_color[2]),
+                                                                               static_cast<std::uint8_t>(brush_color[3]))
+                                                                         : 0xFFFFFFFF;
+
+        const bool invert_mask = (flags & bitmap_draw_flag_invert_mask);
+        software_bitmap *target = binding;
+
+        // Clipped destination begins somewhere inside the full destination rectangle
+        const int skip_x = area.top.x - dest_rect.top.x;
+        const int skip_y = area.top.y - dest_rect.top.y;
+
+        eka2l1::rect scaled_source = source_rect;
+        scaled_source.top.x += static_cast<int>((static_cast<std::int64_t>(skip_x) * source_rect.size.x) / dest_rect.size.x);
+        scaled_source.size.x = static_cast<int>((static_cast<std::int64_t>(area.size.x) * source_rect.size.x) / dest_rect.size.x);
+
+        if (scaled_source.size.x == 0) {
+            scaled_source.size.x = 1;
+        }
+
+        const software_blend_state state = blend_state;
+
+        run_bands(area.size.y, static_cast<std::size_t>(area.size.x) * area.size.y, [&](int start, int end) {
+            thread_local std::vector<std::uint32_t> source_scratch;
+            thread_local std::vector<std::uint32_t> mask_scratch;
+
+            for (int y = start; y < end; y++) {
+                const int source_y = source_rect.top.y + static_cast<int>((static_cast<std::int64_t>(y + skip_y) * source_rect.size.y) / dest_rect.size.y);
+
+                const std::uint32_t *source_row = fetch_source_row(*bmp, scaled_source, source_y, area.size.x, source_scratch);
+                const std::uint32_t *mask_row = mask_bmp ? fetch_source_row(*mask_bmp, scaled_source, source_y, area.size.x, mask_scratch) : nullptr;
+
+                software_blit_row(target->row(area.top.y + y) + area.top.x, source_row, mask_row, area.size.x, tint, invert_mask, state);
+            }
+        });
+    }
+
+    void software_graphics_driver::draw_rectangle(command_helper &helper) {
+        eka2l1::rect fill_rect;
+        helper.pop(fill_rect);
+
+        const eka2l1::rect area = get_target_area().intersect(fill_rect);
+
+        if ((area.size.x <= 0) || (area.size.y <= 0)) {
+            return;
+        }
+
+        const std::uint32_t color = make_software_pixel(static_cast<std::uint8_t>(brush_color[0]), static_cast<std::uint8_t>(brush_color[1]),
+            static_cast<std::uint8_t>(brush_color[2]), static_cast<std::uint8_t>(brush_color[3]));
+
+        software_bitmap *target = binding;
+        const software_blend_state state = blend_state;
+
+        run_bands(area.size.y, static_cast<std::size_t>(area.size.x) * area.size.y, [&](int start, int end) {
+            for (int y = start; y < end; y++) {
+                software_fill_row(target->row(area.top.y + y) + area.top.x, color, area.size.x, state);
+            }
+        });
+    }
+
+    void software_graphics_driver::clear(command_helper &helper) {
+        std::uint32_t color_to_clear = 0;
+        std::uint8_t clear_bits = 0;
+
+        helper.pop(color_to_clear);
+        helper.pop(clear_bits);
+
+        // Depth and stencil are not emulated
+        if ((clear_bits & draw_buffer_bit_color_buffer) == 0) {
+            return;
+        }
+
+        // Same channel order as the GL backend
+        const std::uint32_t color = make_software_pixel(static_cast<std::uint8_t>((color_to_clear & 0xFF000000) >> 24),
+            static_cast<std::uint8_t>((color_to_clear & 0x00FF0000) >> 16), static_cast<std::uint8_t>((color_to_clear & 0x0000FF00) >> 8),
+            static_cast<std::uint8_t>(color_to_clear & 0x000000FF));
+
+        const eka2l1::rect area = get_target_area();
+
+        if ((area.size.x <= 0) || (area.size.y <= 0)) {
+            return;
+        }
+
+        for (int y = 0; y < area.size.y; y++) {
+            std::uint32_t *row = binding->row(area.top.y + y) + area.top.x;
+            std::fill(row, row + area.size.x, color);
+        }
+    }
+
+    void software_graphics_driver::set_brush_color(command_helper &helper) {
+        float r = 0.0f;
+        float g = 0.0f;
+        float b = 0.0f;
+        float a = 0.0f;
+
+        helper.pop(r);
+        helper.pop(g);
+        helper.pop(b);
+        helper.pop(a);
+
+        brush_color = { r, g, b, a };
+    }
+
+    void software_graphics_driver::set_clipping(command_helper &helper) {
+        bool enable = false;
+        helper.pop(enable);
+
+        clipping = enable;
+    }
+
+    void software_graphics_driver::clip_rect(command_helper &helper) {
+        eka2l1::rect new_clip;
+        helper.pop(new_clip);
+
+        // Negative height is the GL way of clipping from the bottom. In memory, rows always go from top to bottom.
+        new_clip.size.y = common::abs(new_clip.size.y);
+        clip = new_clip;
+    }
+
+    void software_graphics_driver::set_blend(command_helper &helper) {
+        bool enable = false;
+        helper.pop(enable);
+
+        blend_state.enabled_ = enable;
+    }
+
+    void software_graphics_driver::blend_formula(command_helper &helper) {
+        helper.pop(blend_state.rgb_equation_);
+        helper.pop(blend_state.a_equation_);
+        helper.pop(blend_state.rgb_frag_out_factor_);
+        helper.pop(blend_state.rgb_current_factor_);
+        helper.pop(blend_state.a_frag_out_factor_);
+        helper.pop(blend_state.a_current_factor_);
+    }
+
+    void software_graphics_driver::set_swizzle(command_helper &helper) {
+        drivers::handle num = 0;
+        channel_swizzles swizzles = { channel_swizzle::red, channel_swizzle::green, channel_swizzle::blue, channel_swizzle::alpha };
+
+        helper.pop(num);
+        helper.pop(swizzles[0]);
+        helper.pop(swizzles[1]);
+        helper.pop(swizzles[2]);
+        helper.pop(swizzles[3]);
+
+        software_bitmap *bmp = get_bitmap(num);
+
+        if (!bmp) {
+            // Only bitmaps exist in this driver
+            return;
+        }
+
+        bmp->swizzle = swizzles;
+    }
+
+    void software_graphics_driver::set_swapchain_size(command_helper &helper) {
+        eka2l1::vec2 size;
+        helper.pop(size);
+
+        swapchain.resize(size);
+    }
+
+    void software_graphics_driver::set_viewport(command_helper &helper) {
+        eka2l1::rect new_viewport;
+        helper.pop(new_viewport);
+
+        set_viewport(new_viewport);
+    }
+
+    void software_graphics_driver::display(command_helper &helper) {
+        if (disp_hook_) {
+            disp_hook_();
+        }
+
+        helper.finish(this, 0);
+    }
+
+    void software_graphics_driver::backup_state() {
+        backup.blend_state = blend_state;
+        backup.clipping = clipping;
+        backup.clip = clip;
+        backup.viewport = viewport;
+    }
+
+    void software_graphics_driver::restore_state() {
+        blend_state = backup.blend_state;
+        clipping = backup.clipping;
+        clip = backup.clip;
+        viewport = backup.viewport;
+    }
+
+    void software_graphics_driver::fail_creation(command_helper &helper) {
+        warn_unsupported(helper.todo_->opcode_);
+
+        if (helper.todo_->status_) {
+            helper.finish(this, -1);
+        }
+    }
+
+    std::unique_ptr<graphics_command_list> software_graphics_driver::new_command_list() {
+        auto list = std::make_unique<server_graphics_command_list>();
+        list->list_.arena_ = arena_pool.acquire();
+
+        return list;
+    }
+
+    std::unique_ptr<graphics_command_list_builder> software_graphics_driver::new_command_builder(graphics_command_list *list) {
+        return std::make_unique<server_graphics_command_list_builder>(list);
+    }
+
+    void software_graphics_driver::submit_command_list(graphics_command_list &command_list) {
+        list_queue.push(std::move(static_cast<server_graphics_command_list &>(command_list)));
+    }
+
+    void software_graphics_driver::dispatch(command *cmd) {
+        command_helper helper(cmd);
+
+        switch (cmd->opcode_) {
+        case graphics_driver_create_bitmap:
+            create_bitmap(helper);
+            break;
+
+        case graphics_driver_bind_bitmap:
+            bind_bitmap(helper);
+            break;
+
+        case graphics_driver_update_bitmap:
+            update_bitmap(helper);
+            break;
+
+        case graphics_driver_resize_bitmap:
+            resize_bitmap(helper);
+            break;
+
+        case graphics_driver_destroy_bitmap:
+            destroy_bitmap(helper);
+            break;
+
+        case graphics_driver_draw_bitmap:
+            draw_bitmap(helper);
+            break;
+
+        case graphics_driver_draw_rectangle:
+            draw_rectangle(helper);
+            break;
+
+        case graphics_driver_clear:
+            clear(helper);
+            break;
+
+        case graphics_driver_set_brush_color:
+            set_brush_color(helper);
+            break;
+
+        case graphics_driver_set_clipping:
+            set_clipping(helper);
+            break;
+
+        case graphics_driver_clip_rect:
+            clip_rect(helper);
+            break;
+
+        case graphics_driver_set_blend:
+            set_blend(helper);
+            break;
+
+        case graphics_driver_blend_formula:
+            blend_formula(helper);
+            break;
+
+        case graphics_driver_set_swizzle:
+            set_swizzle(helper);
+            break;
+
+        case graphics_driver_set_swapchain_size:
+            set_swapchain_size(helper);
+            break;
+
+        case graphics_driver_set_viewport:
+            set_viewport(helper);
+            break;
+
+        case graphics_driver_display:
+            display(helper);
+            break;
+
+        case graphics_driver_create_program:
+        case graphics_driver_create_texture:
+        case graphics_driver_create_buffer:
+            fail_creation(helper);
+            break;
+
+        case graphics_driver_native_dialog:
+            // No UI to pick anything with
+            helper.finish(this, 0);
+            break;
+
+        case graphics_driver_backup_state:
+            backup_state();
+            break;
+
+        case graphics_driver_restore_state:
+            restore_state();
+            break;
+
+        case graphics_driver_set_depth:
+        case graphics_driver_set_stencil:
+        case graphics_driver_set_cull:
+        case graphics_driver_set_back_face_rule:
+        case graphics_driver_stencil_pass_condition:
+        case graphics_driver_stencil_set_action:
+        case graphics_driver_stencil_set_mask:
+            // No depth, stencil or culling in 2D
+            break;
+
+        default:
+            warn_unsupported(cmd->opcode_);
+            break;
+        }
+    }
+
+    void software_graphics_driver::run() {
+        while (!should_stop) {
+            std::optional<server_graphics_command_list> list = list_queue.pop();
+
+            if (!list) {
+                LOG_ERROR("Corrupted graphics command list! Emulation halt.");
+                break;
+            }
+
+            EKA2L1_PROFILE_SCOPE("graphics", "Execute command list");
+            command *cmd = list->list_.first_;
+
+            while (cmd) {
+                dispatch(cmd);
+                cmd = cmd->next_;
+            }
+
+            arena_pool.release(std::move(list->list_.arena_));
+        }
+    }
+
+    void software_graphics_driver::abort() {
+        list_queue.abort();
+        should_stop = true;
+    }
+}
@@ -18,6 +18,7 @@
  */
 
 #include <drivers/graphics/backend/emu_window_glfw.h>
+#include <drivers/graphics/backend/emu_window_null.h>
 #include <drivers/graphics/emu_window.h>
 
 namespace eka2l1 {
@@ -27,6 +28,10 @@ namespace eka2l1 {
             case window_api::glfw: {
                 return std::make_unique<emu_window_glfw3>();
             }
+
+            case window_api::null: {
+                return std::make_unique<emu_window_null>();
+            }
             }
 
             return nullptr;
@@ -37,6 +42,9 @@ namespace eka2l1 {
             case window_api::glfw:
                 return glfwInit() == GLFW_TRUE ? true : false;
 
+            case window_api::null:
+                return true;
+
             default:
                 break;
             }
@@ -50,6 +58,9 @@ namespace eka2l1 {
                 glfwTerminate();
                 return true;
 
+            case window_api::null:
+                return true;
+
             default:
                 break;
             }
@@ -18,6 +18,7 @@
  */
 
 #include <drivers/graphics/backend/ogl/graphics_ogl.h>
+#include <drivers/graphics/backend/software/graphics_software.h>
 #include <drivers/graphics/graphics.h>
 
 #include <common/log.h>
@@ -58,6 +59,10 @@ namespace eka2l1::drivers {
             return std::make_unique<ogl_graphics_driver>();
         }
 
+        case graphic_api::software: {
+            return std::make_unique<software_graphics_driver>();
+        }
+
         default:
             break;
         }
@@ -29,6 +29,7 @@
 #include <common/log.h>
 #include <common/path.h>
 #include <common/platform.h>
+#include <common/profile.h>
 #include <common/random.h>
 
 #include <disasm/disasm.h>
@@ -345,6 +346,10 @@ namespace eka2l1 {
     void system_impl::startup() {
         exit = false;
 
+#if ENABLE_PROFILING == 1
+        common::profile::start_capture();
+#endif
+
         // Initialize all the system that doesn't depend on others first
         timing = std::make_unique<ntimer>(DEFAULT_CPU_HZ);
         asmdis.init();
@@ -454,6 +459,8 @@ namespace eka2l1 {
             kernel::thread *thr = kern->crr_thread();
 
             if (!should_step) {
+                EKA2L1_PROFILE_SCOPE("cpu", "JIT run");
+
                 cpu->run(thr->get_remaining_screenticks());
                 thr->add_ticks(cpu->get_num_instruction_executed());
             } else {
@@ -534,6 +541,10 @@ namespace eka2l1 {
     }
 
     void system_impl::shutdown() {
+#if ENABLE_PROFILING == 1
+        common::profile::stop_capture(eka2l1::add_path(conf->storage, "profile/trace.json"));
+#endif
+
         kern.reset();
         mem.reset();
         asmdis.shutdown();
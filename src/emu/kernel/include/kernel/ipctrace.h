@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <kernel/ipc.h>
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace eka2l1 {
+    class kernel_system;
+    class ntimer;
+}
+
+namespace eka2l1::kernel {
+    /**
+     * \brief IPC trace file layout.
+     *
+     * The file starts with the magic "EIPC" and a version byte. Records follow, each starting with
+     * a record type byte. Integers are LEB128 varints, signed ones are zigzag encoded first.
+     *
+     * - Server: index, name length, name. Defines a server name before its first message.
+     * - Send: time delta, server index, session id, function, flag, 4 args, has status byte,
+     *   descriptor mask byte, then for each descriptor in the mask: max length, data size, data.
+     * - Complete: time delta, sequence of the send record, completion code.
+     *
+     * Send records are numbered in file order, starting from 0. Time deltas are in microseconds,
+     * relative to the previous record.
+     */
+    enum ipc_trace_record_type : std::uint8_t {
+        ipc_trace_record_server = 0,
+        ipc_trace_record_send = 1,
+        ipc_trace_record_complete = 2
+    };
+
+    static constexpr std::uint8_t IPC_TRACE_VERSION = 1;
+
+    struct ipc_trace_descriptor {
+        std::uint32_t max_length_ = 0; ///< In characters, as the descriptor reports it.
+        std::vector<std::uint8_t> data_; ///< Content at the time the message was sent.
+    };
+
+    struct ipc_trace_send {
+        std::uint64_t timestamp_us_ = 0;
+        std::uint32_t sequence_ = 0;
+        std::uint32_t server_index_ = 0;
+        std::uint32_t session_id_ = 0;
+        std::int32_t function_ = 0;
+        ipc_arg args_;
+        bool has_status_ = false;
+        std::uint8_t descriptor_mask_ = 0; ///< Bit N set if argument N has its descriptor in descriptors_[N].
+        ipc_trace_descriptor descriptors_[4];
+    };
+
+    struct ipc_trace_complete {
+        std::uint64_t timestamp_us_ = 0;
+        std::uint32_t sequence_ = 0;
+        std::int32_t code_ = 0;
+    };
+
+    struct ipc_trace_record {
+        ipc_trace_record_type type_;
+        ipc_trace_send send_;
+        ipc_trace_complete complete_;
+    };
+
+    /**
+     * \brief Encode IPC trace records into a buffer, in the layout ipc_trace_reader reads.
+     */
+    class ipc_trace_writer {
+        std::vector<std::uint8_t> buffer_;
+        std::uint64_t last_timestamp_us_;
+
+        std::uint64_t timestamp_delta(const std::uint64_t timestamp_us);
+
+    public:
+        explicit ipc_trace_writer();
+
+        /**
+         * \brief Clear the buffer and write the file header.
+         *
+         * \param timestamp_us Time the first record's delta is counted from.
+         */
+        void begin(const std::uint64_t timestamp_us);
+
+        void write_server(const std::uint32_t index, const std::string &name);
+
+        /**
+         * \brief Write a send record.
+         *
+         * Only descriptors in the descriptor mask are written. The sequence is not stored, the reader
+         * numbers send records itself.
+         */
+        void write_send(const ipc_trace_send &send);
+        void write_complete(const ipc_trace_complete &complete);
+
+        std::vector<std::uint8_t> &buffer() {
+            return buffer_;
+        }
+    };
+
+    /**
+     * \brief Record IPC messages sent by guest code to a trace file.
+     *
+     * The recorder registers itself to the kernel's IPC send and complete callbacks. Descriptor
+     * arguments are copied out of the sender's memory when the message is sent, so the trace can be
+     * replayed later without the guest.
+     */
+    class ipc_trace_recorder {
+        kernel_system *kern_;
+        ntimer *timing_;
+
+        std::ofstream stream_;
+        ipc_trace_writer writer_;
+        std::mutex lock_;
+
+        std::size_t send_callback_handle_;
+        std::size_t complete_callback_handle_;
+        bool recording_;
+
+        std::unordered_map<std::string, std::uint32_t> server_indicies_;
+
+        // Outstanding requests, keyed by sender thread ID and request status address
+        std::map<std::pair<std::uint32_t, std::uint32_t>, std::uint32_t> pending_;
+
+        std::uint32_t sequence_;
+
+        void flush_if_needed(const bool force);
+
+        void on_send(const std::string &server_name, const int ord, const ipc_arg &args, kernel::thread *callee,
+            service::session *ss, eka2l1::ptr<epoc::request_status> status);
+        void on_complete(ipc_msg *msg, const std::int32_t code);
+
+    public:
+        explicit ipc_trace_recorder(kernel_system *kern, ntimer *timing);
+        ~ipc_trace_recorder();
+
+        /**
+         * \brief Start recording to a file on the host.
+         *
+         * \returns False if already recording, or the file can't be opened.
+         */
+        bool start(const std::string &path);
+
+        /**
+         * \brief Stop recording, and write out everything buffered.
+         */
+        void stop();
+
+        bool is_recording() const {
+            return recording_;
+        }
+    };
+
+    /**
+     * \brief Read records back from an IPC trace file.
+     */
+    class ipc_trace_reader {
+        std::ifstream stream_;
+        std::vector<std::string> server_names_;
+
+        std::uint32_t next_sequence_;
+        std::uint64_t timestamp_us_;
+        bool valid_;
+
+        bool read_byte(std::uint8_t &value);
+        bool read_varint(std::uint64_t &value);
+        bool read_signed_varint(std::int64_t &value);
+
+    public:
+        explicit ipc_trace_reader(const std::string &path);
+
+        /**
+         * \brief Check if the file exists and has a supported header.
+         */
+        bool is_valid() const {
+            return valid_;
+        }
+
+        /**
+         * \brief Read the next send or complete record.
+         *
+         * Server name records are consumed here, use server_name() to get them.
+         *
+         * \returns False at the end of the trace, or when the trace is corrupted.
+         */
+        bool next(ipc_trace_record &record);
+
+        /**
+         * \brief Get the name of a server, by the index stored in a send record.
+         *
+         * \returns Empty string if the index was never defined.
+         */
+        std::string server_name(const std::uint32_t index) const;
+    };
+}
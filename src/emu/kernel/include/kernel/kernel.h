@@ -55,7 +55,6 @@
 #include <memory>
 #include <mutex>
 #include <unordered_map>
-#include <regex>
 
 namespace eka2l1 {
 #define SYNCHRONIZE_ACCESS const std::lock_guard<std::mutex> guard(kern_lock)
@@ -157,8 +156,11 @@ namespace eka2l1 {
      * @param ord               The opcode number of this message.
      * @param args              Arguments for this message.
      * @param callee            Thread that sent this message.
+     * @param ss                Session this message is sent through.
+     * @param status            Request status to be completed. Null for blind messages.
      */
-    using ipc_send_callback = std::function<void(const std::string&, const int, const ipc_arg&, kernel::thread*)>;
+    using ipc_send_callback = std::function<void(const std::string&, const int, const ipc_arg&, kernel::thread*,
+        service::session*, eka2l1::ptr<epoc::request_status>)>;
 
     /**
      * @brief Callback invoked by the kernel when an IPC message completes.
@@ -297,7 +299,7 @@ namespace eka2l1 {
         void cpu_exception_handler(arm::core *core, arm::exception_type exception_type, const std::uint32_t exception_data);
 
         void call_ipc_send_callbacks(const std::string &server_name, const int ord, const ipc_arg &args,
-            kernel::thread *callee);
+            kernel::thread *callee, service::session *ss, eka2l1::ptr<epoc::request_status> status);
 
         void call_ipc_complete_callbacks(ipc_msg *msg, const int complete_code);
         void call_thread_kill_callbacks(kernel::thread *target, const std::string &category, const std::int32_t reason);
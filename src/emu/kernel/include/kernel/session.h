@@ -72,7 +72,13 @@ namespace eka2l1 {
             void destroy() override;
 
             int send_receive_sync(const int function, const ipc_arg &args, eka2l1::ptr<epoc::request_status> request_sts);
-            int send_receive(const int function, const ipc_arg &args, eka2l1::ptr<epoc::request_status> request_sts);
+            /**
+             * \brief Send an asynchronous message through this session.
+             *
+             * \param sender Thread the message is sent from. Null for the current thread.
+             */
+            int send_receive(const int function, const ipc_arg &args, eka2l1::ptr<epoc::request_status> request_sts,
+                kernel::thread *sender = nullptr);
 
             void set_cookie_address(const uint32_t addr) {
                 cookie_address = addr;
@@ -0,0 +1,487 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <kernel/ipctrace.h>
+#include <kernel/kernel.h>
+#include <kernel/timing.h>
+
+#include <common/log.h>
+#include <common/path.h>
+
+#include <utils/des.h>
+
+#include <algorithm>
+
+namespace eka2l1::kernel {
+    static constexpr char IPC_TRACE_MAGIC[4] = { 'E', 'I', 'P', 'C' };
+
+    // Write out the buffer once it grows past this
+    static constexpr std::size_t IPC_TRACE_FLUSH_THRESHOLD = 256 * 1024;
+
+    // Descriptors bigger than this are not captured, the replay gets an empty one instead
+    static constexpr std::uint32_t IPC_TRACE_MAX_DESCRIPTOR_SIZE = 16 * 1024 * 1024;
+
+    static void write_varint(std::vector<std::uint8_t> &buffer, std::uint64_t value) {
+        do {
+            std::uint8_t byte = static_cast<std::uint8_t>(value & 0x7F);
+            value >>= 7;
+
+            if (value) {
+                byte |= 0x80;
+            }
+
+            buffer.push_back(byte);
+        } while (value);
+    }
+
+    static void write_signed_varint(std::vector<std::uint8_t> &buffer, const std::int64_t value) {
+        write_varint(buffer, (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+    }
+
+    ipc_trace_writer::ipc_trace_writer()
+        : last_timestamp_us_(0) {
+    }
+
+    std::uint64_t ipc_trace_writer::timestamp_delta(const std::uint64_t timestamp_us) {
+        const std::uint64_t delta = (timestamp_us > last_timestamp_us_) ? (timestamp_us - last_timestamp_us_) : 0;
+
+        last_timestamp_us_ = std::max(timestamp_us, last_timestamp_us_);
+        return delta;
+    }
+
+    void ipc_trace_writer::begin(const std::uint64_t timestamp_us) {
+        buffer_.clear();
+        buffer_.insert(buffer_.end(), IPC_TRACE_MAGIC, IPC_TRACE_MAGIC + sizeof(IPC_TRACE_MAGIC));
+        buffer_.push_back(IPC_TRACE_VERSION);
+
+        last_timestamp_us_ = timestamp_us;
+    }
+
+    void ipc_trace_writer::write_server(const std::uint32_t index, const std::string &name) {
+        buffer_.push_back(ipc_trace_record_server);
+        write_varint(buffer_, index);
+        write_varint(buffer_, name.size());
+        buffer_.insert(buffer_.end(), name.begin(), name.end());
+    }
+
+    void ipc_trace_writer::write_send(const ipc_trace_send &send) {
+        buffer_.push_back(ipc_trace_record_send);
+        write_varint(buffer_, timestamp_delta(send.timestamp_us_));
+        write_varint(buffer_, send.server_index_);
+        write_varint(buffer_, send.session_id_);
+        write_signed_varint(buffer_, send.function_);
+        write_varint(buffer_, static_cast<std::uint32_t>(send.args_.flag));
+
+        for (const int arg : send.args_.args) {
+            write_varint(buffer_, static_cast<std::uint32_t>(arg));
+        }
+
+        buffer_.push_back(send.has_status_ ? 1 : 0);
+        buffer_.push_back(send.descriptor_mask_);
+
+        for (int i = 0; i < 4; i++) {
+            if (!(send.descriptor_mask_ & (1 << i))) {
+                continue;
+            }
+
+            const ipc_trace_descriptor &descriptor = send.descriptors_[i];
+
+            write_varint(buffer_, descriptor.max_length_);
+            write_varint(buffer_, descriptor.data_.size());
+            buffer_.insert(buffer_.end(), descriptor.data_.begin(), descriptor.data_.end());
+        }
+    }
+
+    void ipc_trace_writer::write_complete(const ipc_trace_complete &complete) {
+        buffer_.push_back(ipc_trace_record_complete);
+        write_varint(buffer_, timestamp_delta(complete.timestamp_us_));
+        write_varint(buffer_, complete.sequence_);
+        write_signed_varint(buffer_, complete.code_);
+    }
+
+    ipc_trace_recorder::ipc_trace_recorder(kernel_system *kern, ntimer *timing)
+        : kern_(kern)
+        , timing_(timing)
+        , send_callback_handle_(0)
+        , complete_callback_handle_(0)
+        , recording_(false)
+        , sequence_(0) {
+    }
+
+    ipc_trace_recorder::~ipc_trace_recorder() {
+        stop();
+    }
+
+    bool ipc_trace_recorder::start(const std::string &path) {
+        const std::lock_guard<std::mutex> guard(lock_);
+
+        if (recording_) {
+            return false;
+        }
+
+        const std::string directory = eka2l1::file_directory(path);
+
+        if (!directory.empty()) {
+            eka2l1::create_directories(directory);
+        }
+
+        stream_.open(path, std::ios::binary | std::ios::trunc);
+
+        if (stream_.fail()) {
+            LOG_ERROR("Unable to open IPC trace file {}", path);
+            return false;
+        }
+
+        writer_.begin(timing_->microseconds());
+
+        server_indicies_.clear();
+        pending_.clear();
+
+        sequence_ = 0;
+        recording_ = true;
+
+        send_callback_handle_ = kern_->register_ipc_send_callback([this](const std::string &server_name, const int ord,
+                                                                      const ipc_arg &args, kernel::thread *callee, service::session *ss, eka2l1::ptr<epoc::request_status> status) {
+            on_send(server_name, ord, args, callee, ss, status);
+        });
+
+        complete_callback_handle_ = kern_->register_ipc_complete_callback([this](ipc_msg *msg, const std::int32_t code) {
+            on_complete(msg, code);
+        });
+
+        LOG_INFO("Recording IPC trace to {}", path);
+        return true;
+    }
+
+    void ipc_trace_recorder::stop() {
+        if (!recording_) {
+            return;
+        }
+
+        kern_->unregister_ipc_send_callback(send_callback_handle_);
+        kern_->unregister_ipc_complete_callback(complete_callback_handle_);
+
+        const std::lock_guard<std::mutex> guard(lock_);
+
+        flush_if_needed(true);
+        stream_.close();
+
+        recording_ = false;
+        LOG_INFO("IPC trace recorded, {} messages", sequence_);
+    }
+
+    void ipc_trace_recorder::flush_if_needed(const bool force) {
+        std::vector<std::uint8_t> &buffer = writer_.buffer();
+
+        if (buffer.empty() || (!force && (buffer.size() < IPC_TRACE_FLUSH_THRESHOLD))) {
+            return;
+        }
+
+        stream_.write(reinterpret_cast<const char *>(buffer.data()), buffer.size());
+        buffer.clear();
+    }
+
+    void ipc_trace_recorder::on_send(const std::string &server_name, const int ord, const ipc_arg &args, kernel::thread *callee,
+        service::session *ss, eka2l1::ptr<epoc::request_status> status) {
+        const std::lock_guard<std::mutex> guard(lock_);
+
+        if (!recording_ || !ss || !callee) {
+            return;
+        }
+
+        auto server_ite = server_indicies_.find(server_name);
+
+        if (server_ite == server_indicies_.end()) {
+            const std::uint32_t index = static_cast<std::uint32_t>(server_indicies_.size());
+            server_ite = server_indicies_.emplace(server_name, index).first;
+
+            writer_.write_server(index, server_name);
+        }
+
+        ipc_trace_send send;
+        send.timestamp_us_ = timing_->microseconds();
+        send.server_index_ = server_ite->second;
+        send.session_id_ = ss->unique_id();
+        send.function_ = ord;
+        send.args_ = args;
+        send.has_status_ = static_cast<bool>(status);
+
+        // Copy out descriptors. With no header flag, the argument types are unknown.
+        kernel::process *pr = callee->owning_process();
+        ipc_arg args_copy = args;
+
+        for (int i = 0; (i < 4) && pr && (args.flag != -1); i++) {
+            const int arg_type = static_cast<int>(args_copy.get_arg_type(i));
+
+            if (!(arg_type & static_cast<int>(ipc_arg_type::flag_des))) {
+                continue;
+            }
+
+            epoc::des8 *des = eka2l1::ptr<epoc::des8>(static_cast<std::uint32_t>(args.args[i])).get(pr);
+
+            if (!des || !des->is_valid_descriptor()) {
+                continue;
+            }
+
+            const std::uint32_t char_size = (arg_type & static_cast<int>(ipc_arg_type::flag_16b)) ? 2 : 1;
+            const std::uint32_t data_size = des->get_length() * char_size;
+            const std::uint8_t *data = reinterpret_cast<const std::uint8_t *>(des->get_pointer_raw(pr));
+
+            if ((data_size > IPC_TRACE_MAX_DESCRIPTOR_SIZE) || (data_size && !data)) {
+                continue;
+            }
+
+            send.descriptor_mask_ |= static_cast<std::uint8_t>(1 << i);
+            send.descriptors_[i].max_length_ = des->get_max_length(pr);
+            send.descriptors_[i].data_.assign(data, data + data_size);
+        }
+
+        writer_.write_send(send);
+
+        if (status) {
+            pending_[{ callee->unique_id(), status.ptr_address() }] = sequence_;
+        }
+
+        sequence_++;
+        flush_if_needed(false);
+    }
+
+    void ipc_trace_recorder::on_complete(ipc_msg *msg, const std::int32_t code) {
+        const std::lock_guard<std::mutex> guard(lock_);
+
+        if (!recording_ || !msg->own_thr || !msg->request_sts) {
+            return;
+        }
+
+        auto pending_ite = pending_.find({ msg->own_thr->unique_id(), msg->request_sts.ptr_address() });
+
+        if (pending_ite == pending_.end()) {
+            // Sent before the recording started
+            return;
+        }
+
+        ipc_trace_complete complete;
+        complete.timestamp_us_ = timing_->microseconds();
+        complete.sequence_ = pending_ite->second;
+        complete.code_ = code;
+
+        writer_.write_complete(complete);
+
+        pending_.erase(pending_ite);
+        flush_if_needed(false);
+    }
+
+    ipc_trace_reader::ipc_trace_reader(const std::string &path)
+        : stream_(path, std::ios::binary)
+        , next_sequence_(0)
+        , timestamp_us_(0)
+        , valid_(false) {
+        char magic[sizeof(IPC_TRACE_MAGIC)];
+        std::uint8_t version = 0;
+
+        if (stream_.fail() || !stream_.read(magic, sizeof(magic)) || !read_byte(version)) {
+            return;
+        }
+
+        if (std::equal(magic, magic + sizeof(magic), IPC_TRACE_MAGIC) && (version == IPC_TRACE_VERSION)) {
+            valid_ = true;
+        }
+    }
+
+    bool ipc_trace_reader::read_byte(std::uint8_t &value) {
+        char c = 0;
+
+        if (!stream_.get(c)) {
+            return false;
+        }
+
+        value = static_cast<std::uint8_t>(c);
+        return true;
+    }
+
+    bool ipc_trace_reader::read_varint(std::uint64_t &value) {
+        value = 0;
+
+        for (int shift = 0; shift < 64; shift += 7) {
+            std::uint8_t byte = 0;
+
+            if (!read_byte(byte)) {
+                return false;
+            }
+
+            value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+
+            if (!(byte & 0x80)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool ipc_trace_reader::read_signed_varint(std::int64_t &value) {
+        std::uint64_t encoded = 0;
+
+        if (!read_varint(encoded)) {
+            return false;
+        }
+
+        value = static_cast<std::int64_t>(encoded >> 1) ^ -static_cast<std::int64_t>(encoded & 1);
+        return true;
+    }
+
+    bool ipc_trace_reader::next(ipc_trace_record &record) {
+        if (!valid_) {
+            return false;
+        }
+
+        std::uint8_t type = 0;
+        std::uint64_t value = 0;
+        std::int64_t signed_value = 0;
+
+        while (read_byte(type)) {
+            switch (type) {
+            case ipc_trace_record_server: {
+                std::uint64_t index = 0;
+                std::uint64_t length = 0;
+
+                if (!read_varint(index) || !read_varint(length) || (index != server_names_.size())) {
+                    valid_ = false;
+                    return false;
+                }
+
+                std::string name(static_cast<std::size_t>(length), '\0');
+
+                if (length && !stream_.read(&name[0], length)) {
+                    valid_ = false;
+                    return false;
+                }
+
+                server_names_.push_back(std::move(name));
+                break;
+            }
+
+            case ipc_trace_record_send: {
+                ipc_trace_send &send = record.send_;
+                std::uint64_t fields[7];
+
+                record.type_ = ipc_trace_record_send;
+
+                if (!read_varint(value) || !read_varint(fields[0]) || !read_varint(fields[1]) || !read_signed_varint(signed_value)) {
+                    valid_ = false;
+                    return false;
+                }
+
+                timestamp_us_ += value;
+
+                send.timestamp_us_ = timestamp_us_;
+                send.sequence_ = next_sequence_++;
+                send.server_index_ = static_cast<std::uint32_t>(fields[0]);
+                send.session_id_ = static_cast<std::uint32_t>(fields[1]);
+                send.function_ = static_cast<std::int32_t>(signed_value);
+
+                for (int i = 2; i < 7; i++) {
+                    if (!read_varint(fields[i])) {
+                        valid_ = false;
+                        return false;
+                    }
+                }
+
+                send.args_.flag = static_cast<int>(fields[2]);
+
+                for (int i = 0; i < 4; i++) {
+                    send.args_.args[i] = static_cast<int>(fields[3 + i]);
+                }
+
+                std::uint8_t has_status = 0;
+
+                if (!read_byte(has_status) || !read_byte(send.descriptor_mask_)) {
+                    valid_ = false;
+                    return false;
+                }
+
+                send.has_status_ = (has_status != 0);
+
+                for (int i = 0; i < 4; i++) {
+                    ipc_trace_descriptor &descriptor = send.descriptors_[i];
+                    descriptor.max_length_ = 0;
+                    descriptor.data_.clear();
+
+                    if (!(send.descriptor_mask_ & (1 << i))) {
+                        continue;
+                    }
+
+                    std::uint64_t max_length = 0;
+                    std::uint64_t data_size = 0;
+
+                    if (!read_varint(max_length) || !read_varint(data_size) || (data_size > IPC_TRACE_MAX_DESCRIPTOR_SIZE)) {
+                        valid_ = false;
+                        return false;
+                    }
+
+                    descriptor.max_length_ = static_cast<std::uint32_t>(max_length);
+                    descriptor.data_.resize(static_cast<std::size_t>(data_size));
+
+                    if (data_size && !stream_.read(reinterpret_cast<char *>(descriptor.data_.data()), data_size)) {
+                        valid_ = false;
+                        return false;
+                    }
+                }
+
+                return true;
+            }
+
+            case ipc_trace_record_complete: {
+                ipc_trace_complete &complete = record.complete_;
+                std::uint64_t sequence = 0;
+
+                record.type_ = ipc_trace_record_complete;
+
+                if (!read_varint(value) || !read_varint(sequence) || !read_signed_varint(signed_value)) {
+                    valid_ = false;
+                    return false;
+                }
+
+                timestamp_us_ += value;
+
+                complete.timestamp_us_ = timestamp_us_;
+                complete.sequence_ = static_cast<std::uint32_t>(sequence);
+                complete.code_ = static_cast<std::int32_t>(signed_value);
+
+                return true;
+            }
+
+            default:
+                LOG_ERROR("Unknown IPC trace record type {}, trace is corrupted", type);
+                valid_ = false;
+                return false;
+            }
+        }
+
+        return false;
+    }
+
+    std::string ipc_trace_reader::server_name(const std::uint32_t index) const {
+        if (index >= server_names_.size()) {
+            return "";
+        }
+
+        return server_names_[index];
+    }
+}
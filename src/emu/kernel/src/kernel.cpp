@@ -267,9 +267,9 @@ namespace eka2l1 {
     }
 
     void kernel_system::call_ipc_send_callbacks(const std::string &server_name, const int ord, const ipc_arg &args,
-        kernel::thread *callee) {
+        kernel::thread *callee, service::session *ss, eka2l1::ptr<epoc::request_status> status) {
         for (auto &ipc_send_callback_func: ipc_send_callbacks_) {
-            ipc_send_callback_func(server_name, ord, args, callee);
+            ipc_send_callback_func(server_name, ord, args, callee, ss, status);
         }
     }
 
@@ -767,7 +767,7 @@ namespace eka2l1 {
 
     std::optional<find_handle> kernel_system::find_object(const std::string &name, int start, kernel::object_type type, const bool use_full_name) {
         find_handle handle_find_info;
-        std::regex filter(common::wildcard_to_regex_string(name));
+        const common::wildcard_matcher filter(name, false);
 
         switch (type) {
 #define OBJECT_SEARCH(obj_type, obj_map)                                                       \
@@ -779,7 +779,7 @@ namespace eka2l1 {
             } else {                                                                           \
                 to_compare = rhs->name();                                                      \
             }                                                                                  \
-            return std::regex_match(to_compare, filter);                                       \
+            return filter.match(to_compare);                                                   \
         });                                                                                    \
         if (res == obj_map.end())                                                              \
             return std::nullopt;                                                               \
@@ -24,6 +24,7 @@
 #include <common/ini.h>
 #include <common/log.h>
 #include <common/path.h>
+#include <common/profile.h>
 #include <common/random.h>
 
 #include <kernel/common.h>
@@ -808,6 +809,7 @@ namespace eka2l1::hle {
         }
 
         epoc_import_func func = res->second;
+        EKA2L1_PROFILE_SCOPE_DYNAMIC("svc", func.name);
 
         if (kern_->get_config()->log_svc) {
             LOG_TRACE("Calling SVC 0x{:x} {}", svcnum, func.name);
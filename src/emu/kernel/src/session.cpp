@@ -97,7 +97,8 @@ namespace eka2l1 {
             return 0;
         }
 
-        int session::send_receive(const int function, const ipc_arg &args, eka2l1::ptr<epoc::request_status> request_sts) {
+        int session::send_receive(const int function, const ipc_arg &args, eka2l1::ptr<epoc::request_status> request_sts,
+            kernel::thread *sender) {
             ipc_msg_ptr msg = get_free_msg();
 
             if (!msg) {
@@ -107,7 +108,7 @@ namespace eka2l1 {
             msg->function = function;
             msg->args = args;
             msg->request_sts = request_sts;
-            msg->own_thr = kern->crr_thread();
+            msg->own_thr = sender ? sender : kern->crr_thread();
 
             send(msg);
 
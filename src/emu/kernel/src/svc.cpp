@@ -958,7 +958,7 @@ namespace eka2l1::epoc {
         }
 
         const std::string server_name = ss->get_server()->name();
-        kern->call_ipc_send_callbacks(server_name, ord, arg, kern->crr_thread());
+        kern->call_ipc_send_callbacks(server_name, ord, arg, kern->crr_thread(), ss, status);
 
         const int result = sync ? ss->send_receive_sync(ord, arg, status) : ss->send_receive(ord, arg, status);
 
@@ -3507,10 +3507,9 @@ namespace eka2l1::epoc {
         std::u16string source = str_des->to_std_string(crr_process);
         std::u16string sequence_search = seq_des->to_std_string(crr_process);
 
-        const std::size_t pos = common::match_wildcard_in_string(common::ucs2_to_wstr(source), common::ucs2_to_wstr(sequence_search),
-            is_fold);
+        const std::size_t pos = common::match_wildcard_in_string(source, sequence_search, is_fold);
 
-        if (pos == std::wstring::npos) {
+        if (pos == std::u16string::npos) {
             return epoc::error_not_found;
         }
 
@@ -21,6 +21,8 @@
 #include <common/algorithm.h>
 #include <common/chunkyseri.h>
 #include <common/log.h>
+#include <common/profile.h>
+#include <common/thread.h>
 
 #include <kernel/timing.h>
 
@@ -52,6 +54,8 @@ namespace eka2l1 {
     }
 
     void ntimer::loop() {
+        common::set_thread_name("Timer thread");
+
         while (!should_stop_) {
             while (!should_paused_) {
                 const std::optional<std::uint64_t> next_microseconds = advance();
@@ -87,8 +91,13 @@ namespace eka2l1 {
             });
 
             unq.unlock();
-            event_types_[evt.event_type]
-                .callback(evt.event_user_data, static_cast<int>(global_timer - evt.event_time));
+
+            {
+                EKA2L1_PROFILE_SCOPE_DYNAMIC("timer", event_types_[evt.event_type].name);
+                event_types_[evt.event_type]
+                    .callback(evt.event_user_data, static_cast<int>(global_timer - evt.event_time));
+            }
+
             unq.lock();
         }
 
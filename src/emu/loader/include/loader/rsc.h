@@ -24,9 +24,12 @@
 #pragma once
 
 #include <cstdint>
+#include <list>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace eka2l1 {
@@ -70,15 +73,13 @@ namespace eka2l1::loader {
         std::vector<std::uint16_t> lookup_offset_table_;
         std::vector<std::uint8_t> lookup_data_;
 
-        bool lookup_mode_;
-
         bool read_header(common::ro_stream *seri);
-        std::optional<std::uint16_t> read_bits(const std::int16_t offset, const std::int16_t count);
+        std::optional<std::uint16_t> read_bits(const std::int16_t offset, const std::int16_t count, const bool is_lookup) const;
 
     public:
         explicit rsc_file_legacy(common::ro_stream *seri);
 
-        void read_internal(const int res_id, std::vector<std::uint8_t> &buffer, const bool is_lookup = false);
+        void read_internal(const int res_id, std::vector<std::uint8_t> &buffer, const bool is_lookup = false) const;
         std::vector<std::uint8_t> read(const int res_id) override;
 
         std::uint16_t get_total_resources() const override {
@@ -120,6 +121,10 @@ namespace eka2l1::loader {
             std::uint32_t offset;
         } signature;
 
+        // The file may be shared through the resource cache, confirm only once
+        std::once_flag signature_confirm_flag;
+        bool signature_valid = false;
+
         std::vector<std::uint8_t> unicode_flag_array;
         std::vector<std::uint8_t> res_data;
 
@@ -146,13 +151,117 @@ namespace eka2l1::loader {
         bool confirm_signature() override;
     };
 
+    using rsc_file_impl_ptr = std::shared_ptr<rsc_file_impl_base>;
+
+    /**
+     * \brief Parse a RSC file from stream, choosing the right format.
+     *
+     * \returns Null if the stream can't be read.
+     */
+    rsc_file_impl_ptr instantiate_rsc_impl(common::ro_stream *stream);
+
+    /**
+     * \brief Process-wide cache of parsed RSC files and their decompressed resources.
+     *
+     * Files are identified by path and last modification time, so a modified file is parsed
+     * again. Parsed files are bounded by count, decompressed resources by a memory budget;
+     * the least recently used ones are evicted first.
+     */
+    class rsc_cache {
+        struct file_key {
+            std::u16string path_;
+            std::uint64_t last_write_;
+
+            bool operator==(const file_key &rhs) const {
+                return (last_write_ == rhs.last_write_) && (path_ == rhs.path_);
+            }
+        };
+
+        struct resource_key {
+            file_key file_;
+            int res_id_;
+
+            bool operator==(const resource_key &rhs) const {
+                return (res_id_ == rhs.res_id_) && (file_ == rhs.file_);
+            }
+        };
+
+        struct key_hasher {
+            std::size_t operator()(const file_key &key) const;
+            std::size_t operator()(const resource_key &key) const;
+        };
+
+        using file_list = std::list<std::pair<file_key, rsc_file_impl_ptr>>;
+        using resource_list = std::list<std::pair<resource_key, std::vector<std::uint8_t>>>;
+
+        std::mutex lock_;
+
+        // Front is the most recently used
+        file_list files_;
+        std::unordered_map<file_key, file_list::iterator, key_hasher> file_lookup_;
+
+        resource_list resources_;
+        std::unordered_map<resource_key, resource_list::iterator, key_hasher> resource_lookup_;
+
+        std::size_t max_files_;
+        std::size_t resource_budget_;
+        std::size_t resource_usage_;
+
+        void evict_resources();
+
+    public:
+        explicit rsc_cache(const std::size_t max_files = 64, const std::size_t resource_budget = 4 * 1024 * 1024);
+
+        /**
+         * \brief Get the parsed file, parsing it from the stream if it's not cached.
+         *
+         * \param path        Path of the file. Compared case-insensitively.
+         * \param last_write  Last modification time of the file.
+         * \param stream      Stream of the file content, only read on a cache miss.
+         *
+         * \returns Null if the file can't be parsed.
+         */
+        rsc_file_impl_ptr get_file(const std::u16string &path, const std::uint64_t last_write, common::ro_stream *stream);
+
+        bool get_resource(const std::u16string &path, const std::uint64_t last_write, const int res_id,
+            std::vector<std::uint8_t> &data);
+
+        void put_resource(const std::u16string &path, const std::uint64_t last_write, const int res_id,
+            const std::vector<std::uint8_t> &data);
+
+        std::size_t resource_memory_usage();
+        void clear();
+    };
+
+    /**
+     * \brief Get the resource cache shared by everyone in this process.
+     */
+    rsc_cache &get_rsc_cache();
+
     class rsc_file {
     protected:
-        std::unique_ptr<rsc_file_impl_base> impl_;
+        rsc_file_impl_ptr impl_;
+
+        std::u16string cache_path_;
+        std::uint64_t cache_last_write_ = 0;
+        bool cached_ = false;
+
         void instantiate_impl(common::ro_stream *stream);
 
     public:
         explicit rsc_file(common::ro_stream *stream);
+
+        /**
+         * \brief Open a RSC file through the shared resource cache.
+         *
+         * The stream is only parsed if the file is not yet cached. Resources read are also
+         * kept in the cache for the next reader of the same file.
+         *
+         * \param stream      Stream of the file content.
+         * \param path        Path of the file.
+         * \param last_write  Last modification time of the file.
+         */
+        explicit rsc_file(common::ro_stream *stream, const std::u16string &path, const std::uint64_t last_write);
         
         std::vector<std::uint8_t> read(const int res_id);
         std::uint32_t get_uid(const int idx);
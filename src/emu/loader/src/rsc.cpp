@@ -502,16 +502,20 @@ namespace eka2l1::loader {
     }
 
     bool rsc_file_morden::confirm_signature() {
-        auto dat = read(1);
+        std::call_once(signature_confirm_flag, [this]() {
+            auto dat = read(1);
 
-        if (dat.size() > sizeof(sig_record)) {
-            return false;
-        }
+            if (dat.size() > sizeof(sig_record)) {
+                return;
+            }
 
-        signature = *reinterpret_cast<sig_record *>(&dat[0]);
-        signature.offset &= 0xFFFFF000;
+            signature = *reinterpret_cast<sig_record *>(&dat[0]);
+            signature.offset &= 0xFFFFF000;
 
-        return true;
+            signature_valid = true;
+        });
+
+        return signature_valid;
     }
 
     rsc_file_morden::rsc_file_morden(common::ro_stream *buf)
@@ -604,7 +608,7 @@ namespace eka2l1::loader {
         return true;
     }
 
-    std::optional<std::uint16_t> rsc_file_legacy::read_bits(const std::int16_t offset, const std::int16_t count) {
+    std::optional<std::uint16_t> rsc_file_legacy::read_bits(const std::int16_t offset, const std::int16_t count, const bool is_lookup) const {
         if (count > 16) {
             return std::nullopt;
         }
@@ -618,9 +622,9 @@ namespace eka2l1::loader {
                 static_cast<std::int8_t>(common::min<std::int16_t>(8 - (current_offset & 7), count - bit_read));
 
             if ((bit_to_read_once == 8) && ((current_offset & 7) == 0)) {
-                result |= lookup_mode_ ? (lookup_data_[current_offset >> 3] << bit_read) : (res_data_[current_offset >> 3] << bit_read);
+                result |= is_lookup ? (lookup_data_[current_offset >> 3] << bit_read) : (res_data_[current_offset >> 3] << bit_read);
             } else {
-                result |= common::extract_bits(lookup_mode_ ? lookup_data_[current_offset >> 3] : res_data_[current_offset >> 3],
+                result |= common::extract_bits(is_lookup ? lookup_data_[current_offset >> 3] : res_data_[current_offset >> 3],
                     (current_offset & 7) + 1, bit_to_read_once) << bit_read;
             }
 
@@ -631,7 +635,7 @@ namespace eka2l1::loader {
         return result;
     }
 
-    void rsc_file_legacy::read_internal(const int res_id, std::vector<std::uint8_t> &buffer, const bool is_lookup) {
+    void rsc_file_legacy::read_internal(const int res_id, std::vector<std::uint8_t> &buffer, const bool is_lookup) const {
         if (!is_lookup && ((res_id <= 0) || (res_id > resource_count_))) {
             return;
         }
@@ -652,38 +656,36 @@ namespace eka2l1::loader {
         std::int16_t end_offset = is_lookup ? lookup_offset_table_[res_id] : res_data_offset_table_[res_id];
         const std::int16_t compressed_resource_size_in_bits = end_offset - iterate_offset;
 
-        lookup_mode_ = is_lookup;
-
         while (iterate_offset < end_offset) {
-            if (read_bits(iterate_offset, 1).value() == 1) {
+            if (read_bits(iterate_offset, 1, is_lookup).value() == 1) {
                 iterate_offset++;
 
-                if (read_bits(iterate_offset, 1).value() == 1) {
+                if (read_bits(iterate_offset, 1, is_lookup).value() == 1) {
                     iterate_offset++;
 
-                    if (read_bits(iterate_offset, 1).value() == 1) {
+                    if (read_bits(iterate_offset, 1, is_lookup).value() == 1) {
                         iterate_offset++;
 
-                        if (read_bits(iterate_offset, 1).value() == 1) {
+                        if (read_bits(iterate_offset, 1, is_lookup).value() == 1) {
                             iterate_offset++;
                             
                             // Repeat count with 8
-                            std::uint16_t repeat_count = read_bits(iterate_offset, 8).value();
+                            std::uint16_t repeat_count = read_bits(iterate_offset, 8, is_lookup).value();
                             iterate_offset += 8;
 
                             for (std::uint16_t i = 0; i < repeat_count; i++) {
-                                buffer.push_back(static_cast<std::uint8_t>(read_bits(iterate_offset, 8).value()));
+                                buffer.push_back(static_cast<std::uint8_t>(read_bits(iterate_offset, 8, is_lookup).value()));
                                 iterate_offset += 8;
                             }
                         } else {
                             iterate_offset++;
 
                             // Repeat count with 3-bits
-                            std::uint16_t repeat_count = read_bits(iterate_offset, 3).value() + 3;
+                            std::uint16_t repeat_count = read_bits(iterate_offset, 3, is_lookup).value() + 3;
                             iterate_offset += 3;
 
                             for (std::uint16_t i = 0; i < repeat_count; i++) {
-                                buffer.push_back(static_cast<std::uint8_t>(read_bits(iterate_offset, 8).value()));
+                                buffer.push_back(static_cast<std::uint8_t>(read_bits(iterate_offset, 8, is_lookup).value()));
                                 iterate_offset += 8;
                             }
                         }
@@ -691,7 +693,7 @@ namespace eka2l1::loader {
                         iterate_offset++;
 
                         // Read 2 normal integer
-                        std::uint16_t byte_data = read_bits(iterate_offset, 16).value();
+                        std::uint16_t byte_data = read_bits(iterate_offset, 16, is_lookup).value();
                         buffer.push_back(static_cast<std::uint8_t>(byte_data));
                         buffer.push_back(static_cast<std::uint8_t>(byte_data >> 8));
 
@@ -701,7 +703,7 @@ namespace eka2l1::loader {
                     iterate_offset++;
 
                     // Read a normal byte
-                    std::uint16_t byte_data = read_bits(iterate_offset, 8).value();
+                    std::uint16_t byte_data = read_bits(iterate_offset, 8, is_lookup).value();
                     buffer.push_back(static_cast<std::uint8_t>(byte_data));
 
                     iterate_offset += 8;
@@ -710,12 +712,10 @@ namespace eka2l1::loader {
                 iterate_offset++;
 
                 // Use the lookup table. Not sure if it's really lookup :D
-                std::uint16_t lookup_id = read_bits(iterate_offset, lookup_table_read_bit_count_).value();
+                std::uint16_t lookup_id = read_bits(iterate_offset, lookup_table_read_bit_count_, is_lookup).value();
                 iterate_offset += lookup_table_read_bit_count_;
 
-                bool previous_mode = lookup_mode_;
-                read_internal(lookup_id + 1, buffer, true);        
-                lookup_mode_ = previous_mode;
+                read_internal(lookup_id + 1, buffer, true);
             }
         }
     }
@@ -727,38 +727,183 @@ namespace eka2l1::loader {
         return buf;
     }
 
-    rsc_file_legacy::rsc_file_legacy(common::ro_stream *seri)
-        : lookup_mode_(false) {
+    rsc_file_legacy::rsc_file_legacy(common::ro_stream *seri) {
         read_header(seri);
     }
 
-    void rsc_file::instantiate_impl(common::ro_stream *stream) {
+    rsc_file_impl_ptr instantiate_rsc_impl(common::ro_stream *stream) {
         std::uint32_t uid = 0;
         if (stream->read(&uid, 4) != 4) {
-            return;
+            return nullptr;
         }
 
         stream->seek(0, common::seek_where::beg);
 
         if ((uid == 0x101F4A6B) || (uid == 0x101F5010)) {
-            impl_ = std::make_unique<rsc_file_morden>(stream);
+            return std::make_shared<rsc_file_morden>(stream);
+        }
+
+        return std::make_shared<rsc_file_legacy>(stream);
+    }
+
+    std::size_t rsc_cache::key_hasher::operator()(const file_key &key) const {
+        return std::hash<std::u16string>()(key.path_) ^ (std::hash<std::uint64_t>()(key.last_write_) * 31);
+    }
+
+    std::size_t rsc_cache::key_hasher::operator()(const resource_key &key) const {
+        return (*this)(key.file_) ^ (std::hash<int>()(key.res_id_) * 0x9E3779B9);
+    }
+
+    rsc_cache::rsc_cache(const std::size_t max_files, const std::size_t resource_budget)
+        : max_files_(max_files)
+        , resource_budget_(resource_budget)
+        , resource_usage_(0) {
+    }
+
+    rsc_file_impl_ptr rsc_cache::get_file(const std::u16string &path, const std::uint64_t last_write, common::ro_stream *stream) {
+        file_key key{ common::lowercase_ucs2_string(path), last_write };
+
+        {
+            const std::lock_guard<std::mutex> guard(lock_);
+            auto result = file_lookup_.find(key);
+
+            if (result != file_lookup_.end()) {
+                files_.splice(files_.begin(), files_, result->second);
+                return result->second->second;
+            }
+        }
+
+        // Parse outside the lock, other files can still be served meanwhile
+        rsc_file_impl_ptr impl = instantiate_rsc_impl(stream);
+
+        if (!impl) {
+            return nullptr;
+        }
+
+        const std::lock_guard<std::mutex> guard(lock_);
+        auto result = file_lookup_.find(key);
+
+        if (result != file_lookup_.end()) {
+            // Someone else parsed it first, use theirs
+            files_.splice(files_.begin(), files_, result->second);
+            return result->second->second;
+        }
+
+        files_.emplace_front(key, impl);
+        file_lookup_.emplace(std::move(key), files_.begin());
+
+        while (files_.size() > max_files_) {
+            file_lookup_.erase(files_.back().first);
+            files_.pop_back();
+        }
+
+        return impl;
+    }
+
+    bool rsc_cache::get_resource(const std::u16string &path, const std::uint64_t last_write, const int res_id,
+        std::vector<std::uint8_t> &data) {
+        const resource_key key{ { common::lowercase_ucs2_string(path), last_write }, res_id };
+        const std::lock_guard<std::mutex> guard(lock_);
+
+        auto result = resource_lookup_.find(key);
+
+        if (result == resource_lookup_.end()) {
+            return false;
+        }
+
+        resources_.splice(resources_.begin(), resources_, result->second);
+        data = result->second->second;
+
+        return true;
+    }
+
+    void rsc_cache::put_resource(const std::u16string &path, const std::uint64_t last_write, const int res_id,
+        const std::vector<std::uint8_t> &data) {
+        if (data.size() > resource_budget_) {
+            return;
+        }
+
+        resource_key key{ { common::lowercase_ucs2_string(path), last_write }, res_id };
+        const std::lock_guard<std::mutex> guard(lock_);
+
+        if (resource_lookup_.find(key) != resource_lookup_.end()) {
             return;
         }
 
-        impl_ = std::make_unique<rsc_file_legacy>(stream);
+        resources_.emplace_front(key, data);
+        resource_lookup_.emplace(std::move(key), resources_.begin());
+
+        resource_usage_ += data.size();
+        evict_resources();
+    }
+
+    void rsc_cache::evict_resources() {
+        while (resource_usage_ > resource_budget_) {
+            resource_usage_ -= resources_.back().second.size();
+            resource_lookup_.erase(resources_.back().first);
+            resources_.pop_back();
+        }
+    }
+
+    std::size_t rsc_cache::resource_memory_usage() {
+        const std::lock_guard<std::mutex> guard(lock_);
+        return resource_usage_;
+    }
+
+    void rsc_cache::clear() {
+        const std::lock_guard<std::mutex> guard(lock_);
+
+        file_lookup_.clear();
+        files_.clear();
+
+        resource_lookup_.clear();
+        resources_.clear();
+        resource_usage_ = 0;
+    }
+
+    rsc_cache &get_rsc_cache() {
+        static rsc_cache cache;
+        return cache;
+    }
+
+    void rsc_file::instantiate_impl(common::ro_stream *stream) {
+        impl_ = instantiate_rsc_impl(stream);
     }
     
     rsc_file::rsc_file(common::ro_stream *seri) {
         instantiate_impl(seri);
     }
 
+    rsc_file::rsc_file(common::ro_stream *stream, const std::u16string &path, const std::uint64_t last_write)
+        : cache_path_(path)
+        , cache_last_write_(last_write)
+        , cached_(true) {
+        impl_ = get_rsc_cache().get_file(path, last_write, stream);
+    }
+
     std::vector<std::uint8_t> rsc_file::read(const int res_id) {
         if (!impl_) {
             LOG_ERROR("RSC implementation has not been created!");
             return std::vector<std::uint8_t>{};
         }
 
-        return impl_->read(res_id);
+        if (!cached_) {
+            return impl_->read(res_id);
+        }
+
+        std::vector<std::uint8_t> data;
+
+        if (get_rsc_cache().get_resource(cache_path_, cache_last_write_, res_id, data)) {
+            return data;
+        }
+
+        data = impl_->read(res_id);
+
+        if (!data.empty()) {
+            get_rsc_cache().put_resource(cache_path_, cache_last_write_, res_id, data);
+        }
+
+        return data;
     }
 
     std::uint32_t rsc_file::get_uid(const int idx) {
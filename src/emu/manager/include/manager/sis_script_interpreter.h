@@ -21,13 +21,18 @@
 #pragma once
 
 #include <atomic>
+#include <cstdint>
 #include <functional>
+#include <mutex>
 #include <string>
 #include <stack>
 #include <vector>
 
+#include <manager/sis_common.h>
 #include <manager/sis_fields.h>
 
+#include <miniz.h>
+
 namespace eka2l1 {
     class system;
     class io_system;
@@ -47,6 +52,67 @@ namespace eka2l1 {
     }
 
     namespace loader {
+        /**
+         * \brief A file the install script wants to have extracted.
+         *
+         * The script is interpreted first, collecting these, and the files are extracted afterwards.
+         */
+        struct sis_extract_job {
+            std::string path;
+            std::uint32_t data_idx;
+            std::uint16_t block_idx;
+            std::uint64_t size;
+        };
+
+        /**
+         * \brief Called with the amount of raw data consumed, each time a chunk of a file is done.
+         */
+        using sis_extract_chunk_done_func = std::function<void(const std::uint64_t)>;
+
+        /**
+         * \brief Extract a single job, reporting each chunk done. Returns true on success.
+         */
+        using sis_extract_func = std::function<bool(const sis_extract_job &, const sis_extract_chunk_done_func &)>;
+
+        /**
+         * \brief Order jobs for extraction, largest first.
+         *
+         * A big file started last would keep the install waiting on a single core.
+         *
+         * \returns Total raw size of the jobs.
+         */
+        std::uint64_t plan_sis_extract_jobs(std::vector<sis_extract_job> &jobs);
+
+        /**
+         * \brief Run extract jobs in parallel.
+         *
+         * Progress is the percentage of raw data consumed, updated as each chunk is done.
+         *
+         * \param jobs      The jobs to run. They are reordered by plan_sis_extract_jobs.
+         * \param extract   Function extracting one job. Called from multiple threads at once.
+         * \param progress  Progress to report to.
+         *
+         * \returns True if every job succeeded.
+         */
+        bool run_sis_extract_jobs(std::vector<sis_extract_job> &jobs, const sis_extract_func &extract, std::atomic<int> &progress);
+
+        /**
+         * \brief Inflate a chunk of a deflated file.
+         *
+         * The output buffer is drained until all input of the chunk is consumed, since a well
+         * compressed chunk can inflate to more than the buffer holds.
+         *
+         * \param stream      The inflate stream of the file.
+         * \param data        The chunk.
+         * \param size        Size of the chunk.
+         * \param out_buf     Buffer to inflate to. Must not be empty.
+         * \param write       Called with each piece of inflated data.
+         *
+         * \returns False if the data is corrupted.
+         */
+        bool inflate_sis_chunk(mz_stream &stream, std::uint8_t *data, const std::uint32_t size, std::vector<std::uint8_t> &out_buf,
+            const std::function<void(const std::uint8_t *, const std::uint32_t)> &write);
+
         // An interpreter that runs SIS install script
         class ss_interpreter {
             sis_controller *main_controller;
@@ -58,6 +124,10 @@ namespace eka2l1 {
             drive_number install_drive;
 
             common::ro_stream *data_stream;
+            std::mutex data_stream_lock;
+
+            std::vector<sis_extract_job> extract_jobs;
+            std::vector<std::string> pending_sis_installs;
 
             io_system *io;
             window_server *winserv;
@@ -81,6 +151,19 @@ namespace eka2l1 {
              */
             int gasp_true_form_of_integral_expression(const sis_expression &expr);
 
+            /**
+             * \brief Get the size of a file's data as stored in the SIS (compressed if it's compressed).
+             */
+            std::uint64_t get_raw_data_size(const std::uint32_t data_idx, const std::uint16_t crr_blck_idx);
+
+            /**
+             * \brief Extract all files collected while interpreting the script.
+             *
+             * Files are independent from each other, so they are inflated and written in parallel.
+             * Embedded SIS files are installed once every file has been extracted.
+             */
+            bool extract_pending_files(std::atomic<int> &progress);
+
         public:
             show_text_func show_text; ///< Hook function to display texts.
             choose_lang_func choose_lang; ///< Hook function to choose controller's language.
@@ -105,11 +188,17 @@ namespace eka2l1 {
              * 
              * Usually uses for extracting large app data.
              * 
+             * Safe to be called from multiple threads at once, reads from the SIS stream are serialized.
+             * 
              * \param path          UTF-8 path to the physical file.
              * \param data_idx      The index of the source buffer in block buffer.
-             * \param crr_block_idx The block index..
+             * \param crr_block_idx The block index.
+             * \param chunk_done    Optional, called each time a chunk has been read, inflated and written.
+             * 
+             * \returns True on success.
              */
-            void extract_file(const std::string &path, const uint32_t idx, uint16_t crr_blck_idx);
+            bool extract_file(const std::string &path, const uint32_t idx, uint16_t crr_blck_idx,
+                const sis_extract_chunk_done_func &chunk_done = nullptr);
 
             explicit ss_interpreter();
             explicit ss_interpreter(common::ro_stream *stream,
@@ -126,9 +215,7 @@ namespace eka2l1 {
 
             bool interpret(sis_controller *controller, const std::uint16_t base_data_idx, std::atomic<int> &progress);
 
-            bool interpret(std::atomic<int> &progress) {
-                return interpret(main_controller, 0, progress);
-            }
+            bool interpret(std::atomic<int> &progress);
         };
     }
 }
@@ -30,141 +30,240 @@
 #include <common/log.h>
 #include <common/path.h>
 #include <common/pystr.h>
+#include <common/thread.h>
+#include <common/virtualmem.h>
 
 #include <algorithm>
-#include <array>
-#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <set>
+#include <thread>
 #include <vector>
 
 namespace eka2l1::loader {
-    static bool extract_file(const std::string &devices_rom_path, FILE *parent, rpkg_entry &ent) {
-        std::string file_full_relative = common::ucs2_to_utf8(ent.path.substr(3));
-        std::transform(file_full_relative.begin(), file_full_relative.end(), file_full_relative.begin(),
-            ::tolower);
+    struct rpkg_extract_job {
+        const std::uint8_t *data;
+        std::uint64_t data_size;
+        std::string real_path;
+    };
+
+    /**
+     * \brief Cursor over the memory-mapped archive, that never reads past the end.
+     */
+    struct rpkg_reader {
+        const std::uint8_t *cur;
+        const std::uint8_t *end;
+
+        template <typename T>
+        bool read(T &val) {
+            return read(&val, sizeof(T));
+        }
 
-        std::string real_path = add_path(add_path(devices_rom_path, "/temp/"), file_full_relative);
+        bool read(void *dest, const std::uint64_t size) {
+            if (static_cast<std::uint64_t>(end - cur) < size) {
+                return false;
+            }
 
-        std::string dir = eka2l1::file_directory(real_path);
-        eka2l1::create_directories(dir);
+            std::memcpy(dest, cur, size);
+            cur += size;
 
-        FILE *wf
-            = fopen(real_path.c_str(), "wb");
+            return true;
+        }
 
-        if (!wf) {
-            LOG_INFO("Skipping with real path: {}, dir: {}", real_path, dir);
+        const std::uint8_t *skip(const std::uint64_t size) {
+            if (static_cast<std::uint64_t>(end - cur) < size) {
+                return nullptr;
+            }
+
+            const std::uint8_t *start = cur;
+            cur += size;
+
+            return start;
+        }
+    };
+
+    static bool read_rpkg_header(rpkg_reader &reader, rpkg_header &header) {
+        if (!reader.read(header.magic)) {
             return false;
         }
 
-        int64_t left = ent.data_size;
-        int64_t take_def = 0x10000;
+        // Each magic character is stored as a 32-bit integer
+        if (header.magic[0] != 'R' || header.magic[1] != 'P' || header.magic[2] != 'K') {
+            return false;
+        }
 
-        std::array<char, 0x10000> temp;
+        std::uint8_t is_ver_one = 1;
 
-        while (left) {
-            int64_t take = left < take_def ? left : take_def;
+        switch (header.magic[3]) {
+        case 'G':
+            is_ver_one = 1;
+            break;
+
+        case '2':
+            is_ver_one = 0;
+            break;
+
+        default:
+            return false;
+        }
 
-            if (fread(temp.data(), 1, take, parent) != take) {
+        header.machine_uid = 0;
+        header.header_size = 0;
+
+        if (!reader.read(header.major_rom) || !reader.read(header.minor_rom) || !reader.read(header.build_rom)
+            || !reader.read(header.count)) {
+            return false;
+        }
+
+        if (!is_ver_one) {
+            if (!reader.read(header.header_size) || !reader.read(header.machine_uid)) {
                 return false;
             }
 
-            if (fwrite(temp.data(), 1, take, wf) != take) {
+            // Header size accounts for the two fields above
+            if (header.header_size != 8) {
                 return false;
             }
-
-            left -= take;
         }
 
-        fclose(wf);
-
         return true;
     }
 
-    bool install_rpkg(manager::device_manager *dvcmngr, const std::string &path,
-        const std::string &devices_rom_path, std::string &firmware_code_ret, std::atomic<int> &res) {
-        FILE *f = fopen(path.data(), "rb");
+    static bool write_extracted_file(const rpkg_extract_job &job) {
+        FILE *wf = fopen(job.real_path.c_str(), "wb");
 
-        if (!f) {
+        if (!wf) {
+            LOG_INFO("Skipping with real path: {}", job.real_path);
             return false;
         }
 
-        rpkg_header header;
+        // The data is already in memory, don't copy it through stdio's buffer
+        setvbuf(wf, nullptr, _IONBF, 0);
 
-        if (fread(&header.magic, 4, 4, f) != 4) {
-            return false;
-        }
+        static constexpr std::uint64_t MAX_WRITE_SIZE = 0x4000000;
 
-        std::uint8_t is_ver_one = 1;
+        const std::uint8_t *data = job.data;
+        std::uint64_t left = job.data_size;
+        bool result = true;
 
-        if (header.magic[0] != 'R' || header.magic[1] != 'P' || header.magic[2] != 'K') {
-            switch (header.magic[3]) {
-            case 'G':
-                is_ver_one = 1;
-                break;
+        while (left) {
+            const std::size_t take = static_cast<std::size_t>(std::min<std::uint64_t>(left, MAX_WRITE_SIZE));
 
-            case '2':
-                is_ver_one = 0;
+            if (fwrite(data, 1, take, wf) != take) {
+                result = false;
                 break;
-
-            default:
-                fclose(f);
-                return false;
             }
+
+            data += take;
+            left -= take;
         }
 
-        std::size_t total_read_size = 0;
+        fclose(wf);
+        return result;
+    }
 
-        total_read_size += fread(&header.major_rom, 1, 1, f);
-        total_read_size += fread(&header.minor_rom, 1, 1, f);
-        total_read_size += fread(&header.build_rom, 1, 2, f);
-        total_read_size += fread(&header.count, 1, 4, f);
+    bool install_rpkg(manager::device_manager *dvcmngr, const std::string &path,
+        const std::string &devices_rom_path, std::string &firmware_code_ret, std::atomic<int> &res) {
+        const std::int64_t archive_size = common::file_size(path);
 
-        header.machine_uid = 0;
-        header.header_size = 0;
+        if (archive_size <= 0) {
+            return false;
+        }
 
-        if (!is_ver_one) {
-            total_read_size += fread(&header.header_size, 1, 4, f);
-            total_read_size += fread(&header.machine_uid, 1, 4, f);
+        const std::uint8_t *archive = reinterpret_cast<const std::uint8_t *>(common::map_file(path, prot::read));
+
+        if (!archive) {
+            LOG_ERROR("Unable to map RPKG {} to memory", path);
+            return false;
         }
 
-        if (total_read_size != 8 + header.header_size) {
-            fclose(f);
+        const auto start_time = std::chrono::steady_clock::now();
+
+        rpkg_reader reader{ archive, archive + archive_size };
+        rpkg_header header;
+
+        if (!read_rpkg_header(reader, header)) {
+            common::unmap_file(const_cast<std::uint8_t *>(archive), static_cast<std::size_t>(archive_size));
             return false;
         }
 
-        while (!feof(f)) {
-            total_read_size = 0;
+        const std::string extract_root = add_path(devices_rom_path, "/temp/");
 
-            rpkg_entry entry;
+        // Gather all entries first. Entry data is not touched here, only pointers into the mapping are kept
+        std::vector<rpkg_extract_job> jobs;
+        std::set<std::string> directories;
 
-            total_read_size += fread(&entry.attrib, 1, 8, f);
-            total_read_size += fread(&entry.time, 1, 8, f);
-            total_read_size += fread(&entry.path_len, 1, 8, f);
+        std::uint64_t total_data_size = 0;
+        jobs.reserve(header.count);
 
-            if (total_read_size != 24) {
+        while (reader.cur < reader.end) {
+            rpkg_entry entry;
+
+            if (!reader.read(entry.attrib) || !reader.read(entry.time) || !reader.read(entry.path_len)) {
                 break;
             }
 
             entry.path.resize(entry.path_len);
 
-            total_read_size = 0;
+            if (!reader.read(entry.path.data(), entry.path_len * 2) || !reader.read(entry.data_size)) {
+                break;
+            }
 
-            total_read_size += fread(entry.path.data(), 1, entry.path_len * 2, f);
-            total_read_size += fread(&entry.data_size, 1, 8, f);
+            const std::uint8_t *data = reader.skip(entry.data_size);
 
-            if (total_read_size != entry.path_len * 2 + 8) {
+            if (!data) {
+                LOG_ERROR("Entry {} is truncated, stop extracting", common::ucs2_to_utf8(entry.path));
                 break;
             }
 
-            LOG_INFO("Extracting: {}", common::ucs2_to_utf8(entry.path));
+            rpkg_extract_job job;
+            job.data = data;
+            job.data_size = entry.data_size;
+            job.real_path = add_path(extract_root, common::lowercase_string(common::ucs2_to_utf8(entry.path.substr(3))));
 
-            if (!extract_file(devices_rom_path, f, entry)) {
-                break;
+            directories.insert(eka2l1::file_directory(job.real_path));
+
+            total_data_size += job.data_size;
+            jobs.push_back(std::move(job));
+        }
+
+        // Creating directories concurrently races, do them all here
+        for (const std::string &dir : directories) {
+            eka2l1::create_directories(dir);
+        }
+
+        std::atomic<std::uint64_t> written_size{ 0 };
+        std::atomic<std::size_t> failed_count{ 0 };
+
+        {
+            // File creation cost dominates for the many small files, so use more workers than cores
+            common::thread_pool pool(std::max<std::size_t>(std::thread::hardware_concurrency(), 2) * 2,
+                "RPKG extract thread");
+
+            for (const rpkg_extract_job &job : jobs) {
+                pool.enqueue([&]() {
+                    if (!write_extracted_file(job)) {
+                        failed_count++;
+                    }
+
+                    written_size += job.data_size;
+
+                    if (total_data_size != 0) {
+                        res = static_cast<int>(written_size.load() * 100 / total_data_size);
+                    }
+                });
             }
 
-            res += (int)(100 / header.count);
+            pool.wait_all();
         }
 
-        fclose(f);
+        common::unmap_file(const_cast<std::uint8_t *>(archive), static_cast<std::size_t>(archive_size));
+
+        const double elapsed_secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        const double total_mb = static_cast<double>(total_data_size) / (1024.0 * 1024.0);
+
+        LOG_INFO("Extracted {} files ({:.2f} MB) from RPKG in {:.2f}s ({:.2f} MB/s), {} failed", jobs.size(),
+            total_mb, elapsed_secs, (elapsed_secs > 0.0) ? (total_mb / elapsed_secs) : 0.0, failed_count.load());
 
         const std::string folder_extracted = add_path(devices_rom_path, "temp\\");
         epocver ver = determine_rpkg_symbian_version(folder_extracted);
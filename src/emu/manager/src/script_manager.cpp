@@ -134,7 +134,8 @@ namespace eka2l1::manager {
         if (!ipc_send_callback_handle) {
             kernel_system *kern = sys->get_kernel_system();
             
-            ipc_send_callback_handle = kern->register_ipc_send_callback([this](const std::string& svr_name, const int ord, const ipc_arg& args, kernel::thread* callee) {
+            ipc_send_callback_handle = kern->register_ipc_send_callback([this](const std::string& svr_name, const int ord, const ipc_arg& args, kernel::thread* callee,
+                service::session *ss, eka2l1::ptr<epoc::request_status> status) {
                 call_ipc_send(svr_name, ord, args.args[0], args.args[1], args.args[2], args.args[3], args.flag, callee);
             });
 
@@ -24,6 +24,7 @@
 #include <common/flate.h>
 #include <common/log.h>
 #include <common/path.h>
+#include <common/thread.h>
 #include <common/types.h>
 
 #include <epoc/epoc.h>
@@ -40,6 +41,8 @@
 
 #include <miniz.h>
 
+#include <algorithm>
+
 namespace eka2l1 {
     namespace loader {
         #define HAL_ENTRY(generic_name, display_name, num, num_old) hal_entry_##generic_name = num,
@@ -102,8 +105,10 @@ namespace eka2l1 {
 
             compressed.compressed_data.resize(us);
 
-            data_stream->seek(compressed.offset, common::seek_where::beg);
-            data_stream->read(&compressed.compressed_data[0], us);
+            {
+                const std::lock_guard<std::mutex> guard(data_stream_lock);
+                data_stream->read(compressed.offset, &compressed.compressed_data[0], us);
+            }
 
             if (compressed.algorithm == sis_compressed_algorithm::none) {
                 return compressed.compressed_data;
@@ -141,71 +146,124 @@ namespace eka2l1 {
             fclose(temp);
         }
 
-        void ss_interpreter::extract_file(const std::string &path, const uint32_t idx, uint16_t crr_blck_idx) {
+        std::uint64_t ss_interpreter::get_raw_data_size(const std::uint32_t data_idx, const std::uint16_t crr_blck_idx) {
+            sis_data_unit *data_unit = reinterpret_cast<sis_data_unit *>(install_data->data_units.fields[crr_blck_idx].get());
+            sis_file_data *data = reinterpret_cast<sis_file_data *>(data_unit->data_unit.fields[data_idx].get());
+
+            return ((data->raw_data.len_low) | (static_cast<std::uint64_t>(data->raw_data.len_high) << 32)) - 12;
+        }
+
+        bool inflate_sis_chunk(mz_stream &stream, std::uint8_t *data, const std::uint32_t size, std::vector<std::uint8_t> &out_buf,
+            const std::function<void(const std::uint8_t *, const std::uint32_t)> &write) {
+            stream.next_in = data;
+            stream.avail_in = size;
+
+            // A well compressed chunk can inflate over the output buffer, keep draining it
+            do {
+                stream.next_out = out_buf.data();
+                stream.avail_out = static_cast<std::uint32_t>(out_buf.size());
+
+                const int res = inflate(&stream, MZ_NO_FLUSH);
+
+                if ((res != MZ_OK) && (res != MZ_STREAM_END) && (res != MZ_BUF_ERROR)) {
+                    LOG_ERROR("Uncompress failed ({})! Report to developers", mz_error(res));
+                    return false;
+                }
+
+                const std::uint32_t inflated_size = static_cast<std::uint32_t>(out_buf.size()) - stream.avail_out;
+
+                if (inflated_size != 0) {
+                    write(out_buf.data(), inflated_size);
+                }
+
+                if (res == MZ_STREAM_END) {
+                    break;
+                }
+            } while ((stream.avail_in > 0) || (stream.avail_out == 0));
+
+            return true;
+        }
+
+        bool ss_interpreter::extract_file(const std::string &path, const uint32_t idx, uint16_t crr_blck_idx,
+            const sis_extract_chunk_done_func &chunk_done) {
             std::string rp = eka2l1::file_directory(path);
             eka2l1::create_directories(rp);
 
             FILE *file = fopen(path.c_str(), "wb");
 
+            if (!file) {
+                LOG_ERROR("Unable to open {} for writing", path);
+                return false;
+            }
+
             sis_data_unit *data_unit = reinterpret_cast<sis_data_unit *>(install_data->data_units.fields[crr_blck_idx].get());
             sis_file_data *data = reinterpret_cast<sis_file_data *>(data_unit->data_unit.fields[idx].get());
 
-            sis_compressed compressed = data->raw_data;
+            const sis_compressed &compressed = data->raw_data;
+            const bool deflated = (compressed.algorithm == sis_compressed_algorithm::deflated);
 
-            std::uint64_t left = ((compressed.len_low) | (static_cast<std::uint64_t>(compressed.len_high) << 32)) - 12;
-            data_stream->seek(compressed.offset, common::seek_where::beg);
+            std::uint64_t left = get_raw_data_size(idx, crr_blck_idx);
+            std::uint64_t read_pos = compressed.offset;
 
             std::vector<unsigned char> temp_chunk;
             temp_chunk.resize(CHUNK_SIZE);
 
             std::vector<unsigned char> temp_inflated_chunk;
-            temp_inflated_chunk.resize(CHUNK_MAX_INFLATED_SIZE);
 
-            mz_stream stream;
+            mz_stream stream{};
 
-            stream.zalloc = nullptr;
-            stream.zfree = nullptr;
+            if (deflated) {
+                temp_inflated_chunk.resize(CHUNK_MAX_INFLATED_SIZE);
 
-            if (compressed.algorithm == sis_compressed_algorithm::deflated) {
                 if (inflateInit(&stream) != MZ_OK) {
                     LOG_ERROR("Can not intialize inflate stream");
+                    fclose(file);
+
+                    return false;
                 }
             }
 
-            std::uint32_t total_inflated_size = 0;
-
-            while (left > 0) {
-                std::fill(temp_chunk.begin(), temp_chunk.end(), 0);
-                int grab = static_cast<int>(left < CHUNK_SIZE ? left : CHUNK_SIZE);
+            std::uint64_t total_inflated_size = 0;
+            bool result = true;
 
-                data_stream->read(&temp_chunk[0], grab);
+            auto write_inflated = [&](const std::uint8_t *inflated, const std::uint32_t inflated_size) {
+                fwrite(inflated, 1, inflated_size, file);
+                total_inflated_size += inflated_size;
+            };
 
-                if (!data_stream->valid()) {
-                    LOG_ERROR("Stream fail, skipping this file, should report to developers.");
-                    return;
-                }
+            while ((left > 0) && result) {
+                const std::uint32_t grab = static_cast<std::uint32_t>(std::min<std::uint64_t>(left, CHUNK_SIZE));
 
-                if (compressed.algorithm == sis_compressed_algorithm::deflated) {
-                    uint32_t inflated_size = 0;
+                {
+                    // The stream is shared with other extracting threads. Inflating and writing is the
+                    // expensive part, so only hold this for the read.
+                    const std::lock_guard<std::mutex> guard(data_stream_lock);
+                    data_stream->read(read_pos, &temp_chunk[0], grab);
 
-                    auto res = flate::inflate_data(&stream, temp_chunk.data(), temp_inflated_chunk.data(), grab, &inflated_size);
+                    if (!data_stream->valid()) {
+                        LOG_ERROR("Stream fail, skipping this file, should report to developers.");
+                        result = false;
 
-                    if (!res) {
-                        LOG_ERROR("Uncompress failed! Report to developers");
-                        return;
+                        break;
                     }
+                }
 
-                    fwrite(temp_inflated_chunk.data(), 1, inflated_size, file);
-                    total_inflated_size += inflated_size;
-                } else {
+                read_pos += grab;
+                left -= grab;
+
+                if (!deflated) {
                     fwrite(temp_chunk.data(), 1, grab, file);
+                } else {
+                    result = inflate_sis_chunk(stream, temp_chunk.data(), grab, temp_inflated_chunk, write_inflated);
                 }
 
-                left -= grab;
+                if (chunk_done) {
+                    chunk_done(grab);
+                }
             }
 
-            if (compressed.algorithm == sis_compressed_algorithm::deflated) {
-                if (total_inflated_size != compressed.uncompressed_size) {
+            if (deflated) {
+                if (result && (total_inflated_size != compressed.uncompressed_size)) {
                     LOG_ERROR("Sanity check failed: Total inflated size not equal to specified uncompress size "
                               "in SISCompressed ({} vs {})!",
                         total_inflated_size, compressed.uncompressed_size);
@@ -215,6 +273,95 @@ namespace eka2l1 {
             }
 
             fclose(file);
+            return result;
+        }
+
+        std::uint64_t plan_sis_extract_jobs(std::vector<sis_extract_job> &jobs) {
+            std::uint64_t total_size = 0;
+
+            for (const sis_extract_job &job : jobs) {
+                total_size += job.size;
+            }
+
+            std::stable_sort(jobs.begin(), jobs.end(), [](const sis_extract_job &lhs, const sis_extract_job &rhs) {
+                return lhs.size > rhs.size;
+            });
+
+            return total_size;
+        }
+
+        bool run_sis_extract_jobs(std::vector<sis_extract_job> &jobs, const sis_extract_func &extract, std::atomic<int> &progress) {
+            const std::uint64_t total_size = plan_sis_extract_jobs(jobs);
+
+            std::atomic<std::uint64_t> bytes_done{ 0 };
+            std::atomic<bool> all_ok{ true };
+
+            if (total_size != 0) {
+                progress = 0;
+            }
+
+            const sis_extract_chunk_done_func report_progress = [&](const std::uint64_t chunk_size) {
+                const std::uint64_t done = (bytes_done += chunk_size);
+
+                if (total_size == 0) {
+                    return;
+                }
+
+                // Threads finishing chunks at once may store out of order, never let it go back
+                const int percent = static_cast<int>(std::min<std::uint64_t>(done * 100 / total_size, 100));
+                int current = progress.load();
+
+                while ((percent > current) && !progress.compare_exchange_weak(current, percent)) {
+                }
+            };
+
+            auto run_job = [&](const sis_extract_job &job) {
+                if (!extract(job, report_progress)) {
+                    all_ok = false;
+                }
+            };
+
+            if (jobs.size() <= 1) {
+                for (const sis_extract_job &job : jobs) {
+                    run_job(job);
+                }
+            } else {
+                common::thread_pool pool(0, "SIS extract thread");
+
+                for (const sis_extract_job &job : jobs) {
+                    pool.enqueue([&run_job, &job]() {
+                        run_job(job);
+                    });
+                }
+
+                pool.wait_all();
+            }
+
+            return all_ok;
+        }
+
+        bool ss_interpreter::extract_pending_files(std::atomic<int> &progress) {
+            std::vector<sis_extract_job> jobs = std::move(extract_jobs);
+            extract_jobs.clear();
+
+            // Create directories now, creating the same tree from many threads at once races
+            for (const sis_extract_job &job : jobs) {
+                eka2l1::create_directories(eka2l1::file_directory(job.path));
+            }
+
+            const bool all_ok = run_sis_extract_jobs(jobs, [this](const sis_extract_job &job, const sis_extract_chunk_done_func &chunk_done) {
+                return extract_file(job.path, job.data_idx, job.block_idx, chunk_done);
+            }, progress);
+
+            // Now that everything is on disk, install SmartInstaller payloads
+            std::vector<std::string> sis_installs = std::move(pending_sis_installs);
+            pending_sis_installs.clear();
+
+            for (const std::string &sis_path : sis_installs) {
+                mngr->install_package(common::utf8_to_ucs2(sis_path), drive_c, progress);
+            }
+
+            return all_ok;
         }
 
         static bool is_expression_integral_type(const ss_expr_op op) {
@@ -383,6 +530,17 @@ namespace eka2l1 {
             return pass;
         }
 
+        bool ss_interpreter::interpret(std::atomic<int> &progress) {
+            // First walk the script and collect what to extract, then extract everything at once
+            const bool result = interpret(main_controller, 0, progress);
+
+            if (!extract_pending_files(progress)) {
+                LOG_ERROR("Some files failed to extract during the installation");
+            }
+
+            return result;
+        }
+
         bool ss_interpreter::interpret(sis_controller *controller, const std::uint16_t base_data_idx, std::atomic<int> &progress) {
             // Set current controller
             current_controllers.push(controller);
@@ -454,6 +612,8 @@ namespace eka2l1 {
 
                         case 1 << 11:
                         case 1 << 12: { // Abort
+                            // Files queued so far belong to the bucket being deleted, get them on disk first
+                            extract_pending_files(progress);
                             mngr->delete_files_and_bucket(current_controllers.top()->info.uid.uid);
                             const std::string err_string = fmt::format("Continue the installation for this package? (0x{:X})", current_controllers.top()->info.uid.uid);
 
@@ -477,13 +637,19 @@ namespace eka2l1 {
                     case ss_op::EOpInstall:
                     case ss_op::EOpNull: {
                         if (!skip_next_file) {
-                            extract_file(raw_path, file->idx, crr_blck_idx);
+                            sis_extract_job job;
+                            job.path = raw_path;
+                            job.data_idx = file->idx;
+                            job.block_idx = crr_blck_idx;
+                            job.size = get_raw_data_size(file->idx, crr_blck_idx);
+
+                            extract_jobs.push_back(std::move(job));
 
-                            raw_path = common::lowercase_string(raw_path);
+                            const std::string lowered_path = common::lowercase_string(raw_path);
 
-                            if (FOUND_STR(raw_path.find(".sis")) || FOUND_STR(raw_path.find(".sisx"))) {
+                            if (FOUND_STR(lowered_path.find(".sis")) || FOUND_STR(lowered_path.find(".sisx"))) {
                                 LOG_INFO("Detected an SmartInstaller SIS, path at: {}", raw_path);
-                                mngr->install_package(common::utf8_to_ucs2(raw_path), drive_c, progress);
+                                pending_sis_installs.push_back(raw_path);
                             }
 
                             LOG_INFO("EOpInstall: {}", raw_path);
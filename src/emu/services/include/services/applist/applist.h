@@ -27,6 +27,8 @@
 #include <vfs/vfs.h>
 
 #include <mutex>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace eka2l1 {
@@ -36,6 +38,7 @@ namespace eka2l1 {
     struct fbsbitmap;
 
     namespace common {
+        class chunkyseri;
         class ro_stream;
     }
 
@@ -76,6 +79,16 @@ namespace eka2l1 {
         std::vector<view_data> view_datas;
         file_ownership_list ownership_list;
 
+        // Size and last write time of the files this registry was read from.
+        // Used to validate the persisted registry cache.
+        std::uint64_t rsc_size{ 0 };
+        std::uint64_t rsc_last_write{ 0 };
+        std::u16string localised_info_rsc_resolved_path;
+        std::uint64_t localised_info_rsc_size{ 0 };
+        std::uint64_t localised_info_rsc_last_write{ 0 };
+
+        void do_state(common::chunkyseri &seri);
+
         /**
          * @brief Get parameters to launch this app registry.
          * 
@@ -146,6 +159,39 @@ namespace eka2l1 {
      */
     bool read_localised_registration_info(common::ro_stream *stream, apa_app_registry &reg, const drive_number land_drive);
 
+    /**
+     * \brief Choose the nearest language file for each resource in a directory listing.
+     *
+     * Same preference as utils::get_nearest_lang_file: the ideal language, then .rsc, then
+     * the first variant listed.
+     *
+     * \param entries   Entries of the directory.
+     * \param lang      The language of the system.
+     *
+     * \returns One entry per resource, ordered by lowercased name.
+     */
+    std::vector<const entry_info *> pick_nearest_lang_entries(const std::vector<entry_info> &entries, const language lang);
+
+    /**
+     * \brief Read app registrations from the cache file.
+     *
+     * \param path      Path to the cache file on the host.
+     * \param lang      The language of the system. A cache made for another language is rejected.
+     * \param regs      Registrations to fill. Untouched on failure.
+     *
+     * \returns True on success.
+     */
+    bool load_app_registry_cache(const std::string &path, const language lang, std::vector<apa_app_registry> &regs);
+
+    /**
+     * \brief Write app registrations to the cache file.
+     *
+     * \param path      Path to the cache file on the host.
+     * \param lang      The language the registrations were resolved with.
+     * \param regs      Registrations to write.
+     */
+    void save_app_registry_cache(const std::string &path, const language lang, std::vector<apa_app_registry> &regs);
+
     const std::string get_app_list_server_name_by_epocver(const epocver ver);
 
     class applist_session : public service::typical_session {
@@ -167,6 +213,14 @@ namespace eka2l1 {
         std::vector<apa_app_registry> regs;
         std::uint32_t flags{ 0 };
 
+        // Lowercased registration path and app UID to index in regs
+        std::unordered_map<std::u16string, std::size_t> path_index_;
+        std::unordered_map<std::uint32_t, std::size_t> uid_index_;
+
+        // Registrations read from the cache file, waiting to be validated by a scan
+        std::unordered_map<std::u16string, apa_app_registry> cached_regs_;
+        std::string registry_cache_path_;
+
         std::vector<std::int64_t> watchs_;
         fbs_server *fbsserv;
 
@@ -175,12 +229,39 @@ namespace eka2l1 {
         };
 
         void sort_registry_list();
+        void add_registry(apa_app_registry &&reg);
         void init();
 
         bool delete_registry(const std::u16string &rsc_path);
 
+        bool load_registry_cache(const language lang);
+        void save_registry_cache(const language lang);
+
+        /**
+         * \brief Take a registration from the cache, if its files have not changed since.
+         *
+         * \param io      The IO system.
+         * \param key     Lowercased path of the registration file.
+         * \param entry   Directory entry of the registration file.
+         *
+         * \returns True if the cached registration was valid and has been added.
+         */
+        bool use_cached_registry(eka2l1::io_system *io, const std::u16string &key, const entry_info &entry);
+
+        /**
+         * \brief Load an app registration file.
+         *
+         * \param io              The IO system.
+         * \param path            Path to the registration file.
+         * \param land_drive      The drive contains this registration.
+         * \param ideal_lang      The language to pick localised resources for.
+         * \param resolved_entry  If not null, path is already the nearest language file and this is
+         *                        its directory entry. The cached registration is used when valid.
+         *
+         * \returns True on success.
+         */
         bool load_registry(eka2l1::io_system *io, const std::u16string &path, drive_number land_drive,
-            const language ideal_lang = language::en);
+            const language ideal_lang = language::en, const entry_info *resolved_entry = nullptr);
 
         bool load_registry_oldarch(eka2l1::io_system *io, const std::u16string &path, drive_number land_drive,
             const language ideal_lang = language::en);
@@ -43,6 +43,20 @@ namespace eka2l1 {
 	*/
     bool parse_new_centrep_ini(const std::string &path, central_repo &repo);
 
+    /*! \brief Parse a new centrep ini file, using the compiled repository cache.
+     *
+     * A parsed repository is stored in the cache folder in CRE form, under a name made from the
+     * repository UID and a hash of the INI content. As long as the INI does not change, later loads
+     * read the CRE instead of parsing the text again.
+     *
+     * \param path          Host path to the INI file.
+     * \param cache_folder  Host folder to keep compiled repositories in. Empty to not use the cache.
+     * \param repo          Repository to fill. The UID must already be set.
+     *
+     * \returns False if IO error or invalid centrep configs.
+     */
+    bool parse_new_centrep_ini_cached(const std::string &path, const std::string &cache_folder, central_repo &repo);
+
     class central_repo_server;
 
     struct central_repo_client_session {
@@ -81,6 +95,9 @@ namespace eka2l1 {
         std::vector<drive_number> avail_drives;
         std::mutex serv_lock;
 
+        // Host folder storing INI repositories compiled to CRE
+        std::string compiled_cache_folder;
+
         bool first_repo = true;
 
     protected:
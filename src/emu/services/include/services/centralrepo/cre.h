@@ -31,5 +31,18 @@ namespace eka2l1 {
         class chunkyseri;
     }
 
-    int do_state_for_cre(common::chunkyseri &seri, eka2l1::central_repo &repo);
+    // Written in the second UID of CRE files made by the emulator, which store reals as TReal64
+    static constexpr std::uint32_t CRE_REAL64_MARKER_UID = 0x454B4132;
+
+    /**
+     * \brief Read, write or measure a repository in CRE form.
+     *
+     * \param seri                 The serializer.
+     * \param repo                 The repository.
+     * \param may_have_float_reals True if the file is in the emulator's own persists folder, where older builds
+     *                             stored reals as 4-byte floats. Only used when reading a file without the marker UID.
+     *
+     * \returns 0 on success.
+     */
+    int do_state_for_cre(common::chunkyseri &seri, eka2l1::central_repo &repo, const bool may_have_float_reals = false);
 }
\ No newline at end of file
@@ -28,6 +28,7 @@
 #include <cstdint>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace eka2l1 {
@@ -95,6 +96,7 @@ namespace eka2l1 {
 
         std::uint32_t owner_uid;
 
+        // Sorted by key
         std::vector<central_repo_entry> entries;
         std::vector<central_repo_client_subsession *> attached;
 
@@ -105,13 +107,32 @@ namespace eka2l1 {
         std::uint32_t default_meta = 0;
         std::vector<central_repo_default_meta> meta_range;
 
-        std::uint64_t time_stamp;
+        std::uint64_t time_stamp = 0;
 
         std::vector<std::uint32_t> deleted_settings;
 
         void write_changes(eka2l1::io_system *io, manager::device_manager *mngr);
         central_repo_entry *find_entry(const std::uint32_t key);
 
+        /**
+         * \brief Get the range of entries that can match a key filter.
+         *
+         * Entries are sorted by key, so the leading bits fully covered by the mask give a contiguous
+         * range of keys. Entries inside the range still need to be checked against the mask.
+         *
+         * \param partial_key The bit pattern to be matched.
+         * \param mask        The mask that requires which bit is mandatory.
+         */
+        std::pair<std::vector<central_repo_entry>::iterator, std::vector<central_repo_entry>::iterator>
+        entries_in_filter_range(const std::uint32_t partial_key, const std::uint32_t mask);
+
+        /**
+         * \brief Sort entries by key, if they are not already.
+         *
+         * Call this after filling entries directly.
+         */
+        void sort_entries();
+
         std::uint32_t get_default_meta_for_new_key(const std::uint32_t key);
 
         bool add_new_entry(const std::uint32_t key, const central_repo_entry_variant &var);
@@ -24,12 +24,20 @@
 #include <services/framework.h>
 #include <common/uid.h>
 
+#include <cstdint>
+#include <mutex>
+#include <set>
 #include <string>
 #include <vector>
 
 namespace eka2l1 {
     class io_system;
 
+    namespace common {
+        class chunkyseri;
+        struct directory_change;
+    }
+
     namespace epoc::fs {
         struct entry;
     }
@@ -110,8 +118,17 @@ namespace eka2l1 {
 
         bool init{ false };
 
+        std::string registry_cache_path_;
+        std::vector<std::int64_t> watchs_;
+
+        // Plugin resource paths reported changed by the directory watcher. Filled from
+        // the watcher thread, consumed before the next registry lookup.
+        std::mutex pending_changes_lock_;
+        std::set<std::u16string> pending_plugin_changes_;
+
     protected:
         bool register_implementation(const std::uint32_t interface_uid, ecom_implementation_info_ptr &impl);
+        void unregister_plugin(const std::u16string &name, const drive_number drv);
 
         bool load_plugins(eka2l1::io_system *io);
         bool load_and_install_plugin_from_buffer(const std::u16string &name, std::uint8_t *buf, const std::size_t size,
@@ -135,10 +152,32 @@ namespace eka2l1 {
          */
         bool load_archives(eka2l1::io_system *io);
 
+        /**
+         * \brief Compute a fingerprint of every plugin resource the registry is built from.
+         *
+         * Only the names, sizes and modification times of archives and resource files are
+         * visited, nothing is read. A matching fingerprint means the cached registry is
+         * still what a full scan would produce.
+         */
+        std::uint64_t get_plugin_fingerprint(eka2l1::io_system *io);
+
+        bool load_registry_cache(const std::uint64_t fingerprint);
+        void save_registry_cache(const std::uint64_t fingerprint);
+
+        void watch_plugin_directories(eka2l1::io_system *io);
+        void on_plugin_directory_changes(const std::u16string &base, std::vector<common::directory_change> &changes);
+        void apply_pending_plugin_changes(eka2l1::io_system *io);
+
+        /**
+         * \brief Make sure the registry is loaded and up-to-date with plugin changes.
+         */
+        void update_registry();
+
         void connect(service::ipc_context &ctx) override;
 
     public:
         explicit ecom_server(eka2l1::system *sys);
+        ~ecom_server() override;
 
         /**
          * \brief Get interface info of a given UID.
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project 
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <services/ecom/plugin.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace eka2l1 {
+    struct entry_info;
+
+    namespace common {
+        class chunkyseri;
+    }
+
+    using ecom_interface_map = std::unordered_map<std::uint32_t, ecom_interface_info>;
+
+    /**
+     * \brief Compute the fingerprint of the plugin resources a registry is built from.
+     *
+     * Only names, sizes and modification times of the entries are used. The order of the
+     * entries does not matter.
+     *
+     * \param lang     The system language. Archives are picked by it.
+     * \param ver      The EPOC version. The registry layout differs between versions.
+     * \param entries  Plugin archives and resource files.
+     */
+    std::uint64_t make_ecom_plugin_fingerprint(const std::uint32_t lang, const std::uint32_t ver, const std::vector<entry_info> &entries);
+
+    /**
+     * \brief Read, write or measure the registry.
+     *
+     * When reading, implementations are added to both the interfaces and the sorted implementation list.
+     */
+    void do_ecom_registry_state(common::chunkyseri &seri, ecom_interface_map &interfaces, std::vector<ecom_implementation_info_ptr> &implementations);
+
+    /**
+     * \brief Load the registry from the cache file.
+     *
+     * \returns False if there is no cache, if it was made from another fingerprint, or if it is corrupted.
+     *          The registry is left empty in that case.
+     */
+    bool load_ecom_registry_cache(const std::string &path, const std::uint64_t fingerprint, ecom_interface_map &interfaces,
+        std::vector<ecom_implementation_info_ptr> &implementations);
+
+    /**
+     * \brief Write the registry to the cache file, tagged with the given fingerprint.
+     */
+    void save_ecom_registry_cache(const std::string &path, const std::uint64_t fingerprint, ecom_interface_map &interfaces,
+        std::vector<ecom_implementation_info_ptr> &implementations);
+}
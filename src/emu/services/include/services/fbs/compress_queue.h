@@ -23,26 +23,58 @@
 #include <common/queue.h>
 #include <utils/reqsts.h>
 
+#include <atomic>
+#include <cstdint>
 #include <mutex>
+#include <vector>
 
 namespace eka2l1 {
     struct fbsbitmap;
     class fbs_server;
+    class kernel_system;
 
     /**
      * \brief Queue that handle bitmap compression.
      * 
-     * This queue runs on separate thread.
+     * This queue is drained by one or more worker threads. The RLE pass runs in parallel. Creating the
+     * clean bitmap and completing requests is done with the kernel locked, like the server thread does.
+     * 
+     * Dirty bitmap notifications are not sent for every compressed bitmap, but once the queue drains or
+     * after a batch of bitmaps has been compressed, so a burst of compress requests only wakes clients once.
      */
     class compress_queue {
         request_queue<fbsbitmap *> queue_;
         fbs_server *serv_;
+        kernel_system *kern_;
 
         std::vector<epoc::notify_info> notifies_;
         std::mutex notify_mutex_;
 
+        std::vector<fbsbitmap *> in_progress_;
+        std::mutex bitmap_mutex_;
+
+        std::atomic<std::uint32_t> outstanding_count_;
+        std::uint32_t compressed_since_notify_;
+
     protected:
-        void actual_compress(fbsbitmap *bmp);
+        /**
+         * \brief Compress a bitmap and publish the result as its clean bitmap.
+         * 
+         * \param bmp              The bitmap to compress.
+         * \param compressed_data  Scratch buffer of the calling worker.
+         * 
+         * \returns True if a clean bitmap was produced.
+         */
+        bool actual_compress(fbsbitmap *bmp, std::vector<std::uint8_t> &compressed_data);
+
+        /**
+         * \brief Account a finished compression, and complete dirty bitmap notifications when a batch is done.
+         * 
+         * \param compressed       True if a new clean bitmap was produced.
+         * 
+         * \returns True if no bitmap is left to compress.
+         */
+        bool finish_compress(const bool compressed);
 
     public:
         explicit compress_queue(fbs_server *serv);
@@ -61,8 +93,7 @@ namespace eka2l1 {
         /**
          * \brief Compress a bitmap.
          * 
-         * If the compress queue is full. This function stalls until the queue has slot for this bitmap.
-         * 
+         * Never blocks. The caller holds the kernel lock, which the workers need to finish a bitmap.
          * 
          * \param bmp   The bitmap to compress.
          */
@@ -70,6 +101,8 @@ namespace eka2l1 {
 
         /**
          * \brief Run the compression queue.
+         * 
+         * Can be called from multiple worker threads at once.
          */
         void run();
 
@@ -78,4 +111,4 @@ namespace eka2l1 {
          */
         void abort();
     };
-}
\ No newline at end of file
+}
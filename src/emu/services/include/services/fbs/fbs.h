@@ -35,6 +35,7 @@
 
 #include <common/allocator.h>
 #include <common/hash.h>
+#include <common/thread.h>
 
 #include <drivers/graphics/common.h>
 
@@ -231,6 +232,46 @@ namespace eka2l1 {
         void deref() override;
     };
 
+    /**
+     * \brief Identity of a bitmap loaded from a MBM file.
+     *
+     * Files are identified by their lowercased path, size and modification time. ROM files
+     * are identified by where their data lives in ROM, since they only know their name.
+     */
+    struct fbsbitmap_cache_info {
+        std::u16string path;
+        std::uint64_t size{ 0 };
+        std::uint64_t last_write{ 0 };
+        const std::uint8_t *rom_data{ nullptr };
+        int bitmap_idx{ 0 };
+    };
+
+    inline bool operator==(const fbsbitmap_cache_info &lhs, const fbsbitmap_cache_info &rhs) {
+        return (lhs.bitmap_idx == rhs.bitmap_idx) && (lhs.rom_data == rhs.rom_data) && (lhs.size == rhs.size)
+            && (lhs.last_write == rhs.last_write) && (lhs.path == rhs.path);
+    }
+}
+
+namespace std {
+    template <>
+    struct hash<eka2l1::fbsbitmap_cache_info> {
+        std::size_t operator()(eka2l1::fbsbitmap_cache_info const &info) const noexcept {
+            std::size_t seed = 0x151A5151;
+
+            eka2l1::common::hash_combine(seed, info.path);
+            eka2l1::common::hash_combine(seed, info.size);
+            eka2l1::common::hash_combine(seed, info.last_write);
+            eka2l1::common::hash_combine(seed, info.rom_data);
+            eka2l1::common::hash_combine(seed, info.bitmap_idx);
+
+            return seed;
+        }
+    };
+}
+
+namespace eka2l1 {
+    class fbsbitmap_share_map;
+
     struct fbsbitmap : public fbsobj {
         epoc::bitwise_bitmap *bitmap_;
         fbs_server *serv_;
@@ -239,6 +280,10 @@ namespace eka2l1 {
         bool support_dirty_bitmap;
         epoc::notify_info compress_done_nof;
 
+        // Set while the bitmap is in a shared bitmap map under this key
+        fbsbitmap_share_map *share_map_{ nullptr };
+        fbsbitmap_cache_info cache_info_;
+
         explicit fbsbitmap(fbs_server *srv, epoc::bitwise_bitmap *bitmap, const bool shared, const bool support_dirty_bitmap)
             : fbsobj(fbsobj_kind::bitmap)
             , bitmap_(bitmap)
@@ -251,31 +296,44 @@ namespace eka2l1 {
         ~fbsbitmap() override;
     };
 
-    struct fbsbitmap_cache_info {
-        std::u16string path;
-        int bitmap_idx;
-    };
+    /**
+     * \brief Bitmaps loaded with sharing on, by the identity of the file they came from.
+     *
+     * The map holds no reference. A bitmap leaves it when the last handle to it is closed.
+     */
+    class fbsbitmap_share_map {
+        std::unordered_map<fbsbitmap_cache_info, fbsbitmap *> bitmaps_;
 
-    inline bool operator==(const fbsbitmap_cache_info &lhs, const fbsbitmap_cache_info &rhs) {
-        return (lhs.path == rhs.path) && (lhs.bitmap_idx == rhs.bitmap_idx);
-    }
-}
+    public:
+        ~fbsbitmap_share_map();
 
-namespace std {
-    template <>
-    struct hash<eka2l1::fbsbitmap_cache_info> {
-        std::size_t operator()(eka2l1::fbsbitmap_cache_info const &info) const noexcept {
-            std::size_t seed = 0x151A5151;
+        /**
+         * \brief   Look for a bitmap loaded from the same file and index.
+         *
+         * A bitmap that was resized or changed its display mode since loading no longer holds
+         * what the file does, and is dropped from the map instead of being returned.
+         *
+         * \returns The bitmap, or null if none can be shared.
+         */
+        fbsbitmap *find(const fbsbitmap_cache_info &info);
 
-            eka2l1::common::hash_combine(seed, info.path);
-            eka2l1::common::hash_combine(seed, info.bitmap_idx);
+        void add(const fbsbitmap_cache_info &info, fbsbitmap *bmp);
+        void remove(fbsbitmap *bmp);
+        void clear();
 
-            return seed;
+        std::size_t size() const {
+            return bitmaps_.size();
         }
     };
-}
 
-namespace eka2l1 {
+    /**
+     * \brief Get the identity of a bitmap in a MBM file.
+     *
+     * \param source      The MBM file.
+     * \param bitmap_idx  Index of the bitmap in the file.
+     */
+    fbsbitmap_cache_info make_bitmap_cache_info(file *source, const int bitmap_idx);
+
     class io_system;
 
     enum fbs_load_data_err {
@@ -313,13 +371,13 @@ namespace eka2l1 {
 
         std::u16string default_system_font;
 
-        std::unordered_map<fbsbitmap_cache_info, fbsbitmap *> shared_bitmaps;
+        fbsbitmap_share_map shared_bitmaps;
 
         std::unique_ptr<epoc::chunk_allocator> shared_chunk_allocator;
         std::unique_ptr<epoc::chunk_allocator> large_chunk_allocator;
 
         std::unique_ptr<compress_queue> compressor;
-        std::unique_ptr<std::thread> compressor_thread;
+        std::unique_ptr<common::thread_pool> compressor_workers;
 
         epoc::open_font_session_cache_list *session_cache_list;
         epoc::open_font_session_cache_link *session_cache_link;
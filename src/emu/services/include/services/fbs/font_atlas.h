@@ -17,15 +17,17 @@
 
 #pragma once
 
+#include <common/linked.h>
 #include <common/vecx.h>
 #include <drivers/graphics/common.h>
 #include <services/fbs/adapter/font_adapter.h>
 #include <services/window/common.h>
 
-#include <deque>
 #include <map>
 #include <memory>
+#include <optional>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace eka2l1::drivers {
@@ -36,25 +38,99 @@ namespace eka2l1::drivers {
 namespace eka2l1::epoc {
 #define ESTIMATE_MAX_CHAR_IN_ATLAS_WIDTH 50
 
+    /**
+     * \brief Packs rectangles into horizontal shelves, and can take them back.
+     * 
+     * A rectangle goes to the shelf that fits its height best, reusing freed space in the shelf
+     * before growing it. Freed neighbours are merged, and a shelf with nothing left in it can hold
+     * rectangles of any height up to its own.
+     */
+    class font_atlas_packer {
+        struct span {
+            int x_;
+            int width_;
+        };
+
+        struct shelf {
+            int y_;
+            int height_;
+            int cursor_;
+            int used_count_;
+
+            std::vector<span> free_spans_; ///< Sorted by x, all before the cursor.
+        };
+
+        eka2l1::vec2 size_;
+        std::vector<shelf> shelves_; ///< Sorted by y.
+        int next_shelf_y_;
+
+        std::optional<int> allocate_in_shelf(shelf &target, const int width);
+
+    public:
+        explicit font_atlas_packer(const eka2l1::vec2 &size = { 0, 0 });
+
+        void reset(const eka2l1::vec2 &size);
+
+        /**
+         * \brief Find space for a rectangle.
+         * 
+         * \param  size The size of the rectangle.
+         * \returns The area given, or nothing if there is no space left.
+         */
+        std::optional<eka2l1::rect> allocate(const eka2l1::vec2 &size);
+
+        /**
+         * \brief Give back an area previously returned by allocate.
+         */
+        void free(const eka2l1::rect &area);
+    };
+
+    /**
+     * \brief A glyph kept in the atlas.
+     */
+    struct font_atlas_glyph {
+        char16_t code_;
+        adapter::character_info info_; ///< Metrics, with the bitmap position pointing into the atlas.
+        eka2l1::rect slot_; ///< Space used in the atlas, padding included. Empty for glyphs without bitmap.
+        std::uint32_t last_draw_; ///< Serial of the last text draw that used this glyph.
+
+        common::double_linked_queue_element lru_link_;
+    };
+
     /**
      * \brief Font atlas is a texture contains glyph bitmaps.
      * 
-     * The atlas dimension is a square, and height is equals to font_size *
-     * estimate_max_char_in_atlas.
+     * The atlas is a square of font_size * estimate_max_char_in_atlas pixels. Glyphs are rasterized
+     * when first drawn and kept until the space is needed; the least recently used ones are evicted first.
+     * Only the parts of the atlas that changed are uploaded to the driver.
      */
     struct font_atlas {
-        std::map<char16_t, adapter::character_info> characters_;
+        std::unordered_map<char16_t, font_atlas_glyph> glyphs_;
+        common::roundabout lru_; ///< Least recently used glyph first.
+
+        font_atlas_packer packer_;
+        std::uint32_t draw_serial_;
+
         drivers::handle atlas_handle_;
         adapter::font_file_adapter_base *adapter_;
         int size_;
 
-        std::vector<int> last_use_;
-
         std::pair<char16_t, char16_t> initial_range_;
+        bool initial_range_loaded_;
+
         std::unique_ptr<std::uint8_t[]> atlas_data_;
+        std::vector<std::uint8_t> raster_scratch_;
+        std::map<int, eka2l1::rect> dirty_shelves_; ///< Changed areas waiting for upload, one per shelf.
 
         std::size_t typeface_idx_;
-        std::int32_t pack_handle_;
+
+        font_atlas_glyph *get_glyph(const char16_t code);
+        void touch_glyph(font_atlas_glyph &glyph);
+        bool evict_least_used();
+
+        std::optional<eka2l1::rect> allocate_slot(const eka2l1::vec2 &size);
+        void rasterize_glyphs(const int *codes, const std::size_t count);
+        void flush_dirty(drivers::graphics_command_list_builder *builder);
 
     public:
         explicit font_atlas();
@@ -62,6 +138,9 @@ namespace eka2l1::epoc {
         explicit font_atlas(adapter::font_file_adapter_base *adapter, const std::size_t typeface_idx, const char16_t initial_start,
             const char16_t initial_char_count, int font_size);
 
+        font_atlas(const font_atlas &) = delete;
+        font_atlas &operator=(const font_atlas &) = delete;
+
         void init(adapter::font_file_adapter_base *adapter, const std::size_t typeface_idx, const char16_t initial_start,
             const char16_t initial_char_count, int font_size);
 
@@ -72,4 +151,4 @@ namespace eka2l1::epoc {
         bool draw_text(const std::u16string &text, const eka2l1::rect &box, const epoc::text_alignment alignment, drivers::graphics_driver *driver,
             drivers::graphics_command_list_builder *builder);
     };
-}
\ No newline at end of file
+}
@@ -30,7 +30,6 @@
 #include <atomic>
 #include <clocale>
 #include <memory>
-#include <regex>
 #include <unordered_map>
 
 namespace eka2l1::kernel {
@@ -79,6 +78,10 @@ namespace eka2l1 {
 
         bool exclusive{ false };
         kernel::uid process{ 0 };
+
+        // Directory entries read ahead in a batch, not yet given to the client
+        std::vector<entry_info> pending_entries;
+        std::size_t pending_entry_index{ 0 };
         
         void deref() override;
     };
@@ -183,7 +186,7 @@ namespace eka2l1 {
         };
 
         struct notify_entry {
-            std::regex match_pattern;
+            std::u16string match_pattern;
             notify_type type;
             epoc::notify_info info;
         };
@@ -30,6 +30,7 @@
 #include <services/fbs/bitmap.h>
 
 #include <array>
+#include <vector>
 
 namespace eka2l1 {
     class kernel_system;
@@ -38,6 +39,24 @@ namespace eka2l1 {
 namespace eka2l1::epoc {
     constexpr std::uint32_t MAX_CACHE_SIZE = 1024;
 
+    bool is_palette_bitmap(epoc::bitwise_bitmap *bw_bmp);
+
+    /**
+     * \brief Convert bitmap data to 24bpp data that the graphics driver can upload.
+     *
+     * \param bw_bmp          The bitmap that the data belongs to.
+     * \param original_ptr    Pointer to the bitmap's uncompressed data.
+     * \param converted_pool  Vector that will hold the converted data.
+     *
+     * \returns Pointer to the converted data, inside converted_pool.
+     */
+    char *converted_one_bpp_to_twenty_four_bpp_bitmap(epoc::bitwise_bitmap *bw_bmp,
+        const std::uint32_t *original_ptr, std::vector<char> &converted_pool);
+    char *convert_twelve_bpp_to_twenty_four_bpp_bitmap(epoc::bitwise_bitmap *bw_bmp,
+        const std::uint32_t *original_ptr, std::vector<char> &converted_pool);
+    char *converted_palette_bitmap_to_twenty_four_bitmap(epoc::bitwise_bitmap *bw_bmp,
+        const std::uint8_t *original_ptr, std::vector<char> &converted_pool);
+
     class bitmap_cache {
     public:
         using driver_texture_handle_array = std::array<drivers::handle, MAX_CACHE_SIZE>;
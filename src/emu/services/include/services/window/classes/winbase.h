@@ -125,6 +125,10 @@ namespace eka2l1::epoc {
         */
         virtual void queue_event(const epoc::event &evt);
 
+        /*! \brief Queue an event coming from the input thread.
+        */
+        virtual void queue_input_event(const epoc::event &evt);
+
         /**
          * \brief Get the origin of window.
          */
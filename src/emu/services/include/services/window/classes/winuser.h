@@ -129,7 +129,14 @@ namespace eka2l1::epoc {
          */
         void take_action_on_change();
 
+        /**
+         * @brief Mark part of this window as changed, so the screen composes it again.
+         * @param local_rect The changed area, relative to the window.
+         */
+        void damage_screen(const eka2l1::rect &local_rect);
+
         void queue_event(const epoc::event &evt) override;
+        void queue_input_event(const epoc::event &evt) override;
 
         // ===================== OPCODE IMPLEMENTATIONS ===========================
         void begin_redraw(service::ipc_context &context, ws_cmd &cmd);
@@ -87,6 +87,13 @@ namespace eka2l1::epoc {
     bool is_display_mode_mono(const display_mode disp_mode);
     bool is_display_mode_alpha(const display_mode disp_mode);
     int get_bpp_from_display_mode(const epoc::display_mode bpp);
+
+    /**
+     * \brief Get the size of a bitmap or screen row in bytes, as Symbian lays it out.
+     *
+     * Rows are word aligned. 12bpp pixels take 16 bits, and 24bpp rows are aligned to 12 bytes.
+     */
+    int get_byte_width(const std::uint32_t pixels_width, const std::uint8_t bits_per_pixel);
     epoc::display_mode string_to_display_mode(const std::string &disp_str);
     std::string display_mode_to_string(const epoc::display_mode disp_mode);
     epoc::display_mode get_display_mode_from_bpp(const int bpp);
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <common/region.h>
+#include <common/vecx.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace eka2l1::epoc {
+    /**
+     * \brief Placement of a window on the screen when it was composed.
+     */
+    struct composed_window {
+        std::uint64_t driver_win_id;
+        eka2l1::rect extent; ///< Area of the screen the window covers.
+        bool opaque; ///< Content behind the window can't be seen through it.
+    };
+
+    /**
+     * \brief Part of a window that has to be drawn to the screen.
+     */
+    struct composed_draw {
+        std::size_t window_index; ///< Index of the window in the composition.
+        eka2l1::rect part; ///< Area of the screen to draw, inside the window's extent.
+    };
+
+    /**
+     * \brief Keep track of what changed on a screen, and pick what to draw to bring it up to date.
+     */
+    struct screen_compositor {
+        common::region damage; ///< Area of the screen whose content changed since the last composition.
+        bool full_redraw_pending; ///< Compose every window again on next redraw, for example when the screen texture is reallocated.
+        std::vector<composed_window> last_composition; ///< Windows drawn on the last composition, back to front.
+
+        explicit screen_compositor();
+
+        /**
+         * \brief Mark an area of the screen as changed.
+         *
+         * \param damaged_rect The area, in screen coordinates.
+         * \param screen_size  Size of the screen. The area is clipped to it.
+         */
+        void add_damage(const eka2l1::rect &damaged_rect, const eka2l1::vec2 &screen_size);
+
+        /**
+         * \brief Pick the parts of the windows to draw, and clear the damage.
+         *
+         * Any change in the window list (move, resize, show or hide) damages the whole screen. A window
+         * only draws the damaged part that no opaque window in front of it covers.
+         *
+         * \param windows     Visible windows, back to front.
+         * \param screen_size Size of the screen.
+         *
+         * \returns Parts to draw, back to front.
+         */
+        std::vector<composed_draw> compose(const std::vector<composed_window> &windows, const eka2l1::vec2 &screen_size);
+    };
+}
@@ -26,19 +26,197 @@
 #include <services/window/common.h>
 #include <utils/reqsts.h>
 
-#include <algorithm>
+#include <common/queue.h>
+
 #include <array>
+#include <atomic>
 #include <cstdint>
 #include <mutex>
 #include <optional>
-#include <vector>
 
 namespace eka2l1::epoc {
-    template <typename T, unsigned int MAX_ELEM = 32>
+    /**
+     * \brief Fixed-capacity ring of queued events.
+     *
+     * Push and pop at the ends are O(1). Removing an element in the middle only marks it dead,
+     * dead elements are skipped on pop, and squeezed out when the ring needs room again.
+     *
+     * This class is not thread-safe.
+     */
+    template <typename T, unsigned int MAX_ELEM>
+    class fifo_ring {
+    public:
+        struct fifo_element {
+            std::uint32_t id;
+            std::uint32_t order; ///< Elements pushed with an order stay sorted by it, lowest first.
+            bool alive;
+            T evt;
+        };
+
+    private:
+        std::array<fifo_element, MAX_ELEM> elems_;
+
+        std::uint32_t head_ = 0; ///< Index of the oldest element.
+        std::uint32_t used_ = 0; ///< Number of elements in the ring, dead ones included.
+        std::uint32_t alive_ = 0; ///< Number of elements not yet removed.
+
+        void compact() {
+            std::uint32_t write_pos = 0;
+
+            for (std::uint32_t read_pos = 0; read_pos < used_; read_pos++) {
+                if (at(read_pos).alive) {
+                    if (write_pos != read_pos) {
+                        at(write_pos) = at(read_pos);
+                    }
+
+                    write_pos++;
+                }
+            }
+
+            used_ = write_pos;
+        }
+
+    public:
+        /**
+         * \brief Get the element at the given position, counting from the oldest one.
+         */
+        fifo_element &at(const std::uint32_t pos) {
+            return elems_[(head_ + pos) % MAX_ELEM];
+        }
+
+        /**
+         * \brief Drop dead elements at both ends of the ring.
+         *
+         * Positions given by at() are not stable across this call.
+         */
+        void trim() {
+            while (used_ && !elems_[head_].alive) {
+                head_ = (head_ + 1) % MAX_ELEM;
+                used_--;
+            }
+
+            while (used_ && !at(used_ - 1).alive) {
+                used_--;
+            }
+        }
+
+        std::uint32_t used() const {
+            return used_;
+        }
+
+        std::uint32_t size() const {
+            return alive_;
+        }
+
+        bool empty() const {
+            return alive_ == 0;
+        }
+
+        bool full() const {
+            return alive_ == MAX_ELEM;
+        }
+
+        /**
+         * \brief Add an element, after every alive element with an order not greater than the given one.
+         *
+         * With the same order for every element, this is a plain push to the back.
+         */
+        bool push(const std::uint32_t id, const T &evt, const std::uint32_t order = 0) {
+            if (used_ == MAX_ELEM) {
+                if (alive_ == MAX_ELEM) {
+                    return false;
+                }
+
+                compact();
+            }
+
+            std::uint32_t pos = used_++;
+
+            for (; pos > 0; pos--) {
+                fifo_element &prev = at(pos - 1);
+
+                if (prev.alive && (prev.order <= order)) {
+                    break;
+                }
+
+                at(pos) = prev;
+            }
+
+            fifo_element &elem = at(pos);
+            elem.id = id;
+            elem.order = order;
+            elem.alive = true;
+            elem.evt = evt;
+
+            alive_++;
+            return true;
+        }
+
+        std::optional<T> pop() {
+            if (alive_ == 0) {
+                return std::nullopt;
+            }
+
+            T evt = elems_[head_].evt;
+
+            elems_[head_].alive = false;
+            alive_--;
+
+            trim();
+            return evt;
+        }
+
+        /**
+         * \brief Get the newest element, or nullptr if the ring is empty.
+         */
+        fifo_element *back() {
+            trim();
+            return (alive_ == 0) ? nullptr : &at(used_ - 1);
+        }
+
+        /**
+         * \brief Mark the element at the given position as removed.
+         *
+         * Positions of other elements stay the same until trim() is called.
+         */
+        void remove(const std::uint32_t pos) {
+            fifo_element &elem = at(pos);
+
+            if (elem.alive) {
+                elem.alive = false;
+                alive_--;
+            }
+        }
+
+        bool remove_by_id(const std::uint32_t id) {
+            for (std::uint32_t i = 0; i < used_; i++) {
+                fifo_element &elem = at(i);
+
+                if (elem.alive && (elem.id == id)) {
+                    remove(i);
+                    trim();
+
+                    return true;
+                }
+            }
+
+            return false;
+        }
+    };
+
+    /**
+     * \brief Event queue made of one or more priority lanes.
+     *
+     * Lanes are drained in order, the first non-empty lane is always popped first.
+     */
+    template <typename T, unsigned int MAX_ELEM = 32, unsigned int LANE_COUNT = 1>
     class base_fifo {
+        static_assert(LANE_COUNT <= 32, "Lane mask only has 32 bits");
+
     public:
         enum {
-            maximum_element = MAX_ELEM
+            maximum_element = MAX_ELEM,
+            lane_count = LANE_COUNT
         };
 
         enum class queue_priority {
@@ -46,45 +224,79 @@ namespace eka2l1::epoc {
             low ///< When the queue is max, the event will not be schedule, until some elements are freed
         };
 
-        struct fifo_element {
-            std::uint32_t id;
-            std::uint16_t pri;
-            T evt;
-
-            fifo_element(const std::uint32_t id, const T &evt)
-                : id(id)
-                , evt(std::move(evt)) {
-            }
-        };
+        using lane = fifo_ring<T, MAX_ELEM>;
 
     protected:
-        std::vector<fifo_element> q_;
+        std::array<lane, LANE_COUNT> lanes_;
+        std::uint32_t lane_mask_ = 0; ///< Bit N is set when lane N has events.
+        std::uint32_t id_counter_ = 0;
+
         std::mutex lock_;
 
         epoc::notify_info nof;
 
-    public:
-        void trigger_notification() {
-            if (q_.size() > 0)
-                nof.complete(0);
+        void update_lane_mask(const unsigned int lane_index) {
+            if (lanes_[lane_index].empty()) {
+                lane_mask_ &= ~(1 << lane_index);
+            } else {
+                lane_mask_ |= (1 << lane_index);
+            }
         }
 
-    protected:
         /*! \brief Queue an event. This doesn't care about whenther the queue has reached maximum size
          *         yet
          * 
          * This method is unsafe
+         *
+         * \returns ID of the event, 0 if the lane is full.
         */
-        std::uint32_t queue_event_dont_care(const T &evt) {
-            fifo_element element(static_cast<std::uint32_t>(q_.size()) + 1, evt);
-            q_.push_back(std::move(element));
+        std::uint32_t queue_event_dont_care(const T &evt, const unsigned int lane_index = 0, const std::uint32_t order = 0) {
+            if (++id_counter_ == 0) {
+                id_counter_ = 1;
+            }
+
+            if (!lanes_[lane_index].push(id_counter_, evt, order)) {
+                return 0;
+            }
+
+            lane_mask_ |= (1 << lane_index);
+            return id_counter_;
+        }
+
+        std::optional<T> get_evt_opt_unsafe() {
+            if (lane_mask_ == 0) {
+                return std::nullopt;
+            }
+
+            unsigned int lane_index = 0;
+
+            while ((lane_mask_ & (1 << lane_index)) == 0) {
+                lane_index++;
+            }
+
+            std::optional<T> evt = lanes_[lane_index].pop();
+            update_lane_mask(lane_index);
+
+            return evt;
+        }
+
+        bool has_events_unsafe() const {
+            return lane_mask_ != 0;
+        }
 
-            return static_cast<std::uint32_t>(q_.size());
+        void trigger_notification_unsafe() {
+            if (has_events_unsafe())
+                nof.complete(0);
         }
 
     public:
         base_fifo() {}
 
+        void trigger_notification() {
+            const std::lock_guard<std::mutex> guard(lock_);
+            trigger_notification_unsafe();
+        }
+
         /*! \brief Set a listener to all events that are going to be queued.
          *
          * If an event is pending, this will mostly returns immidiately with the request finished.
@@ -95,7 +307,7 @@ namespace eka2l1::epoc {
         void set_listener(epoc::notify_info nof_info) {
             const std::lock_guard<std::mutex> guard(lock_);
 
-            if (q_.size() > 0) {
+            if (has_events_unsafe()) {
                 // Complete with KErrNone
                 nof_info.complete(0);
                 return;
@@ -111,11 +323,11 @@ namespace eka2l1::epoc {
         void cancel_event_queue(std::uint32_t id) {
             const std::lock_guard<std::mutex> guard(lock_);
 
-            auto elem_ite = std::find_if(q_.begin(), q_.end(),
-                [=](const fifo_element &elem) { return elem.id == id; });
-
-            if (elem_ite != q_.end()) {
-                q_.erase(elem_ite);
+            for (unsigned int i = 0; i < LANE_COUNT; i++) {
+                if ((lane_mask_ & (1 << i)) && lanes_[i].remove_by_id(id)) {
+                    update_lane_mask(i);
+                    break;
+                }
             }
         }
 
@@ -134,13 +346,19 @@ namespace eka2l1::epoc {
          * \param userdata      Userdata passed to callback.
          */
         void walk(walker_func walker, void *userdata) {
-            for (std::uint32_t i = 0; i < q_.size();) {
-                if (!walker(userdata, q_[i].evt)) {
-                    // Delete the element
-                    q_.erase(q_.begin() + i);
-                } else {
-                    i++;
+            const std::lock_guard<std::mutex> guard(lock_);
+
+            for (unsigned int i = 0; i < LANE_COUNT; i++) {
+                lane &target = lanes_[i];
+
+                for (std::uint32_t j = 0; j < target.used(); j++) {
+                    if (target.at(j).alive && !walker(userdata, target.at(j).evt)) {
+                        target.remove(j);
+                    }
                 }
+
+                target.trim();
+                update_lane_mask(i);
             }
         }
 
@@ -150,20 +368,23 @@ namespace eka2l1::epoc {
         */
         std::optional<T> get_evt_opt() {
             const std::lock_guard<std::mutex> guard(lock_);
-            if (q_.size() == 0) {
-                return std::nullopt;
-            }
-
-            fifo_element elem = std::move(q_.front());
-
-            // Keep the order. Not too efficient though
-            q_.erase(q_.begin());
-            return elem.evt;
+            return get_evt_opt_unsafe();
         }
     };
 
     class event_fifo : public base_fifo<event, 32> {
     protected:
+        static constexpr std::size_t MAX_INPUT_ELEM = 256;
+
+        /**
+         * Events coming from input threads. Keyboard and touch come from the window thread, joysticks
+         * from their polling thread, so pushes are serialized by input_push_lock_. The consumer always
+         * holds the queue lock while draining, so it never waits on a producer.
+         */
+        spsc_ring_queue<event, MAX_INPUT_ELEM> input_q_;
+        std::mutex input_push_lock_;
+        std::atomic<bool> listening_{ false };
+
         /*! \brief Check if the event is high-priority
          *
          * High priority events are password, switch on and off event.
@@ -182,10 +403,31 @@ namespace eka2l1::epoc {
         */
         void do_purge();
 
+        /*! \brief Queue an event, merging it with the last one if both are pointer moves.
+         *
+         * This method is unsafe
+        */
+        std::uint32_t queue_event_unsafe(const event &evt);
+
+        /*! \brief Move events pushed by the input thread to the queue.
+         *
+         * This method is unsafe
+        */
+        void drain_input_unsafe();
+
+        /*! \brief Complete the listener if there is any event.
+         *
+         * This method is unsafe
+        */
+        void notify_unsafe();
+
     public:
         event_fifo()
             : base_fifo<event>() {}
 
+        void set_listener(epoc::notify_info nof_info);
+        void walk(walker_func walker, void *userdata);
+
         /*! \brief Get an on-queue event
          *
          * If there is nothing on the queue, a null event is returned.
@@ -193,12 +435,28 @@ namespace eka2l1::epoc {
         event get_event();
 
         std::uint32_t queue_event(const event &evt);
+
+        /*! \brief Queue an event from an input thread.
+         *
+         * This does not take the queue lock, unless the client is waiting for an event, or
+         * too many input events are waiting to be moved to the queue. Safe to call from many threads.
+        */
+        void queue_input_event(const event &evt);
     };
 
-    class redraw_fifo : public base_fifo<redraw_event, 32> {
+    /**
+     * \brief Queue of redraws, popped in window priority order.
+     *
+     * The priority is the packed ordinal from window_user_base::redraw_priority(), lower goes first.
+     * Its top 4 bits are the top-level window ordinal, which picks the lane. Inside a lane, redraws
+     * are kept sorted by the whole priority, and in queue order for equal ones.
+     */
+    class redraw_fifo : public base_fifo<redraw_event, 32, 16> {
+        static constexpr std::uint32_t LANE_SHIFT = 28;
+
     public:
         redraw_fifo()
-            : base_fifo<redraw_event>() {}
-        std::uint32_t queue_event(const redraw_event &evt, const std::uint16_t pri);
+            : base_fifo<redraw_event, 32, 16>() {}
+        std::uint32_t queue_event(const redraw_event &evt, const std::uint32_t pri);
     };
 }
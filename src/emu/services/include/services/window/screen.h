@@ -19,10 +19,12 @@
 
 #pragma once
 
+#include <common/region.h>
 #include <common/vecx.h>
 #include <drivers/graphics/common.h>
 #include <services/window/classes/config.h>
 #include <services/window/common.h>
+#include <services/window/compositor.h>
 
 #include <cstdint>
 #include <map>
@@ -65,6 +67,7 @@ namespace eka2l1::epoc {
         epoc::display_mode disp_mode;
 
         std::uint64_t last_vsync;
+        std::uint64_t frame_count; ///< Number of frames presented since the screen was created.
 
         epoc::config::screen scr_config; ///< All mode of this screen
         std::uint8_t crr_mode; ///< The current mode being used by the screen.
@@ -74,6 +77,8 @@ namespace eka2l1::epoc {
 
         screen *next;
 
+        screen_compositor compositor; ///< Damage and last composition of the screen.
+
         eka2l1::rect dsa_rect;
         kernel::chunk *screen_buffer_chunk;
 
@@ -150,6 +155,18 @@ namespace eka2l1::epoc {
         void resize(drivers::graphics_driver *driver, const eka2l1::vec2 &new_size);
 
         void deinit(drivers::graphics_driver *driver);
+
+        /**
+         * \brief Compose windows onto the screen texture.
+         * 
+         * Only the damaged area of the screen is drawn again, the rest of the screen texture is kept
+         * from last time. Windows that are fully covered by opaque windows in front of them, or that do not
+         * overlap the damage, are skipped. If windows were moved, resized, shown or hidden since the last
+         * composition, the whole screen is considered damaged.
+         * 
+         * \param builder      The builder to record draw commands to.
+         * \param need_bind    True if the screen texture must be bound first.
+         */
         void redraw(drivers::graphics_command_list_builder *builder, const bool need_bind);
 
         /**
@@ -158,6 +175,12 @@ namespace eka2l1::epoc {
          */
         void redraw(drivers::graphics_driver *driver);
 
+        /**
+         * \brief Mark an area of the screen as changed, so it is composed again on next redraw.
+         * \param damaged_rect The area, in screen coordinates.
+         */
+        void add_damage(const eka2l1::rect &damaged_rect);
+
         /**
          * \brief Update the window group focus.
          */
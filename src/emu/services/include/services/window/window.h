@@ -245,6 +245,13 @@ namespace eka2l1::epoc {
             return events.queue_event(evt);
         }
 
+        /**
+         * \brief Queue an event from the input thread.
+         */
+        void queue_input_event(const event &evt) {
+            events.queue_input_event(evt);
+        }
+
         void walk_event(epoc::event_fifo::walker_func walker, void *userdata) {
             events.walk(walker, userdata);
         }
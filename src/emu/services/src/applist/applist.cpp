@@ -23,14 +23,18 @@
 #include <services/fbs/fbs.h>
 #include <services/context.h>
 
+#include <common/algorithm.h>
 #include <common/benchmark.h>
+#include <common/chunkyseri.h>
 #include <common/cvt.h>
+#include <common/fileutils.h>
 #include <common/log.h>
 #include <common/path.h>
 #include <common/pystr.h>
 #include <common/types.h>
 
 #include <common/common.h>
+#include <config/config.h>
 #include <epoc/epoc.h>
 #include <kernel/kernel.h>
 #include <loader/rsc.h>
@@ -40,7 +44,9 @@
 #include <vfs/vfs.h>
 
 #include <utils/err.h>
+#include <fstream>
 #include <functional>
+#include <map>
 
 namespace eka2l1 {
     const std::string get_app_list_server_name_by_epocver(const epocver ver) {
@@ -54,6 +60,65 @@ namespace eka2l1 {
     applist_server::applist_server(system *sys)
         : service::typical_server(sys, get_app_list_server_name_by_epocver(sys->get_symbian_version_use()))
         , fbsserv(nullptr) {
+        if (config::state *conf = sys->get_config()) {
+            registry_cache_path_ = eka2l1::add_path(conf->storage, "cache/applist/registry.bin");
+        }
+    }
+
+    void apa_app_registry::do_state(common::chunkyseri &seri) {
+        auto absorb_des = [&](auto &des) {
+            std::u16string str;
+
+            if (seri.get_seri_mode() != common::SERI_MODE_READ) {
+                str = des.to_std_string(nullptr);
+            }
+
+            seri.absorb(str);
+
+            if (seri.get_seri_mode() == common::SERI_MODE_READ) {
+                des.assign(nullptr, str);
+            }
+        };
+
+        seri.absorb(mandatory_info.uid);
+        absorb_des(mandatory_info.app_path);
+        absorb_des(mandatory_info.short_caption);
+        absorb_des(mandatory_info.long_caption);
+
+        seri.absorb(caps.ability);
+        seri.absorb(caps.support_being_asked_to_create_new_file);
+        seri.absorb(caps.is_hidden);
+        seri.absorb(caps.launch_in_background);
+        absorb_des(caps.group_name);
+        seri.absorb(caps.flags);
+        seri.absorb(caps.reserved);
+
+        seri.absorb(rsc_path);
+        seri.absorb(localised_info_rsc_path);
+        seri.absorb(localised_info_rsc_id);
+        seri.absorb(default_screen_number);
+        seri.absorb(icon_count);
+        seri.absorb(icon_file_path);
+
+        seri.absorb_container(data_types, [](common::chunkyseri &seri, data_type &type) {
+            seri.absorb(type.priority_);
+            seri.absorb(type.type_);
+        });
+
+        seri.absorb_container(view_datas, [](common::chunkyseri &seri, view_data &view) {
+            seri.absorb(view.uid_);
+            seri.absorb(view.screen_mode_);
+            seri.absorb(view.icon_count_);
+            seri.absorb(view.caption_);
+        });
+
+        seri.absorb_container(ownership_list);
+
+        seri.absorb(rsc_size);
+        seri.absorb(rsc_last_write);
+        seri.absorb(localised_info_rsc_resolved_path);
+        seri.absorb(localised_info_rsc_size);
+        seri.absorb(localised_info_rsc_last_write);
     }
 
     bool applist_server::load_registry_oldarch(eka2l1::io_system *io, const std::u16string &path, drive_number land_drive,
@@ -123,26 +188,35 @@ namespace eka2l1 {
             reg.caps.is_hidden = true;
         }
         
-        regs.push_back(std::move(reg));
+        add_registry(std::move(reg));
         return true;
     }
 
     bool applist_server::load_registry(eka2l1::io_system *io, const std::u16string &path, drive_number land_drive,
-        const language ideal_lang) {
+        const language ideal_lang, const entry_info *resolved_entry) {
         // common::benchmarker marker(__FUNCTION__);
-        const std::u16string nearest_path = utils::get_nearest_lang_file(io, path, ideal_lang, land_drive);
+        const std::u16string nearest_path = resolved_entry ? path : utils::get_nearest_lang_file(io, path, ideal_lang, land_drive);
+        const std::u16string key = common::lowercase_ucs2_string(nearest_path);
 
-        auto find_result = std::find_if(regs.begin(), regs.end(), [=](const apa_app_registry &reg) {
-            return reg.rsc_path == nearest_path;
-        });
+        if (path_index_.find(key) != path_index_.end()) {
+            return true;
+        }
 
-        if (find_result != regs.end()) {
+        if (resolved_entry && use_cached_registry(io, key, *resolved_entry)) {
             return true;
         }
 
         apa_app_registry reg;
         reg.rsc_path = nearest_path;
 
+        if (resolved_entry) {
+            reg.rsc_size = resolved_entry->size;
+            reg.rsc_last_write = resolved_entry->last_write;
+        } else if (auto entry = io->get_entry_info(nearest_path)) {
+            reg.rsc_size = entry->size;
+            reg.rsc_last_write = entry->last_write;
+        }
+
         // Load the resource
         symfile f = io->open_file(nearest_path, READ_MODE | BIN_MODE);
 
@@ -150,13 +224,19 @@ namespace eka2l1 {
             return false;
         }
 
-        auto read_rsc_from_file = [](symfile &f, const int id, const bool confirm_sig, std::uint32_t *uid3) -> std::vector<std::uint8_t> {
+        auto read_rsc_from_file = [](symfile &f, const std::u16string &rsc_path, const int id, const bool confirm_sig,
+            std::uint32_t *uid3) -> std::vector<std::uint8_t> {
+            if (!f) {
+                return {};
+            }
+
             eka2l1::ro_file_stream std_rsc_raw(f.get());
             if (!std_rsc_raw.valid()) {
                 return {};
             }
 
-            loader::rsc_file std_rsc(reinterpret_cast<common::ro_stream *>(&std_rsc_raw));
+            loader::rsc_file std_rsc(reinterpret_cast<common::ro_stream *>(&std_rsc_raw), rsc_path,
+                f->last_modify_since_1ad());
 
             if (confirm_sig) {
                 std_rsc.confirm_signature();
@@ -170,7 +250,7 @@ namespace eka2l1 {
         };
 
         // Open the file
-        auto dat = read_rsc_from_file(f, 1, false, &reg.mandatory_info.uid);
+        auto dat = read_rsc_from_file(f, nearest_path, 1, false, &reg.mandatory_info.uid);
 
         if (dat.empty()) {
             return false;
@@ -210,9 +290,15 @@ namespace eka2l1 {
             return true;
         }
 
+        if (auto entry = io->get_entry_info(localised_path)) {
+            reg.localised_info_rsc_resolved_path = localised_path;
+            reg.localised_info_rsc_size = entry->size;
+            reg.localised_info_rsc_last_write = entry->last_write;
+        }
+
         f = io->open_file(localised_path, READ_MODE | BIN_MODE);
 
-        dat = read_rsc_from_file(f, reg.localised_info_rsc_id, true, nullptr);
+        dat = read_rsc_from_file(f, localised_path, reg.localised_info_rsc_id, true, nullptr);
 
         common::ro_buf_stream localised_app_info_resource_stream(&dat[0], dat.size());
 
@@ -246,20 +332,33 @@ namespace eka2l1 {
             }
         }
 
-        regs.push_back(std::move(reg));
+        add_registry(std::move(reg));
         return true;
     }
 
+    void applist_server::add_registry(apa_app_registry &&reg) {
+        path_index_.emplace(common::lowercase_ucs2_string(reg.rsc_path), regs.size());
+        regs.push_back(std::move(reg));
+    }
+
     bool applist_server::delete_registry(const std::u16string &rsc_path) {
-        auto result = std::find_if(regs.begin(), regs.end(), [rsc_path](const apa_app_registry &reg) {
-            return common::compare_ignore_case(reg.rsc_path, rsc_path) == 0;
-        });
+        auto result = path_index_.find(common::lowercase_ucs2_string(rsc_path));
 
-        if (result == regs.end()) {
+        if (result == path_index_.end()) {
             return false;
         }
 
-        regs.erase(result);
+        const std::size_t index = result->second;
+        path_index_.erase(result);
+
+        // Swap with the last one so only that registry has to be re-indexed. Order is
+        // restored by the next sort.
+        if (index != regs.size() - 1) {
+            regs[index] = std::move(regs.back());
+            path_index_[common::lowercase_ucs2_string(regs[index].rsc_path)] = index;
+        }
+
+        regs.pop_back();
         return true;
     }
 
@@ -267,6 +366,141 @@ namespace eka2l1 {
         std::sort(regs.begin(), regs.end(), [](const apa_app_registry &lhs, const apa_app_registry &rhs) {
             return lhs.mandatory_info.uid < rhs.mandatory_info.uid;
         });
+
+        path_index_.clear();
+        uid_index_.clear();
+
+        for (std::size_t i = 0; i < regs.size(); i++) {
+            path_index_.emplace(common::lowercase_ucs2_string(regs[i].rsc_path), i);
+
+            // Keep the first one on duplicated UID, same as a binary search would
+            uid_index_.emplace(regs[i].mandatory_info.uid, i);
+        }
+    }
+
+    bool applist_server::use_cached_registry(eka2l1::io_system *io, const std::u16string &key, const entry_info &entry) {
+        auto cached = cached_regs_.find(key);
+
+        if (cached == cached_regs_.end()) {
+            return false;
+        }
+
+        apa_app_registry &reg = cached->second;
+
+        if ((reg.rsc_size != entry.size) || (reg.rsc_last_write != entry.last_write)) {
+            return false;
+        }
+
+        if (!reg.localised_info_rsc_resolved_path.empty()) {
+            auto localised_entry = io->get_entry_info(reg.localised_info_rsc_resolved_path);
+
+            if (!localised_entry || (localised_entry->size != reg.localised_info_rsc_size)
+                || (localised_entry->last_write != reg.localised_info_rsc_last_write)) {
+                return false;
+            }
+        }
+
+        add_registry(std::move(reg));
+        cached_regs_.erase(cached);
+
+        return true;
+    }
+
+    bool load_app_registry_cache(const std::string &path, const language lang, std::vector<apa_app_registry> &regs) {
+        std::ifstream cache_stream(path, std::ios::binary);
+
+        if (!cache_stream) {
+            return false;
+        }
+
+        std::vector<std::uint8_t> buf((std::istreambuf_iterator<char>(cache_stream)), std::istreambuf_iterator<char>());
+
+        if (buf.empty()) {
+            return false;
+        }
+
+        common::chunkyseri seri(&buf[0], buf.size(), common::SERI_MODE_READ);
+        auto s = seri.section("AppRegistry", 1);
+
+        if (!s) {
+            return false;
+        }
+
+        // Localised files are picked by language
+        std::uint32_t cached_lang = 0;
+        seri.absorb(cached_lang);
+
+        if (cached_lang != static_cast<std::uint32_t>(lang)) {
+            return false;
+        }
+
+        std::vector<apa_app_registry> cached;
+        seri.absorb_container(cached, [](common::chunkyseri &seri, apa_app_registry &reg) {
+            reg.do_state(seri);
+        });
+
+        if (seri.size() != buf.size()) {
+            LOG_WARN("App registry cache {} is corrupted, ignored", path);
+            return false;
+        }
+
+        regs = std::move(cached);
+        return true;
+    }
+
+    void save_app_registry_cache(const std::string &path, const language lang, std::vector<apa_app_registry> &regs) {
+        std::uint32_t lang32 = static_cast<std::uint32_t>(lang);
+        std::vector<std::uint8_t> buf;
+
+        auto do_cache_state = [&](common::chunkyseri &seri) {
+            seri.section("AppRegistry", 1);
+            seri.absorb(lang32);
+            seri.absorb_container(regs, [](common::chunkyseri &seri, apa_app_registry &reg) {
+                reg.do_state(seri);
+            });
+        };
+
+        {
+            common::chunkyseri seri(nullptr, 0, common::SERI_MODE_MEASURE);
+            do_cache_state(seri);
+
+            buf.resize(seri.size());
+        }
+
+        common::chunkyseri seri(&buf[0], buf.size(), common::SERI_MODE_WRITE);
+        do_cache_state(seri);
+
+        eka2l1::create_directories(eka2l1::file_directory(path));
+        std::ofstream out_stream(path, std::ios::binary);
+
+        if (out_stream) {
+            out_stream.write(reinterpret_cast<const char *>(buf.data()), buf.size());
+        }
+    }
+
+    bool applist_server::load_registry_cache(const language lang) {
+        std::vector<apa_app_registry> cached;
+
+        if (!load_app_registry_cache(registry_cache_path_, lang, cached)) {
+            return false;
+        }
+
+        for (auto &reg : cached) {
+            const std::u16string key = common::lowercase_ucs2_string(reg.rsc_path);
+            cached_regs_.emplace(key, std::move(reg));
+        }
+
+        return true;
+    }
+
+    void applist_server::save_registry_cache(const language lang) {
+        // Old architecture registries hold icon bitmaps created on the FBS server, which can't
+        // outlive the session.
+        if (registry_cache_path_.empty() || is_oldarch()) {
+            return;
+        }
+
+        save_app_registry_cache(registry_cache_path_, lang, regs);
     }
 
     void applist_server::on_register_directory_changes(eka2l1::io_system *io, const std::u16string &base, drive_number land_drive,
@@ -280,7 +514,7 @@ namespace eka2l1 {
             case common::directory_change_action_created:
             case common::directory_change_action_moved_to:
                 if (!change.filename_.empty())
-                    load_registry(io, rsc_path, land_drive);
+                    load_registry(io, rsc_path, land_drive, kern->get_current_language());
 
                 break;
 
@@ -296,7 +530,7 @@ namespace eka2l1 {
             case common::directory_change_action_modified:
                 // Delete the registry and then load it again
                 delete_registry(rsc_path);
-                load_registry(io, rsc_path, land_drive);
+                load_registry(io, rsc_path, land_drive, kern->get_current_language());
 
                 break;
 
@@ -306,6 +540,7 @@ namespace eka2l1 {
         }
 
         sort_registry_list();
+        save_registry_cache(kern->get_current_language());
     }
 
     void applist_server::rescan_registries_oldarch(eka2l1::io_system *io) {
@@ -338,18 +573,64 @@ namespace eka2l1 {
         }
     }
 
+    std::vector<const entry_info *> pick_nearest_lang_entries(const std::vector<entry_info> &entries,
+        const language lang) {
+        const std::string ideal_ext = fmt::format(".r{:02d}", static_cast<int>(lang));
+
+        // Lowercased name without extension -> entry and its rank (lower is better)
+        std::map<std::string, std::pair<const entry_info *, int>> picks;
+
+        for (const entry_info &ent : entries) {
+            const std::string lowered = common::lowercase_string(ent.full_path);
+            const std::string ext = eka2l1::path_extension(lowered);
+
+            int rank = 2;
+
+            if (ext == ideal_ext) {
+                rank = 0;
+            } else if (ext == ".rsc") {
+                rank = 1;
+            }
+
+            auto result = picks.emplace(eka2l1::replace_extension(lowered, ""), std::make_pair(&ent, rank));
+
+            if (!result.second && (rank < result.first->second.second)) {
+                result.first->second = std::make_pair(&ent, rank);
+            }
+        }
+
+        std::vector<const entry_info *> results;
+        results.reserve(picks.size());
+
+        for (auto &[name, pick] : picks) {
+            results.push_back(pick.first);
+        }
+
+        return results;
+    }
+
     void applist_server::rescan_registries_newarch(eka2l1::io_system *io) {
+        const language lang = kern->get_current_language();
+
         for (drive_number drv = drive_z; drv >= drive_a; drv--) {
             if (io->get_drive_entry(drv)) {
                 const std::u16string base_dir = std::u16string(1, drive_to_char16(drv)) + u":\\Private\\10003a3f\\import\\apps\\";
                 auto reg_dir = io->open_dir(base_dir + u"*.r*", io_attrib_include_file);
 
                 if (reg_dir) {
+                    std::vector<entry_info> entries;
+
                     while (auto ent = reg_dir->get_next_entry()) {
                         if (ent->type == io_component_type::file) {
-                            load_registry(io, common::utf8_to_ucs2(ent->full_path), drv, kern->get_current_language());
+                            entries.push_back(std::move(*ent));
                         }
                     }
+
+                    // The listing already tells which language variants exist, pick from it
+                    // rather than probing for each file
+                    for (const entry_info *ent : pick_nearest_lang_entries(entries, lang)) {
+                        load_registry(io, common::utf8_to_ucs2(ent->full_path), drv, lang, ent);
+                    }
                 }
 
                 const std::int64_t watch = io->watch_directory(
@@ -371,10 +652,16 @@ namespace eka2l1 {
         if (kern->is_eka1()) {
             rescan_registries_oldarch(io);
         } else {
+            load_registry_cache(kern->get_current_language());
             rescan_registries_newarch(io);
+
+            // What is left was not found or has changed
+            cached_regs_.clear();
         }
 
         sort_registry_list();
+        save_registry_cache(kern->get_current_language());
+
         LOG_INFO("Done loading!");
     }
 
@@ -415,15 +702,13 @@ namespace eka2l1 {
             init();
         }
 
-        auto result = std::lower_bound(regs.begin(), regs.end(), uid, [](const apa_app_registry &lhs, const std::uint32_t rhs) {
-            return lhs.mandatory_info.uid < rhs;
-        });
+        auto result = uid_index_.find(uid);
 
-        if (result != regs.end() && result->mandatory_info.uid == uid) {
-            return &(*result);
+        if (result == uid_index_.end()) {
+            return nullptr;
         }
 
-        return nullptr;
+        return &regs[result->second];
     }
 
     void applist_server::is_accepted_to_run(service::ipc_context &ctx) {
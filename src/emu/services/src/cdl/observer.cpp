@@ -43,7 +43,8 @@ namespace eka2l1::epoc {
         }
 
         eka2l1::ro_file_stream ref_rsc_file_stream(rsc_file.get());
-        loader::rsc_file ref_rsc_stream(reinterpret_cast<common::ro_stream *>(&ref_rsc_file_stream));
+        loader::rsc_file ref_rsc_stream(reinterpret_cast<common::ro_stream *>(&ref_rsc_file_stream), ref_rsc_path,
+            rsc_file->last_modify_since_1ad());
 
         auto ref_rsc_data = ref_rsc_stream.read(1);
         common::ro_buf_stream ref_rsc_data_stream(&ref_rsc_data[0], ref_rsc_data.size());
@@ -20,8 +20,12 @@
 #include <common/algorithm.h>
 #include <common/chunkyseri.h>
 #include <common/cvt.h>
+#include <common/fileutils.h>
 #include <common/ini.h>
 #include <common/log.h>
+#include <common/path.h>
+
+#include <config/config.h>
 
 #include <epoc/epoc.h>
 #include <services/centralrepo/centralrepo.h>
@@ -205,9 +209,106 @@ namespace eka2l1 {
         return true;
     }
 
+    static std::uint64_t hash_centrep_ini_content(const std::vector<char> &content) {
+        // FNV-1a
+        std::uint64_t hash = 0xCBF29CE484222325ULL;
+
+        for (const char c : content) {
+            hash ^= static_cast<std::uint8_t>(c);
+            hash *= 0x100000001B3ULL;
+        }
+
+        return hash;
+    }
+
+    bool parse_new_centrep_ini_cached(const std::string &path, const std::string &cache_folder, central_repo &repo) {
+        if (cache_folder.empty()) {
+            return parse_new_centrep_ini(path, repo);
+        }
+
+        std::ifstream ini_stream(path, std::ios::binary);
+
+        if (!ini_stream) {
+            return false;
+        }
+
+        const std::vector<char> ini_content((std::istreambuf_iterator<char>(ini_stream)), std::istreambuf_iterator<char>());
+        const std::string cache_path = eka2l1::add_path(cache_folder, fmt::format("{:08x}_{:016x}.cre", repo.uid,
+            hash_centrep_ini_content(ini_content)));
+
+        {
+            std::ifstream cache_stream(cache_path, std::ios::binary);
+
+            if (cache_stream) {
+                std::vector<std::uint8_t> buf((std::istreambuf_iterator<char>(cache_stream)), std::istreambuf_iterator<char>());
+
+                if (!buf.empty()) {
+                    central_repo cached_repo;
+                    common::chunkyseri seri(&buf[0], buf.size(), common::SERI_MODE_READ);
+
+                    if ((do_state_for_cre(seri, cached_repo) == 0) && (cached_repo.uid == repo.uid)) {
+                        repo = std::move(cached_repo);
+                        return true;
+                    }
+                }
+
+                LOG_WARN("Compiled repository cache {} is invalid, parsing the INI again", cache_path);
+            }
+        }
+
+        if (!parse_new_centrep_ini(path, repo)) {
+            return false;
+        }
+
+        // Store the compiled form, so the next boot skips the parsing
+        std::vector<std::uint8_t> buf;
+
+        {
+            common::chunkyseri seri(nullptr, 0, common::SERI_MODE_MEASURE);
+            do_state_for_cre(seri, repo);
+
+            buf.resize(seri.size());
+        }
+
+        common::chunkyseri seri(&buf[0], buf.size(), common::SERI_MODE_WRITE);
+        do_state_for_cre(seri, repo);
+
+        eka2l1::create_directories(cache_folder);
+
+        {
+            // Drop the caches of older versions of this INI, they would never be hit again
+            common::dir_iterator stale_iterator(eka2l1::add_path(cache_folder, fmt::format("{:08x}_*.cre", repo.uid)));
+            common::dir_entry stale_entry;
+
+            std::vector<std::string> stale_paths;
+
+            while (stale_iterator.next_entry(stale_entry) == 0) {
+                stale_paths.push_back(eka2l1::add_path(cache_folder, eka2l1::filename(stale_entry.name)));
+            }
+
+            for (const std::string &stale_path : stale_paths) {
+                if (stale_path != cache_path) {
+                    common::remove(stale_path);
+                }
+            }
+        }
+
+        std::ofstream out_stream(cache_path, std::ios::binary);
+
+        if (out_stream) {
+            out_stream.write(reinterpret_cast<const char *>(buf.data()), buf.size());
+        }
+
+        return true;
+    }
+
     central_repo_server::central_repo_server(eka2l1::system *sys)
         : service::server(sys->get_kernel_system(), sys, CENTRAL_REPO_SERVER_NAME, true)
         , id_counter(0) {
+        if (config::state *conf = sys->get_config()) {
+            compiled_cache_folder = eka2l1::add_path(conf->storage, "cache/centralrepo/");
+        }
+
         REGISTER_IPC(central_repo_server, redirect_msg_to_session, cen_rep_init, "CenRep::Init");
         REGISTER_IPC(central_repo_server, redirect_msg_to_session, cen_rep_close, "CenRep::Close");
         REGISTER_IPC(central_repo_server, redirect_msg_to_session, cen_rep_reset, "CenRep::Reset");
@@ -377,7 +478,11 @@ namespace eka2l1 {
 
                     common::chunkyseri seri(&buf[0], buf.size(), common::SERI_MODE_READ);
 
-                    if (int err = do_state_for_cre(seri, *repo)) {
+                    // Symbian never writes to the firmware-code persists folder, only the emulator does. A file
+                    // there without the real64 marker comes from an older build of the emulator.
+                    const bool in_emulator_persists = (repo_folder == repo_dir + private_dir_persists_separate_firm);
+
+                    if (int err = do_state_for_cre(seri, *repo, in_emulator_persists)) {
                         LOG_ERROR("Loading CRE file failed with code: 0x{:X}, repo 0x{:X}", err, key);
                         avail_drives.pop_back();
 
@@ -400,7 +505,7 @@ namespace eka2l1 {
                 }
 
                 repo->uid = key;
-                if (parse_new_centrep_ini(common::ucs2_to_utf8(*path), *repo)) {
+                if (parse_new_centrep_ini_cached(common::ucs2_to_utf8(*path), compiled_cache_folder, *repo)) {
                     repo->reside_place = avail_drives[0];
                     repo->access_count = 1;
                     avail_drives.pop_back();
@@ -43,9 +43,9 @@ namespace eka2l1 {
      * |      9              |       4       |    Entry count           |
      * 
     */
-    int do_state_for_cre(common::chunkyseri &seri, eka2l1::central_repo &repo) {
+    int do_state_for_cre(common::chunkyseri &seri, eka2l1::central_repo &repo, const bool may_have_float_reals) {
         std::uint32_t uid1 = 0x10000037; // Direct file store UID
-        std::uint32_t uid2 = 0;
+        std::uint32_t uid2 = CRE_REAL64_MARKER_UID;
         std::uint32_t uid3 = 0x10202BE9; // Cenrep Server UID
 
         seri.absorb(uid1);
@@ -56,6 +56,10 @@ namespace eka2l1 {
             return -1;
         }
 
+        // Files we wrote before the marker existed stored reals as 4-byte floats. Files from Symbian
+        // itself have no marker but always use 8 bytes.
+        const bool float_reals = may_have_float_reals && (uid2 != CRE_REAL64_MARKER_UID);
+
         // TODO: Figure out usage
         std::uint32_t unk1 = 0xCC776985;
         std::uint32_t unk2 = 0x14;
@@ -205,8 +209,18 @@ namespace eka2l1 {
             }
 
             case central_repo_entry_type::real: {
-                float dat = static_cast<float>(entry.data.reald);
-                seri.absorb_impl(reinterpret_cast<std::uint8_t *>(&dat), sizeof(float));
+                if (float_reals) {
+                    // Only ever read, the next write migrates the file to TReal64
+                    float dat = static_cast<float>(entry.data.reald);
+                    seri.absorb_impl(reinterpret_cast<std::uint8_t *>(&dat), sizeof(float));
+
+                    entry.data.reald = dat;
+                    break;
+                }
+
+                // Externalized as TReal64
+                double dat = entry.data.reald;
+                seri.absorb_impl(reinterpret_cast<std::uint8_t *>(&dat), sizeof(double));
 
                 entry.data.reald = dat;
 
@@ -223,6 +237,11 @@ namespace eka2l1 {
             }
         }
 
+        if (seri.get_seri_mode() == common::SERI_MODE_READ) {
+            // Lookups binary search the entries
+            repo.sort_entries();
+        }
+
         if (repo.ver >= 1) {
             std::uint32_t deleted_settings_count = static_cast<std::uint32_t>(repo.deleted_settings.size());
             seri.absorb(deleted_settings_count);
@@ -50,51 +50,77 @@ namespace eka2l1 {
         return default_meta;
     }
 
-    bool central_repo::add_new_entry(const std::uint32_t key, const central_repo_entry_variant &var) {
-        if (find_entry(key)) {
-            return false;
-        }
-
-        // Find default meta
-        central_repo_entry entry;
-        entry.metadata_val = get_default_meta_for_new_key(key);
-        entry.key = key;
-        entry.data = var;
-
-        entries.push_back(entry);
+    static bool central_repo_entry_key_less(const central_repo_entry &lhs, const std::uint32_t key) {
+        return lhs.key < key;
+    }
 
-        return true;
+    bool central_repo::add_new_entry(const std::uint32_t key, const central_repo_entry_variant &var) {
+        return add_new_entry(key, var, get_default_meta_for_new_key(key));
     }
 
     bool central_repo::add_new_entry(const std::uint32_t key, const central_repo_entry_variant &var,
         const std::uint32_t meta) {
-        if (find_entry(key)) {
-            return false;
+        // Keys in repository files are usually in order, so appending is the common case
+        auto ite = entries.end();
+
+        if (!entries.empty() && (entries.back().key >= key)) {
+            ite = std::lower_bound(entries.begin(), entries.end(), key, central_repo_entry_key_less);
+
+            if (ite->key == key) {
+                return false;
+            }
         }
 
-        // Find default meta
         central_repo_entry entry;
         entry.metadata_val = meta;
         entry.key = key;
         entry.data = var;
 
-        entries.push_back(entry);
+        entries.insert(ite, std::move(entry));
 
         return true;
     }
 
     central_repo_entry *central_repo::find_entry(const std::uint32_t key) {
-        auto ite = std::find_if(entries.begin(), entries.end(), [=](const central_repo_entry &e) {
-            return e.key == key;
-        });
+        auto ite = std::lower_bound(entries.begin(), entries.end(), key, central_repo_entry_key_less);
 
-        if (ite == entries.end()) {
+        if ((ite == entries.end()) || (ite->key != key)) {
             return nullptr;
         }
 
         return &(*ite);
     }
 
+    std::pair<std::vector<central_repo_entry>::iterator, std::vector<central_repo_entry>::iterator>
+    central_repo::entries_in_filter_range(const std::uint32_t partial_key, const std::uint32_t mask) {
+        // Take the leading ones of the mask. Every matching key shares these bits with the partial key.
+        std::uint32_t prefix_mask = 0;
+
+        for (std::uint32_t bit = 0x80000000; bit && (mask & bit); bit >>= 1) {
+            prefix_mask |= bit;
+        }
+
+        const std::uint32_t low_key = partial_key & prefix_mask;
+        const std::uint32_t high_key = low_key | ~prefix_mask;
+
+        auto begin = std::lower_bound(entries.begin(), entries.end(), low_key, central_repo_entry_key_less);
+        auto end = std::upper_bound(begin, entries.end(), high_key, [](const std::uint32_t key, const central_repo_entry &rhs) {
+            return key < rhs.key;
+        });
+
+        return { begin, end };
+    }
+
+    void central_repo::sort_entries() {
+        auto key_less = [](const central_repo_entry &lhs, const central_repo_entry &rhs) {
+            return lhs.key < rhs.key;
+        };
+
+        if (!std::is_sorted(entries.begin(), entries.end(), key_less)) {
+            std::stable_sort(entries.begin(), entries.end(), key_less);
+        }
+    }
+
     void central_repo::query_entries(const std::uint32_t partial_key, const std::uint32_t mask,
         std::vector<central_repo_entry *> &matched_entries,
         const central_repo_entry_type etype) {
@@ -185,14 +211,7 @@ namespace eka2l1 {
         // If not in transaction, or if we are in transaction but read-mode
         // Directly get the repo data
         if (!active || mode == 0) {
-            auto result = std::find_if(attach_repo->entries.begin(), attach_repo->entries.end(),
-                [&](const central_repo_entry &entry) { return entry.key == key; });
-
-            if (result == attach_repo->entries.end()) {
-                return nullptr;
-            }
-
-            return &(*result);
+            return attach_repo->find_entry(key);
         }
 
         transactor.changes.emplace(key, central_repo_entry{});
@@ -451,7 +470,30 @@ namespace eka2l1 {
         // Set found count to 0
         found_uid_result_array[0] = 0;
 
-        for (auto &entry : attach_repo->entries) {
+        // Value to compare against, read once for all entries
+        std::int32_t compare_int = 0;
+        std::string compare_string;
+
+        switch (ctx->msg->function) {
+        case cen_rep_find_eq_int:
+        case cen_rep_find_neq_int:
+            compare_int = ctx->get_argument_value<std::int32_t>(1).value_or(0);
+            break;
+
+        case cen_rep_find_eq_string:
+        case cen_rep_find_neq_string:
+            compare_string = ctx->get_argument_value<std::string>(1).value_or("");
+            break;
+
+        default:
+            break;
+        }
+
+        auto [range_begin, range_end] = attach_repo->entries_in_filter_range(filter->partial_key, filter->id_mask);
+
+        for (auto entry_ite = range_begin; entry_ite != range_end; entry_ite++) {
+            central_repo_entry &entry = *entry_ite;
+
             // Try to match the key first
             if ((entry.key & filter->id_mask) != (filter->partial_key & filter->id_mask)) {
                 // Mask doesn't match, abandon this entry
@@ -483,7 +525,7 @@ namespace eka2l1 {
 
                 // Index 1 argument contains the value we should look for
                 // TODO: Signed/unsigned is dangerous
-                if (static_cast<std::int32_t>(entry.data.intd) == *ctx->get_argument_value<std::int32_t>(1)) {
+                if (static_cast<std::int32_t>(entry.data.intd) == compare_int) {
                     if (!find_not_eq) {
                         key_found = entry.key;
                     }
@@ -503,7 +545,7 @@ namespace eka2l1 {
                     break;
                 }
 
-                if (static_cast<std::string>(entry.data.strd) == ctx->get_argument_value<std::string>(1)) {
+                if (entry.data.strd == compare_string) {
                     if (!find_not_eq) {
                         key_found = entry.key;
                     }
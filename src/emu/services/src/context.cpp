@@ -29,6 +29,8 @@
 
 #include <config/config.h>
 
+#include <common/profile.h>
+
 namespace eka2l1 {
     namespace service {
         ipc_context::ipc_context(const bool auto_free, const bool accurate_timing)
@@ -155,6 +157,8 @@ namespace eka2l1 {
                     signaled = true;
                 }
             }
+
+            sys->get_kernel_system()->call_ipc_complete_callbacks(msg.get(), res);
         }
 
         int ipc_context::flag() const {
@@ -345,6 +349,8 @@ namespace eka2l1 {
                 return;
             }
 
+            EKA2L1_PROFILE_SCOPE_DYNAMIC("ipc", obj_name);
+
             int func = process_msg->function;
 
             auto func_ite = ipc_funcs.find(func);
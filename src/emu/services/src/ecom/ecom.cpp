@@ -19,16 +19,23 @@
  */
 
 #include <cassert>
-#include <regex>
+#include <fstream>
 
+#include <common/algorithm.h>
 #include <common/buffer.h>
 #include <common/chunkyseri.h>
 #include <common/cvt.h>
+#include <common/fileutils.h>
 #include <common/log.h>
 #include <common/path.h>
 #include <common/pystr.h>
+#include <common/watcher.h>
+
+#include <config/config.h>
+#include <kernel/kernel.h>
 
 #include <services/ecom/ecom.h>
+#include <services/ecom/registry.h>
 #include <vfs/vfs.h>
 
 #include <epoc/epoc.h>
@@ -68,6 +75,26 @@ namespace eka2l1 {
         return false;
     }
 
+    void ecom_server::unregister_plugin(const std::u16string &name, const drive_number drv) {
+        auto is_from_plugin = [&](const ecom_implementation_info_ptr &impl) {
+            return (impl->drv == drv) && (common::compare_ignore_case(impl->original_name, name) == 0);
+        };
+
+        for (auto ite = interfaces.begin(); ite != interfaces.end();) {
+            auto &impls = ite->second.implementations;
+            impls.erase(std::remove_if(impls.begin(), impls.end(), is_from_plugin), impls.end());
+
+            if (impls.empty()) {
+                ite = interfaces.erase(ite);
+            } else {
+                ite++;
+            }
+        }
+
+        implementations.erase(std::remove_if(implementations.begin(), implementations.end(), is_from_plugin),
+            implementations.end());
+    }
+
     std::vector<std::string> ecom_server::get_ecom_plugin_archives(eka2l1::io_system *io) {
         std::u16string pattern = u"";
 
@@ -142,13 +169,7 @@ namespace eka2l1 {
     }
 
     ecom_interface_info *ecom_server::get_interface(const epoc::uid interface_uid) {
-        if (!init) {
-            if (!load_plugins(sys->get_io_system())) {
-                LOG_ERROR("An error happens with initialization of ECom");
-            }
-
-            init = true;
-        }
+        update_registry();
 
         // First, lookup the interface
         auto interface_ite = interfaces.find(interface_uid);
@@ -162,13 +183,7 @@ namespace eka2l1 {
     }
 
     bool ecom_server::get_resolved_implementations(std::vector<ecom_implementation_info_ptr> &collect_vector, const epoc::uid interface_uid, const ecom_resolver_params &params, const bool generic_wildcard_match) {
-        if (!init) {
-            if (!load_plugins(sys->get_io_system())) {
-                LOG_ERROR("An error happens with initialization of ECom");
-            }
-
-            init = true;
-        }
+        update_registry();
 
          // First, lookup the interface
         auto interface_ite = interfaces.find(interface_uid);
@@ -182,12 +197,8 @@ namespace eka2l1 {
         // - All extended interfaces given are available in the implementation
         // - Match the wildcard (if wildcard not empty)
 
-        // May want to construct a regex for name comparing if we use generic match
-        std::regex wildcard_matcher;
-
-        if (generic_wildcard_match && !params.match_string_.empty()) {
-            wildcard_matcher = std::move(std::regex(common::wildcard_to_regex_string(params.match_string_)));
-        }
+        // Prepare the matcher once for all implementations
+        const common::wildcard_matcher wildcard_matcher(params.match_string_, false);
 
         // Iterate through all implementations
         for (ecom_implementation_info_ptr &implementation : interface_ite->second.implementations) {
@@ -219,7 +230,7 @@ namespace eka2l1 {
             // We still need to see if the name is match
             // Generic match ? Wildcard check
             if (generic_wildcard_match) {
-                if (std::regex_match(implementation->default_data, wildcard_matcher)) {
+                if (wildcard_matcher.match(implementation->default_data)) {
                     satisfy = true;
                 }
             } else {
@@ -320,19 +331,175 @@ namespace eka2l1 {
             }
         }
 
-        // TODO: Register a notification to the server side
-
         return true;
     }
 
-    void ecom_server::connect(service::ipc_context &ctx) {
-        if (!init) {
-            if (!load_plugins(ctx.sys->get_io_system())) {
+    std::uint64_t ecom_server::get_plugin_fingerprint(eka2l1::io_system *io) {
+        std::vector<entry_info> entries;
+
+        for (const std::string &archive : get_ecom_plugin_archives(io)) {
+            if (auto entry = io->get_entry_info(common::utf8_to_ucs2(archive))) {
+                entries.push_back(*entry);
+            }
+        }
+
+        for (drive_number drv = drive_a; drv <= drive_z; drv = (drive_number)((int)drv + 1)) {
+            if (!io->get_drive_entry(drv)) {
+                continue;
+            }
+
+            std::u16string plugin_dir_path;
+            plugin_dir_path += drive_to_char16(drv);
+            plugin_dir_path += u":\\Resource\\Plugins\\*.r*";
+
+            if (auto plugin_dir = io->open_dir(plugin_dir_path, io_attrib_include_file)) {
+                while (auto entry = plugin_dir->get_next_entry()) {
+                    entries.push_back(*entry);
+                }
+            }
+        }
+
+        return make_ecom_plugin_fingerprint(static_cast<std::uint32_t>(sys->get_system_language()),
+            static_cast<std::uint32_t>(kern->get_epoc_version()), entries);
+    }
+
+    bool ecom_server::load_registry_cache(const std::uint64_t fingerprint) {
+        return load_ecom_registry_cache(registry_cache_path_, fingerprint, interfaces, implementations);
+    }
+
+    void ecom_server::save_registry_cache(const std::uint64_t fingerprint) {
+        if (registry_cache_path_.empty()) {
+            return;
+        }
+
+        save_ecom_registry_cache(registry_cache_path_, fingerprint, interfaces, implementations);
+    }
+
+    void ecom_server::watch_plugin_directories(eka2l1::io_system *io) {
+        for (drive_number drv = drive_a; drv <= drive_z; drv = (drive_number)((int)drv + 1)) {
+            auto drive_entry = io->get_drive_entry(drv);
+
+            // ROM content never changes under us
+            if (!drive_entry || (drive_entry->media_type == drive_media::rom)) {
+                continue;
+            }
+
+            const std::u16string base_dir = std::u16string(1, drive_to_char16(drv)) + u":\\Resource\\Plugins\\";
+            const std::int64_t watch = io->watch_directory(
+                base_dir, [this, base_dir](void *userdata, common::directory_changes &changes) {
+                    on_plugin_directory_changes(base_dir, changes);
+                },
+                nullptr, common::directory_change_move | common::directory_change_last_write);
+
+            if (watch != -1) {
+                watchs_.push_back(watch);
+            }
+        }
+    }
+
+    void ecom_server::on_plugin_directory_changes(const std::u16string &base, common::directory_changes &changes) {
+        const std::lock_guard<std::mutex> guard(pending_changes_lock_);
+
+        for (auto &change : changes) {
+            if (change.filename_.empty()) {
+                continue;
+            }
+
+            const std::u16string plugin_path = eka2l1::add_path(base, common::utf8_to_ucs2(change.filename_));
+            const std::u16string ext = common::lowercase_ucs2_string(eka2l1::path_extension(plugin_path));
+
+            // Same filter as the plugin scan: only resource files
+            if ((ext.length() < 2) || (ext[1] != u'r')) {
+                continue;
+            }
+
+            pending_plugin_changes_.insert(plugin_path);
+        }
+    }
+
+    void ecom_server::apply_pending_plugin_changes(eka2l1::io_system *io) {
+        std::set<std::u16string> changes;
+
+        {
+            const std::lock_guard<std::mutex> guard(pending_changes_lock_);
+            changes.swap(pending_plugin_changes_);
+        }
+
+        if (changes.empty()) {
+            return;
+        }
+
+        for (const std::u16string &plugin_path : changes) {
+            const drive_number drv = char16_to_drive(plugin_path[0]);
+            const std::u16string name = eka2l1::replace_extension(eka2l1::filename(plugin_path), u"");
+
+            // Drop what the old version of the resource registered, then load it again if it's still there
+            unregister_plugin(name, drv);
+
+            symfile f = io->open_file(plugin_path, READ_MODE | BIN_MODE);
+
+            if (!f) {
+                LOG_TRACE("ECom plugin {} removed", common::ucs2_to_utf8(plugin_path));
+                continue;
+            }
+
+            std::vector<std::uint8_t> dat;
+            dat.resize(f->size());
+
+            if (!dat.empty()) {
+                f->read_file(&dat[0], static_cast<std::uint32_t>(dat.size()), 1);
+            }
+
+            f->close();
+
+            if (dat.empty() || !load_and_install_plugin_from_buffer(plugin_path, &dat[0], dat.size(), drv)) {
+                LOG_ERROR("Can't load and install plugins description {}", common::ucs2_to_utf8(plugin_path));
+                continue;
+            }
+
+            LOG_TRACE("ECom plugin {} registered", common::ucs2_to_utf8(plugin_path));
+        }
+
+        save_registry_cache(get_plugin_fingerprint(io));
+    }
+
+    void ecom_server::update_registry() {
+        eka2l1::io_system *io = sys->get_io_system();
+
+        if (init) {
+            apply_pending_plugin_changes(io);
+            return;
+        }
+
+        // Watch before fingerprinting, so nothing installed in between gets lost
+        watch_plugin_directories(io);
+
+        {
+            // The scan below picks up everything reported so far. Changes reported while it runs
+            // are applied right after, as they may have come in after their directory was read.
+            const std::lock_guard<std::mutex> guard(pending_changes_lock_);
+            pending_plugin_changes_.clear();
+        }
+
+        const std::uint64_t fingerprint = get_plugin_fingerprint(io);
+
+        if (!registry_cache_path_.empty() && load_registry_cache(fingerprint)) {
+            LOG_INFO("ECom registry loaded from cache ({} interfaces, {} implementations)", interfaces.size(),
+                implementations.size());
+        } else {
+            if (!load_plugins(io)) {
                 LOG_ERROR("An error happens with initialization of ECom");
             }
+
+            save_registry_cache(fingerprint);
         }
 
         init = true;
+        apply_pending_plugin_changes(io);
+    }
+
+    void ecom_server::connect(service::ipc_context &ctx) {
+        update_registry();
 
         create_session<ecom_session>(&ctx);
         ctx.complete(epoc::error_none);
@@ -582,5 +749,16 @@ namespace eka2l1 {
 
     ecom_server::ecom_server(eka2l1::system *sys)
         : service::typical_server(sys, "!ecomserver") {
+        if (config::state *conf = sys->get_config()) {
+            registry_cache_path_ = eka2l1::add_path(conf->storage, "cache/ecom/registry.bin");
+        }
+    }
+
+    ecom_server::~ecom_server() {
+        eka2l1::io_system *io = sys->get_io_system();
+
+        for (const std::int64_t watch : watchs_) {
+            io->unwatch_directory(watch);
+        }
     }
 }
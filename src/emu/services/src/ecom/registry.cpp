@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project 
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <services/ecom/registry.h>
+
+#include <common/chunkyseri.h>
+#include <common/cvt.h>
+#include <common/fileutils.h>
+#include <common/log.h>
+#include <common/path.h>
+#include <vfs/vfs.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+namespace eka2l1 {
+    static void hash_plugin_fingerprint(std::uint64_t &hash, const std::uint8_t *data, const std::size_t size) {
+        // FNV-1a
+        for (std::size_t i = 0; i < size; i++) {
+            hash ^= data[i];
+            hash *= 0x100000001B3ULL;
+        }
+    }
+
+    static std::uint64_t hash_plugin_entry(const entry_info &entry) {
+        std::uint64_t hash = 0xCBF29CE484222325ULL;
+
+        const std::string name = common::lowercase_string(entry.full_path);
+        const std::uint64_t size = entry.size;
+
+        hash_plugin_fingerprint(hash, reinterpret_cast<const std::uint8_t *>(name.data()), name.size());
+        hash_plugin_fingerprint(hash, reinterpret_cast<const std::uint8_t *>(&size), sizeof(size));
+        hash_plugin_fingerprint(hash, reinterpret_cast<const std::uint8_t *>(&entry.last_write), sizeof(entry.last_write));
+
+        return hash;
+    }
+
+    std::uint64_t make_ecom_plugin_fingerprint(const std::uint32_t lang, const std::uint32_t ver, const std::vector<entry_info> &entries) {
+        std::uint64_t fingerprint = 0xCBF29CE484222325ULL;
+
+        hash_plugin_fingerprint(fingerprint, reinterpret_cast<const std::uint8_t *>(&lang), sizeof(lang));
+        hash_plugin_fingerprint(fingerprint, reinterpret_cast<const std::uint8_t *>(&ver), sizeof(ver));
+
+        // Entry hashes are summed, so the order the host lists the directory in does not matter
+        std::uint64_t entries_hash = 0;
+
+        for (const entry_info &entry : entries) {
+            entries_hash += hash_plugin_entry(entry);
+        }
+
+        hash_plugin_fingerprint(fingerprint, reinterpret_cast<const std::uint8_t *>(&entries_hash), sizeof(entries_hash));
+        return fingerprint;
+    }
+
+    void do_ecom_registry_state(common::chunkyseri &seri, ecom_interface_map &interfaces, std::vector<ecom_implementation_info_ptr> &implementations) {
+        std::uint32_t total_interfaces = static_cast<std::uint32_t>(interfaces.size());
+        seri.absorb(total_interfaces);
+
+        auto interface_ite = interfaces.begin();
+
+        for (std::uint32_t i = 0; i < total_interfaces; i++) {
+            std::uint32_t interface_uid = 0;
+
+            if (seri.get_seri_mode() != common::SERI_MODE_READ) {
+                interface_uid = interface_ite->first;
+            }
+
+            seri.absorb(interface_uid);
+
+            ecom_interface_info &interface = interfaces[interface_uid];
+            interface.uid = interface_uid;
+
+            std::uint32_t total_impls = static_cast<std::uint32_t>(interface.implementations.size());
+            seri.absorb(total_impls);
+
+            if (seri.get_seri_mode() == common::SERI_MODE_READ) {
+                if (seri.eos()) {
+                    return;
+                }
+
+                interface.implementations.resize(total_impls);
+            }
+
+            for (auto &impl : interface.implementations) {
+                if (seri.get_seri_mode() == common::SERI_MODE_READ) {
+                    impl = std::make_shared<ecom_implementation_info>();
+                }
+
+                seri.absorb(impl->original_name);
+                seri.absorb(impl->uid);
+                seri.absorb(impl->version);
+                seri.absorb(impl->format);
+                seri.absorb(impl->display_name);
+                seri.absorb(impl->default_data);
+                seri.absorb(impl->opaque_data);
+
+                // Creation info is resolved against the loaded DLL, don't carry it over
+                std::uint32_t flags = impl->flags & ~ecom_implementation_info::FLAG_IMPL_CREATE_INFO_CACHED;
+                seri.absorb(flags);
+
+                std::uint32_t drv32 = static_cast<std::uint32_t>(impl->drv);
+                seri.absorb(drv32);
+
+                seri.absorb_container(impl->extended_interfaces);
+
+                if (seri.get_seri_mode() == common::SERI_MODE_READ) {
+                    impl->flags = flags;
+                    impl->drv = static_cast<drive_number>(drv32);
+
+                    implementations.push_back(impl);
+                }
+            }
+
+            if (seri.get_seri_mode() != common::SERI_MODE_READ) {
+                interface_ite++;
+            }
+        }
+
+        if (seri.get_seri_mode() == common::SERI_MODE_READ) {
+            std::sort(implementations.begin(), implementations.end(),
+                [](const ecom_implementation_info_ptr &lhs, const ecom_implementation_info_ptr &rhs) {
+                    return lhs->uid < rhs->uid;
+                });
+        }
+    }
+
+    bool load_ecom_registry_cache(const std::string &path, const std::uint64_t fingerprint, ecom_interface_map &interfaces,
+        std::vector<ecom_implementation_info_ptr> &implementations) {
+        std::ifstream cache_stream(path, std::ios::binary);
+
+        if (!cache_stream) {
+            return false;
+        }
+
+        std::vector<std::uint8_t> buf((std::istreambuf_iterator<char>(cache_stream)), std::istreambuf_iterator<char>());
+
+        if (buf.empty()) {
+            return false;
+        }
+
+        common::chunkyseri seri(&buf[0], buf.size(), common::SERI_MODE_READ);
+        auto s = seri.section("EComRegistry", 1);
+
+        if (!s) {
+            return false;
+        }
+
+        std::uint64_t cached_fingerprint = 0;
+        seri.absorb(cached_fingerprint);
+
+        if (cached_fingerprint != fingerprint) {
+            return false;
+        }
+
+        do_ecom_registry_state(seri, interfaces, implementations);
+
+        // Reads past the end are dropped without moving forward, so also check that what got loaded
+        // takes exactly the whole cache when written back
+        common::chunkyseri measure_seri(nullptr, 0, common::SERI_MODE_MEASURE);
+        measure_seri.section("EComRegistry", 1);
+        measure_seri.absorb(cached_fingerprint);
+        do_ecom_registry_state(measure_seri, interfaces, implementations);
+
+        if ((seri.size() != buf.size()) || (measure_seri.size() != buf.size())) {
+            LOG_WARN("ECom registry cache {} is corrupted, scanning plugins again", path);
+
+            interfaces.clear();
+            implementations.clear();
+
+            return false;
+        }
+
+        return true;
+    }
+
+    void save_ecom_registry_cache(const std::string &path, const std::uint64_t fingerprint, ecom_interface_map &interfaces,
+        std::vector<ecom_implementation_info_ptr> &implementations) {
+        std::uint64_t fingerprint_to_write = fingerprint;
+        std::vector<std::uint8_t> buf;
+
+        {
+            common::chunkyseri seri(nullptr, 0, common::SERI_MODE_MEASURE);
+            seri.section("EComRegistry", 1);
+            seri.absorb(fingerprint_to_write);
+            do_ecom_registry_state(seri, interfaces, implementations);
+
+            buf.resize(seri.size());
+        }
+
+        common::chunkyseri seri(&buf[0], buf.size(), common::SERI_MODE_WRITE);
+        seri.section("EComRegistry", 1);
+        seri.absorb(fingerprint_to_write);
+        do_ecom_registry_state(seri, interfaces, implementations);
+
+        eka2l1::create_directories(eka2l1::file_directory(path));
+        std::ofstream out_stream(path, std::ios::binary);
+
+        if (out_stream) {
+            out_stream.write(reinterpret_cast<const char *>(buf.data()), buf.size());
+        }
+    }
+}
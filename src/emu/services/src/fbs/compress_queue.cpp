@@ -25,10 +25,27 @@
 #include <common/log.h>
 #include <common/runlen.h>
 
+#include <kernel/kernel.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
 namespace eka2l1 {
+    // Maximum number of compressed bitmaps before dirty notifications are sent, even if the queue is still busy.
+    static constexpr std::uint32_t NOTIFY_BATCH_SIZE = 16;
+
+    // Workers keep their compression scratch buffer between bitmaps only up to this size.
+    static constexpr std::size_t MAX_KEPT_SCRATCH_SIZE = 512 * 1024;
+
     compress_queue::compress_queue(fbs_server *serv)
-        : serv_(serv) {
-        queue_.max_pending_count_ = 256;
+        : serv_(serv)
+        , kern_(serv->get_kernel_object_owner())
+        , outstanding_count_(0)
+        , compressed_since_notify_(0) {
+        // Requests are pushed with the kernel locked, which workers need to publish their results.
+        // Waiting for a free slot there would deadlock, so never cap the queue.
+        queue_.max_pending_count_ = std::numeric_limits<std::uint32_t>::max();
     }
 
     void compress_queue::compress(fbsbitmap *bmp) {
@@ -38,6 +55,7 @@ namespace eka2l1 {
             return;
         }
 
+        outstanding_count_++;
         queue_.push(bmp);
     }
 
@@ -67,146 +85,151 @@ namespace eka2l1 {
         return epoc::bitmap_file_no_compression;
     }
 
-    static std::size_t estimate_compress_size(fbsbitmap *bmp, std::uint8_t *data_base) {
-        std::size_t est_size = 0;
-        data_base += bmp->bitmap_->data_offset_;
-
-        common::ro_buf_stream source(data_base, bmp->bitmap_->header_.bitmap_size - sizeof(loader::sbm_header));
+    static bool compress_data(fbsbitmap *bmp, const std::uint8_t *base, std::vector<std::uint8_t> &dest, const std::size_t max_size) {
+        const std::uint8_t *source = base + bmp->bitmap_->data_offset_;
+        const std::size_t source_size = bmp->bitmap_->header_.bitmap_size - sizeof(loader::sbm_header);
 
         switch (bmp->bitmap_->header_.bit_per_pixels) {
         case 8:
-            compress_rle<8>(&source, nullptr, est_size);
-            break;
+            return compress_rle<8>(source, source_size, dest, max_size);
 
         case 16:
-            compress_rle<16>(&source, nullptr, est_size);
-            break;
+            return compress_rle<16>(source, source_size, dest, max_size);
 
         case 24:
-            compress_rle<24>(&source, nullptr, est_size);
-            break;
+            return compress_rle<24>(source, source_size, dest, max_size);
 
         case 32:
-            compress_rle<32>(&source, nullptr, est_size);
-            break;
+            return compress_rle<32>(source, source_size, dest, max_size);
 
         default:
             break;
         }
 
-        return est_size;
+        return false;
     }
 
-    static bool compress_data(fbsbitmap *bmp, std::uint8_t *base, std::uint8_t *dest_ptr, const std::size_t dest_size) {
-        std::size_t est_size = 0;
-        base += bmp->bitmap_->data_offset_;
-
-        common::ro_buf_stream source(base, bmp->bitmap_->header_.bitmap_size - sizeof(loader::sbm_header));
-        common::wo_buf_stream dest(dest_ptr, dest_size);
-
-        bool result = false;
+    bool compress_queue::actual_compress(fbsbitmap *bmp, std::vector<std::uint8_t> &compressed_data) {
+        const epoc::bitmap_file_compression target_compression = get_suitable_compression_method(bmp);
+        const std::size_t org_size = bmp->bitmap_->header_.bitmap_size - sizeof(loader::sbm_header);
 
-        switch (bmp->bitmap_->header_.bit_per_pixels) {
-        case 8:
-            result = compress_rle<8>(&source, &dest, est_size);
-            break;
+        // Compress in one pass to the worker's scratch buffer. The encoder stops early
+        // once the result is no smaller than the original, in that case don't bother.
+        std::uint8_t *data_base = serv_->get_large_chunk_base();
 
-        case 16:
-            result = compress_rle<16>(&source, &dest, est_size);
-            break;
+        const bool worth_it = (target_compression != epoc::bitmap_file_no_compression) && (org_size != 0)
+            && compress_data(bmp, data_base, compressed_data, org_size - 1);
 
-        case 24:
-            result = compress_rle<24>(&source, &dest, est_size);
-            break;
+        // Publishing touches server objects and guest request statuses, which the server thread uses while
+        // handling IPC with the kernel locked. Do it under the same lock.
+        const std::lock_guard<kernel_system> guard(*kern_);
 
-        case 32:
-            result = compress_rle<32>(&source, nullptr, est_size);
-            break;
-
-        default:
-            break;
+        if (!worth_it) {
+            bmp->compress_done_nof.complete(epoc::error_none);
+            return false;
         }
 
-        return result;
-    }
+        const std::size_t compressed_size = compressed_data.size();
 
-    void compress_queue::actual_compress(fbsbitmap *bmp) {
         fbsbitmap *clean_bitmap = bmp;
-        epoc::bitmap_file_compression target_compression = get_suitable_compression_method(bmp);
+        std::uint8_t *new_data = reinterpret_cast<std::uint8_t *>(serv_->allocate_large_data(compressed_size));
 
-        if (target_compression == epoc::bitmap_file_no_compression) {
-            return;
-        }
-
-        if (bmp->support_dirty_bitmap) {
+        if (new_data && bmp->support_dirty_bitmap) {
             // Have to create new bitmap
             fbs_bitmap_data_info info;
             info.dpm_ = bmp->bitmap_->settings_.current_display_mode();
             info.size_ = bmp->bitmap_->header_.size_pixels;
 
             clean_bitmap = serv_->create_bitmap(info, false, true);
+
+            if (!clean_bitmap) {
+                serv_->free_large_data(new_data);
+                new_data = nullptr;
+            }
         }
 
+        if (!new_data) {
+            LOG_ERROR("Unable to compress bitmap {}", bmp->id);
+            bmp->compress_done_nof.complete(epoc::error_no_memory);
+
+            return false;
+        }
+
+        std::memcpy(new_data, compressed_data.data(), compressed_size);
+
         clean_bitmap->bitmap_->header_.compression = target_compression;
         clean_bitmap->bitmap_->compressed_in_ram_ = true;
+        clean_bitmap->bitmap_->data_offset_ = static_cast<int>(new_data - data_base);
+        clean_bitmap->bitmap_->header_.bitmap_size = static_cast<std::uint32_t>(compressed_size + sizeof(loader::sbm_header));
 
-        // Estimate compressed size
-        std::uint8_t *data_base = serv_->get_large_chunk_base();
-        const std::size_t estimated_size = estimate_compress_size(bmp, data_base);
-        const std::size_t org_size = bmp->bitmap_->header_.bitmap_size - sizeof(loader::sbm_header);
-
-        if (estimated_size >= org_size) {
-            // Stop compress
-            if (bmp->support_dirty_bitmap) {
-                serv_->free_bitmap(clean_bitmap);
-            }
+        bmp->clean_bitmap = clean_bitmap;
 
-            bmp->compress_done_nof.complete(epoc::error_none);
-            return;
-        }
+        // Mark old bitmap as dirty
+        bmp->bitmap_->settings_.dirty_bitmap(true);
 
-        std::uint8_t *new_data = reinterpret_cast<std::uint8_t *>(serv_->allocate_large_data(estimated_size));
-        const bool compress_result = compress_data(bmp, data_base, new_data, estimated_size);
+        // Notify bitmap compression done. Now the thread can run.
+        bmp->compress_done_nof.complete(epoc::error_none);
 
-        if (!compress_result) {
-            LOG_ERROR("Unable to compress bitmap {}", bmp->id);
+        LOG_TRACE("Bitmap ID {} compressed with ratio {}%, clean bitmap ID {}", bmp->id, static_cast<int>(static_cast<double>(compressed_size) / static_cast<double>(org_size) * 100.0), clean_bitmap->id);
+        return true;
+    }
 
-            // Cleanup
-            serv_->free_large_data(new_data);
+    bool compress_queue::finish_compress(const bool compressed) {
+        const bool drained = (--outstanding_count_ == 0);
 
-            if (bmp->support_dirty_bitmap) {
-                serv_->free_bitmap(clean_bitmap);
-            }
+        // Same lock order as the server thread: kernel first, then the notify list
+        const std::lock_guard<kernel_system> kern_guard(*kern_);
+        const std::lock_guard<std::mutex> guard(notify_mutex_);
 
-            return;
+        if (compressed) {
+            compressed_since_notify_++;
         }
 
-        clean_bitmap->bitmap_->data_offset_ = static_cast<int>(new_data - data_base);
-        clean_bitmap->bitmap_->header_.bitmap_size = static_cast<std::uint32_t>(estimated_size + sizeof(loader::sbm_header));
+        if ((compressed_since_notify_ == 0) || (!drained && (compressed_since_notify_ < NOTIFY_BATCH_SIZE))) {
+            return drained;
+        }
 
         // Notify dirty bitmaps
-        {
-            const std::lock_guard<std::mutex> guard(notify_mutex_);
-            for (auto notify : notifies_) {
-                notify.complete(0);
-            }
-
-            notifies_.clear();
+        for (auto &notify : notifies_) {
+            notify.complete(0);
         }
 
-        // Notify bitmap compression done. Now the thread can run.
-        bmp->compress_done_nof.complete(epoc::error_none);
-        bmp->clean_bitmap = clean_bitmap;
-
-        // Mark old bitmap as dirty
-        bmp->bitmap_->settings_.dirty_bitmap(true);
+        notifies_.clear();
+        compressed_since_notify_ = 0;
 
-        LOG_TRACE("Bitmap ID {} compressed with ratio {}%, clean bitmap ID {}", bmp->id, static_cast<int>(static_cast<double>(estimated_size) / static_cast<double>(org_size) * 100.0), clean_bitmap->id);
+        return drained;
     }
 
     void compress_queue::run() {
+        std::vector<std::uint8_t> scratch;
+
         while (auto bmp = queue_.pop()) {
-            actual_compress(bmp.value());
+            fbsbitmap *target = bmp.value();
+            bool taken = false;
+
+            {
+                // The same bitmap may be queued twice. Let the worker already on it finish the job.
+                const std::lock_guard<std::mutex> guard(bitmap_mutex_);
+                taken = (std::find(in_progress_.begin(), in_progress_.end(), target) != in_progress_.end());
+
+                if (!taken) {
+                    in_progress_.push_back(target);
+                }
+            }
+
+            bool compressed = false;
+
+            if (!taken) {
+                compressed = actual_compress(target, scratch);
+
+                const std::lock_guard<std::mutex> guard(bitmap_mutex_);
+                in_progress_.erase(std::find(in_progress_.begin(), in_progress_.end(), target));
+            }
+
+            if (finish_compress(compressed) || (scratch.capacity() > MAX_KEPT_SCRATCH_SIZE)) {
+                // Don't hold on to the biggest bitmap's worth of memory while idle
+                std::vector<std::uint8_t>().swap(scratch);
+            }
         }
     }
 
@@ -231,4 +254,4 @@ namespace eka2l1 {
         nof.complete(epoc::error_cancel);
         return true;
     }
-}
\ No newline at end of file
+}
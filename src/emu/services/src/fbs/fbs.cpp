@@ -41,6 +41,9 @@
 
 #include <config/config.h>
 
+#include <algorithm>
+#include <thread>
+
 namespace eka2l1 {
     namespace epoc {
         bool does_client_use_pointer_instead_of_offset(fbscli *cli) {
@@ -239,11 +242,6 @@ namespace eka2l1 {
         , bmp_font_vtab(0) {
     }
 
-    static void compressor_thread_func(compress_queue *queue) {
-        common::set_thread_name("FBS Server compressor thread");
-        queue->run();
-    }
-
     int fbs_server::legacy_level() const {
         if (kern->is_eka1()) {
             return 2;
@@ -352,10 +350,16 @@ namespace eka2l1 {
         large_chunk_allocator->allocate(4);
         shared_chunk_allocator->allocate(4);
 
-        // Create compressor thread
+        // Create compressor workers. Leave half of the host cores to the CPU and graphics threads.
         if (sys->get_config()->fbs_enable_compression_queue) {
+            const std::size_t worker_count = std::max<std::size_t>(std::thread::hardware_concurrency() / 2, 1);
+
             compressor = std::make_unique<compress_queue>(this);
-            compressor_thread = std::make_unique<std::thread>(compressor_thread_func, compressor.get());
+            compressor_workers = std::make_unique<common::thread_pool>(worker_count, "FBS Server compressor thread");
+
+            for (std::size_t i = 0; i < worker_count; i++) {
+                compressor_workers->enqueue([this]() { compressor->run(); });
+            }
         }
     }
 
@@ -412,11 +416,14 @@ namespace eka2l1 {
     fbs_server::~fbs_server() {
         if (compressor) {
             compressor->abort();
-            compressor_thread->join();
+            compressor_workers.reset();
         }
 
         clear_all_sessions();
 
+        // Bitmaps still alive are destroyed after this map, don't let them look it up
+        shared_bitmaps.clear();
+
         // Destroy chunks.
         if (shared_chunk)
             kern->destroy(shared_chunk);
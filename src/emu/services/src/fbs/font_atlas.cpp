@@ -21,22 +21,178 @@
 #include <common/algorithm.h>
 #include <common/time.h>
 
+#include <algorithm>
+#include <cstring>
+
 namespace eka2l1::epoc {
+    // A shelf taller than this many times the glyph height wastes too much space to hold it.
+    static constexpr float MAX_SHELF_HEIGHT_WASTE_RATIO = 1.5f;
+
+    static void reset_lru(common::roundabout &lru) {
+        // The glyphs owning the links are gone, only the list head needs to point back to itself
+        lru.elem_.next = &lru.elem_;
+        lru.elem_.previous = &lru.elem_;
+    }
+
+    font_atlas_packer::font_atlas_packer(const eka2l1::vec2 &size) {
+        reset(size);
+    }
+
+    void font_atlas_packer::reset(const eka2l1::vec2 &size) {
+        size_ = size;
+        shelves_.clear();
+        next_shelf_y_ = 0;
+    }
+
+    std::optional<int> font_atlas_packer::allocate_in_shelf(shelf &target, const int width) {
+        for (std::size_t i = 0; i < target.free_spans_.size(); i++) {
+            span &free_span = target.free_spans_[i];
+
+            if (free_span.width_ >= width) {
+                const int x = free_span.x_;
+                free_span.x_ += width;
+                free_span.width_ -= width;
+
+                if (free_span.width_ == 0) {
+                    target.free_spans_.erase(target.free_spans_.begin() + i);
+                }
+
+                target.used_count_++;
+                return x;
+            }
+        }
+
+        if (target.cursor_ + width <= size_.x) {
+            const int x = target.cursor_;
+            target.cursor_ += width;
+            target.used_count_++;
+
+            return x;
+        }
+
+        return std::nullopt;
+    }
+
+    std::optional<eka2l1::rect> font_atlas_packer::allocate(const eka2l1::vec2 &size) {
+        if ((size.x <= 0) || (size.y <= 0) || (size.x > size_.x) || (size.y > size_.y)) {
+            return std::nullopt;
+        }
+
+        const int max_shelf_height = static_cast<int>(size.y * MAX_SHELF_HEIGHT_WASTE_RATIO);
+
+        // Best fit by height. Empty shelves take anything that is not taller than them.
+        shelf *best = nullptr;
+
+        for (shelf &candidate : shelves_) {
+            if ((candidate.height_ < size.y) || ((candidate.used_count_ != 0) && (candidate.height_ > max_shelf_height))) {
+                continue;
+            }
+
+            if (best && (best->height_ <= candidate.height_)) {
+                continue;
+            }
+
+            if ((candidate.cursor_ + size.x > size_.x) && std::none_of(candidate.free_spans_.begin(), candidate.free_spans_.end(),
+                    [&](const span &s) { return s.width_ >= size.x; })) {
+                continue;
+            }
+
+            best = &candidate;
+        }
+
+        if (best) {
+            const std::optional<int> x = allocate_in_shelf(*best, size.x);
+            return eka2l1::rect({ x.value(), best->y_ }, size);
+        }
+
+        if (next_shelf_y_ + size.y > size_.y) {
+            return std::nullopt;
+        }
+
+        shelf new_shelf;
+        new_shelf.y_ = next_shelf_y_;
+        new_shelf.height_ = size.y;
+        new_shelf.cursor_ = size.x;
+        new_shelf.used_count_ = 1;
+
+        shelves_.push_back(new_shelf);
+        next_shelf_y_ += size.y;
+
+        return eka2l1::rect({ 0, new_shelf.y_ }, size);
+    }
+
+    void font_atlas_packer::free(const eka2l1::rect &area) {
+        auto shelf_ite = std::lower_bound(shelves_.begin(), shelves_.end(), area.top.y,
+            [](const shelf &lhs, const int y) { return lhs.y_ < y; });
+
+        if ((shelf_ite == shelves_.end()) || (shelf_ite->y_ != area.top.y)) {
+            return;
+        }
+
+        shelf &target = *shelf_ite;
+
+        if (--target.used_count_ == 0) {
+            target.cursor_ = 0;
+            target.free_spans_.clear();
+
+            // The last shelf can be given back so a shelf of another height can grow there
+            if (&target == &shelves_.back()) {
+                next_shelf_y_ = target.y_;
+                shelves_.pop_back();
+            }
+
+            return;
+        }
+
+        auto span_ite = std::lower_bound(target.free_spans_.begin(), target.free_spans_.end(), area.top.x,
+            [](const span &lhs, const int x) { return lhs.x_ < x; });
+
+        span_ite = target.free_spans_.insert(span_ite, span{ area.top.x, area.size.x });
+
+        // Merge with the next span, then with the previous one
+        auto next_ite = span_ite + 1;
+
+        if ((next_ite != target.free_spans_.end()) && (span_ite->x_ + span_ite->width_ == next_ite->x_)) {
+            span_ite->width_ += next_ite->width_;
+            target.free_spans_.erase(next_ite);
+        }
+
+        if (span_ite != target.free_spans_.begin()) {
+            auto prev_ite = span_ite - 1;
+
+            if (prev_ite->x_ + prev_ite->width_ == span_ite->x_) {
+                prev_ite->width_ += span_ite->width_;
+                span_ite = target.free_spans_.erase(span_ite) - 1;
+            }
+        }
+
+        // Space right before the cursor goes back to the cursor
+        if (span_ite->x_ + span_ite->width_ == target.cursor_) {
+            target.cursor_ = span_ite->x_;
+            target.free_spans_.erase(span_ite);
+        }
+    }
+
     font_atlas::font_atlas()
-        : atlas_handle_(0)
+        : draw_serial_(0)
+        , atlas_handle_(0)
+        , adapter_(nullptr)
+        , size_(0)
+        , initial_range_loaded_(false)
         , atlas_data_(nullptr)
-        , pack_handle_(0) {
+        , typeface_idx_(0) {
     }
 
     font_atlas::font_atlas(adapter::font_file_adapter_base *adapter, const std::size_t typeface_idx, const char16_t initial_start,
         const char16_t initial_char_count, int font_size)
-        : atlas_handle_(0)
+        : draw_serial_(0)
+        , atlas_handle_(0)
         , adapter_(adapter)
         , size_(font_size)
         , initial_range_(initial_start, initial_char_count)
-        , typeface_idx_(typeface_idx)
+        , initial_range_loaded_(false)
         , atlas_data_(nullptr)
-        , pack_handle_(0) {
+        , typeface_idx_(typeface_idx) {
     }
 
     void font_atlas::init(adapter::font_file_adapter_base *adapter, const std::size_t typeface_idx, const char16_t initial_start,
@@ -45,9 +201,12 @@ namespace eka2l1::epoc {
         atlas_handle_ = 0;
         size_ = font_size;
         initial_range_ = { initial_start, initial_char_count };
+        initial_range_loaded_ = false;
         typeface_idx_ = typeface_idx;
-        pack_handle_ = 0;
 
+        glyphs_.clear();
+        reset_lru(lru_);
+        dirty_shelves_.clear();
         atlas_data_.reset();
     }
 
@@ -60,92 +219,227 @@ namespace eka2l1::epoc {
             driver->submit_command_list(*cmd_list);
 
             atlas_handle_ = 0;
-            atlas_data_.reset();
         }
 
-        if (pack_handle_) {
-            adapter_->end_get_atlas(pack_handle_);
-        }
+        glyphs_.clear();
+        reset_lru(lru_);
+        dirty_shelves_.clear();
+        raster_scratch_.clear();
+        atlas_data_.reset();
+
+        initial_range_loaded_ = false;
     }
 
     int font_atlas::get_atlas_width() const {
         return common::align(ESTIMATE_MAX_CHAR_IN_ATLAS_WIDTH * size_, 1024);
     }
 
-    bool font_atlas::draw_text(const std::u16string &text, const eka2l1::rect &text_box, const epoc::text_alignment alignment, drivers::graphics_driver *driver, drivers::graphics_command_list_builder *builder) {
-        const int width = get_atlas_width();
+    font_atlas_glyph *font_atlas::get_glyph(const char16_t code) {
+        auto glyph_ite = glyphs_.find(code);
+        return (glyph_ite == glyphs_.end()) ? nullptr : &glyph_ite->second;
+    }
 
-        if (!atlas_data_) {
-            atlas_data_ = std::make_unique<std::uint8_t[]>(width * width);
-            auto cinfos = std::make_unique<adapter::character_info[]>(initial_range_.second);
+    void font_atlas::touch_glyph(font_atlas_glyph &glyph) {
+        glyph.last_draw_ = draw_serial_;
 
-            pack_handle_ = adapter_->begin_get_atlas(atlas_data_.get(), { width, width });
-            
-            if (pack_handle_ == -1) {
-                return false;
-            }
+        glyph.lru_link_.deque();
+        lru_.push(&glyph.lru_link_);
+    }
 
-            if (!adapter_->get_glyph_atlas(pack_handle_, typeface_idx_, initial_range_.first, nullptr, initial_range_.second,
-                    size_, cinfos.get())) {
-                return false;
-            }
+    bool font_atlas::evict_least_used() {
+        common::double_linked_queue_element *least_used = lru_.first();
 
-            // initialize the last used list and character map
-            for (char16_t i = 0; i < initial_range_.second; i++) {
-                last_use_.push_back(initial_range_.first + i);
-                characters_.emplace(initial_range_.first + i, cinfos[i]);
+        if (!least_used) {
+            return false;
+        }
+
+        font_atlas_glyph *glyph = E_LOFF(least_used, font_atlas_glyph, lru_link_);
+
+        if (glyph->last_draw_ == draw_serial_) {
+            // Everything left is needed by the text being drawn
+            return false;
+        }
+
+        if (!glyph->slot_.empty()) {
+            packer_.free(glyph->slot_);
+        }
+
+        glyph->lru_link_.deque();
+        glyphs_.erase(glyph->code_);
+
+        return true;
+    }
+
+    std::optional<eka2l1::rect> font_atlas::allocate_slot(const eka2l1::vec2 &size) {
+        while (true) {
+            std::optional<eka2l1::rect> slot = packer_.allocate(size);
+
+            if (slot || !evict_least_used()) {
+                return slot;
             }
+        }
+    }
 
-            atlas_handle_ = drivers::create_bitmap(driver, { width, width });
-            builder->update_bitmap(atlas_handle_, 8, reinterpret_cast<const char *>(atlas_data_.get()),
-                width * width, { 0, 0 }, { width, width });
+    void font_atlas::rasterize_glyphs(const int *codes, const std::size_t count) {
+        if (count == 0) {
+            return;
         }
 
-        std::vector<int> to_rast;
-        std::vector<char16_t> unique_char;
+        const int width = get_atlas_width();
 
-        // Iterate through characters, and filter out characters which is not available in the atlas.
-        // Add character to last used, too.
-        for (auto &chr : text) {
-            if (characters_.find(chr) == characters_.end()) {
-                if (!std::binary_search(to_rast.begin(), to_rast.end(), chr)) {
-                    to_rast.push_back(chr);
-                    std::sort(to_rast.begin(), to_rast.end());
-                }
+        // Glyphs are oversampled twice by the adapters. Guess the scratch height from that, and grow if it is not enough.
+        const int cell_size = size_ * 2 + 4;
+        const int cells_per_row = common::max(width / cell_size, 1);
+        int scratch_height = common::min(width, static_cast<int>((count + cells_per_row - 1) / cells_per_row + 1) * cell_size);
+
+        auto cinfos = std::make_unique<adapter::character_info[]>(count);
+        bool packed = false;
+
+        while (!packed) {
+            raster_scratch_.assign(static_cast<std::size_t>(width) * scratch_height, 0);
+
+            const std::int32_t pack_handle = adapter_->begin_get_atlas(raster_scratch_.data(), { width, scratch_height });
+
+            if (pack_handle == -1) {
+                return;
             }
 
-            if (std::find(unique_char.begin(), unique_char.end(), chr) == unique_char.end()) {
-                last_use_.insert(last_use_.begin(), chr);
-                unique_char.push_back(chr);
+            packed = adapter_->get_glyph_atlas(pack_handle, typeface_idx_, 0, const_cast<int *>(codes), static_cast<char16_t>(count),
+                size_, cinfos.get());
+
+            adapter_->end_get_atlas(pack_handle);
+
+            if (!packed) {
+                if (scratch_height < width) {
+                    scratch_height = common::min(width, scratch_height * 2);
+                    continue;
+                }
+
+                if (count > 1) {
+                    // Too many for one go, split the batch
+                    const std::size_t half = count / 2;
+
+                    rasterize_glyphs(codes, half);
+                    rasterize_glyphs(codes + half, count - half);
+                }
+
+                return;
             }
         }
 
-        last_use_.erase(last_use_.end() - unique_char.size(), last_use_.end());
+        for (std::size_t i = 0; i < count; i++) {
+            adapter::character_info info = cinfos[i];
+
+            const int glyph_width = info.x1 - info.x0;
+            const int glyph_height = info.y1 - info.y0;
 
-        if (!to_rast.empty()) {
-            // Try to rasterize these
-            auto cinfos = std::make_unique<adapter::character_info[]>(to_rast.size());
+            eka2l1::rect slot;
 
-            if (!adapter_->get_glyph_atlas(pack_handle_, typeface_idx_, 0, to_rast.data(), static_cast<char16_t>(to_rast.size()), size_,
-                    cinfos.get())) {
-                // Try to redo the atlas, getting latest use characters.
-                adapter_->end_get_atlas(pack_handle_);
-                pack_handle_ = adapter_->begin_get_atlas(atlas_data_.get(), { width, width });
+            if ((glyph_width != 0) && (glyph_height != 0)) {
+                // Pad one pixel right and bottom, so filtering does not bleed the neighbours in
+                std::optional<eka2l1::rect> allocated = allocate_slot({ glyph_width + 1, glyph_height + 1 });
 
-                if (pack_handle_ == -1) {
-                    return false;
+                if (!allocated) {
+                    // The text uses more glyphs than the atlas can hold. Drop this one.
+                    continue;
                 }
 
-                if (!adapter_->get_glyph_atlas(pack_handle_, typeface_idx_, 0, &last_use_[0], static_cast<char16_t>(characters_.size() - 5),
-                        size_, cinfos.get())) {
-                    return false;
+                slot = allocated.value();
+
+                for (int y = 0; y < glyph_height; y++) {
+                    std::uint8_t *dest = atlas_data_.get() + (slot.top.y + y) * width + slot.top.x;
+                    std::memcpy(dest, raster_scratch_.data() + (info.y0 + y) * width + info.x0, glyph_width);
+                    dest[glyph_width] = 0;
                 }
 
-                for (std::size_t i = 0; i < characters_.size() - 5; i++) {
-                    characters_[last_use_[i]] = cinfos[i];
+                std::memset(atlas_data_.get() + (slot.top.y + glyph_height) * width + slot.top.x, 0, glyph_width + 1);
+
+                info.x0 = static_cast<std::uint16_t>(slot.top.x);
+                info.y0 = static_cast<std::uint16_t>(slot.top.y);
+                info.x1 = static_cast<std::uint16_t>(slot.top.x + glyph_width);
+                info.y1 = static_cast<std::uint16_t>(slot.top.y + glyph_height);
+
+                auto dirty_ite = dirty_shelves_.find(slot.top.y);
+
+                if (dirty_ite == dirty_shelves_.end()) {
+                    dirty_shelves_.emplace(slot.top.y, slot);
+                } else {
+                    dirty_ite->second.merge(slot);
                 }
             }
+
+            const char16_t code = static_cast<char16_t>(codes[i]);
+            font_atlas_glyph &glyph = glyphs_[code];
+
+            glyph.code_ = code;
+            glyph.info_ = info;
+            glyph.slot_ = slot;
+
+            touch_glyph(glyph);
         }
+    }
+
+    void font_atlas::flush_dirty(drivers::graphics_command_list_builder *builder) {
+        const int width = get_atlas_width();
+
+        for (auto &[shelf_y, dirty] : dirty_shelves_) {
+            const std::size_t offset = static_cast<std::size_t>(dirty.top.y) * width + dirty.top.x;
+            const std::size_t size = static_cast<std::size_t>(dirty.size.y - 1) * width + dirty.size.x;
+
+            builder->update_bitmap(atlas_handle_, 8, reinterpret_cast<const char *>(atlas_data_.get() + offset), size,
+                dirty.top, dirty.size, width);
+        }
+
+        dirty_shelves_.clear();
+    }
+
+    bool font_atlas::draw_text(const std::u16string &text, const eka2l1::rect &text_box, const epoc::text_alignment alignment, drivers::graphics_driver *driver, drivers::graphics_command_list_builder *builder) {
+        const int width = get_atlas_width();
+
+        if (!atlas_data_) {
+            atlas_data_ = std::make_unique<std::uint8_t[]>(width * width);
+            std::fill(atlas_data_.get(), atlas_data_.get() + width * width, 0);
+
+            packer_.reset({ width, width });
+
+            if (!atlas_handle_) {
+                atlas_handle_ = drivers::create_bitmap(driver, { width, width });
+            }
+
+            builder->update_bitmap(atlas_handle_, 8, reinterpret_cast<const char *>(atlas_data_.get()),
+                width * width, { 0, 0 }, { width, width });
+        }
+
+        draw_serial_++;
+
+        std::vector<int> to_rast;
+
+        if (!initial_range_loaded_) {
+            for (char16_t i = 0; i < initial_range_.second; i++) {
+                to_rast.push_back(initial_range_.first + i);
+            }
+
+            initial_range_loaded_ = true;
+        }
+
+        // Mark the glyphs in use, and gather the ones that are not in the atlas yet
+        for (auto &chr : text) {
+            font_atlas_glyph *glyph = get_glyph(chr);
+
+            if (glyph) {
+                if (glyph->last_draw_ != draw_serial_) {
+                    touch_glyph(*glyph);
+                }
+            } else {
+                to_rast.push_back(chr);
+            }
+        }
+
+        std::sort(to_rast.begin(), to_rast.end());
+        to_rast.erase(std::unique(to_rast.begin(), to_rast.end()), to_rast.end());
+
+        rasterize_glyphs(to_rast.data(), to_rast.size());
+        flush_dirty(builder);
 
         eka2l1::vec2 cur_pos = text_box.top;
 
@@ -155,7 +449,9 @@ namespace eka2l1::epoc {
             float size_length = 0;
 
             for (auto &chr : text) {
-                size_length += characters_[chr].xoff2 - characters_[chr].xoff;
+                if (font_atlas_glyph *glyph = get_glyph(chr)) {
+                    size_length += glyph->info_.xoff2 - glyph->info_.xoff;
+                }
             }
 
             if (alignment == epoc::text_alignment::right) {
@@ -172,8 +468,14 @@ namespace eka2l1::epoc {
 
         // Start to render these texts.
         for (auto &chr : text) {
+            font_atlas_glyph *glyph = get_glyph(chr);
+
+            if (!glyph) {
+                continue;
+            }
+
+            const adapter::character_info &info = glyph->info_;
             eka2l1::rect source_rect;
-            adapter::character_info &info = characters_[chr];
 
             source_rect.top = { info.x0, info.y0 };
             source_rect.size = eka2l1::object_size(info.x1 - info.x0, info.y1 - info.y0);
@@ -196,4 +498,4 @@ namespace eka2l1::epoc {
 
         return true;
     }
-}
\ No newline at end of file
+}
@@ -55,55 +55,6 @@ namespace eka2l1 {
         return epoc::color_bitmap;
     }
 
-    static int get_byte_width(const std::uint32_t pixels_width, const std::uint8_t bits_per_pixel) {
-        int word_width = 0;
-
-        switch (bits_per_pixel) {
-        case 1: {
-            word_width = (pixels_width + 31) / 32;
-            break;
-        }
-
-        case 2: {
-            word_width = (pixels_width + 15) / 16;
-            break;
-        }
-
-        case 4: {
-            word_width = (pixels_width + 7) / 8;
-            break;
-        }
-
-        case 8: {
-            word_width = (pixels_width + 3) / 4;
-            break;
-        }
-
-        case 12:
-        case 16: {
-            word_width = (pixels_width + 1) / 2;
-            break;
-        }
-
-        case 24: {
-            word_width = (((pixels_width * 3) + 11) / 12) * 3;
-            break;
-        }
-
-        case 32: {
-            word_width = pixels_width;
-            break;
-        }
-
-        default: {
-            assert(false);
-            break;
-        }
-        }
-
-        return word_width * 4;
-    }
-
     fbs_bitmap_data_info::fbs_bitmap_data_info()
         : dpm_(epoc::display_mode::none)
         , comp_(epoc::bitmap_file_compression::bitmap_file_no_compression)
@@ -199,7 +150,7 @@ namespace eka2l1 {
             if (support_current_display_mode_flag)
                 settings_.current_display_mode(disp_mode);
 
-            byte_width_ = get_byte_width(info.size_pixels.width(), static_cast<std::uint8_t>(info.bit_per_pixels));
+            byte_width_ = epoc::get_byte_width(info.size_pixels.width(), static_cast<std::uint8_t>(info.bit_per_pixels));
 
             if (white_fill && (data_offset_ != 0)) {
                 do_white_fill(reinterpret_cast<std::uint8_t *>(data), info.bitmap_size - sizeof(loader::sbm_header), settings_.current_display_mode());
@@ -280,8 +231,78 @@ namespace eka2l1 {
     };
 
     fbsbitmap::~fbsbitmap() {
-        if (serv_)
+        if (share_map_) {
+            share_map_->remove(this);
+        }
+
+        if (serv_) {
             serv_->free_bitmap(this);
+        }
+    }
+
+    fbsbitmap_cache_info make_bitmap_cache_info(file *source, const int bitmap_idx) {
+        fbsbitmap_cache_info info;
+        info.bitmap_idx = bitmap_idx;
+        info.rom_data = source->get_mapped_data();
+
+        if (!info.rom_data) {
+            info.path = common::lowercase_ucs2_string(source->file_name());
+            info.size = source->size();
+            info.last_write = source->last_modify_since_1ad();
+        }
+
+        return info;
+    }
+
+    fbsbitmap_share_map::~fbsbitmap_share_map() {
+        clear();
+    }
+
+    fbsbitmap *fbsbitmap_share_map::find(const fbsbitmap_cache_info &info) {
+        auto shared_bitmap_ite = bitmaps_.find(info);
+
+        if (shared_bitmap_ite == bitmaps_.end()) {
+            return nullptr;
+        }
+
+        fbsbitmap *bmp = shared_bitmap_ite->second;
+        const epoc::bitwise_bitmap::settings &settings = bmp->bitmap_->settings_;
+
+        if (!bmp->clean_bitmap && (settings.current_display_mode() == settings.initial_display_mode())) {
+            return bmp;
+        }
+
+        // The content has drifted from the file. Holders keep it, new loads get a fresh copy
+        bmp->share_map_ = nullptr;
+        bitmaps_.erase(shared_bitmap_ite);
+
+        return nullptr;
+    }
+
+    void fbsbitmap_share_map::add(const fbsbitmap_cache_info &info, fbsbitmap *bmp) {
+        auto result = bitmaps_.emplace(info, bmp);
+
+        if (result.second) {
+            bmp->cache_info_ = info;
+            bmp->share_map_ = this;
+        }
+    }
+
+    void fbsbitmap_share_map::remove(fbsbitmap *bmp) {
+        if (bmp->share_map_ != this) {
+            return;
+        }
+
+        bitmaps_.erase(bmp->cache_info_);
+        bmp->share_map_ = nullptr;
+    }
+
+    void fbsbitmap_share_map::clear() {
+        for (auto &[info, bmp] : bitmaps_) {
+            bmp->share_map_ = nullptr;
+        }
+
+        bitmaps_.clear();
     }
 
     std::optional<std::size_t> fbs_server::load_data_to_rom(loader::mbm_file &mbmf_, const std::size_t idx_, int *err_code) {
@@ -418,14 +439,12 @@ namespace eka2l1 {
         // Check if it's shared first
         if (load_options->share) {
             // Shared bitmaps are stored on server's map, because it's means to be accessed by
-            // other fbs clients. Let's lookup our bitmap on there
-            cache_info_.bitmap_idx = load_options->bitmap_id;
-            cache_info_.path = source->file_name();
-
-            auto shared_bitmap_ite = fbss->shared_bitmaps.find(cache_info_);
+            // other fbs clients. Let's lookup our bitmap on there. A hit only costs a new handle,
+            // the same as duplicating the bitmap.
+            cache_info_ = make_bitmap_cache_info(source, load_options->bitmap_id);
+            bmp = fbss->shared_bitmaps.find(cache_info_);
 
-            if (shared_bitmap_ite != fbss->shared_bitmaps.end()) {
-                bmp = shared_bitmap_ite->second;
+            if (bmp) {
                 already_cache = true;
             }
         }
@@ -493,7 +512,7 @@ namespace eka2l1 {
 
             bws_bmp->data_offset_ = static_cast<std::uint32_t>(bmp_data_offset.value());
             bws_bmp->compressed_in_ram_ = false;
-            bws_bmp->byte_width_ = get_byte_width(bws_bmp->header_.size_pixels.x, bws_bmp->header_.bit_per_pixels);
+            bws_bmp->byte_width_ = epoc::get_byte_width(bws_bmp->header_.size_pixels.x, bws_bmp->header_.bit_per_pixels);
             bws_bmp->uid_ = epoc::bitwise_bitmap_uid;
 
             // Get display mode
@@ -505,8 +524,7 @@ namespace eka2l1 {
         }
 
         if (load_options->share && !already_cache) {
-            fbss->shared_bitmaps.emplace(cache_info_, bmp);
-            bmp->ref();
+            fbss->shared_bitmaps.add(cache_info_, bmp);
         }
 
         // Now writes the bitmap info in
@@ -526,7 +544,7 @@ namespace eka2l1 {
             return 0;
         }
 
-        return get_byte_width(size.x, epoc::get_bpp_from_display_mode(bpp)) * size.y;
+        return epoc::get_byte_width(size.x, epoc::get_bpp_from_display_mode(bpp)) * size.y;
     }
 
     fbsbitmap *fbs_server::create_bitmap(fbs_bitmap_data_info &info, const bool alloc_data, const bool support_current_display_mode_flag, const bool support_dirty) {
@@ -819,7 +837,7 @@ namespace eka2l1 {
             file.write(reinterpret_cast<const char *>(&dib_header), dib_header.header_size);
 
             if (need_process) {
-                const std::uint32_t byte_width = get_byte_width(bitmap->header_.size_pixels.x,
+                const std::uint32_t byte_width = epoc::get_byte_width(bitmap->header_.size_pixels.x,
                     bitmap->header_.bit_per_pixels);
 
                 const std::uint8_t *packed_data = reinterpret_cast<const std::uint8_t *>(bitmap->data_offset_ + base);
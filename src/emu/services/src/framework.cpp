@@ -18,6 +18,7 @@
  */
 
 #include <common/log.h>
+#include <common/profile.h>
 #include <epoc/epoc.h>
 
 #include <services/framework.h>
@@ -73,6 +74,8 @@ namespace eka2l1::service {
             return;
         }
 
+        EKA2L1_PROFILE_SCOPE_DYNAMIC("ipc", obj_name);
+
         ipc_context context;
         context.sys = sys;
         context.msg = process_msg;
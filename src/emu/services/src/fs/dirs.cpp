@@ -33,6 +33,22 @@
 #include <utils/err.h>
 
 namespace eka2l1 {
+    static constexpr std::size_t DIR_READ_BATCH_COUNT = 64;
+
+    // Get the next entry to give to the client. Entries are read from the directory in batches.
+    static entry_info *peek_dir_entry(fs_node *node, directory *dir) {
+        if (node->pending_entry_index >= node->pending_entries.size()) {
+            node->pending_entries.clear();
+            node->pending_entry_index = 0;
+
+            if (dir->read_entries(node->pending_entries, DIR_READ_BATCH_COUNT) == 0) {
+                return nullptr;
+            }
+        }
+
+        return &node->pending_entries[node->pending_entry_index];
+    }
+
     void fs_server_client::open_dir(service::ipc_context *ctx) {
         auto dir = ctx->get_argument_value<std::u16string>(0);
 
@@ -130,13 +146,15 @@ namespace eka2l1 {
         epoc::fs::entry entry;
         entry.attrib = 0;
 
-        std::optional<entry_info> info = dir->get_next_entry();
+        entry_info *info = peek_dir_entry(dir_node, dir);
 
         if (!info) {
             ctx->complete(epoc::error_eof);
             return;
         }
 
+        dir_node->pending_entry_index++;
+
         if (info->has_raw_attribute) {
             entry.attrib |= info->raw_attribute;
         } else {
@@ -204,7 +222,7 @@ namespace eka2l1 {
             epoc::fs::entry entry;
             entry.attrib = 0;
 
-            std::optional<entry_info> info = dir->peek_next_entry();
+            entry_info *info = peek_dir_entry(dir_node, dir);
 
             if (!info) {
                 entry_arr->set_length(own_pr, static_cast<std::uint32_t>(entry_buf - entry_buf_org));
@@ -259,7 +277,7 @@ namespace eka2l1 {
             }
 
             queried_entries += 1;
-            dir->get_next_entry();
+            dir_node->pending_entry_index++;
         }
 
         entry_arr->set_length(own_pr, static_cast<std::uint32_t>(entry_buf - entry_buf_org));
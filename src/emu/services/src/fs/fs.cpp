@@ -28,7 +28,6 @@
 #include <clocale>
 #include <cwctype>
 #include <memory>
-#include <regex>
 
 #include <common/algorithm.h>
 #include <common/cvt.h>
@@ -434,9 +433,8 @@ namespace eka2l1 {
             return;
         }
 
-        std::regex pattern("[<>:\"/|*?]+");
-        std::string path_utf8 = common::ucs2_to_utf8(path.value());
-        std::uint32_t valid = !(std::regex_match(path_utf8, pattern) || path->empty());
+        // Invalid when the name is made of nothing but reserved characters
+        std::uint32_t valid = (path->find_first_not_of(u"<>:\"/|*?") != std::u16string::npos);
 
         ctx->write_data_to_descriptor_argument<std::uint32_t>(1, valid);
         ctx->complete(epoc::error_none);
@@ -445,7 +443,7 @@ namespace eka2l1 {
     void fs_server_client::notify_change(service::ipc_context *ctx) {
         notify_entry entry;
 
-        entry.match_pattern = ".*";
+        entry.match_pattern = u"*";
         entry.type = static_cast<notify_type>(*ctx->get_argument_value<std::int32_t>(0));
         entry.info = epoc::notify_info(ctx->msg->request_sts, ctx->msg->own_thr);
 
@@ -461,7 +459,7 @@ namespace eka2l1 {
         }
 
         notify_entry entry;
-        entry.match_pattern = common::wildcard_to_regex_string(common::ucs2_to_utf8(*wildcard_match));
+        entry.match_pattern = *wildcard_match;
         entry.type = static_cast<notify_type>(*ctx->get_argument_value<std::int32_t>(0));
         entry.info = epoc::notify_info(ctx->msg->request_sts, ctx->msg->own_thr);
 
@@ -338,7 +338,8 @@ namespace eka2l1::epoc::msv {
         }
 
         ro_file_stream nearest_default_entries_file_stream(nearest_default_entries_file_io.get());
-        loader::rsc_file nearest_default_entries_loader(reinterpret_cast<common::ro_stream *>(&nearest_default_entries_file_stream));
+        loader::rsc_file nearest_default_entries_loader(reinterpret_cast<common::ro_stream *>(&nearest_default_entries_file_stream),
+            nearest_default_entries_file, nearest_default_entries_file_io->last_modify_since_1ad());
 
         auto entries_info_buf = nearest_default_entries_loader.read(1);
 
@@ -45,7 +45,8 @@ namespace eka2l1::epoc::msv {
         }
 
         eka2l1::ro_file_stream rsc_file_stream(rsc_file.get());
-        loader::rsc_file rsc_file_loader(reinterpret_cast<common::ro_stream *>(&rsc_file_stream));
+        loader::rsc_file rsc_file_loader(reinterpret_cast<common::ro_stream *>(&rsc_file_stream), path,
+            rsc_file->last_modify_since_1ad());
 
         std::vector<std::uint8_t> info = rsc_file_loader.read(1); // Info
         common::chunkyseri info_reader(info.data(), info.size(), common::SERI_MODE_READ);
@@ -54,11 +54,13 @@ namespace eka2l1 {
 
         // Try to read resource file contains priority
         std::u16string priority_filename = u"resource\\apps\\PrioritySet.rsc";
+        std::u16string priority_path;
         symfile f = nullptr;
 
         for (drive_number drive = drive_z; drive >= drive_a; drive = static_cast<drive_number>(static_cast<int>(drive) - 1)) {
             if (io->get_drive_entry(drive)) {
-                f = io->open_file(std::u16string(drive_to_char16(drive), 1) + priority_filename, READ_MODE | BIN_MODE);
+                priority_path = std::u16string(1, drive_to_char16(drive)) + u":\\" + priority_filename;
+                f = io->open_file(priority_path, READ_MODE | BIN_MODE);
 
                 if (f) {
                     break;
@@ -72,10 +74,14 @@ namespace eka2l1 {
         }
 
         eka2l1::ro_file_stream fstream(f.get());
-        loader::rsc_file rsc_priority(reinterpret_cast<common::ro_stream *>(&fstream));
+        loader::rsc_file rsc_priority(reinterpret_cast<common::ro_stream *>(&fstream), priority_path,
+            f->last_modify_since_1ad());
 
         auto priority_view_value_raw = rsc_priority.read(2);
-        priority_ = *reinterpret_cast<const std::uint32_t *>(priority_view_value_raw.data());
+
+        if (priority_view_value_raw.size() >= sizeof(std::uint32_t)) {
+            priority_ = *reinterpret_cast<const std::uint32_t *>(priority_view_value_raw.data());
+        }
 
         flags_ |= flag_inited;
 
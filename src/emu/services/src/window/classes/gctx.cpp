@@ -297,6 +297,7 @@ namespace eka2l1::epoc {
             flush_queue_to_driver();
 
             // Content of the window changed, so call the handler
+            attached_window->damage_screen(attached_window->bounding_rect());
             attached_window->take_action_on_change();
         }
 
@@ -32,6 +32,10 @@ namespace eka2l1::epoc {
         client->queue_event(evt);
     }
 
+    void window::queue_input_event(const epoc::event &evt) {
+        client->queue_input_event(evt);
+    }
+
     void window::set_parent(window *new_parent) {
         // New one will be the oldest. Quirky, but how WSERV functions.
         parent = new_parent;
@@ -37,7 +37,7 @@
 namespace eka2l1::epoc {
     static constexpr std::uint8_t bits_per_ordpos = 4;
     static constexpr std::uint8_t max_ordpos_pri = 0b1111;
-    static constexpr std::uint8_t max_pri_level = (sizeof(std::uint32_t) / bits_per_ordpos) - 1;
+    static constexpr std::uint8_t max_pri_level = (sizeof(std::uint32_t) * 8 / bits_per_ordpos) - 1;
 
     // ======================= WINDOW USER BASE ======================================
     window_user_base::window_user_base(window_server_client_ptr client, screen *scr, window *parent, const window_kind kind)
@@ -117,6 +117,14 @@ namespace eka2l1::epoc {
         window::queue_event(evt);
     }
 
+    void window_user::queue_input_event(const epoc::event &evt) {
+        if (!is_visible()) {
+            return;
+        }
+
+        window::queue_input_event(evt);
+    }
+
     void window_user::set_extent(const eka2l1::vec2 &top, const eka2l1::vec2 &new_size) {
         pos = top;
 
@@ -180,7 +188,7 @@ namespace eka2l1::epoc {
         }
 
         int shift = 0;
-        int parent_pri = reinterpret_cast<window_user_base *>(parent)->redraw_priority(&shift);
+        const std::uint32_t parent_pri = reinterpret_cast<window_user_base *>(parent)->redraw_priority(&shift);
 
         if (shift > 0) {
             shift--;
@@ -210,6 +218,11 @@ namespace eka2l1::epoc {
         }
     }
 
+    void window_user::damage_screen(const eka2l1::rect &local_rect) {
+        // Same placement the screen composes this window with
+        scr->add_damage(eka2l1::rect(pos + local_rect.top, local_rect.size));
+    }
+
     void window_user::invalidate(const eka2l1::rect &irect) {
         if (irect.empty()) {
             return;
@@ -220,6 +233,7 @@ namespace eka2l1::epoc {
         }
 
         eka2l1::rect to_queue = irect;
+        damage_screen(to_queue);
 
         // Queue invalidate even if there's no change to the invalidated region.
         redraw_region.add_rect(to_queue);
@@ -233,6 +247,8 @@ namespace eka2l1::epoc {
     void window_user::end_redraw(service::ipc_context &ctx, ws_cmd &cmd) {
         drivers::graphics_driver *drv = client->get_ws().get_graphics_driver();
 
+        const eka2l1::rect redrawn_rect = redraw_rect_curr;
+
         redraw_region.eliminate(redraw_rect_curr);
         redraw_rect_curr.make_empty();
 
@@ -280,6 +296,7 @@ namespace eka2l1::epoc {
         } while (ite != end);
 
         if (any_flush_performed) {
+            damage_screen(redrawn_rect);
             take_action_on_change();
         }
 
@@ -27,6 +27,8 @@
 
 #include <services/window/common.h>
 
+#include <cassert>
+
 namespace eka2l1::epoc {
     // TODO: Use emulated time
     event::event(const std::uint32_t handle, event_code evt_code)
@@ -73,6 +75,55 @@ namespace eka2l1::epoc {
         }
     }
 
+    int get_byte_width(const std::uint32_t pixels_width, const std::uint8_t bits_per_pixel) {
+        int word_width = 0;
+
+        switch (bits_per_pixel) {
+        case 1: {
+            word_width = (pixels_width + 31) / 32;
+            break;
+        }
+
+        case 2: {
+            word_width = (pixels_width + 15) / 16;
+            break;
+        }
+
+        case 4: {
+            word_width = (pixels_width + 7) / 8;
+            break;
+        }
+
+        case 8: {
+            word_width = (pixels_width + 3) / 4;
+            break;
+        }
+
+        case 12:
+        case 16: {
+            word_width = (pixels_width + 1) / 2;
+            break;
+        }
+
+        case 24: {
+            word_width = (((pixels_width * 3) + 11) / 12) * 3;
+            break;
+        }
+
+        case 32: {
+            word_width = pixels_width;
+            break;
+        }
+
+        default: {
+            assert(false);
+            break;
+        }
+        }
+
+        return word_width * 4;
+    }
+
     int get_num_colors_from_display_mode(const epoc::display_mode disp_mode) {
         switch (disp_mode) {
         case epoc::display_mode::gray2:
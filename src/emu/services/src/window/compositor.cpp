@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <services/window/compositor.h>
+
+#include <algorithm>
+
+namespace eka2l1::epoc {
+    static bool is_same_composition(const std::vector<composed_window> &lhs, const std::vector<composed_window> &rhs) {
+        if (lhs.size() != rhs.size()) {
+            return false;
+        }
+
+        for (std::size_t i = 0; i < lhs.size(); i++) {
+            if ((lhs[i].driver_win_id != rhs[i].driver_win_id) || (lhs[i].extent.top != rhs[i].extent.top)
+                || (lhs[i].extent.size != rhs[i].extent.size) || (lhs[i].opaque != rhs[i].opaque)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    screen_compositor::screen_compositor()
+        : full_redraw_pending(true) {
+    }
+
+    void screen_compositor::add_damage(const eka2l1::rect &damaged_rect, const eka2l1::vec2 &screen_size) {
+        damage.add_rect(damaged_rect.intersect(eka2l1::rect({ 0, 0 }, screen_size)));
+    }
+
+    std::vector<composed_draw> screen_compositor::compose(const std::vector<composed_window> &windows, const eka2l1::vec2 &screen_size) {
+        if (full_redraw_pending || !is_same_composition(windows, last_composition)) {
+            // Windows moved, appeared or went away. What used to be under them has to be drawn again.
+            damage.make_empty();
+            damage.add_rect(eka2l1::rect({ 0, 0 }, screen_size));
+
+            full_redraw_pending = false;
+        }
+
+        // Walk front to back. Each window only has to fill the damaged part that is not already
+        // covered by an opaque window in front of it.
+        common::region covered;
+        std::vector<composed_draw> draws;
+
+        for (std::size_t i = windows.size(); (i > 0) && !damage.empty(); i--) {
+            const composed_window &win = windows[i - 1];
+
+            common::region visible_damage;
+            visible_damage.add_rect(win.extent);
+            visible_damage = visible_damage.intersect(damage);
+            visible_damage.eliminate(covered);
+
+            for (const eka2l1::rect &part : visible_damage.rects_) {
+                draws.push_back({ i - 1, part });
+            }
+
+            if (win.opaque) {
+                covered.add_rect(win.extent);
+            }
+        }
+
+        // Back to front, so windows with transparency blend over what is behind them
+        std::reverse(draws.begin(), draws.end());
+
+        last_composition = windows;
+        damage.make_empty();
+
+        return draws;
+    }
+}
@@ -24,9 +24,13 @@
 #include <common/log.h>
 #include <services/window/fifo.h>
 
-#include <cassert>
+#include <algorithm>
 
 namespace eka2l1::epoc {
+    static bool is_pointer_move_event(const event &evt) {
+        return (evt.type == event_code::touch) && ((evt.adv_pointer_evt_.evtype == event_type::drag) || (evt.adv_pointer_evt_.evtype == event_type::move));
+    }
+
     bool event_fifo::is_my_priority_really_high(epoc::event_code evt) {
         switch (evt) {
         case event_code::switch_off:
@@ -39,19 +43,118 @@ namespace eka2l1::epoc {
         }
     }
 
-    std::uint32_t event_fifo::queue_event(const event &evt) {
-        const std::lock_guard<std::mutex> guard(lock_);
+    void event_fifo::notify_unsafe() {
+        if (has_events_unsafe()) {
+            nof.complete(0);
+            listening_.store(false);
+        }
+    }
+
+    std::uint32_t event_fifo::queue_event_unsafe(const event &evt) {
+        lane &q = lanes_[0];
+
+        if (is_pointer_move_event(evt)) {
+            // Only the latest position matters. Merge with the previous move if nothing came in between.
+            lane::fifo_element *last = q.back();
+
+            if (last && is_pointer_move_event(last->evt) && (last->evt.handle == evt.handle)
+                && (last->evt.adv_pointer_evt_.evtype == evt.adv_pointer_evt_.evtype)
+                && (last->evt.adv_pointer_evt_.ptr_num == evt.adv_pointer_evt_.ptr_num)) {
+                last->evt = evt;
+                return last->id;
+            }
+        }
 
-        if (q_.size() == maximum_element) {
+        if (q.full()) {
             do_purge();
         }
 
-        std::uint32_t result = queue_event_dont_care(evt);
-        trigger_notification();
+        const std::uint32_t result = queue_event_dont_care(evt);
+
+        if (result == 0) {
+            LOG_WARN("Event queue is full, event type {} is dropped", static_cast<int>(evt.type));
+        }
 
         return result;
     }
 
+    void event_fifo::drain_input_unsafe() {
+        while (std::optional<event> evt = input_q_.pop()) {
+            queue_event_unsafe(evt.value());
+        }
+    }
+
+    std::uint32_t event_fifo::queue_event(const event &evt) {
+        const std::lock_guard<std::mutex> guard(lock_);
+
+        // Keep the order with events that came from the input thread earlier
+        drain_input_unsafe();
+
+        const std::uint32_t result = queue_event_unsafe(evt);
+        notify_unsafe();
+
+        return result;
+    }
+
+    void event_fifo::queue_input_event(const event &evt) {
+        bool pushed = false;
+
+        {
+            const std::lock_guard<std::mutex> push_guard(input_push_lock_);
+            pushed = input_q_.push(evt);
+        }
+
+        if (!pushed) {
+            const std::lock_guard<std::mutex> guard(lock_);
+
+            drain_input_unsafe();
+            queue_event_unsafe(evt);
+            notify_unsafe();
+
+            return;
+        }
+
+        // Pairs with the fence in set_listener, so either the listener sees this event, or we see the listener.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (listening_.load(std::memory_order_relaxed)) {
+            const std::lock_guard<std::mutex> guard(lock_);
+
+            drain_input_unsafe();
+            notify_unsafe();
+        }
+    }
+
+    void event_fifo::set_listener(epoc::notify_info nof_info) {
+        const std::lock_guard<std::mutex> guard(lock_);
+        drain_input_unsafe();
+
+        if (has_events_unsafe()) {
+            // Complete with KErrNone
+            nof_info.complete(0);
+            return;
+        }
+
+        nof = nof_info;
+        listening_.store(true, std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (!input_q_.empty()) {
+            drain_input_unsafe();
+            notify_unsafe();
+        }
+    }
+
+    void event_fifo::walk(walker_func walker, void *userdata) {
+        {
+            const std::lock_guard<std::mutex> guard(lock_);
+            drain_input_unsafe();
+        }
+
+        base_fifo<event, 32>::walk(walker, userdata);
+    }
+
     // Symbian purges:
     // Pointer up/down pairs
     // Key messages
@@ -62,16 +165,37 @@ namespace eka2l1::epoc {
     // Lone pointer ups
     // Lone focus lost/gain
     void event_fifo::do_purge() {
-        for (size_t i = 0; i < q_.size(); i++) {
-            switch (q_[i].evt.type) {
+        lane &q = lanes_[0];
+
+        // Position of the next event not removed yet, or used() if there is none
+        const auto next_alive = [&](std::uint32_t pos) {
+            for (pos++; pos < q.used(); pos++) {
+                if (q.at(pos).alive) {
+                    break;
+                }
+            }
+
+            return pos;
+        };
+
+        for (std::uint32_t i = 0; i < q.used(); i++) {
+            lane::fifo_element &elem = q.at(i);
+
+            if (!elem.alive) {
+                continue;
+            }
+
+            switch (elem.evt.type) {
             case epoc::event_code::event_password:
                 break;
 
             case epoc::event_code::null:
             case epoc::event_code::key:
+            case epoc::event_code::key_down:
+            case epoc::event_code::key_up:
             case epoc::event_code::touch_enter:
             case epoc::event_code::touch_exit: {
-                q_.erase(q_.begin() + i);
+                q.remove(i);
                 break;
             }
 
@@ -79,39 +203,48 @@ namespace eka2l1::epoc {
                 // TODO: implement logics in
                 // https://github.com/SymbianSource/oss.FCL.sf.os.graphics/blob/ff133bc50e6158bfb08cc093b0f0055321dcde99/windowing/windowserver/nga/SERVER/EVQUEUE.CPP#L630
                 // just purge it right now
-                q_.erase(q_.begin() + i);
+                q.remove(i);
                 break;
             }
 
             case epoc::event_code::focus_gained:
             case epoc::event_code::focus_lost: {
-                if ((i + 1 < q_.size()) && ((q_[i + 1].evt.type == epoc::event_code::focus_gained) || (q_[i + 1].evt.type == epoc::event_code::focus_lost))) {
-                    q_.erase(q_.begin() + i + 1);
-                    q_.erase(q_.begin() + i);
+                const std::uint32_t next = next_alive(i);
+
+                if ((next < q.used()) && ((q.at(next).evt.type == epoc::event_code::focus_gained) || (q.at(next).evt.type == epoc::event_code::focus_lost))) {
+                    q.remove(next);
+                    q.remove(i);
                 }
 
                 break;
             }
 
             case epoc::event_code::switch_on: {
-                if (i + 1 < q_.size() && (q_[i + 1].evt.type == epoc::event_code::switch_on)) {
-                    q_.erase(q_.begin() + i);
-                    break;
+                const std::uint32_t next = next_alive(i);
+
+                if ((next < q.used()) && (q.at(next).evt.type == epoc::event_code::switch_on)) {
+                    q.remove(i);
                 }
+
+                break;
             }
 
             default: {
-                LOG_ERROR("Unhandled purge of event type: {}", static_cast<int>(q_[i].evt.type));
-                assert(false);
-
+                LOG_ERROR("Unhandled purge of event type: {}", static_cast<int>(elem.evt.type));
                 break;
             }
             }
         }
+
+        q.trim();
+        update_lane_mask(0);
     }
 
     event event_fifo::get_event() {
-        std::optional<event> evt = get_evt_opt();
+        const std::lock_guard<std::mutex> guard(lock_);
+        drain_input_unsafe();
+
+        std::optional<event> evt = get_evt_opt_unsafe();
 
         if (!evt) {
             // Create a null event
@@ -121,34 +254,61 @@ namespace eka2l1::epoc {
         return *evt;
     }
 
-    std::uint32_t redraw_fifo::queue_event(const redraw_event &evt, const std::uint16_t pri) {
+    std::uint32_t redraw_fifo::queue_event(const redraw_event &evt, const std::uint32_t pri) {
         const std::lock_guard<std::mutex> guard(lock_);
         eka2l1::rect target_queue_rect(evt.top_left, evt.bottom_right);
         target_queue_rect.transform_from_symbian_rectangle();
 
-        std::size_t limit = q_.size();
+        const unsigned int lane_index = std::min<std::uint32_t>(pri >> LANE_SHIFT, lane_count - 1);
+        lane &q = lanes_[lane_index];
 
-        for (std::size_t i = 0; i < limit; i++) {
-            eka2l1::rect queued_rect(q_[i].evt.top_left, q_[i].evt.bottom_right);
+        for (std::uint32_t i = 0; i < q.used(); i++) {
+            lane::fifo_element &elem = q.at(i);
+
+            if (!elem.alive || (elem.evt.handle != evt.handle)) {
+                continue;
+            }
+
+            eka2l1::rect queued_rect(elem.evt.top_left, elem.evt.bottom_right);
             queued_rect.transform_from_symbian_rectangle();
 
-            if ((q_[i].evt.handle == evt.handle) && target_queue_rect.contains(queued_rect)) {
+            if (target_queue_rect.contains(queued_rect)) {
                 // The new redraw rect contains the old queued redraw rect. Remove it to avoid
                 // unneccessary redraws.
-                q_.erase(q_.begin() + i);
-                limit--;
+                q.remove(i);
+            }
+        }
+
+        q.trim();
+
+        std::uint32_t id = queue_event_dont_care(evt, lane_index, pri);
+
+        if (id == 0) {
+            // Lane is full. Grow the newest redraw of the same window to cover the new area instead.
+            for (std::uint32_t i = q.used(); i > 0; i--) {
+                lane::fifo_element &elem = q.at(i - 1);
+
+                if (elem.alive && (elem.evt.handle == evt.handle)) {
+                    eka2l1::rect queued_rect(elem.evt.top_left, elem.evt.bottom_right);
+                    queued_rect.transform_from_symbian_rectangle();
+                    queued_rect.merge(target_queue_rect);
+
+                    elem.evt.top_left = queued_rect.top;
+                    elem.evt.bottom_right = queued_rect.top + queued_rect.size;
+
+                    id = elem.id;
+                    break;
+                }
+            }
+
+            if (id == 0) {
+                LOG_WARN("Redraw queue is full, redraw for window handle 0x{:X} is dropped", evt.handle);
             }
         }
-        
-        std::uint32_t id = queue_event_dont_care(evt);
-        q_.back().pri = pri;
 
-        std::stable_sort(q_.begin(), q_.end(),
-            [&](const fifo_element &e1, const fifo_element &e2) {
-                return e1.pri < e2.pri;
-            });
+        update_lane_mask(lane_index);
 
         // Queue a redraw won't directly trigger a notification.
         return id;
     }
-}
\ No newline at end of file
+}
@@ -51,7 +51,7 @@ namespace eka2l1::epoc {
         kernel_system *kern = win->client->get_ws().get_kernel_system();
 
         const bool try_success = kern->try_lock();
-        win->queue_event(evt);
+        win->queue_input_event(evt);
         
         if (try_success) 
             kern->unlock();
@@ -166,7 +166,7 @@ namespace eka2l1::epoc {
             kernel_system *kern = focus->client->get_ws().get_kernel_system();
 
             bool try_success = kern->try_lock();
-            focus->queue_event(evt);
+            focus->queue_input_event(evt);
 
             if (try_success)
                 kern->unlock();
@@ -174,7 +174,7 @@ namespace eka2l1::epoc {
             if (!dont_send_extra_key_event) {
                 // Give it a single key event also
                 try_success = kern->try_lock();
-                focus->queue_event(extra_event);
+                focus->queue_input_event(extra_event);
                 
                 if (try_success)
                     kern->unlock();
@@ -193,7 +193,7 @@ namespace eka2l1::epoc {
                 case epoc::event_key_capture_type::normal:
                     extra_event.handle = ite->user->get_client_handle();
                     try_success = kern->try_lock();
-                    ite->user->queue_event(extra_event);
+                    ite->user->queue_input_event(extra_event);
                     
                     if (try_success)
                         kern->unlock();
@@ -203,7 +203,7 @@ namespace eka2l1::epoc {
                 case epoc::event_key_capture_type::up_and_downs:
                     evt.handle = ite->user->get_client_handle();
                     try_success = kern->try_lock();
-                    ite->user->queue_event(evt);
+                    ite->user->queue_input_event(evt);
                     
                     if (try_success)
                         kern->unlock();
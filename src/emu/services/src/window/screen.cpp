@@ -31,14 +31,8 @@
 #include <thread>
 
 namespace eka2l1::epoc {
-    struct window_drawer_walker : public window_tree_walker {
-        drivers::graphics_command_list_builder *builder_;
-        std::uint32_t total_redrawed_;
-
-        explicit window_drawer_walker(drivers::graphics_command_list_builder *builder)
-            : builder_(builder)
-            , total_redrawed_(0) {
-        }
+    struct window_composition_walker : public window_tree_walker {
+        std::vector<composed_window> windows_;
 
         bool do_it(window *win) {
             if (win->type != window_kind::client) {
@@ -58,12 +52,12 @@ namespace eka2l1::epoc {
                 return false;
             }
 
-            // Draw it onto current binding buffer
-            builder_->draw_bitmap(winuser->driver_win_id, 0, eka2l1::rect(winuser->pos, { 0, 0 }),
-                eka2l1::rect({ 0, 0 }, winuser->size), 0);
-
-            total_redrawed_++;
+            composed_window composed;
+            composed.driver_win_id = winuser->driver_win_id;
+            composed.extent = eka2l1::rect(winuser->pos, winuser->size);
+            composed.opaque = !(winuser->flags & window::flags_enable_alpha);
 
+            windows_.push_back(composed);
             return false;
         }
     };
@@ -79,10 +73,12 @@ namespace eka2l1::epoc {
         , dsa_texture(0)
         , disp_mode(display_mode::color16ma)
         , last_vsync(0)
+        , frame_count(0)
         , scr_config(scr_conf)
         , crr_mode(1)
         , next(nullptr)
-        , focus(nullptr) {
+        , focus(nullptr)
+        , screen_buffer_chunk(nullptr) {
         root = std::make_unique<epoc::window>(nullptr, this, nullptr);
         disp_mode = scr_conf.disp_mode;
 
@@ -94,20 +90,32 @@ namespace eka2l1::epoc {
     }
 
     void screen::redraw(drivers::graphics_command_list_builder *cmd_builder, const bool need_bind) {
+        window_composition_walker composition;
+        root->walk_tree_back_to_front(&composition);
+
+        const std::vector<composed_draw> draws = compositor.compose(composition.windows_, size());
+
         if (need_bind) {
+            if (draws.empty()) {
+                return;
+            }
+
             cmd_builder->bind_bitmap(screen_texture);
         }
 
-        // Walk through the window tree in recursive order, and do draw
-        // We dont care about visible regions. Nowadays, detect visible region to reduce pixel plotting is
-        // just not really worth the time, since GPU draws so fast. Symbian code still has it though.
-        window_drawer_walker adrawwalker(cmd_builder);
-        root->walk_tree_back_to_front(&adrawwalker);
+        for (const composed_draw &draw : draws) {
+            const composed_window &win = composition.windows_[draw.window_index];
+            cmd_builder->draw_bitmap(win.driver_win_id, 0, draw.part, eka2l1::rect(draw.part.top - win.extent.top, draw.part.size), 0);
+        }
 
         // Done! Unbind and submit this to the driver
         cmd_builder->bind_bitmap(0);
     }
 
+    void screen::add_damage(const eka2l1::rect &damaged_rect) {
+        compositor.add_damage(damaged_rect, size());
+    }
+
     void screen::redraw(drivers::graphics_driver *driver) {
         if (!screen_texture) {
             set_screen_mode(driver, crr_mode);
@@ -148,6 +156,9 @@ namespace eka2l1::epoc {
 
         bool need_bind = true;
 
+        // Whatever was on the screen texture is gone
+        compositor.full_redraw_pending = true;
+
         if (!screen_texture) {
             // Create new one!
             screen_texture = drivers::create_bitmap(driver, new_size);
@@ -261,6 +272,7 @@ namespace eka2l1::epoc {
         }
 
         last_vsync = tnow;
+        frame_count++;
     }
 
     const epoc::config::screen_mode *screen::mode_info(const int number) const {
@@ -30,6 +30,7 @@
 #include <mutex>
 #include <optional>
 #include <string>
+#include <vector>
 
 namespace eka2l1 {
     class memory_system;
@@ -166,6 +167,17 @@ namespace eka2l1 {
         */
         virtual address rom_address() const = 0;
 
+        /*! \brief Get a host pointer to the whole content of the file.
+         *
+         * Only files that already sit in host memory (such as ROM files) provide this, so the content
+         * can be parsed in place instead of being read out. The pointer stays valid while the ROM is loaded.
+         *
+         * \returns Pointer to size() bytes of file data, or null if the file is not memory resident.
+         */
+        virtual const std::uint8_t *get_mapped_data() const {
+            return nullptr;
+        }
+
         virtual bool resize(const std::size_t new_size) = 0;
 
         virtual bool flush();
@@ -219,13 +231,22 @@ namespace eka2l1 {
 
         /*! \brief Get the next iterating entry. 
         *
-        * All the entries are filtered through a regex expression. The directory iterator
+        * All the entries are filtered through a wildcard pattern. The directory iterator
         * will increase itself if it's not at the end entry, and returns the entry info. Else,
         * it will return nothing
         */
         virtual std::optional<entry_info> get_next_entry() = 0;
 
         virtual std::optional<entry_info> peek_next_entry() = 0;
+
+        /*! \brief Read many entries at once.
+         *
+         * \param entries   Vector to append the entries to.
+         * \param max_count Maximum number of entries to read.
+         *
+         * \returns Number of entries appended. 0 when there are no entries left.
+         */
+        virtual std::size_t read_entries(std::vector<entry_info> &entries, const std::size_t max_count);
     };
 
     enum class abstract_file_system_err_code {
@@ -36,9 +36,9 @@
 #include <iostream>
 #include <map>
 #include <mutex>
-#include <regex>
 #include <thread>
 #include <stack>
+#include <unordered_map>
 
 #include <string.h>
 
@@ -55,6 +55,23 @@ namespace eka2l1 {
         : io_component(io_component_type::dir, attrib) {
     }
 
+    std::size_t directory::read_entries(std::vector<entry_info> &entries, const std::size_t max_count) {
+        std::size_t count = 0;
+
+        while (count < max_count) {
+            std::optional<entry_info> info = get_next_entry();
+
+            if (!info) {
+                break;
+            }
+
+            entries.push_back(std::move(info.value()));
+            count++;
+        }
+
+        return count;
+    }
+
     bool file::flush() {
         return true;
     }
@@ -168,6 +185,10 @@ namespace eka2l1 {
             return file.address_lin;
         }
 
+        const std::uint8_t *get_mapped_data() const override {
+            return file_ptr;
+        }
+
         uint64_t tell() override {
             return crr_pos;
         }
@@ -414,7 +435,7 @@ namespace eka2l1 {
 
     /* DIRECTORY VFS */
     class physical_directory : public directory {
-        std::regex filter;
+        common::wildcard_matcher filter;
         std::string vir_path;
 
         common::dir_iterator iterator;
@@ -430,7 +451,7 @@ namespace eka2l1 {
     public:
         physical_directory(abstract_file_system *inst, const std::string &phys_path,
             const std::string &vir_path, const std::string &filter, const std::uint32_t attrib)
-            : filter(common::wildcard_to_regex_string(common::lowercase_string(filter)))
+            : filter(filter, true)
             , iterator(phys_path)
             , vir_path(vir_path)
             , attrib(attrib)
@@ -469,13 +490,13 @@ namespace eka2l1 {
                     }
                 }
 
-                // Quick hack: Regex dumb with null-terminated string
+                // Null terminator is not part of the name to match
                 if (name.back() == '\0') {
                     name.erase(name.length() - 1);
                 }
 
                 // If it doesn't meet the filter, continue until find one or there is no one
-                if (!std::regex_match(common::lowercase_string(name), filter)) {
+                if (!filter.match(name)) {
                     continue;
                 }
 
@@ -830,58 +851,77 @@ namespace eka2l1 {
         loader::rom *rom_cache;
         memory_system *mem;
 
-        loader::rom_dir *burn_tree_find_dir(const std::string &vir_path) {
-            auto ite = path_iterator(vir_path);
-            loader::rom_dir *last_dir_found = &(rom_cache->root.root_dirs[0].dir);
+        // Case-folded paths relative to the drive root, separated by backslashes
+        std::unordered_map<std::u16string, loader::rom_dir *> dir_index_;
+        std::unordered_map<std::u16string, const loader::rom_entry *> entry_index_;
+
+        static std::u16string make_index_key(const std::u16string &path) {
+            std::size_t start = 0;
 
             // Skip through the drive
-            ite++;
+            if ((path.length() >= 2) && (path[1] == u':')) {
+                start = 2;
+            }
+
+            std::u16string key;
+            key.reserve(path.length() - start);
+
+            for (std::size_t i = start; i < path.length(); i++) {
+                char16_t c = path[i];
+
+                if (c == u'/') {
+                    c = u'\\';
+                }
 
-            std::vector<std::string> components;
+                // Skip leading and duplicated separators
+                if ((c == u'\\') && (key.empty() || (key.back() == u'\\'))) {
+                    continue;
+                }
 
-            for (; ite; ite++) {
-                components.push_back(*ite);
+                key.push_back(static_cast<char16_t>(std::towlower(c)));
             }
 
-            if (components.size() == 0) {
-                return nullptr;
+            if (!key.empty() && (key.back() == u'\\')) {
+                key.pop_back();
             }
 
-            for (std::size_t i = 0; i < components.size(); i++) {
-                loader::rom_dir temp;
-                temp.name = common::utf8_to_ucs2(components[i]);
+            return key;
+        }
+
+        void build_index(loader::rom_dir &dir, const std::u16string &dir_key) {
+            dir_index_.emplace(dir_key, &dir);
 
-                auto res1 = std::lower_bound(last_dir_found->subdirs.begin(), last_dir_found->subdirs.end(), temp,
-                    [](const loader::rom_dir &lhs, const loader::rom_dir &rhs) { return common::compare_ignore_case(lhs.name, rhs.name) == -1; });
+            const std::u16string prefix = dir_key.empty() ? dir_key : (dir_key + u'\\');
 
-                if (res1 != last_dir_found->subdirs.end() && (common::compare_ignore_case(res1->name, temp.name) == 0)) {
-                    last_dir_found = &(last_dir_found->subdirs[std::distance(last_dir_found->subdirs.begin(), res1)]);
-                } else {
-                    return nullptr;
+            for (const loader::rom_entry &entry : dir.entries) {
+                if (!entry.dir) {
+                    entry_index_.emplace(prefix + common::lowercase_ucs2_string(entry.name), &entry);
                 }
             }
 
-            return last_dir_found;
+            for (loader::rom_dir &subdir : dir.subdirs) {
+                build_index(subdir, prefix + common::lowercase_ucs2_string(subdir.name));
+            }
         }
 
-        std::optional<loader::rom_entry> burn_tree_find_entry(const std::string &vir_path) {
-            loader::rom_dir *last_dir_found = burn_tree_find_dir(eka2l1::file_directory(vir_path, true));
+        loader::rom_dir *burn_tree_find_dir(const std::u16string &vir_path) {
+            auto result = dir_index_.find(make_index_key(vir_path));
 
-            if (!last_dir_found) {
-                return std::nullopt;
+            if (result == dir_index_.end()) {
+                return nullptr;
             }
 
-            loader::rom_entry temp_entry;
-            temp_entry.name = common::utf8_to_ucs2(eka2l1::filename(vir_path, true));
+            return result->second;
+        }
 
-            auto res2 = std::lower_bound(last_dir_found->entries.begin(), last_dir_found->entries.end(), temp_entry,
-                [](const loader::rom_entry &lhs, const loader::rom_entry &rhs) { return common::compare_ignore_case(lhs.name, rhs.name) == -1; });
+        const loader::rom_entry *burn_tree_find_entry(const std::u16string &vir_path) {
+            auto result = entry_index_.find(make_index_key(vir_path));
 
-            if (res2 != last_dir_found->entries.end() && !res2->dir && (common::compare_ignore_case(temp_entry.name, res2->name) == 0)) {
-                return *res2;
+            if (result == entry_index_.end()) {
+                return nullptr;
             }
 
-            return std::nullopt;
+            return result->second;
         }
 
     public:
@@ -889,6 +929,9 @@ namespace eka2l1 {
             : physical_file_system(ver, product_code)
             , rom_cache(cache)
             , mem(mem) {
+            if (!rom_cache->root.root_dirs.empty()) {
+                build_index(rom_cache->root.root_dirs[0].dir, u"");
+            }
         }
 
         bool delete_entry(const std::u16string &path) override {
@@ -917,12 +960,8 @@ namespace eka2l1 {
         }
 
         abstract_file_system_err_code is_entry_in_rom(const std::u16string &path) override {
-            // Don't bother getting an entry if it's not even available on host
-            if (!exists(path)) {
-                return abstract_file_system_err_code::no;
-            }
-
-            if (burn_tree_find_entry(common::ucs2_to_utf8(path))) {
+            // Index lookup is much cheaper than asking the host, do it first
+            if (burn_tree_find_entry(path) && exists(path)) {
                 return abstract_file_system_err_code::ok;
             }
 
@@ -950,7 +989,7 @@ namespace eka2l1 {
                 }
             }
 
-            auto entry = burn_tree_find_entry(common::ucs2_to_utf8(new_path));
+            const loader::rom_entry *entry = burn_tree_find_entry(new_path);
 
             if (!entry) {
                 return physical_file_system::open_file(new_path, mode);
@@ -965,7 +1004,7 @@ namespace eka2l1 {
                 return std::nullopt;
             }
 
-            auto entry = burn_tree_find_entry(common::ucs2_to_utf8(path));
+            const loader::rom_entry *entry = burn_tree_find_entry(path);
 
             if (!entry) {
                 return physical_file_system::get_entry_info(path);
@@ -987,7 +1026,7 @@ namespace eka2l1 {
             loader::rom_dir *the_base_dir = &(rom_cache->root.root_dirs[0].dir);
 
             if (!the_base_path.empty()) {
-                the_base_dir = burn_tree_find_dir(common::ucs2_to_utf8(clue));
+                the_base_dir = burn_tree_find_dir(clue);
             }
 
             if (!the_base_dir) {
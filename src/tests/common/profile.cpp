@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <common/profile.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using namespace eka2l1;
+
+static std::string read_whole_file(const std::string &path) {
+    std::ifstream stream(path);
+    std::stringstream content;
+    content << stream.rdbuf();
+
+    return content.str();
+}
+
+TEST_CASE("zones_written_as_chrome_trace", "profile") {
+    static const char *TRACE_PATH = "profile_test_trace.json";
+
+    {
+        common::profile::scoped_zone zone("test", "before_capture");
+    }
+
+    common::profile::start_capture();
+    common::profile::set_thread_name("Profile \"test\" thread");
+
+    {
+        common::profile::scoped_zone zone("test", "captured_zone");
+    }
+
+    REQUIRE(common::profile::stop_capture(TRACE_PATH));
+
+    {
+        common::profile::scoped_zone zone("test", "after_capture");
+    }
+
+    const std::string trace = read_whole_file(TRACE_PATH);
+    std::remove(TRACE_PATH);
+
+    REQUIRE(trace.find("\"traceEvents\":[") != std::string::npos);
+    REQUIRE(trace.find("\"name\":\"captured_zone\",\"cat\":\"test\",\"ph\":\"X\"") != std::string::npos);
+    REQUIRE(trace.find("Profile \\\"test\\\" thread") != std::string::npos);
+    REQUIRE(trace.find("before_capture") == std::string::npos);
+    REQUIRE(trace.find("after_capture") == std::string::npos);
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <common/queue.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+
+TEST_CASE("spsc_ring_queue_order_and_capacity", "queue") {
+    eka2l1::spsc_ring_queue<int, 4> queue;
+
+    for (int i = 0; i < 4; i++) {
+        REQUIRE(queue.push(i));
+    }
+
+    REQUIRE(!queue.push(4));
+    REQUIRE(queue.size() == 4);
+
+    for (int i = 0; i < 4; i++) {
+        REQUIRE(queue.pop().value() == i);
+    }
+
+    REQUIRE(queue.empty());
+    REQUIRE(!queue.pop());
+}
+
+TEST_CASE("spsc_ring_queue_two_threads", "queue") {
+    static constexpr int TOTAL_ITEMS = 100000;
+    eka2l1::spsc_ring_queue<int, 64> queue;
+
+    std::thread producer([&]() {
+        for (int i = 0; i < TOTAL_ITEMS;) {
+            if (queue.push(i)) {
+                i++;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    int expected = 0;
+
+    while (expected < TOTAL_ITEMS) {
+        if (std::optional<int> item = queue.pop()) {
+            REQUIRE(item.value() == expected);
+            expected++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    producer.join();
+}
+
+TEST_CASE("spsc_ring_buffer_wrap_around", "queue") {
+    eka2l1::spsc_ring_buffer<std::int16_t> ring(6);
+    REQUIRE(ring.capacity() == 8);
+
+    const std::int16_t first[] = { 1, 2, 3, 4, 5 };
+    const std::int16_t second[] = { 6, 7, 8, 9, 10 };
+
+    REQUIRE(ring.write(first, 5));
+
+    // All or nothing
+    REQUIRE(!ring.write(second, 5));
+
+    std::int16_t out[8] = {};
+    REQUIRE(ring.read(out, 3) == 3);
+    REQUIRE(out[2] == 3);
+
+    // This one crosses the end of the storage
+    REQUIRE(ring.write(second, 5));
+    REQUIRE(ring.size() == 7);
+
+    REQUIRE(ring.skip(1) == 1);
+    REQUIRE(ring.read(out, 8) == 6);
+
+    const std::int16_t expected[] = { 5, 6, 7, 8, 9, 10 };
+    REQUIRE(std::equal(expected, expected + 6, out));
+
+    REQUIRE(ring.read_position() == 10);
+    REQUIRE(ring.write_position() == 10);
+}
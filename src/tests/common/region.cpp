@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <common/region.h>
+
+#include <cstdint>
+
+using namespace eka2l1;
+
+static std::uint64_t region_area(const common::region &reg) {
+    std::uint64_t area = 0;
+
+    for (const eka2l1::rect &r : reg.rects_) {
+        area += static_cast<std::uint64_t>(r.size.x) * r.size.y;
+    }
+
+    return area;
+}
+
+TEST_CASE("add_overlapping_rects_keeps_union", "region") {
+    common::region reg;
+    REQUIRE(reg.add_rect(eka2l1::rect({ 10, 10 }, { 40, 20 })));
+    REQUIRE(reg.add_rect(eka2l1::rect({ 40, 20 }, { 30, 20 })));
+
+    // 800 + 600 minus the 10x10 overlap
+    REQUIRE(region_area(reg) == 1300);
+
+    const eka2l1::rect bound = reg.bounding_rect();
+    REQUIRE(bound.top == eka2l1::vec2(10, 10));
+    REQUIRE(bound.size == eka2l1::vec2(60, 30));
+
+    // No two rectangles of the region may overlap
+    for (std::size_t i = 0; i < reg.rects_.size(); i++) {
+        for (std::size_t j = i + 1; j < reg.rects_.size(); j++) {
+            REQUIRE(reg.rects_[i].intersect(reg.rects_[j]).empty());
+        }
+    }
+}
+
+TEST_CASE("add_covered_rect_is_no_op", "region") {
+    common::region reg;
+    reg.add_rect(eka2l1::rect({ 0, 0 }, { 100, 100 }));
+
+    REQUIRE_FALSE(reg.add_rect(eka2l1::rect({ 20, 20 }, { 10, 10 })));
+    REQUIRE(reg.rects_.size() == 1);
+}
+
+TEST_CASE("add_rect_spanning_several_rects", "region") {
+    common::region reg;
+    reg.add_rect(eka2l1::rect({ 0, 0 }, { 10, 10 }));
+    reg.add_rect(eka2l1::rect({ 20, 0 }, { 10, 10 }));
+    reg.add_rect(eka2l1::rect({ 5, 5 }, { 20, 10 }));
+
+    // 100 + 100 + 200 minus two 5x5 overlaps
+    REQUIRE(region_area(reg) == 350);
+}
+
+TEST_CASE("eliminate_rect_from_several_rects", "region") {
+    common::region reg;
+    reg.add_rect(eka2l1::rect({ 0, 0 }, { 10, 10 }));
+    reg.add_rect(eka2l1::rect({ 10, 0 }, { 10, 10 }));
+    reg.add_rect(eka2l1::rect({ 20, 0 }, { 10, 10 }));
+
+    // Cuts into all three rectangles
+    reg.eliminate(eka2l1::rect({ 5, 5 }, { 20, 10 }));
+
+    REQUIRE(region_area(reg) == 200);
+
+    for (const eka2l1::rect &r : reg.rects_) {
+        REQUIRE(r.intersect(eka2l1::rect({ 5, 5 }, { 20, 10 })).empty());
+    }
+}
@@ -178,4 +178,59 @@ TEST_CASE("sixteen_bits_compression_small", "rle_compression") {
 
     REQUIRE(compressed_size == expected.size());
     REQUIRE(std::equal(expected.begin(), expected.end(), dest_buf.begin()));
-}
\ No newline at end of file
+}
+
+TEST_CASE("eight_bit_buffer_compression_matches_stream", "rle_compression") {
+    static std::array<std::uint8_t, 27> source = {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // 18 zeros
+
+        0x05, 0x06, 0x07, 0x08, 0x09, 0x10, 0x11, 0x12, 0x13, // Non-consecutive sequence
+    };
+
+    static std::array<std::int8_t, 12> expected = {
+        17, 0x00,
+        -9, 0x05, 0x06, 0x07, 0x08, 0x09, 0x10, 0x11, 0x12, 0x13
+    };
+
+    std::vector<std::uint8_t> dest_buf;
+
+    REQUIRE(compress_rle<8>(source.data(), source.size(), dest_buf, source.size()));
+    REQUIRE(dest_buf.size() == expected.size());
+    REQUIRE(std::equal(expected.begin(), expected.end(), reinterpret_cast<std::int8_t *>(dest_buf.data())));
+
+    // Output larger than the limit should be rejected
+    REQUIRE_FALSE(compress_rle<8>(source.data(), source.size(), dest_buf, 4));
+}
+
+TEST_CASE("twenty_four_bits_buffer_compression_round_trip", "rle_compression") {
+    std::vector<std::uint8_t> source;
+
+    // Long repeat, a literal stretch, short repeats and a lone pixel at the end
+    for (int i = 0; i < 300; i++) {
+        source.insert(source.end(), { 0x10, 0x20, 0x30 });
+    }
+
+    for (int i = 0; i < 150; i++) {
+        source.insert(source.end(), { static_cast<std::uint8_t>(i), 0x00, static_cast<std::uint8_t>(i * 3) });
+    }
+
+    for (int i = 0; i < 2; i++) {
+        source.insert(source.end(), { 0xAA, 0xBB, 0xCC });
+    }
+
+    source.insert(source.end(), { 0x01, 0x02, 0x03 });
+
+    std::vector<std::uint8_t> compressed;
+    REQUIRE(compress_rle<24>(source.data(), source.size(), compressed, source.size()));
+    REQUIRE(compressed.size() < source.size());
+
+    std::vector<std::uint8_t> decompressed(source.size());
+
+    common::ro_buf_stream compressed_stream(compressed.data(), compressed.size());
+    common::wo_buf_stream decompressed_stream(decompressed.data(), decompressed.size());
+
+    decompress_rle<24>(&compressed_stream, &decompressed_stream);
+
+    REQUIRE(decompressed == source);
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <common/thread.h>
+
+#include <atomic>
+
+using namespace eka2l1;
+
+TEST_CASE("pool_runs_all_tasks", "thread_pool") {
+    common::thread_pool pool(4);
+    std::atomic<int> sum(0);
+
+    for (int i = 1; i <= 1000; i++) {
+        pool.enqueue([&sum, i]() {
+            sum += i;
+        });
+    }
+
+    pool.wait_all();
+    REQUIRE(sum == 500500);
+}
+
+TEST_CASE("pool_wait_all_reusable", "thread_pool") {
+    common::thread_pool pool(2);
+    std::atomic<int> counter(0);
+
+    for (int round = 0; round < 10; round++) {
+        for (int i = 0; i < 16; i++) {
+            pool.enqueue([&counter]() {
+                counter++;
+            });
+        }
+
+        pool.wait_all();
+        REQUIRE(counter == (round + 1) * 16);
+    }
+}
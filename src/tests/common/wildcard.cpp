@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project 
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <common/wildcard.h>
+
+using namespace eka2l1;
+
+TEST_CASE("wildcard_star_and_question", "wildcard") {
+    const common::wildcard_matcher matcher("*.r??", true);
+
+    REQUIRE(matcher.match("hello.rsc"));
+    REQUIRE(matcher.match("HELLO.RSC"));
+    REQUIRE(matcher.match(".r01"));
+    REQUIRE_FALSE(matcher.match("hello.rs"));
+    REQUIRE_FALSE(matcher.match("hello.rsc.bak"));
+
+    const common::wildcard_matcher all("*", true);
+    REQUIRE(all.match(""));
+    REQUIRE(all.match("anything"));
+
+    const common::wildcard_matcher empty("", true);
+    REQUIRE(empty.match(""));
+    REQUIRE_FALSE(empty.match("a"));
+}
+
+TEST_CASE("wildcard_backtrack", "wildcard") {
+    const common::wildcard_matcher matcher("a*b*c", false);
+
+    REQUIRE(matcher.match("abc"));
+    REQUIRE(matcher.match("aXbYbZc"));
+    REQUIRE(matcher.match("abcbc"));
+    REQUIRE_FALSE(matcher.match("abcb"));
+    REQUIRE_FALSE(matcher.match("Abc"));
+}
+
+TEST_CASE("wildcard_match_position", "wildcard") {
+    // Like TDesC::Match, the position is where the first non-star part matched
+    REQUIRE(common::match_wildcard_in_string<char16_t>(u"abcdef", u"*cd*", false) == 2);
+    REQUIRE(common::match_wildcard_in_string<char16_t>(u"abcdef", u"abc*", false) == 0);
+    REQUIRE(common::match_wildcard_in_string<char16_t>(u"abcdef", u"*?e?", false) == 3);
+    REQUIRE(common::match_wildcard_in_string<char16_t>(u"ABCDEF", u"*cd*", true) == 2);
+    REQUIRE(common::match_wildcard_in_string<char16_t>(u"abcdef", u"cd", false) == std::u16string::npos);
+    REQUIRE(common::match_wildcard_in_string<char16_t>(u"abcdef", u"*CD*", false) == std::u16string::npos);
+}
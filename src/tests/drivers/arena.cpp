@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <drivers/driver.h>
+
+#include <cstdint>
+
+using namespace eka2l1;
+
+TEST_CASE("arena_oversized_payload_keeps_current_block", "command_arena") {
+    drivers::command_arena arena;
+
+    std::uint8_t *first = reinterpret_cast<std::uint8_t *>(arena.allocate(16, 16));
+    std::uint8_t *big = reinterpret_cast<std::uint8_t *>(arena.allocate(drivers::COMMAND_ARENA_BLOCK_SIZE * 2, 16));
+    std::uint8_t *second = reinterpret_cast<std::uint8_t *>(arena.allocate(16, 16));
+
+    REQUIRE(big != nullptr);
+    REQUIRE(reinterpret_cast<std::uintptr_t>(big) % 16 == 0);
+
+    // The small allocation after the big one continues in the same block
+    REQUIRE(second == first + 16);
+}
+
+TEST_CASE("arena_reset_reuses_blocks", "command_arena") {
+    drivers::command_arena arena;
+
+    void *first = arena.allocate(64);
+
+    // Fill past the first block
+    for (std::size_t i = 0; i < drivers::COMMAND_ARENA_BLOCK_SIZE / 64; i++) {
+        arena.allocate(64);
+    }
+
+    arena.allocate(drivers::COMMAND_ARENA_BLOCK_SIZE * 2);
+    arena.reset();
+
+    REQUIRE(arena.allocate(64) == first);
+}
+
+TEST_CASE("arena_respects_alignment", "command_arena") {
+    drivers::command_arena arena;
+
+    arena.allocate(3, 1);
+    void *aligned = arena.allocate(8, 64);
+
+    REQUIRE(reinterpret_cast<std::uintptr_t>(aligned) % 64 == 0);
+}
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <drivers/audio/backend/capture/audio_capture.h>
+#include <drivers/audio/mixer.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+using namespace eka2l1;
+
+static std::uint32_t read_u32_le(const std::uint8_t *data) {
+    return data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<std::uint32_t>(data[3]) << 24);
+}
+
+TEST_CASE("capture_pulls_on_virtual_clock", "audio_capture") {
+    drivers::capture_audio_driver driver;
+
+    std::size_t frames_pulled = 0;
+    std::unique_ptr<drivers::audio_output_stream> stream = driver.new_output_stream(8000, 1,
+        [&](std::int16_t *buffer, const std::size_t frame_count) {
+            frames_pulled += frame_count;
+            return frame_count;
+        });
+
+    // Nothing is pulled before the stream starts
+    driver.advance(10000);
+    REQUIRE(frames_pulled == 0);
+
+    REQUIRE(stream->start());
+
+    // 1/3 ms does not hold a whole frame at 8000 Hz, the remainder must carry over
+    for (int i = 0; i < 3000; i++) {
+        driver.advance(333);
+    }
+
+    REQUIRE(frames_pulled == 999 * 8);
+
+    const drivers::audio_stream_stats stats = driver.stats();
+    REQUIRE(stats.frames_requested_ == frames_pulled);
+    REQUIRE(stats.underrun_count_ == 0);
+}
+
+TEST_CASE("capture_counts_underruns", "audio_capture") {
+    drivers::capture_audio_driver driver;
+
+    std::unique_ptr<drivers::audio_output_stream> stream = driver.new_output_stream(44100, 2,
+        [&](std::int16_t *buffer, const std::size_t frame_count) {
+            return frame_count / 2;
+        });
+
+    stream->start();
+
+    for (int i = 0; i < 10; i++) {
+        driver.advance(10000);
+    }
+
+    const drivers::audio_stream_stats stats = driver.stats();
+
+    REQUIRE(stats.callback_count_ == 10);
+    REQUIRE(stats.frames_requested_ == 4410);
+    REQUIRE(stats.frames_received_ == 2200);
+    REQUIRE(stats.underrun_count_ == 10);
+}
+
+TEST_CASE("capture_driver_counts_guest_stream_underruns", "audio_capture") {
+    std::unique_ptr<drivers::audio_driver> driver = drivers::make_audio_driver(drivers::audio_driver_backend::capture);
+    REQUIRE(driver);
+
+    // This is how the emulator gets to the virtual clock and the stats
+    drivers::mixer_audio_driver *mixer_driver = static_cast<drivers::mixer_audio_driver *>(driver.get());
+    drivers::capture_audio_driver *capture_driver = static_cast<drivers::capture_audio_driver *>(mixer_driver->backend());
+
+    std::unique_ptr<drivers::audio_output_stream> full = driver->new_output_stream(44100, 2,
+        [&](std::int16_t *buffer, const std::size_t frame_count) {
+            std::fill(buffer, buffer + frame_count * 2, 0);
+            return frame_count;
+        });
+
+    std::unique_ptr<drivers::audio_output_stream> starving = driver->new_output_stream(44100, 2,
+        [&](std::int16_t *buffer, const std::size_t frame_count) {
+            return frame_count / 2;
+        });
+
+    full->start();
+    starving->start();
+
+    for (int i = 0; i < 10; i++) {
+        capture_driver->advance(10000);
+    }
+
+    // The mixed output is always complete, the starving stream still shows up
+    REQUIRE(capture_driver->stats().underrun_count_ == 0);
+
+    const drivers::audio_stream_stats stats = mixer_driver->stats();
+
+    REQUIRE(stats.callback_count_ == 20);
+    REQUIRE(stats.frames_requested_ == 8820);
+    REQUIRE(stats.frames_received_ == 4410 + 2200);
+    REQUIRE(stats.underrun_count_ == 10);
+}
+
+TEST_CASE("capture_writes_wav_on_guest_timeline", "audio_capture") {
+    static const char *CAPTURE_PATH = "audio_capture_test.wav";
+
+    {
+        drivers::capture_audio_driver driver(CAPTURE_PATH);
+        REQUIRE(driver.is_capture_valid());
+
+        std::unique_ptr<drivers::audio_output_stream> stream = driver.new_output_stream(44100, 2,
+            [&](std::int16_t *buffer, const std::size_t frame_count) {
+                std::fill(buffer, buffer + frame_count * 2, 1000);
+                return frame_count;
+            });
+
+        // 100ms of silence, then 100ms of the stream
+        driver.advance(100000);
+        stream->start();
+        driver.advance(100000);
+    }
+
+    std::ifstream wav(CAPTURE_PATH, std::ios::binary);
+    std::vector<std::uint8_t> data((std::istreambuf_iterator<char>(wav)), std::istreambuf_iterator<char>());
+
+    wav.close();
+    std::remove(CAPTURE_PATH);
+
+    REQUIRE(data.size() == 44 + 8820 * 4);
+    REQUIRE(std::memcmp(data.data(), "RIFF", 4) == 0);
+    REQUIRE(std::memcmp(data.data() + 8, "WAVE", 4) == 0);
+    REQUIRE(read_u32_le(data.data() + 24) == 44100);
+    REQUIRE(read_u32_le(data.data() + 40) == 8820 * 4);
+
+    const std::int16_t *samples = reinterpret_cast<const std::int16_t *>(data.data() + 44);
+
+    REQUIRE(samples[0] == 0);
+    REQUIRE(samples[4410 * 2 - 1] == 0);
+    REQUIRE(samples[4410 * 2] == 1000);
+    REQUIRE(samples[8820 * 2 - 1] == 1000);
+}
@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <drivers/audio/backend/dsp_shared.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using namespace eka2l1;
+
+namespace {
+    struct idle_output_stream : public drivers::audio_output_stream {
+        bool start() override {
+            return true;
+        }
+
+        bool stop() override {
+            return true;
+        }
+
+        bool is_playing() override {
+            return false;
+        }
+
+        bool set_volume(const float volume) override {
+            return true;
+        }
+    };
+
+    struct idle_audio_driver : public drivers::audio_driver {
+        std::unique_ptr<drivers::audio_output_stream> new_output_stream(const std::uint32_t sample_rate,
+            const std::uint8_t channels, drivers::data_callback callback) override {
+            return std::make_unique<idle_output_stream>();
+        }
+
+        std::uint32_t native_sample_rate() override {
+            return 1000;
+        }
+    };
+
+    // Decodes each byte to one sample of 100 times its value
+    struct test_dsp_stream : public drivers::dsp_output_stream_shared {
+        std::atomic<int> decode_count_{ 0 };
+
+        explicit test_dsp_stream(drivers::audio_driver *aud)
+            : drivers::dsp_output_stream_shared(aud) {
+            format(drivers::AMR_FOUR_CC_CODE);
+        }
+
+        ~test_dsp_stream() override {
+            stop_decode_worker();
+        }
+
+        void get_supported_formats(std::vector<drivers::four_cc> &cc_list) override {
+            cc_list.push_back(drivers::AMR_FOUR_CC_CODE);
+        }
+
+        void decode_data(const std::uint8_t *data, const std::uint32_t data_size, std::vector<std::uint8_t> &dest) override {
+            dest.resize(data_size * sizeof(std::int16_t));
+            std::int16_t *samples = reinterpret_cast<std::int16_t *>(dest.data());
+
+            for (std::uint32_t i = 0; i < data_size; i++) {
+                samples[i] = static_cast<std::int16_t>(data[i] * 100);
+            }
+
+            decode_count_++;
+        }
+
+        std::uint64_t position_non_pcm16() override {
+            return 0;
+        }
+
+        std::size_t buffered() const {
+            return samples_.size();
+        }
+    };
+
+    template <typename F>
+    bool wait_until(F condition) {
+        for (int i = 0; i < 1000; i++) {
+            if (condition()) {
+                return true;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        return condition();
+    }
+}
+
+TEST_CASE("dsp_decode_worker_decodes_in_order", "dsp") {
+    idle_audio_driver driver;
+    test_dsp_stream stream(&driver);
+
+    REQUIRE(stream.set_properties(1000, 1));
+    stream.decode_ahead(0);
+
+    int copied = 0;
+    stream.register_callback(drivers::dsp_stream_notification_buffer_copied, [&](void *) { copied++; }, nullptr);
+
+    const std::uint8_t first[4] = { 1, 2, 3, 4 };
+    const std::uint8_t second[2] = { 5, 6 };
+
+    REQUIRE(stream.write(first, sizeof(first)));
+    REQUIRE(stream.write(second, sizeof(second)));
+    REQUIRE(wait_until([&]() { return stream.buffered() == 6; }));
+
+    std::int16_t output[6] = {};
+    stream.data_callback(output, 6);
+
+    for (int i = 0; i < 6; i++) {
+        REQUIRE(output[i] == (i + 1) * 100);
+    }
+
+    REQUIRE(copied == 2);
+}
+
+TEST_CASE("dsp_decode_worker_keeps_limited_lead", "dsp") {
+    idle_audio_driver driver;
+    test_dsp_stream stream(&driver);
+
+    REQUIRE(stream.set_properties(1000, 1));
+
+    // 10 samples at 1000 Hz mono
+    stream.decode_ahead(10);
+
+    const std::uint8_t buffer[8] = { 1, 1, 1, 1, 1, 1, 1, 1 };
+
+    for (int i = 0; i < 6; i++) {
+        REQUIRE(stream.write(buffer, sizeof(buffer)));
+    }
+
+    // Two buffers are enough to reach the target, the rest waits
+    REQUIRE(wait_until([&]() { return stream.decode_count_ == 2; }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    REQUIRE(stream.decode_count_ == 2);
+
+    std::int16_t output[16] = {};
+    stream.data_callback(output, 16);
+
+    REQUIRE(wait_until([&]() { return stream.decode_count_ == 4; }));
+}
+
+TEST_CASE("dsp_stop_drops_undecoded_buffers", "dsp") {
+    idle_audio_driver driver;
+    test_dsp_stream stream(&driver);
+
+    REQUIRE(stream.set_properties(1000, 1));
+    stream.decode_ahead(10);
+
+    const std::uint8_t buffer[16] = {};
+
+    for (int i = 0; i < 5; i++) {
+        REQUIRE(stream.write(buffer, sizeof(buffer)));
+    }
+
+    REQUIRE(wait_until([&]() { return stream.decode_count_ == 1; }));
+    REQUIRE(stream.stop());
+
+    // Queue is empty and the worker is idle, so properties may change again
+    REQUIRE(stream.set_properties(2000, 2));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    REQUIRE(stream.decode_count_ == 1);
+}
+
+TEST_CASE("dsp_pcm16_waits_for_room_in_ring", "dsp") {
+    idle_audio_driver driver;
+    test_dsp_stream stream(&driver);
+
+    REQUIRE(stream.format(drivers::PCM16_FOUR_CC_CODE));
+
+    // Ring holds 2 seconds, 2000 samples at 1000 Hz mono
+    REQUIRE(stream.set_properties(1000, 1));
+
+    int copied = 0;
+    stream.register_callback(drivers::dsp_stream_notification_buffer_copied, [&](void *) { copied++; }, nullptr);
+
+    std::vector<std::int16_t> buffers[3];
+
+    for (int i = 0; i < 3; i++) {
+        buffers[i].assign(1000, static_cast<std::int16_t>(i + 1));
+        REQUIRE(stream.write(reinterpret_cast<const std::uint8_t *>(buffers[i].data()), 2000));
+    }
+
+    // The third buffer is not played, nor dropped
+    REQUIRE(stream.buffered() == 2000);
+
+    std::vector<std::int16_t> output(1001);
+    stream.data_callback(output.data(), 1000);
+
+    REQUIRE(copied == 1);
+    REQUIRE(wait_until([&]() { return stream.buffered() == 2000; }));
+
+    stream.data_callback(output.data(), 1001);
+
+    REQUIRE(copied == 3);
+    REQUIRE(output[999] == 2);
+    REQUIRE(output[1000] == 3);
+}
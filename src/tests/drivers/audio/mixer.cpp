@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <drivers/audio/mixer.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace eka2l1;
+
+static drivers::data_callback make_constant_callback(const std::int16_t value, const std::uint8_t channels) {
+    return [=](std::int16_t *buffer, const std::size_t frame_count) {
+        std::fill(buffer, buffer + frame_count * channels, value);
+        return frame_count;
+    };
+}
+
+TEST_CASE("mixer_sums_streams_with_volume", "mixer") {
+    drivers::audio_mixer mixer(44100);
+
+    drivers::mixer_output_stream first(&mixer, 44100, 2, make_constant_callback(8000, 2));
+    drivers::mixer_output_stream second(&mixer, 44100, 1, make_constant_callback(8000, 1));
+    drivers::mixer_output_stream stopped(&mixer, 44100, 2, make_constant_callback(30000, 2));
+
+    first.start();
+    second.start();
+    second.set_volume(0.5f);
+
+    std::vector<std::int16_t> output(256 * 2);
+    REQUIRE(mixer.mix(output.data(), 256) == 256);
+
+    for (const std::int16_t sample : output) {
+        REQUIRE(sample == 12000);
+    }
+}
+
+TEST_CASE("mixer_clamps_overflow", "mixer") {
+    drivers::audio_mixer mixer(44100);
+
+    drivers::mixer_output_stream first(&mixer, 44100, 2, make_constant_callback(30000, 2));
+    drivers::mixer_output_stream second(&mixer, 44100, 2, make_constant_callback(30000, 2));
+    drivers::mixer_output_stream third(&mixer, 44100, 2, make_constant_callback(-30000, 2));
+    drivers::mixer_output_stream fourth(&mixer, 44100, 2, make_constant_callback(-30000, 2));
+
+    std::vector<std::int16_t> output(64 * 2);
+
+    first.start();
+    second.start();
+    mixer.mix(output.data(), 64);
+
+    for (const std::int16_t sample : output) {
+        REQUIRE(sample == 32767);
+    }
+
+    first.stop();
+    second.stop();
+    third.start();
+    fourth.start();
+    mixer.mix(output.data(), 64);
+
+    for (const std::int16_t sample : output) {
+        REQUIRE(sample == -32768);
+    }
+}
+
+TEST_CASE("mixer_resamples_to_output_rate", "mixer") {
+    static constexpr double PI = 3.14159265358979323846;
+    static constexpr double TONE_FREQ = 440.0;
+
+    drivers::audio_mixer mixer(44100);
+
+    std::size_t frames_pulled = 0;
+    drivers::mixer_output_stream stream(&mixer, 22050, 1, [&](std::int16_t *buffer, const std::size_t frame_count) {
+        for (std::size_t i = 0; i < frame_count; i++) {
+            buffer[i] = static_cast<std::int16_t>(16000.0 * std::sin(2.0 * PI * TONE_FREQ * (frames_pulled + i) / 22050.0));
+        }
+
+        frames_pulled += frame_count;
+        return frame_count;
+    });
+
+    stream.start();
+
+    std::vector<std::int16_t> output(512 * 2);
+    std::size_t frames_mixed = 0;
+
+    for (int round = 0; round < 40; round++) {
+        mixer.mix(output.data(), 512);
+        frames_mixed += 512;
+
+        // Both channels carry the mono source
+        for (std::size_t i = 0; i < 512; i++) {
+            REQUIRE(output[i * 2] == output[i * 2 + 1]);
+        }
+
+        if (round == 0) {
+            continue;
+        }
+
+        // The output should follow the tone
+        for (std::size_t i = 0; i < 512; i++) {
+            const double time = (frames_mixed - 512 + i) / 44100.0;
+            const double expected = 16000.0 * std::sin(2.0 * PI * TONE_FREQ * time);
+
+            REQUIRE(std::abs(output[i * 2] - expected) < 200.0);
+        }
+    }
+
+    // Consumption must track the rate ratio, with only a few frames read ahead
+    REQUIRE(frames_pulled >= frames_mixed / 2);
+    REQUIRE(frames_pulled <= frames_mixed / 2 + 4);
+}
+
+TEST_CASE("mixer_stop_waits_for_callback", "mixer") {
+    drivers::audio_mixer mixer(44100);
+
+    std::atomic<bool> in_callback(false);
+    std::atomic<bool> callback_done(false);
+
+    drivers::mixer_output_stream stream(&mixer, 44100, 2, [&](std::int16_t *buffer, const std::size_t frame_count) {
+        in_callback = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        std::fill(buffer, buffer + frame_count * 2, 0);
+        callback_done = true;
+
+        return frame_count;
+    });
+
+    stream.start();
+
+    std::thread mix_thread([&]() {
+        std::vector<std::int16_t> output(64 * 2);
+        mixer.mix(output.data(), 64);
+    });
+
+    while (!in_callback) {
+        std::this_thread::yield();
+    }
+
+    // The callback must not be running anymore once stop returns
+    stream.stop();
+    REQUIRE(callback_done);
+
+    mix_thread.join();
+}
+
+TEST_CASE("mixer_stop_from_callback", "mixer") {
+    drivers::audio_mixer mixer(44100);
+    drivers::mixer_output_stream *self = nullptr;
+
+    drivers::mixer_output_stream stream(&mixer, 44100, 2, [&](std::int16_t *buffer, const std::size_t frame_count) {
+        self->stop();
+        std::fill(buffer, buffer + frame_count * 2, 0);
+
+        return frame_count;
+    });
+
+    self = &stream;
+    stream.start();
+
+    std::vector<std::int16_t> output(64 * 2);
+    mixer.mix(output.data(), 64);
+
+    REQUIRE(!stream.is_playing());
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <drivers/audio/backend/null/audio_null.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+using namespace eka2l1;
+
+static bool wait_until(const std::function<bool()> &cond) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+
+    while (!cond()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    return true;
+}
+
+TEST_CASE("null_stream_stop_from_callback", "audio_null") {
+    drivers::null_audio_driver driver;
+
+    std::atomic<int> calls{ 0 };
+    drivers::audio_output_stream *stream_ptr = nullptr;
+
+    std::unique_ptr<drivers::audio_output_stream> stream = driver.new_output_stream(44100, 2,
+        [&](std::int16_t *buffer, const std::size_t frame_count) {
+            if (++calls == 3) {
+                stream_ptr->stop();
+            }
+
+            return frame_count;
+        });
+
+    stream_ptr = stream.get();
+
+    REQUIRE(stream->start());
+    REQUIRE(wait_until([&]() { return !stream->is_playing(); }));
+
+    // The consumer left its loop, nothing else is pulled
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    REQUIRE(calls == 3);
+
+    // Starting again joins the old consumer and pulls from a new one
+    REQUIRE(stream->start());
+    REQUIRE(wait_until([&]() { return calls > 3; }));
+
+    REQUIRE(stream->stop());
+    REQUIRE_FALSE(stream->is_playing());
+}
@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <drivers/graphics/backend/software/blit_software.h>
+#include <drivers/graphics/backend/software/graphics_software.h>
+#include <drivers/itc.h>
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using namespace eka2l1;
+
+static drivers::software_blend_state make_alpha_blend_state() {
+    drivers::software_blend_state state;
+    state.enabled_ = true;
+    state.rgb_frag_out_factor_ = drivers::blend_factor::frag_out_alpha;
+    state.rgb_current_factor_ = drivers::blend_factor::one_minus_frag_out_alpha;
+    state.a_frag_out_factor_ = drivers::blend_factor::one;
+    state.a_current_factor_ = drivers::blend_factor::one_minus_frag_out_alpha;
+
+    return state;
+}
+
+TEST_CASE("software_blit_row_alpha_blend", "software_graphics") {
+    // Seven pixels: one full SIMD batch and a scalar tail
+    const std::uint32_t sources[4] = {
+        drivers::make_software_pixel(255, 0, 0, 255),
+        drivers::make_software_pixel(255, 255, 255, 0),
+        drivers::make_software_pixel(255, 255, 255, 128),
+        drivers::make_software_pixel(0, 0, 0, 128)
+    };
+
+    const std::uint32_t dests[4] = {
+        drivers::make_software_pixel(0, 0, 255, 255),
+        drivers::make_software_pixel(10, 20, 30, 255),
+        drivers::make_software_pixel(0, 0, 0, 255),
+        drivers::make_software_pixel(255, 255, 255, 255)
+    };
+
+    const std::uint32_t expected[4] = {
+        drivers::make_software_pixel(255, 0, 0, 255),
+        drivers::make_software_pixel(10, 20, 30, 255),
+        drivers::make_software_pixel(128, 128, 128, 255),
+        drivers::make_software_pixel(127, 127, 127, 255)
+    };
+
+    std::vector<std::uint32_t> source(7);
+    std::vector<std::uint32_t> dest(7);
+
+    for (std::size_t i = 0; i < source.size(); i++) {
+        source[i] = sources[i % 4];
+        dest[i] = dests[i % 4];
+    }
+
+    std::vector<std::uint32_t> dest_scalar = dest;
+    const drivers::software_blend_state state = make_alpha_blend_state();
+
+    drivers::software_blit_row(dest.data(), source.data(), nullptr, dest.size(), 0xFFFFFFFF, false, state);
+    drivers::software_blit_row_scalar(dest_scalar.data(), source.data(), nullptr, dest_scalar.size(), 0xFFFFFFFF, false, state);
+
+    for (std::size_t i = 0; i < dest.size(); i++) {
+        REQUIRE(dest[i] == expected[i % 4]);
+        REQUIRE(dest_scalar[i] == expected[i % 4]);
+    }
+}
+
+TEST_CASE("software_blit_row_tint_and_mask", "software_graphics") {
+    const drivers::software_blend_state state;
+    const std::uint32_t tint = drivers::make_software_pixel(255, 128, 0, 255);
+
+    std::vector<std::uint32_t> source(5, drivers::make_software_pixel(200, 100, 50, 255));
+    std::vector<std::uint32_t> mask(5);
+
+    for (std::size_t i = 0; i < mask.size(); i++) {
+        mask[i] = (i % 2 == 0) ? 0xFFFFFFFF : 0;
+    }
+
+    const std::uint32_t tinted = drivers::make_software_pixel(200, 50, 0, 255);
+
+    for (const bool invert : { false, true }) {
+        std::vector<std::uint32_t> dest(5, 0x12345678);
+        std::vector<std::uint32_t> dest_scalar(5, 0x12345678);
+
+        drivers::software_blit_row(dest.data(), source.data(), mask.data(), dest.size(), tint, invert, state);
+        drivers::software_blit_row_scalar(dest_scalar.data(), source.data(), mask.data(), dest_scalar.size(), tint, invert, state);
+
+        for (std::size_t i = 0; i < dest.size(); i++) {
+            const bool visible = ((i % 2 == 0) != invert);
+
+            REQUIRE(dest[i] == (visible ? tinted : 0));
+            REQUIRE(dest_scalar[i] == dest[i]);
+        }
+    }
+}
+
+TEST_CASE("software_fill_row_blend", "software_graphics") {
+    // Longer than a fill batch, and not a multiple of the SIMD width
+    const std::size_t count = 70;
+    const std::uint32_t color = drivers::make_software_pixel(255, 0, 0, 128);
+    const std::uint32_t expected = drivers::make_software_pixel(128, 0, 127, 255);
+
+    const drivers::software_blend_state state = make_alpha_blend_state();
+
+    std::vector<std::uint32_t> dest(count, drivers::make_software_pixel(0, 0, 255, 255));
+    std::vector<std::uint32_t> dest_scalar = dest;
+    std::vector<std::uint32_t> solid(count, color);
+
+    drivers::software_fill_row(dest.data(), color, count, state);
+    drivers::software_blit_row_scalar(dest_scalar.data(), solid.data(), nullptr, count, 0xFFFFFFFF, false, state);
+
+    for (std::size_t i = 0; i < count; i++) {
+        REQUIRE(dest[i] == expected);
+        REQUIRE(dest_scalar[i] == expected);
+    }
+}
+
+namespace {
+    struct software_driver_runner {
+        drivers::software_graphics_driver driver;
+        std::thread driver_thread;
+
+        explicit software_driver_runner()
+            : driver(2)
+            , driver_thread([this]() { driver.run(); }) {
+        }
+
+        ~software_driver_runner() {
+            driver.abort();
+            driver_thread.join();
+        }
+
+        void submit_and_wait(drivers::graphics_command_list &list, drivers::graphics_command_list_builder &builder) {
+            int status = -100;
+            builder.present(&status);
+
+            driver.submit_command_list(list);
+            driver.wait_for(&status);
+        }
+
+        std::uint32_t pixel(const int x, const int y) {
+            return driver.get_swapchain_image().row(y)[x];
+        }
+    };
+}
+
+static const std::uint32_t RED_PIXEL = drivers::make_software_pixel(255, 0, 0, 255);
+static const std::uint32_t BLUE_PIXEL = drivers::make_software_pixel(0, 0, 255, 255);
+
+TEST_CASE("software_driver_fill_clipped", "software_graphics") {
+    software_driver_runner runner;
+
+    auto list = runner.driver.new_command_list();
+    auto builder = runner.driver.new_command_builder(list.get());
+
+    eka2l1::rect clip({ 2, 1 }, { 3, 2 });
+
+    builder->set_swapchain_size({ 8, 4 });
+    builder->set_brush_color_detail({ 255, 0, 0, 255 });
+    builder->draw_rectangle(eka2l1::rect({ 0, 0 }, { 8, 4 }));
+    builder->clip_rect(clip);
+    builder->set_clipping(true);
+    builder->set_brush_color_detail({ 0, 0, 255, 255 });
+    builder->draw_rectangle(eka2l1::rect({ 0, 0 }, { 8, 4 }));
+
+    runner.submit_and_wait(*list, *builder);
+
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 8; x++) {
+            const bool inside = (x >= 2) && (x < 5) && (y >= 1) && (y < 3);
+            REQUIRE(runner.pixel(x, y) == (inside ? BLUE_PIXEL : RED_PIXEL));
+        }
+    }
+}
+
+TEST_CASE("software_driver_restores_backup_state", "software_graphics") {
+    software_driver_runner runner;
+
+    auto list = runner.driver.new_command_list();
+    auto builder = runner.driver.new_command_builder(list.get());
+
+    eka2l1::rect clip({ 1, 1 }, { 2, 2 });
+
+    builder->set_swapchain_size({ 4, 4 });
+    builder->clip_rect(clip);
+    builder->set_clipping(true);
+    builder->backup_state();
+    builder->set_clipping(false);
+    builder->load_backup_state();
+    builder->set_brush_color_detail({ 255, 0, 0, 255 });
+    builder->draw_rectangle(eka2l1::rect({ 0, 0 }, { 4, 4 }));
+
+    runner.submit_and_wait(*list, *builder);
+
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            const bool inside = (x >= 1) && (x < 3) && (y >= 1) && (y < 3);
+            REQUIRE(runner.pixel(x, y) == (inside ? RED_PIXEL : 0));
+        }
+    }
+}
+
+TEST_CASE("software_driver_upload_12bpp", "software_graphics") {
+    software_driver_runner runner;
+
+    const drivers::handle bmp = drivers::create_bitmap(&runner.driver, { 2, 1 });
+    REQUIRE(bmp != 0);
+
+    // EColor4K: red, and a green-blue mix
+    const std::uint16_t pixels[2] = { 0x0F00, 0x00F5 };
+
+    auto list = runner.driver.new_command_list();
+    auto builder = runner.driver.new_command_builder(list.get());
+
+    builder->set_swapchain_size({ 4, 2 });
+    builder->update_bitmap(bmp, 12, reinterpret_cast<const char *>(pixels), sizeof(pixels), { 0, 0 }, { 2, 1 });
+    builder->draw_bitmap(bmp, 0, eka2l1::rect({ 1, 1 }, { 0, 0 }), eka2l1::rect({ 0, 0 }, { 0, 0 }));
+
+    runner.submit_and_wait(*list, *builder);
+
+    REQUIRE(runner.pixel(1, 1) == RED_PIXEL);
+    REQUIRE(runner.pixel(2, 1) == drivers::make_software_pixel(0, 255, 85, 255));
+    REQUIRE(runner.pixel(0, 1) == 0);
+    REQUIRE(runner.pixel(1, 0) == 0);
+}
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <kernel/ipctrace.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <vector>
+
+using namespace eka2l1;
+
+static constexpr const char *TRACE_PATH = "ipctrace_roundtrip.eipc";
+
+TEST_CASE("ipc_trace_round_trip", "ipc_trace") {
+    kernel::ipc_trace_writer writer;
+    writer.begin(1000);
+
+    writer.write_server(0, "!Windowserver");
+    writer.write_server(1, "");
+
+    // Negative and extreme values go through zigzag, large ones need several varint bytes
+    kernel::ipc_trace_send first;
+    first.timestamp_us_ = 1000 + 300;
+    first.server_index_ = 0;
+    first.session_id_ = 0x12345678;
+    first.function_ = std::numeric_limits<std::int32_t>::min();
+    first.args_ = ipc_arg(-1, 0x7FFFFFFF, 0, std::numeric_limits<int>::min(), -1);
+    first.has_status_ = true;
+
+    // Descriptors only in slots 1 and 3, one of them empty. Slot 0 is outside the mask and not written.
+    first.descriptor_mask_ = 0b1010;
+    first.descriptors_[0].max_length_ = 99;
+    first.descriptors_[0].data_ = { 0xDE, 0xAD };
+    first.descriptors_[1].max_length_ = 200;
+    first.descriptors_[1].data_.assign(200, 0x5A);
+    first.descriptors_[3].max_length_ = 16;
+
+    writer.write_send(first);
+
+    kernel::ipc_trace_send second;
+    second.timestamp_us_ = 1000 + 300 + 0x200000;
+    second.server_index_ = 1;
+    second.session_id_ = 0;
+    second.function_ = 77;
+    second.args_ = ipc_arg(5, 6, 7, 8, 0);
+    second.has_status_ = false;
+
+    writer.write_send(second);
+
+    kernel::ipc_trace_complete complete;
+    complete.timestamp_us_ = 1000 + 300 + 0x200000 + 5;
+    complete.sequence_ = 0;
+    complete.code_ = -46;
+
+    writer.write_complete(complete);
+
+    // A timestamp going backwards is stored as no time passing
+    kernel::ipc_trace_complete late_complete;
+    late_complete.timestamp_us_ = 0;
+    late_complete.sequence_ = 300;
+    late_complete.code_ = std::numeric_limits<std::int32_t>::max();
+
+    writer.write_complete(late_complete);
+
+    {
+        std::ofstream out(TRACE_PATH, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(writer.buffer().data()), writer.buffer().size());
+    }
+
+    kernel::ipc_trace_reader reader(TRACE_PATH);
+    REQUIRE(reader.is_valid());
+
+    kernel::ipc_trace_record record;
+
+    REQUIRE(reader.next(record));
+    REQUIRE(record.type_ == kernel::ipc_trace_record_send);
+
+    const kernel::ipc_trace_send &send = record.send_;
+
+    REQUIRE(send.timestamp_us_ == 300);
+    REQUIRE(send.sequence_ == 0);
+    REQUIRE(send.server_index_ == 0);
+    REQUIRE(send.session_id_ == 0x12345678);
+    REQUIRE(send.function_ == std::numeric_limits<std::int32_t>::min());
+    REQUIRE(send.args_.args[0] == -1);
+    REQUIRE(send.args_.args[1] == 0x7FFFFFFF);
+    REQUIRE(send.args_.args[2] == 0);
+    REQUIRE(send.args_.args[3] == std::numeric_limits<int>::min());
+    REQUIRE(send.args_.flag == -1);
+    REQUIRE(send.has_status_);
+    REQUIRE(send.descriptor_mask_ == 0b1010);
+    REQUIRE(send.descriptors_[0].data_.empty());
+    REQUIRE(send.descriptors_[1].max_length_ == 200);
+    REQUIRE(send.descriptors_[1].data_ == std::vector<std::uint8_t>(200, 0x5A));
+    REQUIRE(send.descriptors_[2].data_.empty());
+    REQUIRE(send.descriptors_[3].max_length_ == 16);
+    REQUIRE(send.descriptors_[3].data_.empty());
+
+    REQUIRE(reader.server_name(0) == "!Windowserver");
+    REQUIRE(reader.server_name(1).empty());
+    REQUIRE(reader.server_name(2).empty());
+
+    REQUIRE(reader.next(record));
+    REQUIRE(record.type_ == kernel::ipc_trace_record_send);
+    REQUIRE(record.send_.timestamp_us_ == 300 + 0x200000);
+    REQUIRE(record.send_.sequence_ == 1);
+    REQUIRE(record.send_.server_index_ == 1);
+    REQUIRE(record.send_.function_ == 77);
+    REQUIRE(record.send_.args_.args[3] == 8);
+    REQUIRE(record.send_.args_.flag == 0);
+    REQUIRE_FALSE(record.send_.has_status_);
+    REQUIRE(record.send_.descriptor_mask_ == 0);
+
+    // Descriptors left over from the previous record are cleared
+    REQUIRE(record.send_.descriptors_[1].data_.empty());
+
+    REQUIRE(reader.next(record));
+    REQUIRE(record.type_ == kernel::ipc_trace_record_complete);
+    REQUIRE(record.complete_.timestamp_us_ == 300 + 0x200000 + 5);
+    REQUIRE(record.complete_.sequence_ == 0);
+    REQUIRE(record.complete_.code_ == -46);
+
+    REQUIRE(reader.next(record));
+    REQUIRE(record.type_ == kernel::ipc_trace_record_complete);
+    REQUIRE(record.complete_.timestamp_us_ == 300 + 0x200000 + 5);
+    REQUIRE(record.complete_.sequence_ == 300);
+    REQUIRE(record.complete_.code_ == std::numeric_limits<std::int32_t>::max());
+
+    REQUIRE_FALSE(reader.next(record));
+    REQUIRE(reader.is_valid());
+
+    std::remove(TRACE_PATH);
+}
+
+TEST_CASE("ipc_trace_truncated", "ipc_trace") {
+    kernel::ipc_trace_writer writer;
+    writer.begin(0);
+
+    kernel::ipc_trace_send send;
+    send.timestamp_us_ = 10;
+    send.args_ = ipc_arg(0, 0, 0, 0, 0);
+    send.descriptor_mask_ = 1;
+    send.descriptors_[0].max_length_ = 8;
+    send.descriptors_[0].data_.assign(8, 1);
+
+    writer.write_send(send);
+
+    // Cut inside the descriptor data
+    {
+        std::ofstream out(TRACE_PATH, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(writer.buffer().data()), writer.buffer().size() - 3);
+    }
+
+    kernel::ipc_trace_reader reader(TRACE_PATH);
+    REQUIRE(reader.is_valid());
+
+    kernel::ipc_trace_record record;
+
+    REQUIRE_FALSE(reader.next(record));
+    REQUIRE_FALSE(reader.is_valid());
+
+    std::remove(TRACE_PATH);
+}
@@ -146,3 +146,67 @@ TEST_CASE("no_compress_but_may_contain_unicode_3", "rsc_file") {
     REQUIRE(res_from_eka2l1.size() == res_size);
     REQUIRE(expected_res == res_from_eka2l1);
 }
+
+TEST_CASE("cached_read_matches_direct_read", "rsc_file") {
+    const char *rsc_name = "loaderassets//sample_0xed3e09d5.rsc";
+    symfile f = eka2l1::physical_file_proxy(rsc_name, READ_MODE | BIN_MODE);
+
+    REQUIRE(f);
+
+    std::vector<std::uint8_t> buf;
+    buf.resize(f->size());
+    f->read_file(reinterpret_cast<std::uint8_t *>(&buf[0]), 1, static_cast<std::uint32_t>(buf.size()));
+
+    f->close();
+
+    loader::get_rsc_cache().clear();
+
+    common::ro_buf_stream direct_stream(&buf[0], buf.size());
+    loader::rsc_file direct_rsc(reinterpret_cast<common::ro_stream *>(&direct_stream));
+
+    const std::u16string path = u"Z:\\Resource\\Sample.rsc";
+    const std::uint16_t total_res = 11;
+
+    // Two passes: the first one fills the cache, the second one reads from it
+    for (int pass = 0; pass < 2; pass++) {
+        common::ro_buf_stream stream(&buf[0], buf.size());
+        loader::rsc_file cached_rsc(reinterpret_cast<common::ro_stream *>(&stream), path, 1);
+
+        REQUIRE(cached_rsc.get_total_resources() == total_res);
+
+        for (int i = 1; i <= total_res; i++) {
+            REQUIRE(cached_rsc.read(i) == direct_rsc.read(i));
+        }
+    }
+
+    REQUIRE(loader::get_rsc_cache().resource_memory_usage() > 0);
+
+    // Path is matched case-insensitively, a different modification time is another file
+    std::vector<std::uint8_t> data;
+    REQUIRE(loader::get_rsc_cache().get_resource(u"z:\\resource\\sample.rsc", 1, 1, data));
+    REQUIRE(data == direct_rsc.read(1));
+    REQUIRE(!loader::get_rsc_cache().get_resource(path, 2, 1, data));
+
+    loader::get_rsc_cache().clear();
+    REQUIRE(loader::get_rsc_cache().resource_memory_usage() == 0);
+}
+
+TEST_CASE("cache_evicts_least_recently_used_resource", "rsc_file") {
+    loader::rsc_cache cache(4, 16);
+
+    const std::vector<std::uint8_t> res(8, 0xCC);
+    std::vector<std::uint8_t> data;
+
+    cache.put_resource(u"a.rsc", 0, 1, res);
+    cache.put_resource(u"a.rsc", 0, 2, res);
+
+    // Touch the first one, so the second one is the oldest
+    REQUIRE(cache.get_resource(u"a.rsc", 0, 1, data));
+
+    cache.put_resource(u"a.rsc", 0, 3, res);
+
+    REQUIRE(cache.resource_memory_usage() == 16);
+    REQUIRE(cache.get_resource(u"a.rsc", 0, 1, data));
+    REQUIRE(!cache.get_resource(u"a.rsc", 0, 2, data));
+    REQUIRE(cache.get_resource(u"a.rsc", 0, 3, data));
+}
@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+
+#include <common/flate.h>
+#include <fmt/format.h>
+#include <manager/sis_script_interpreter.h>
+
+#include <map>
+#include <mutex>
+
+using namespace eka2l1;
+
+static loader::sis_extract_job make_extract_job(const std::string &path, const std::uint64_t size) {
+    loader::sis_extract_job job;
+    job.path = path;
+    job.data_idx = 0;
+    job.block_idx = 0;
+    job.size = size;
+
+    return job;
+}
+
+TEST_CASE("sis_extract_plan_largest_first", "sis") {
+    std::vector<loader::sis_extract_job> jobs = {
+        make_extract_job("small.txt", 10),
+        make_extract_job("first_big.dat", 300),
+        make_extract_job("medium.rsc", 50),
+        make_extract_job("second_big.dat", 300)
+    };
+
+    REQUIRE(loader::plan_sis_extract_jobs(jobs) == 660);
+
+    REQUIRE(jobs[0].path == "first_big.dat");
+    REQUIRE(jobs[1].path == "second_big.dat");
+    REQUIRE(jobs[2].path == "medium.rsc");
+    REQUIRE(jobs[3].path == "small.txt");
+}
+
+TEST_CASE("sis_extract_progress_per_chunk", "sis") {
+    std::vector<loader::sis_extract_job> jobs = { make_extract_job("app.exe", 400) };
+
+    std::atomic<int> progress{ 0 };
+    std::vector<int> progress_seen;
+
+    const bool result = loader::run_sis_extract_jobs(jobs, [&](const loader::sis_extract_job &job, const loader::sis_extract_chunk_done_func &chunk_done) {
+        for (int i = 0; i < 4; i++) {
+            chunk_done(100);
+            progress_seen.push_back(progress.load());
+        }
+
+        return true;
+    }, progress);
+
+    REQUIRE(result);
+    REQUIRE(progress_seen == std::vector<int>{ 25, 50, 75, 100 });
+}
+
+TEST_CASE("sis_extract_runs_every_job_once", "sis") {
+    std::vector<loader::sis_extract_job> jobs;
+
+    for (int i = 0; i < 32; i++) {
+        jobs.push_back(make_extract_job(fmt::format("file{}.dat", i), 1000 + i * 10));
+    }
+
+    std::mutex extracted_lock;
+    std::map<std::string, int> extracted;
+
+    std::atomic<int> progress{ 0 };
+
+    const bool result = loader::run_sis_extract_jobs(jobs, [&](const loader::sis_extract_job &job, const loader::sis_extract_chunk_done_func &chunk_done) {
+        for (std::uint64_t left = job.size; left > 0;) {
+            const std::uint64_t chunk = std::min<std::uint64_t>(left, 256);
+            chunk_done(chunk);
+
+            left -= chunk;
+        }
+
+        const std::lock_guard<std::mutex> guard(extracted_lock);
+        extracted[job.path]++;
+
+        return true;
+    }, progress);
+
+    REQUIRE(result);
+    REQUIRE(progress == 100);
+    REQUIRE(extracted.size() == 32);
+
+    for (auto &[path, count] : extracted) {
+        REQUIRE(count == 1);
+    }
+}
+
+TEST_CASE("sis_extract_reports_failure", "sis") {
+    std::vector<loader::sis_extract_job> jobs = {
+        make_extract_job("good.dat", 100),
+        make_extract_job("bad.dat", 100),
+        make_extract_job("other.dat", 100)
+    };
+
+    std::atomic<int> progress{ 0 };
+    std::atomic<int> run_count{ 0 };
+
+    const bool result = loader::run_sis_extract_jobs(jobs, [&](const loader::sis_extract_job &job, const loader::sis_extract_chunk_done_func &chunk_done) {
+        run_count++;
+        chunk_done(job.size);
+
+        return job.path != "bad.dat";
+    }, progress);
+
+    // One failure does not stop the others
+    REQUIRE_FALSE(result);
+    REQUIRE(run_count == 3);
+}
+
+static std::vector<std::uint8_t> inflate_in_sis_chunks(std::vector<std::uint8_t> &deflated, bool &result) {
+    mz_stream stream{};
+    REQUIRE(inflateInit(&stream) == MZ_OK);
+
+    std::vector<std::uint8_t> out_buf(CHUNK_MAX_INFLATED_SIZE);
+    std::vector<std::uint8_t> inflated;
+
+    result = true;
+
+    for (std::size_t offset = 0; (offset < deflated.size()) && result; offset += CHUNK_SIZE) {
+        const std::uint32_t grab = static_cast<std::uint32_t>(std::min<std::size_t>(deflated.size() - offset, CHUNK_SIZE));
+
+        result = loader::inflate_sis_chunk(stream, &deflated[offset], grab, out_buf, [&](const std::uint8_t *data, const std::uint32_t size) {
+            inflated.insert(inflated.end(), data, data + size);
+        });
+    }
+
+    inflateEnd(&stream);
+    return inflated;
+}
+
+static std::vector<std::uint8_t> deflate_for_test(const std::vector<std::uint8_t> &data) {
+    mz_ulong deflated_size = mz_compressBound(static_cast<mz_ulong>(data.size()));
+    std::vector<std::uint8_t> deflated(deflated_size);
+
+    REQUIRE(mz_compress(deflated.data(), &deflated_size, data.data(), static_cast<mz_ulong>(data.size())) == MZ_OK);
+    deflated.resize(deflated_size);
+
+    return deflated;
+}
+
+TEST_CASE("sis_inflate_chunk_over_output_buffer", "sis") {
+    // Zeroes deflate so well that the first chunk alone inflates to many times the output buffer
+    const std::vector<std::uint8_t> original(CHUNK_MAX_INFLATED_SIZE * 12 + 123, 0);
+    std::vector<std::uint8_t> deflated = deflate_for_test(original);
+
+    REQUIRE(deflated.size() < CHUNK_SIZE);
+
+    bool result = false;
+    const std::vector<std::uint8_t> inflated = inflate_in_sis_chunks(deflated, result);
+
+    REQUIRE(result);
+    REQUIRE(inflated == original);
+}
+
+TEST_CASE("sis_inflate_chunk_many_chunks", "sis") {
+    std::vector<std::uint8_t> original(CHUNK_SIZE * 20);
+    std::uint32_t seed = 0x1234567;
+
+    // Poorly compressible, so the deflated data spans many chunks
+    for (std::uint8_t &b : original) {
+        seed = seed * 1103515245 + 12345;
+        b = static_cast<std::uint8_t>(seed >> 16);
+    }
+
+    std::vector<std::uint8_t> deflated = deflate_for_test(original);
+    REQUIRE(deflated.size() > CHUNK_SIZE * 4);
+
+    bool result = false;
+    const std::vector<std::uint8_t> inflated = inflate_in_sis_chunks(deflated, result);
+
+    REQUIRE(result);
+    REQUIRE(inflated == original);
+}
+
+TEST_CASE("sis_inflate_chunk_corrupted", "sis") {
+    std::vector<std::uint8_t> deflated = deflate_for_test(std::vector<std::uint8_t>(4096, 7));
+
+    // Break the zlib header
+    deflated[0] = 0xFF;
+    deflated[1] = 0xFF;
+
+    bool result = true;
+    inflate_in_sis_chunks(deflated, result);
+
+    REQUIRE_FALSE(result);
+}
@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <services/applist/applist.h>
+#include <vfs/vfs.h>
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <filesystem>
+
+using namespace eka2l1;
+
+static entry_info make_registration_entry(const std::string &path) {
+    entry_info entry{};
+    entry.name = path.substr(path.find_last_of('\\') + 1);
+    entry.full_path = path;
+    entry.type = io_component_type::file;
+
+    return entry;
+}
+
+static std::vector<std::string> get_picked_paths(const std::vector<entry_info> &entries, const language lang) {
+    std::vector<std::string> paths;
+
+    for (const entry_info *entry : pick_nearest_lang_entries(entries, lang)) {
+        paths.push_back(entry->full_path);
+    }
+
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+TEST_CASE("pick_nearest_lang_prefers_ideal_language", "applist") {
+    const std::vector<entry_info> entries = {
+        make_registration_entry("Z:\\Private\\10003a3f\\import\\apps\\calc_reg.rsc"),
+        make_registration_entry("Z:\\Private\\10003a3f\\import\\apps\\calc_reg.r02"),
+        make_registration_entry("Z:\\Private\\10003a3f\\import\\apps\\calc_reg.r03")
+    };
+
+    REQUIRE(get_picked_paths(entries, language::fr) == std::vector<std::string>{ "Z:\\Private\\10003a3f\\import\\apps\\calc_reg.r02" });
+    REQUIRE(get_picked_paths(entries, language::de) == std::vector<std::string>{ "Z:\\Private\\10003a3f\\import\\apps\\calc_reg.r03" });
+}
+
+TEST_CASE("pick_nearest_lang_falls_back", "applist") {
+    const std::vector<entry_info> entries = {
+        // No German variant, fall back to .rsc
+        make_registration_entry("Z:\\Private\\10003a3f\\import\\apps\\calc_reg.r02"),
+        make_registration_entry("Z:\\Private\\10003a3f\\import\\apps\\CALC_REG.RSC"),
+
+        // No German variant and no .rsc, the first variant listed is taken
+        make_registration_entry("Z:\\Private\\10003a3f\\import\\apps\\clock_reg.r05"),
+        make_registration_entry("Z:\\Private\\10003a3f\\import\\apps\\clock_reg.r02"),
+
+        // Only one variant
+        make_registration_entry("Z:\\Private\\10003a3f\\import\\apps\\notes_reg.r03")
+    };
+
+    REQUIRE(get_picked_paths(entries, language::de) == std::vector<std::string>{
+        "Z:\\Private\\10003a3f\\import\\apps\\CALC_REG.RSC",
+        "Z:\\Private\\10003a3f\\import\\apps\\clock_reg.r05",
+        "Z:\\Private\\10003a3f\\import\\apps\\notes_reg.r03"
+    });
+}
+
+static apa_app_registry make_test_registration(const std::uint32_t uid, const std::u16string &name) {
+    apa_app_registry reg;
+    reg.mandatory_info.uid = uid;
+    reg.mandatory_info.app_path.assign(nullptr, u"Z:\\sys\\bin\\" + name + u".exe");
+    reg.mandatory_info.short_caption.assign(nullptr, name);
+    reg.mandatory_info.long_caption.assign(nullptr, name + u" long");
+
+    reg.caps.is_hidden = true;
+    reg.caps.group_name.assign(nullptr, u"Tools");
+
+    reg.rsc_path = u"Z:\\Private\\10003a3f\\import\\apps\\" + name + u"_reg.rsc";
+    reg.localised_info_rsc_path = u"Z:\\Resource\\Apps\\" + name + u"_loc.rsc";
+    reg.localised_info_rsc_id = 2;
+    reg.default_screen_number = 1;
+    reg.icon_count = 3;
+    reg.icon_file_path = u"Z:\\Resource\\Apps\\" + name + u".mif";
+
+    reg.data_types.push_back({ 10, "text/plain" });
+    reg.view_datas.push_back({ 0x1000, 1, 2, u"View" });
+    reg.ownership_list.push_back(u"C:\\Data\\" + name + u".dat");
+
+    reg.rsc_size = 128;
+    reg.rsc_last_write = 1000;
+    reg.localised_info_rsc_resolved_path = u"Z:\\Resource\\Apps\\" + name + u"_loc.r02";
+    reg.localised_info_rsc_size = 64;
+    reg.localised_info_rsc_last_write = 2000;
+
+    return reg;
+}
+
+static std::string get_app_registry_cache_path(const std::string &name) {
+    const std::filesystem::path folder = std::filesystem::temp_directory_path() / "eka2l1_applistcache";
+    std::filesystem::create_directories(folder);
+
+    return (folder / name).string();
+}
+
+TEST_CASE("app_registry_cache_round_trip", "applist") {
+    const std::string path = get_app_registry_cache_path("roundtrip.bin");
+
+    std::vector<apa_app_registry> regs;
+    regs.push_back(make_test_registration(0x10005902, u"Calc"));
+    regs.push_back(make_test_registration(0x10005903, u"Clock"));
+
+    save_app_registry_cache(path, language::fr, regs);
+
+    std::vector<apa_app_registry> loaded;
+    const bool result = load_app_registry_cache(path, language::fr, loaded);
+
+    std::filesystem::remove(path);
+
+    REQUIRE(result);
+    REQUIRE(loaded.size() == 2);
+
+    apa_app_registry &reg = loaded[1];
+
+    REQUIRE(reg.mandatory_info.uid == 0x10005903);
+    REQUIRE(reg.mandatory_info.app_path.to_std_string(nullptr) == u"Z:\\sys\\bin\\Clock.exe");
+    REQUIRE(reg.mandatory_info.short_caption.to_std_string(nullptr) == u"Clock");
+    REQUIRE(reg.mandatory_info.long_caption.to_std_string(nullptr) == u"Clock long");
+    REQUIRE(reg.caps.is_hidden);
+    REQUIRE(reg.caps.group_name.to_std_string(nullptr) == u"Tools");
+
+    REQUIRE(reg.rsc_path == u"Z:\\Private\\10003a3f\\import\\apps\\Clock_reg.rsc");
+    REQUIRE(reg.localised_info_rsc_path == u"Z:\\Resource\\Apps\\Clock_loc.rsc");
+    REQUIRE(reg.localised_info_rsc_id == 2);
+    REQUIRE(reg.default_screen_number == 1);
+    REQUIRE(reg.icon_count == 3);
+    REQUIRE(reg.icon_file_path == u"Z:\\Resource\\Apps\\Clock.mif");
+
+    REQUIRE(reg.data_types.size() == 1);
+    REQUIRE(reg.data_types[0].priority_ == 10);
+    REQUIRE(reg.data_types[0].type_ == "text/plain");
+
+    REQUIRE(reg.view_datas.size() == 1);
+    REQUIRE(reg.view_datas[0].uid_ == 0x1000);
+    REQUIRE(reg.view_datas[0].screen_mode_ == 1);
+    REQUIRE(reg.view_datas[0].icon_count_ == 2);
+    REQUIRE(reg.view_datas[0].caption_ == u"View");
+
+    REQUIRE(reg.ownership_list == file_ownership_list{ u"C:\\Data\\Clock.dat" });
+
+    // Validation info for the next boot
+    REQUIRE(reg.rsc_size == 128);
+    REQUIRE(reg.rsc_last_write == 1000);
+    REQUIRE(reg.localised_info_rsc_resolved_path == u"Z:\\Resource\\Apps\\Clock_loc.r02");
+    REQUIRE(reg.localised_info_rsc_size == 64);
+    REQUIRE(reg.localised_info_rsc_last_write == 2000);
+}
+
+TEST_CASE("app_registry_cache_rejects_other_language", "applist") {
+    const std::string path = get_app_registry_cache_path("language.bin");
+
+    std::vector<apa_app_registry> regs;
+    regs.push_back(make_test_registration(0x10005902, u"Calc"));
+
+    save_app_registry_cache(path, language::fr, regs);
+
+    std::vector<apa_app_registry> loaded;
+    const bool result = load_app_registry_cache(path, language::de, loaded);
+
+    std::filesystem::remove(path);
+
+    REQUIRE_FALSE(result);
+    REQUIRE(loaded.empty());
+}
+
+TEST_CASE("app_registry_cache_rejects_truncated", "applist") {
+    const std::string path = get_app_registry_cache_path("truncated.bin");
+
+    std::vector<apa_app_registry> regs;
+    regs.push_back(make_test_registration(0x10005902, u"Calc"));
+
+    save_app_registry_cache(path, language::fr, regs);
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+
+    std::vector<apa_app_registry> loaded;
+    const bool result = load_app_registry_cache(path, language::fr, loaded);
+
+    std::filesystem::remove(path);
+
+    REQUIRE_FALSE(result);
+    REQUIRE(loaded.empty());
+}
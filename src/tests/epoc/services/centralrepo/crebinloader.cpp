@@ -23,6 +23,7 @@
 
 #include <common/chunkyseri.h>
 
+#include <cstring>
 #include <fstream>
 
 using namespace eka2l1;
@@ -52,4 +53,59 @@ TEST_CASE("generic_cre_loading", "centralrepo") {
     REQUIRE(repo.uid == 0x101F876F);
     REQUIRE(repo.entries.size() == 19);
     REQUIRE(repo.single_policies.size() == 19);
-}
\ No newline at end of file
+}
+TEST_CASE("cre_reals_old_float_layout", "centralrepo") {
+    central_repo repo;
+    repo.ver = 0;
+    repo.keyspace_type = 0;
+    repo.uid = 0xEFFF0002;
+    repo.owner_uid = 0;
+
+    central_repo_entry_variant var{};
+    var.etype = central_repo_entry_type::real;
+    var.reald = 0.1;
+
+    REQUIRE(repo.add_new_entry(7, var, 0));
+
+    std::vector<std::uint8_t> buf;
+
+    {
+        common::chunkyseri seri(nullptr, 0, common::SERI_MODE_MEASURE);
+        do_state_for_cre(seri, repo);
+
+        buf.resize(seri.size());
+    }
+
+    common::chunkyseri seri(&buf[0], buf.size(), common::SERI_MODE_WRITE);
+    do_state_for_cre(seri, repo);
+
+    std::uint32_t uid2 = 0;
+    std::memcpy(&uid2, &buf[4], sizeof(uid2));
+
+    REQUIRE(uid2 == CRE_REAL64_MARKER_UID);
+
+    // The marker keeps the 8-byte layout, even when the file may be an old one
+    {
+        central_repo new_repo;
+        common::chunkyseri read_seri(&buf[0], buf.size(), common::SERI_MODE_READ);
+
+        REQUIRE(do_state_for_cre(read_seri, new_repo, true) == 0);
+        REQUIRE(new_repo.find_entry(7));
+        REQUIRE(new_repo.find_entry(7)->data.reald == 0.1);
+    }
+
+    // Make the old layout: no marker, and the real (last in the file for version 0) as a float
+    std::vector<std::uint8_t> old_buf(buf.begin(), buf.end() - sizeof(double));
+    const float old_real = 0.1f;
+
+    old_buf.insert(old_buf.end(), reinterpret_cast<const std::uint8_t *>(&old_real),
+        reinterpret_cast<const std::uint8_t *>(&old_real) + sizeof(float));
+    std::memset(&old_buf[4], 0, sizeof(std::uint32_t));
+
+    central_repo old_repo;
+    common::chunkyseri read_seri(&old_buf[0], old_buf.size(), common::SERI_MODE_READ);
+
+    REQUIRE(do_state_for_cre(read_seri, old_repo, true) == 0);
+    REQUIRE(old_repo.find_entry(7));
+    REQUIRE(old_repo.find_entry(7)->data.reald == static_cast<double>(old_real));
+}
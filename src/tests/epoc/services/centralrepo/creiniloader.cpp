@@ -20,7 +20,12 @@
 
 #include <catch2/catch.hpp>
 #include <services/centralrepo/centralrepo.h>
+#include <services/centralrepo/cre.h>
 
+#include <common/chunkyseri.h>
+
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 
 using namespace eka2l1;
@@ -60,4 +65,123 @@ TEST_CASE("ini_loader_meta_default_and_range", "centralrepo") {
 
     REQUIRE(e1->metadata_val == 10);
     REQUIRE(e2->metadata_val == 12);
-}
\ No newline at end of file
+}
+
+TEST_CASE("ini_loader_compiled_cache", "centralrepo") {
+    const std::filesystem::path cache_folder = std::filesystem::temp_directory_path() / "eka2l1_centralrepocache";
+    std::filesystem::remove_all(cache_folder);
+
+    central_repo parsed_repo;
+    parsed_repo.uid = 0xEFFF0000;
+
+    // First load compiles to the cache
+    REQUIRE(parse_new_centrep_ini_cached("centralrepoassets/EFFF0000.ini", cache_folder.string() + "/", parsed_repo));
+
+    std::vector<std::filesystem::path> cache_files;
+
+    for (const auto &entry : std::filesystem::directory_iterator(cache_folder)) {
+        cache_files.push_back(entry.path());
+    }
+
+    REQUIRE(cache_files.size() == 1);
+
+    // Mark the compiled repository, so the second load shows whether it came from the cache
+    {
+        std::ifstream cache_stream(cache_files[0], std::ios::binary);
+        std::vector<std::uint8_t> buf((std::istreambuf_iterator<char>(cache_stream)), std::istreambuf_iterator<char>());
+
+        central_repo marked_repo;
+        common::chunkyseri read_seri(&buf[0], buf.size(), common::SERI_MODE_READ);
+
+        REQUIRE(do_state_for_cre(read_seri, marked_repo) == 0);
+        REQUIRE(marked_repo.find_entry(78));
+
+        marked_repo.find_entry(78)->metadata_val = 99;
+
+        common::chunkyseri write_seri(&buf[0], buf.size(), common::SERI_MODE_WRITE);
+        REQUIRE(do_state_for_cre(write_seri, marked_repo) == 0);
+
+        cache_stream.close();
+
+        std::ofstream out_stream(cache_files[0], std::ios::binary);
+        out_stream.write(reinterpret_cast<const char *>(buf.data()), buf.size());
+    }
+
+    central_repo cached_repo;
+    cached_repo.uid = 0xEFFF0000;
+
+    REQUIRE(parse_new_centrep_ini_cached("centralrepoassets/EFFF0000.ini", cache_folder.string() + "/", cached_repo));
+    std::filesystem::remove_all(cache_folder);
+
+    REQUIRE(cached_repo.entries.size() == parsed_repo.entries.size());
+
+    central_repo_entry *e2 = cached_repo.find_entry(13);
+    central_repo_entry *e3 = cached_repo.find_entry(78);
+
+    REQUIRE(e2);
+    REQUIRE(e3);
+
+    REQUIRE(e2->data.etype == central_repo_entry_type::real);
+    REQUIRE(e2->data.reald == 5.7);
+    REQUIRE(e3->metadata_val == 99);
+}
+
+TEST_CASE("ini_loader_compiled_cache_prunes_stale", "centralrepo") {
+    const std::filesystem::path cache_folder = std::filesystem::temp_directory_path() / "eka2l1_centralrepocache_prune";
+    std::filesystem::remove_all(cache_folder);
+    std::filesystem::create_directories(cache_folder);
+
+    // A cache of an older version of the same INI, and one of another repository
+    const std::filesystem::path stale_path = cache_folder / "efff0000_0000000000000001.cre";
+    const std::filesystem::path other_path = cache_folder / "efff0001_0000000000000001.cre";
+
+    std::ofstream(stale_path, std::ios::binary) << "stale";
+    std::ofstream(other_path, std::ios::binary) << "other";
+
+    central_repo repo;
+    repo.uid = 0xEFFF0000;
+
+    REQUIRE(parse_new_centrep_ini_cached("centralrepoassets/EFFF0000.ini", cache_folder.string() + "/", repo));
+
+    const bool stale_exists = std::filesystem::exists(stale_path);
+    const bool other_exists = std::filesystem::exists(other_path);
+
+    std::size_t file_count = 0;
+
+    for (const auto &entry : std::filesystem::directory_iterator(cache_folder)) {
+        file_count++;
+    }
+
+    std::filesystem::remove_all(cache_folder);
+
+    REQUIRE_FALSE(stale_exists);
+    REQUIRE(other_exists);
+    REQUIRE(file_count == 2);
+}
+
+TEST_CASE("entries_sorted_and_filtered", "centralrepo") {
+    central_repo repo;
+    central_repo_entry_variant var{};
+    var.etype = central_repo_entry_type::integer;
+
+    const std::uint32_t keys[] = { 0x02000010, 0x01000002, 0x02000001, 0x03000000, 0x01000001 };
+
+    for (const std::uint32_t key : keys) {
+        REQUIRE(repo.add_new_entry(key, var, 0));
+    }
+
+    REQUIRE_FALSE(repo.add_new_entry(0x02000001, var, 0));
+    REQUIRE(repo.entries.size() == 5);
+
+    for (std::size_t i = 1; i < repo.entries.size(); i++) {
+        REQUIRE(repo.entries[i - 1].key < repo.entries[i].key);
+    }
+
+    REQUIRE(repo.find_entry(0x03000000));
+    REQUIRE_FALSE(repo.find_entry(0x03000001));
+
+    auto [range_begin, range_end] = repo.entries_in_filter_range(0x02000000, 0xFF000000);
+
+    REQUIRE(std::distance(range_begin, range_end) == 2);
+    REQUIRE(range_begin->key == 0x02000001);
+}
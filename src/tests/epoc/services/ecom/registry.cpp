@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <services/ecom/registry.h>
+#include <vfs/vfs.h>
+
+#include <filesystem>
+#include <fstream>
+
+using namespace eka2l1;
+
+static entry_info make_plugin_entry(const std::string &path, const std::size_t size, const std::uint64_t last_write) {
+    entry_info entry{};
+    entry.name = path.substr(path.find_last_of('\\') + 1);
+    entry.full_path = path;
+    entry.size = size;
+    entry.last_write = last_write;
+
+    return entry;
+}
+
+static std::vector<entry_info> make_plugin_entries() {
+    return { make_plugin_entry("Z:\\Resource\\Plugins\\aknskins.rsc", 120, 1000),
+        make_plugin_entry("Z:\\Resource\\Plugins\\mtmuis.rsc", 64, 2000),
+        make_plugin_entry("E:\\Resource\\Plugins\\game.r01", 32, 3000) };
+}
+
+static void make_test_registry(ecom_interface_map &interfaces, std::vector<ecom_implementation_info_ptr> &implementations) {
+    auto add_impl = [&](const std::uint32_t interface_uid, const std::uint32_t uid, const std::u16string &name) {
+        auto impl = std::make_shared<ecom_implementation_info>();
+        impl->original_name = u"plugin";
+        impl->uid = uid;
+        impl->version = 2;
+        impl->format = 3;
+        impl->display_name = name;
+        impl->default_data = "text/plain";
+        impl->opaque_data = "opaque";
+        impl->flags = ecom_implementation_info::FLAG_ROM_BASED | ecom_implementation_info::FLAG_IMPL_CREATE_INFO_CACHED;
+        impl->drv = drive_z;
+        impl->extended_interfaces = { 0x10009D8F, 0x1000A0E3 };
+
+        interfaces[interface_uid].uid = interface_uid;
+        interfaces[interface_uid].implementations.push_back(impl);
+        implementations.push_back(impl);
+    };
+
+    add_impl(0x101F8A0C, 0x20000002, u"Second");
+    add_impl(0x101F8A0C, 0x20000001, u"First");
+    add_impl(0x10201A00, 0x20000003, u"Third");
+}
+
+static std::string get_registry_cache_path(const std::string &name) {
+    const std::filesystem::path folder = std::filesystem::temp_directory_path() / "eka2l1_ecomcache";
+    std::filesystem::create_directories(folder);
+
+    return (folder / name).string();
+}
+
+TEST_CASE("plugin_fingerprint_ignores_entry_order", "ecom") {
+    std::vector<entry_info> entries = make_plugin_entries();
+    const std::uint64_t fingerprint = make_ecom_plugin_fingerprint(1, 0x94, entries);
+
+    std::swap(entries[0], entries[2]);
+    REQUIRE(make_ecom_plugin_fingerprint(1, 0x94, entries) == fingerprint);
+
+    // Case of the path does not matter either
+    entries[1].full_path = "z:\\resource\\plugins\\MTMUIS.RSC";
+    REQUIRE(make_ecom_plugin_fingerprint(1, 0x94, entries) == fingerprint);
+}
+
+TEST_CASE("plugin_fingerprint_changes_with_plugins", "ecom") {
+    const std::vector<entry_info> entries = make_plugin_entries();
+    const std::uint64_t fingerprint = make_ecom_plugin_fingerprint(1, 0x94, entries);
+
+    std::vector<entry_info> resized = entries;
+    resized[1].size++;
+
+    std::vector<entry_info> rewritten = entries;
+    rewritten[2].last_write++;
+
+    std::vector<entry_info> removed = entries;
+    removed.pop_back();
+
+    std::vector<entry_info> added = entries;
+    added.push_back(make_plugin_entry("C:\\Resource\\Plugins\\new.rsc", 16, 4000));
+
+    REQUIRE(make_ecom_plugin_fingerprint(1, 0x94, resized) != fingerprint);
+    REQUIRE(make_ecom_plugin_fingerprint(1, 0x94, rewritten) != fingerprint);
+    REQUIRE(make_ecom_plugin_fingerprint(1, 0x94, removed) != fingerprint);
+    REQUIRE(make_ecom_plugin_fingerprint(1, 0x94, added) != fingerprint);
+    REQUIRE(make_ecom_plugin_fingerprint(2, 0x94, entries) != fingerprint);
+    REQUIRE(make_ecom_plugin_fingerprint(1, 0x9B, entries) != fingerprint);
+}
+
+TEST_CASE("registry_cache_round_trip", "ecom") {
+    const std::string path = get_registry_cache_path("roundtrip.bin");
+
+    ecom_interface_map interfaces;
+    std::vector<ecom_implementation_info_ptr> implementations;
+
+    make_test_registry(interfaces, implementations);
+    save_ecom_registry_cache(path, 0xDEADBEEF, interfaces, implementations);
+
+    ecom_interface_map loaded_interfaces;
+    std::vector<ecom_implementation_info_ptr> loaded_implementations;
+
+    const bool loaded = load_ecom_registry_cache(path, 0xDEADBEEF, loaded_interfaces, loaded_implementations);
+    std::filesystem::remove(path);
+
+    REQUIRE(loaded);
+    REQUIRE(loaded_interfaces.size() == 2);
+    REQUIRE(loaded_implementations.size() == 3);
+
+    // Sorted by UID, so implementation lookups can binary search
+    REQUIRE(loaded_implementations[0]->uid == 0x20000001);
+    REQUIRE(loaded_implementations[1]->uid == 0x20000002);
+    REQUIRE(loaded_implementations[2]->uid == 0x20000003);
+
+    const ecom_interface_info &interface = loaded_interfaces[0x101F8A0C];
+    REQUIRE(interface.uid == 0x101F8A0C);
+    REQUIRE(interface.implementations.size() == 2);
+
+    const ecom_implementation_info_ptr &impl = interface.implementations[1];
+    REQUIRE(impl->uid == 0x20000001);
+    REQUIRE(impl->original_name == u"plugin");
+    REQUIRE(impl->version == 2);
+    REQUIRE(impl->format == 3);
+    REQUIRE(impl->display_name == u"First");
+    REQUIRE(impl->default_data == "text/plain");
+    REQUIRE(impl->opaque_data == "opaque");
+    REQUIRE(impl->drv == drive_z);
+    REQUIRE(impl->extended_interfaces == std::vector<std::uint32_t>{ 0x10009D8F, 0x1000A0E3 });
+
+    // Creation info must be resolved again against the loaded DLL
+    REQUIRE(impl->flags == ecom_implementation_info::FLAG_ROM_BASED);
+
+    // Interfaces and the implementation list share the same objects
+    REQUIRE(impl == loaded_implementations[0]);
+}
+
+TEST_CASE("registry_cache_rejects_other_fingerprint", "ecom") {
+    const std::string path = get_registry_cache_path("fingerprint.bin");
+
+    ecom_interface_map interfaces;
+    std::vector<ecom_implementation_info_ptr> implementations;
+
+    make_test_registry(interfaces, implementations);
+    save_ecom_registry_cache(path, 0xDEADBEEF, interfaces, implementations);
+
+    ecom_interface_map loaded_interfaces;
+    std::vector<ecom_implementation_info_ptr> loaded_implementations;
+
+    const bool loaded = load_ecom_registry_cache(path, 0xCAFEBABE, loaded_interfaces, loaded_implementations);
+    std::filesystem::remove(path);
+
+    REQUIRE_FALSE(loaded);
+    REQUIRE(loaded_interfaces.empty());
+    REQUIRE(loaded_implementations.empty());
+}
+
+TEST_CASE("registry_cache_rejects_truncated", "ecom") {
+    const std::string path = get_registry_cache_path("truncated.bin");
+
+    ecom_interface_map interfaces;
+    std::vector<ecom_implementation_info_ptr> implementations;
+
+    make_test_registry(interfaces, implementations);
+    save_ecom_registry_cache(path, 0xDEADBEEF, interfaces, implementations);
+
+    const std::uintmax_t full_size = std::filesystem::file_size(path);
+
+    // Cut in the middle of every field, the loader must never accept a partial registry
+    for (std::uintmax_t size = 0; size < full_size; size++) {
+        std::filesystem::resize_file(path, size);
+
+        ecom_interface_map loaded_interfaces;
+        std::vector<ecom_implementation_info_ptr> loaded_implementations;
+
+        const bool loaded = load_ecom_registry_cache(path, 0xDEADBEEF, loaded_interfaces, loaded_implementations);
+
+        REQUIRE_FALSE(loaded);
+        REQUIRE(loaded_interfaces.empty());
+        REQUIRE(loaded_implementations.empty());
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("registry_cache_missing", "ecom") {
+    ecom_interface_map interfaces;
+    std::vector<ecom_implementation_info_ptr> implementations;
+
+    REQUIRE_FALSE(load_ecom_registry_cache(get_registry_cache_path("missing.bin"), 0xDEADBEEF, interfaces, implementations));
+}
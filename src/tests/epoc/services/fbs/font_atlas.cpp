@@ -0,0 +1,302 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+
+#include <drivers/graphics/graphics.h>
+#include <services/fbs/adapter/font_adapter.h>
+#include <services/fbs/font_atlas.h>
+
+#include <common/log.h>
+
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <thread>
+
+using namespace eka2l1;
+
+TEST_CASE("atlas_packer_fills_shelves", "font_atlas") {
+    epoc::font_atlas_packer packer({ 64, 64 });
+
+    auto first = packer.allocate({ 30, 10 });
+    auto second = packer.allocate({ 30, 10 });
+    auto third = packer.allocate({ 30, 10 });
+
+    REQUIRE(first);
+    REQUIRE(second);
+    REQUIRE(third);
+
+    REQUIRE(first->top == eka2l1::vec2(0, 0));
+    REQUIRE(second->top == eka2l1::vec2(30, 0));
+
+    // Does not fit in the first shelf anymore
+    REQUIRE(third->top == eka2l1::vec2(0, 10));
+
+    // Too tall for the shelves made, and no space is left under them
+    REQUIRE(!packer.allocate({ 10, 50 }));
+}
+
+TEST_CASE("atlas_packer_reuse_freed_space", "font_atlas") {
+    epoc::font_atlas_packer packer({ 64, 64 });
+
+    auto first = packer.allocate({ 20, 16 });
+    auto second = packer.allocate({ 20, 16 });
+    auto third = packer.allocate({ 20, 16 });
+
+    packer.free(*first);
+    packer.free(*second);
+
+    // Both freed slots are merged, so a wider glyph can take their place
+    auto wide = packer.allocate({ 40, 14 });
+
+    REQUIRE(wide);
+    REQUIRE(wide->top == eka2l1::vec2(0, 0));
+
+    packer.free(*wide);
+    packer.free(*third);
+
+    // The shelf is empty and given back, the space can now be used by a taller shelf
+    auto tall = packer.allocate({ 64, 64 });
+
+    REQUIRE(tall);
+    REQUIRE(tall->top == eka2l1::vec2(0, 0));
+}
+
+namespace {
+    /**
+     * \brief Font adapter that produces filled boxes instead of real glyphs.
+     */
+    class box_font_adapter : public epoc::adapter::font_file_adapter_base {
+        std::uint8_t *atlas_ptr_ = nullptr;
+        eka2l1::vec2 atlas_size_;
+
+    public:
+        std::size_t rasterized_count_ = 0;
+        std::map<int, int> rasterized_codes_; ///< Times each code was rasterized.
+
+        bool is_valid() override {
+            return true;
+        }
+
+        bool vectorizable() const override {
+            return true;
+        }
+
+        bool get_face_attrib(const std::size_t idx, epoc::open_font_face_attrib &face_attrib) override {
+            return false;
+        }
+
+        bool get_metrics(const std::size_t idx, epoc::open_font_metrics &metrics) override {
+            return false;
+        }
+
+        bool get_glyph_metric(const std::size_t idx, std::uint32_t code, epoc::open_font_character_metric &metric,
+            const std::int32_t baseline_horz_off, const std::uint16_t font_size) override {
+            return false;
+        }
+
+        std::uint8_t *get_glyph_bitmap(const std::size_t idx, std::uint32_t code, const std::uint16_t font_size,
+            int *rasterized_width, int *rasterized_height, std::uint32_t &total_size, epoc::glyph_bitmap_type *bmp_type) override {
+            return nullptr;
+        }
+
+        void free_glyph_bitmap(std::uint8_t *data) override {
+        }
+
+        epoc::glyph_bitmap_type get_output_bitmap_type() const override {
+            return epoc::antialised_glyph_bitmap;
+        }
+
+        bool does_glyph_exist(std::size_t idx, std::uint32_t code) override {
+            return true;
+        }
+
+        std::int32_t begin_get_atlas(std::uint8_t *atlas_ptr, const eka2l1::vec2 atlas_size) override {
+            atlas_ptr_ = atlas_ptr;
+            atlas_size_ = atlas_size;
+
+            return 0;
+        }
+
+        bool get_glyph_atlas(const std::int32_t handle, const std::size_t idx, const char16_t start_code, int *unicode_point,
+            const char16_t num_code, const int font_size, epoc::adapter::character_info *info) override {
+            int x = 0;
+            int y = 0;
+
+            for (char16_t i = 0; i < num_code; i++) {
+                const int code = unicode_point ? unicode_point[i] : start_code + i;
+                const int width = font_size / 2 + (code % 5);
+                const int height = font_size;
+
+                if (x + width > atlas_size_.x) {
+                    x = 0;
+                    y += height;
+                }
+
+                if (y + height > atlas_size_.y) {
+                    return false;
+                }
+
+                for (int row = 0; row < height; row++) {
+                    std::memset(atlas_ptr_ + (y + row) * atlas_size_.x + x, 0xFF, width);
+                }
+
+                info[i].x0 = static_cast<std::uint16_t>(x);
+                info[i].y0 = static_cast<std::uint16_t>(y);
+                info[i].x1 = static_cast<std::uint16_t>(x + width);
+                info[i].y1 = static_cast<std::uint16_t>(y + height);
+                info[i].xoff = 0.0f;
+                info[i].yoff = 0.0f;
+                info[i].xoff2 = static_cast<float>(width);
+                info[i].yoff2 = static_cast<float>(height);
+                info[i].xadv = static_cast<float>(width + 1);
+
+                x += width;
+            }
+
+            for (char16_t i = 0; i < num_code; i++) {
+                rasterized_codes_[unicode_point ? unicode_point[i] : start_code + i]++;
+            }
+
+            rasterized_count_ += num_code;
+            return true;
+        }
+
+        void end_get_atlas(const std::int32_t handle) override {
+            atlas_ptr_ = nullptr;
+        }
+
+        std::size_t count() override {
+            return 1;
+        }
+
+        std::uint32_t unique_id(const std::size_t face_index) override {
+            return epoc::adapter::INVALID_FONT_TF_UID;
+        }
+    };
+}
+
+TEST_CASE("atlas_evicts_least_used_glyphs", "font_atlas") {
+    drivers::graphics_driver_ptr driver = drivers::create_graphics_driver(drivers::graphic_api::software);
+    std::thread driver_thread([&]() { driver->run(); });
+
+    box_font_adapter adapter;
+    epoc::font_atlas atlas(&adapter, 0, 0x20, 0, 16);
+
+    const eka2l1::rect box({ 0, 0 }, { 360, 640 });
+
+    auto draw = [&](const std::u16string &text) {
+        auto cmd_list = driver->new_command_list();
+        auto cmd_builder = driver->new_command_builder(cmd_list.get());
+
+        REQUIRE(atlas.draw_text(text, box, epoc::text_alignment::left, driver.get(), cmd_builder.get()));
+        driver->submit_command_list(*cmd_list);
+    };
+
+    draw(u"a");
+    REQUIRE(adapter.rasterized_codes_[u'a'] == 1);
+
+    // Far more distinct glyphs than the atlas can hold. 'b' is drawn every time, so it stays
+    // the most recently used and is never evicted.
+    for (int round = 0; round < 10; round++) {
+        std::u16string text = u"b";
+
+        for (char16_t code = 0x4E00 + round * 1000; code < 0x4E00 + (round + 1) * 1000; code++) {
+            text += code;
+        }
+
+        draw(text);
+    }
+
+    REQUIRE(adapter.rasterized_codes_[u'b'] == 1);
+
+    // Eviction never took a glyph still in use by the text being drawn, so each one was rasterized once
+    int rasterized_again = 0;
+
+    for (char16_t code = 0x4E00; code < 0x4E00 + 10 * 1000; code++) {
+        if (adapter.rasterized_codes_[code] != 1) {
+            rasterized_again++;
+        }
+    }
+
+    REQUIRE(rasterized_again == 0);
+
+    // 'a' was evicted to make room, so it has to be rasterized again
+    draw(u"a");
+    REQUIRE(adapter.rasterized_codes_[u'a'] == 2);
+
+    // And it stays cached on the next use
+    draw(u"ab");
+    REQUIRE(adapter.rasterized_codes_[u'a'] == 2);
+    REQUIRE(adapter.rasterized_codes_[u'b'] == 1);
+
+    atlas.free(driver.get());
+
+    driver->abort();
+    driver_thread.join();
+}
+
+TEST_CASE("atlas_draw_mixed_script_benchmark", "[.benchmark]") {
+    drivers::graphics_driver_ptr driver = drivers::create_graphics_driver(drivers::graphic_api::software);
+    std::thread driver_thread([&]() { driver->run(); });
+
+    // Latin, Cyrillic and a wide CJK block, so the atlas has to evict to keep up
+    std::u16string text;
+
+    for (int round = 0; round < 20; round++) {
+        text += u"The quick brown fox jumps over the lazy dog. ";
+        text += u"Съешь же ещё этих мягких французских булок. ";
+
+        for (char16_t code = 0x4E00 + round * 1000; code < 0x4E00 + (round + 1) * 1000; code++) {
+            text += code;
+        }
+    }
+
+    box_font_adapter adapter;
+    epoc::font_atlas atlas(&adapter, 0, 0x20, 0x5F, 16);
+
+    static constexpr int DRAW_ROUNDS = 200;
+    const auto start = std::chrono::steady_clock::now();
+
+    for (int round = 0; round < DRAW_ROUNDS; round++) {
+        auto cmd_list = driver->new_command_list();
+        auto cmd_builder = driver->new_command_builder(cmd_list.get());
+
+        // Draw slices of the text, like lines on a scrolling page
+        const std::size_t slice_start = (round * 97) % text.size();
+        const std::u16string line = text.substr(slice_start, 300);
+
+        REQUIRE(atlas.draw_text(line, eka2l1::rect({ 0, 0 }, { 360, 640 }), epoc::text_alignment::left, driver.get(),
+            cmd_builder.get()));
+
+        driver->submit_command_list(*cmd_list);
+    }
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+    LOG_INFO("Drawn {} mixed-script lines in {} us ({} glyphs rasterized)", DRAW_ROUNDS, elapsed.count(),
+        adapter.rasterized_count_);
+
+    atlas.free(driver.get());
+
+    driver->abort();
+    driver_thread.join();
+}
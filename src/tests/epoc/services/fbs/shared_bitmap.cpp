@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+
+#include <services/fbs/fbs.h>
+#include <utils/obj.h>
+#include <vfs/vfs.h>
+
+using namespace eka2l1;
+
+// Just enough of a file to be identified
+struct identity_test_file : public file {
+    std::u16string name_;
+    std::uint64_t size_;
+    std::uint64_t last_write_;
+    const std::uint8_t *mapped_;
+
+    explicit identity_test_file(const std::u16string &name, const std::uint64_t size, const std::uint64_t last_write,
+        const std::uint8_t *mapped = nullptr)
+        : name_(name)
+        , size_(size)
+        , last_write_(last_write)
+        , mapped_(mapped) {
+    }
+
+    size_t write_file(const void *data, uint32_t size, uint32_t count) override {
+        return 0;
+    }
+
+    size_t read_file(void *data, uint32_t size, uint32_t count) override {
+        return 0;
+    }
+
+    int file_mode() const override {
+        return READ_MODE | BIN_MODE;
+    }
+
+    std::u16string file_name() const override {
+        return name_;
+    }
+
+    uint64_t size() const override {
+        return size_;
+    }
+
+    uint64_t seek(std::int64_t seek_off, file_seek_mode where) override {
+        return 0;
+    }
+
+    uint64_t tell() override {
+        return 0;
+    }
+
+    bool close() override {
+        return true;
+    }
+
+    std::string get_error_descriptor() override {
+        return "";
+    }
+
+    bool is_in_rom() const override {
+        return mapped_ != nullptr;
+    }
+
+    address rom_address() const override {
+        return 0;
+    }
+
+    const std::uint8_t *get_mapped_data() const override {
+        return mapped_;
+    }
+
+    bool resize(const std::size_t new_size) override {
+        return false;
+    }
+
+    bool valid() override {
+        return true;
+    }
+
+    std::uint64_t last_modify_since_1ad() override {
+        return last_write_;
+    }
+};
+
+// Destroys an object once its last handle is closed, as the server's object container does
+struct deleting_test_container : public epoc::object_container {
+    bool remove(epoc::ref_count_object *obj) override {
+        delete obj;
+        return true;
+    }
+};
+
+static fbsbitmap *make_test_bitmap(epoc::bitwise_bitmap &bws_bmp, epoc::object_container *owner) {
+    bws_bmp.settings_.initial_display_mode(epoc::display_mode::color64k);
+    bws_bmp.settings_.current_display_mode(epoc::display_mode::color64k);
+
+    fbsbitmap *bmp = new fbsbitmap(nullptr, &bws_bmp, true, false);
+    bmp->owner = owner;
+
+    return bmp;
+}
+
+TEST_CASE("shared_bitmap_identity_of_files", "fbs") {
+    identity_test_file skin(u"C:\\Resource\\Skins\\Skin.mbm", 4096, 100);
+    identity_test_file same_skin_other_case(u"c:\\resource\\skins\\SKIN.MBM", 4096, 100);
+    identity_test_file resized_skin(u"C:\\Resource\\Skins\\Skin.mbm", 8192, 100);
+    identity_test_file rewritten_skin(u"C:\\Resource\\Skins\\Skin.mbm", 4096, 200);
+    identity_test_file other_skin(u"E:\\Resource\\Skins\\Skin.mbm", 4096, 100);
+
+    const fbsbitmap_cache_info info = make_bitmap_cache_info(&skin, 2);
+
+    REQUIRE(info == make_bitmap_cache_info(&same_skin_other_case, 2));
+    REQUIRE(std::hash<fbsbitmap_cache_info>()(info) == std::hash<fbsbitmap_cache_info>()(make_bitmap_cache_info(&same_skin_other_case, 2)));
+
+    REQUIRE_FALSE(info == make_bitmap_cache_info(&skin, 3));
+    REQUIRE_FALSE(info == make_bitmap_cache_info(&resized_skin, 2));
+    REQUIRE_FALSE(info == make_bitmap_cache_info(&rewritten_skin, 2));
+    REQUIRE_FALSE(info == make_bitmap_cache_info(&other_skin, 2));
+}
+
+TEST_CASE("shared_bitmap_identity_of_rom_files", "fbs") {
+    static const std::uint8_t rom[64] = {};
+
+    // ROM files only know their bare name, which files in different directories can share
+    identity_test_file avkon(u"avkon2.mbm", 32, 0, rom);
+    identity_test_file other_avkon(u"avkon2.mbm", 32, 0, rom + 32);
+    identity_test_file same_avkon(u"Z:\\Resource\\Apps\\avkon2.mbm", 32, 0, rom);
+
+    const fbsbitmap_cache_info info = make_bitmap_cache_info(&avkon, 0);
+
+    REQUIRE(info.rom_data == rom);
+    REQUIRE(info == make_bitmap_cache_info(&same_avkon, 0));
+    REQUIRE_FALSE(info == make_bitmap_cache_info(&other_avkon, 0));
+    REQUIRE_FALSE(info == make_bitmap_cache_info(&avkon, 1));
+}
+
+TEST_CASE("shared_bitmap_released_with_last_handle", "fbs") {
+    identity_test_file skin(u"C:\\Resource\\Skins\\Skin.mbm", 4096, 100);
+    const fbsbitmap_cache_info info = make_bitmap_cache_info(&skin, 0);
+
+    deleting_test_container container;
+    epoc::bitwise_bitmap bws_bmp;
+
+    fbsbitmap_share_map share_map;
+    epoc::object_table first_client;
+    epoc::object_table second_client;
+
+    fbsbitmap *bmp = make_test_bitmap(bws_bmp, &container);
+    const epoc::handle first_handle = first_client.add(bmp);
+    share_map.add(info, bmp);
+
+    // The second load of the same file only gets a new handle
+    REQUIRE(share_map.find(info) == bmp);
+    const epoc::handle second_handle = second_client.add(bmp);
+
+    REQUIRE(bmp->count == 2);
+
+    first_client.remove(first_handle);
+
+    REQUIRE(share_map.size() == 1);
+    REQUIRE(share_map.find(info) == bmp);
+
+    // Closing the last handle destroys the bitmap, and it must leave the map with it
+    second_client.remove(second_handle);
+
+    REQUIRE(share_map.size() == 0);
+    REQUIRE(share_map.find(info) == nullptr);
+}
+
+TEST_CASE("shared_bitmap_dropped_when_changed", "fbs") {
+    identity_test_file skin(u"C:\\Resource\\Skins\\Skin.mbm", 4096, 100);
+    const fbsbitmap_cache_info first_info = make_bitmap_cache_info(&skin, 0);
+    const fbsbitmap_cache_info second_info = make_bitmap_cache_info(&skin, 1);
+
+    deleting_test_container container;
+    epoc::bitwise_bitmap first_bws_bmp;
+    epoc::bitwise_bitmap second_bws_bmp;
+
+    fbsbitmap_share_map share_map;
+    epoc::object_table client;
+
+    fbsbitmap *resized = make_test_bitmap(first_bws_bmp, &container);
+    fbsbitmap *mode_changed = make_test_bitmap(second_bws_bmp, &container);
+
+    const epoc::handle resized_handle = client.add(resized);
+    const epoc::handle mode_changed_handle = client.add(mode_changed);
+
+    share_map.add(first_info, resized);
+    share_map.add(second_info, mode_changed);
+
+    // Resizing leaves the old content in a clean bitmap
+    fbsbitmap clean(nullptr, &first_bws_bmp, false, false);
+    resized->clean_bitmap = &clean;
+
+    second_bws_bmp.settings_.current_display_mode(epoc::display_mode::color16mu);
+
+    // Holders keep their bitmaps, new loads get a fresh copy
+    REQUIRE(share_map.find(first_info) == nullptr);
+    REQUIRE(share_map.find(second_info) == nullptr);
+    REQUIRE(share_map.size() == 0);
+
+    REQUIRE(resized->share_map_ == nullptr);
+    REQUIRE(mode_changed->share_map_ == nullptr);
+
+    client.remove(resized_handle);
+    client.remove(mode_changed_handle);
+}
+
+TEST_CASE("shared_bitmap_map_cleared_before_bitmaps", "fbs") {
+    identity_test_file skin(u"C:\\Resource\\Skins\\Skin.mbm", 4096, 100);
+
+    deleting_test_container container;
+    epoc::bitwise_bitmap bws_bmp;
+    epoc::object_table client;
+
+    fbsbitmap *bmp = make_test_bitmap(bws_bmp, &container);
+    const epoc::handle handle = client.add(bmp);
+
+    {
+        fbsbitmap_share_map share_map;
+        share_map.add(make_bitmap_cache_info(&skin, 0), bmp);
+    }
+
+    // The map is gone, the bitmap must not touch it when it dies
+    REQUIRE(bmp->share_map_ == nullptr);
+    client.remove(handle);
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <services/window/compositor.h>
+
+using namespace eka2l1;
+
+static const eka2l1::vec2 SCREEN_SIZE = { 100, 100 };
+
+static epoc::composed_window make_window(const std::uint64_t id, const eka2l1::rect &extent, const bool opaque = true) {
+    epoc::composed_window win;
+    win.driver_win_id = id;
+    win.extent = extent;
+    win.opaque = opaque;
+
+    return win;
+}
+
+static int get_drawn_area(const std::vector<epoc::composed_draw> &draws, const std::size_t window_index) {
+    int area = 0;
+
+    for (const epoc::composed_draw &draw : draws) {
+        if (draw.window_index == window_index) {
+            area += draw.part.size.x * draw.part.size.y;
+        }
+    }
+
+    return area;
+}
+
+TEST_CASE("compositor_skips_fully_covered_windows", "compositor") {
+    epoc::screen_compositor compositor;
+
+    const std::vector<epoc::composed_window> windows = {
+        make_window(1, eka2l1::rect({ 0, 0 }, { 100, 100 })),
+        make_window(2, eka2l1::rect({ 10, 10 }, { 50, 50 })),
+        make_window(3, eka2l1::rect({ 0, 0 }, { 100, 100 }))
+    };
+
+    const std::vector<epoc::composed_draw> draws = compositor.compose(windows, SCREEN_SIZE);
+
+    REQUIRE(get_drawn_area(draws, 0) == 0);
+    REQUIRE(get_drawn_area(draws, 1) == 0);
+    REQUIRE(get_drawn_area(draws, 2) == 100 * 100);
+}
+
+TEST_CASE("compositor_combines_and_clears_damage", "compositor") {
+    epoc::screen_compositor compositor;
+
+    const std::vector<epoc::composed_window> windows = {
+        make_window(1, eka2l1::rect({ 0, 0 }, { 100, 100 }))
+    };
+
+    // The first composition draws everything
+    REQUIRE(get_drawn_area(compositor.compose(windows, SCREEN_SIZE), 0) == 100 * 100);
+    REQUIRE(compositor.compose(windows, SCREEN_SIZE).empty());
+
+    // Two overlapping rectangles, and one going out of the screen
+    compositor.add_damage(eka2l1::rect({ 10, 10 }, { 20, 20 }), SCREEN_SIZE);
+    compositor.add_damage(eka2l1::rect({ 20, 20 }, { 20, 20 }), SCREEN_SIZE);
+    compositor.add_damage(eka2l1::rect({ 90, 90 }, { 50, 50 }), SCREEN_SIZE);
+
+    const std::vector<epoc::composed_draw> draws = compositor.compose(windows, SCREEN_SIZE);
+
+    REQUIRE(get_drawn_area(draws, 0) == 20 * 20 + 20 * 20 - 10 * 10 + 10 * 10);
+
+    for (const epoc::composed_draw &draw : draws) {
+        REQUIRE(draw.part.top.x >= 10);
+        REQUIRE(draw.part.top.y >= 10);
+        REQUIRE(draw.part.top.x + draw.part.size.x <= 100);
+        REQUIRE(draw.part.top.y + draw.part.size.y <= 100);
+    }
+
+    // Damage is consumed by the redraw
+    REQUIRE(compositor.damage.empty());
+    REQUIRE(compositor.compose(windows, SCREEN_SIZE).empty());
+}
+
+TEST_CASE("compositor_draws_partially_covered_windows", "compositor") {
+    epoc::screen_compositor compositor;
+
+    const std::vector<epoc::composed_window> windows = {
+        make_window(1, eka2l1::rect({ 0, 0 }, { 100, 100 })),
+        make_window(2, eka2l1::rect({ 0, 0 }, { 50, 100 }))
+    };
+
+    compositor.compose(windows, SCREEN_SIZE);
+    compositor.add_damage(eka2l1::rect({ 40, 0 }, { 20, 10 }), SCREEN_SIZE);
+
+    const std::vector<epoc::composed_draw> draws = compositor.compose(windows, SCREEN_SIZE);
+
+    REQUIRE(draws.size() == 2);
+
+    // Back to front: the uncovered half of the window behind, then the window in front
+    REQUIRE(draws[0].window_index == 0);
+    REQUIRE(draws[0].part.top == eka2l1::vec2(50, 0));
+    REQUIRE(draws[0].part.size == eka2l1::vec2(10, 10));
+
+    REQUIRE(draws[1].window_index == 1);
+    REQUIRE(draws[1].part.top == eka2l1::vec2(40, 0));
+    REQUIRE(draws[1].part.size == eka2l1::vec2(10, 10));
+}
+
+TEST_CASE("compositor_draws_behind_transparent_windows", "compositor") {
+    epoc::screen_compositor compositor;
+
+    const std::vector<epoc::composed_window> windows = {
+        make_window(1, eka2l1::rect({ 0, 0 }, { 100, 100 })),
+        make_window(2, eka2l1::rect({ 0, 0 }, { 100, 100 }), false)
+    };
+
+    const std::vector<epoc::composed_draw> draws = compositor.compose(windows, SCREEN_SIZE);
+
+    REQUIRE(get_drawn_area(draws, 0) == 100 * 100);
+    REQUIRE(get_drawn_area(draws, 1) == 100 * 100);
+}
+
+TEST_CASE("compositor_window_move_damages_screen", "compositor") {
+    epoc::screen_compositor compositor;
+
+    std::vector<epoc::composed_window> windows = {
+        make_window(1, eka2l1::rect({ 0, 0 }, { 100, 100 })),
+        make_window(2, eka2l1::rect({ 0, 0 }, { 20, 20 }))
+    };
+
+    compositor.compose(windows, SCREEN_SIZE);
+    windows[1].extent.top = { 50, 50 };
+
+    const std::vector<epoc::composed_draw> draws = compositor.compose(windows, SCREEN_SIZE);
+
+    REQUIRE(get_drawn_area(draws, 0) == 100 * 100 - 20 * 20);
+    REQUIRE(get_drawn_area(draws, 1) == 20 * 20);
+}
@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <services/window/fifo.h>
+
+#include <thread>
+
+using namespace eka2l1;
+
+static epoc::event make_drag_event(const std::uint32_t handle, const int x, const int y) {
+    epoc::event evt(handle, epoc::event_code::touch);
+    evt.adv_pointer_evt_.evtype = epoc::event_type::drag;
+    evt.adv_pointer_evt_.pos = eka2l1::vec2(x, y);
+    evt.adv_pointer_evt_.ptr_num = 0;
+
+    return evt;
+}
+
+TEST_CASE("event_fifo_coalesce_pointer_moves", "window_fifo") {
+    epoc::event_fifo fifo;
+
+    for (int i = 0; i < 100; i++) {
+        fifo.queue_input_event(make_drag_event(1, i, i));
+    }
+
+    fifo.queue_event(epoc::event(1, epoc::event_code::focus_gained));
+    fifo.queue_input_event(make_drag_event(1, 200, 200));
+
+    epoc::event evt = fifo.get_event();
+    REQUIRE(evt.type == epoc::event_code::touch);
+    REQUIRE(evt.adv_pointer_evt_.pos == eka2l1::vec2(99, 99));
+
+    // A move after another event is not merged into the earlier ones
+    REQUIRE(fifo.get_event().type == epoc::event_code::focus_gained);
+
+    evt = fifo.get_event();
+    REQUIRE(evt.type == epoc::event_code::touch);
+    REQUIRE(evt.adv_pointer_evt_.pos == eka2l1::vec2(200, 200));
+
+    REQUIRE(fifo.get_event().type == epoc::event_code::null);
+}
+
+TEST_CASE("event_fifo_purge_when_full", "window_fifo") {
+    epoc::event_fifo fifo;
+
+    for (int i = 0; i < epoc::event_fifo::maximum_element; i++) {
+        fifo.queue_event(epoc::event(1, epoc::event_code::key));
+    }
+
+    // Key events can be purged to make room
+    REQUIRE(fifo.queue_event(epoc::event(1, epoc::event_code::focus_lost)) != 0);
+    REQUIRE(fifo.get_event().type == epoc::event_code::focus_lost);
+    REQUIRE(fifo.get_event().type == epoc::event_code::null);
+}
+
+static bool purge_handle_two(void *userdata, epoc::event &evt) {
+    return evt.handle != 2;
+}
+
+TEST_CASE("event_fifo_walk_remove", "window_fifo") {
+    epoc::event_fifo fifo;
+
+    fifo.queue_event(epoc::event(1, epoc::event_code::key));
+    fifo.queue_event(epoc::event(2, epoc::event_code::key));
+    fifo.queue_event(epoc::event(3, epoc::event_code::key));
+    fifo.queue_input_event(epoc::event(2, epoc::event_code::key));
+
+    fifo.walk(purge_handle_two, nullptr);
+
+    REQUIRE(fifo.get_event().handle == 1);
+    REQUIRE(fifo.get_event().handle == 3);
+    REQUIRE(fifo.get_event().type == epoc::event_code::null);
+}
+
+TEST_CASE("event_fifo_input_from_many_threads", "window_fifo") {
+    static constexpr int EVENTS_PER_THREAD = 15;
+
+    for (int round = 0; round < 100; round++) {
+        epoc::event_fifo fifo;
+
+        const auto producer = [&fifo](const std::uint32_t handle) {
+            for (int i = 0; i < EVENTS_PER_THREAD; i++) {
+                epoc::event evt(handle, epoc::event_code::key);
+                evt.time = i;
+
+                fifo.queue_input_event(evt);
+            }
+        };
+
+        std::thread first(producer, 1);
+        std::thread second(producer, 2);
+
+        first.join();
+        second.join();
+
+        // Nothing is lost, and each thread's events stay in order
+        std::uint64_t next_time[2] = { 0, 0 };
+
+        for (int i = 0; i < EVENTS_PER_THREAD * 2; i++) {
+            const epoc::event evt = fifo.get_event();
+
+            REQUIRE(evt.type == epoc::event_code::key);
+            REQUIRE(evt.time == next_time[evt.handle - 1]++);
+        }
+
+        REQUIRE(fifo.get_event().type == epoc::event_code::null);
+    }
+}
+
+static epoc::redraw_event make_redraw_event(const std::uint32_t handle, const eka2l1::vec2 &top_left, const eka2l1::vec2 &bottom_right) {
+    return epoc::redraw_event{ handle, top_left, bottom_right };
+}
+
+TEST_CASE("redraw_fifo_priority_lanes", "window_fifo") {
+    epoc::redraw_fifo fifo;
+
+    fifo.queue_event(make_redraw_event(1, { 0, 0 }, { 10, 10 }), 3);
+    fifo.queue_event(make_redraw_event(2, { 0, 0 }, { 10, 10 }), 1);
+    fifo.queue_event(make_redraw_event(3, { 0, 0 }, { 10, 10 }), 3);
+
+    // This covers the first redraw of window 1, which is dropped
+    fifo.queue_event(make_redraw_event(1, { 0, 0 }, { 20, 20 }), 3);
+
+    REQUIRE(fifo.get_evt_opt()->handle == 2);
+    REQUIRE(fifo.get_evt_opt()->handle == 3);
+
+    std::optional<epoc::redraw_event> evt = fifo.get_evt_opt();
+    REQUIRE(evt->handle == 1);
+    REQUIRE(evt->bottom_right == eka2l1::vec2(20, 20));
+
+    REQUIRE(!fifo.get_evt_opt());
+}
+
+TEST_CASE("redraw_fifo_packed_priority_order", "window_fifo") {
+    epoc::redraw_fifo fifo;
+
+    // Top-level ordinal in the highest 4 bits, the child ordinal in the next 4
+    const auto packed = [](const std::uint32_t top, const std::uint32_t child) {
+        return (top << 28) | (child << 24);
+    };
+
+    fifo.queue_event(make_redraw_event(1, { 0, 0 }, { 10, 10 }), packed(1, 0));
+    fifo.queue_event(make_redraw_event(2, { 0, 0 }, { 10, 10 }), packed(0, 2));
+    fifo.queue_event(make_redraw_event(3, { 0, 0 }, { 10, 10 }), packed(0, 1));
+    fifo.queue_event(make_redraw_event(4, { 0, 0 }, { 10, 10 }), packed(0, 1));
+    fifo.queue_event(make_redraw_event(5, { 0, 0 }, { 10, 10 }), packed(15, 0));
+
+    REQUIRE(fifo.get_evt_opt()->handle == 3);
+    REQUIRE(fifo.get_evt_opt()->handle == 4);
+    REQUIRE(fifo.get_evt_opt()->handle == 2);
+    REQUIRE(fifo.get_evt_opt()->handle == 1);
+    REQUIRE(fifo.get_evt_opt()->handle == 5);
+    REQUIRE(!fifo.get_evt_opt());
+}
+
+TEST_CASE("redraw_fifo_cancel", "window_fifo") {
+    epoc::redraw_fifo fifo;
+
+    const std::uint32_t first_id = fifo.queue_event(make_redraw_event(1, { 0, 0 }, { 10, 10 }), 0);
+    fifo.queue_event(make_redraw_event(2, { 0, 0 }, { 10, 10 }), 0);
+
+    fifo.cancel_event_queue(first_id);
+
+    REQUIRE(fifo.get_evt_opt()->handle == 2);
+    REQUIRE(!fifo.get_evt_opt());
+}
@@ -2,6 +2,7 @@
 #include <common/algorithm.h>
 #include <common/path.h>
 #include <common/types.h>
+#include <loader/rom.h>
 #include <vfs/vfs.h>
 
 struct io_scope_guard {
@@ -40,3 +41,35 @@ TEST_CASE("get_physical", "vfs") {
 
     REQUIRE(eka2l1::common::compare_ignore_case(*actual_path_b, std::u16string(u"drive_b") + static_cast<char16_t>(eka2l1::get_separator()) + u"despacito3leak") == 0);
 }
+
+TEST_CASE("rom_fs_index_lookup", "vfs") {
+    eka2l1::loader::rom rom_cache{};
+    rom_cache.root.root_dirs.emplace_back();
+
+    eka2l1::loader::rom_entry euser_entry{};
+    euser_entry.name = u"EUser.dll";
+    euser_entry.address_lin = 0x80001000;
+
+    eka2l1::loader::rom_dir bin_dir{};
+    bin_dir.name = u"Bin";
+    bin_dir.entries.push_back(euser_entry);
+
+    eka2l1::loader::rom_dir sys_dir{};
+    sys_dir.name = u"Sys";
+    sys_dir.subdirs.push_back(bin_dir);
+
+    rom_cache.root.root_dirs[0].dir.subdirs.push_back(sys_dir);
+
+    auto rom_fs = eka2l1::create_rom_filesystem(&rom_cache, nullptr, epocver::epoc94, "");
+
+    // Lookups are case-insensitive and accept both separators
+    const auto found = rom_fs->find_entry_with_address(u"Z:\\SYS\\bin\\", 0x80001000);
+    REQUIRE(found);
+    REQUIRE(*found == u"EUser.dll");
+
+    const auto found_slash = rom_fs->find_entry_with_address(u"z:/sys/Bin", 0x80001000);
+    REQUIRE(found_slash);
+
+    REQUIRE_FALSE(rom_fs->find_entry_with_address(u"Z:\\sys\\bin\\", 0x80002000));
+    REQUIRE_FALSE(rom_fs->find_entry_with_address(u"Z:\\sys\\binary\\", 0x80001000));
+}
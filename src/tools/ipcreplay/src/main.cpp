@@ -0,0 +1,511 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <common/algorithm.h>
+#include <common/allocator.h>
+#include <common/arghandler.h>
+#include <common/log.h>
+#include <common/path.h>
+
+#include <config/config.h>
+#include <drivers/graphics/graphics.h>
+#include <epoc/epoc.h>
+
+#include <kernel/chunk.h>
+#include <kernel/ipctrace.h>
+#include <kernel/kernel.h>
+#include <kernel/process.h>
+#include <kernel/server.h>
+#include <kernel/session.h>
+#include <kernel/thread.h>
+
+#include <manager/device_manager.h>
+#include <manager/manager.h>
+
+#include <utils/des.h>
+#include <utils/reqsts.h>
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <new>
+#include <thread>
+
+using namespace eka2l1;
+
+static constexpr std::size_t REPLAY_DATA_CHUNK_SIZE = 0x2000000;
+static constexpr int REQUEST_PENDING = 0x80000001;
+static constexpr std::size_t MAX_MISMATCH_REPORTS = 20;
+
+struct replay_options {
+    std::string trace_path_;
+    std::string server_filter_;
+};
+
+/**
+ * \brief Guest memory of a replayed message, alive until the server completes it.
+ */
+struct replay_request {
+    std::uint8_t *memory_ = nullptr;
+    epoc::request_status *status_ = nullptr;
+
+    // The recorded completion came before the replayed one
+    bool recorded_seen_ = false;
+    std::int32_t recorded_code_ = 0;
+};
+
+struct replay_stats {
+    std::uint64_t messages_ = 0;
+    std::uint64_t total_ns_ = 0;
+    std::uint64_t max_ns_ = 0;
+};
+
+struct replay_verify_stats {
+    std::uint64_t matched_ = 0;
+    std::uint64_t mismatched_ = 0;
+    std::uint64_t late_ = 0;
+};
+
+/**
+ * \brief A process of our own to send messages from.
+ *
+ * The thread is never scheduled. It only owns the messages, and its process owns the memory
+ * that descriptors and request statuses live in.
+ */
+struct replay_host {
+    kernel_system *kern_;
+    kernel::process *process_;
+    kernel::thread *thread_;
+    kernel::chunk *data_;
+
+    std::unique_ptr<common::block_allocator> allocator_;
+    address data_base_;
+
+    std::map<std::uint32_t, service::session *> sessions_;
+
+    explicit replay_host(eka2l1::system *sys)
+        : kern_(sys->get_kernel_system())
+        , process_(nullptr)
+        , thread_(nullptr)
+        , data_(nullptr)
+        , data_base_(0) {
+        memory_system *mem = sys->get_memory_system();
+
+        process_ = kern_->create<kernel::process>(mem, "IpcReplay", u"Nowhere", u"");
+        thread_ = kern_->create<kernel::thread>(mem, sys->get_ntimer(), process_, kernel::access_type::local_access,
+            "IpcReplay", 0, 0x2000, 0, 0x1000, false);
+        data_ = kern_->create<kernel::chunk>(mem, process_, "IpcReplayData", 0, REPLAY_DATA_CHUNK_SIZE,
+            REPLAY_DATA_CHUNK_SIZE, prot::read_write, kernel::chunk_type::normal, kernel::chunk_access::local,
+            kernel::chunk_attrib::none);
+
+        if (data_) {
+            allocator_ = std::make_unique<common::block_allocator>(reinterpret_cast<std::uint8_t *>(data_->host_base()),
+                REPLAY_DATA_CHUNK_SIZE);
+            data_base_ = data_->base(process_).ptr_address();
+        }
+    }
+
+    bool is_valid() const {
+        return process_ && thread_ && data_;
+    }
+
+    address to_guest(const std::uint8_t *host) const {
+        return data_base_ + static_cast<address>(host - reinterpret_cast<std::uint8_t *>(data_->host_base()));
+    }
+
+    service::session *get_session(service::server *svr, const std::uint32_t recorded_id) {
+        auto ite = sessions_.find(recorded_id);
+
+        if (ite != sessions_.end()) {
+            return ite->second;
+        }
+
+        service::session *ss = kern_->create<service::session>(svr, 0);
+        sessions_.emplace(recorded_id, ss);
+
+        return ss;
+    }
+};
+
+static std::size_t descriptor_guest_size(const kernel::ipc_trace_descriptor &des, const ipc_arg_type type) {
+    const std::size_t char_size = ((static_cast<int>(type) & static_cast<int>(ipc_arg_type::flag_16b)) ? 2 : 1);
+    const std::size_t header_size = ((static_cast<int>(type) & static_cast<int>(ipc_arg_type::flag_const)) ? 4 : 8);
+
+    return header_size + common::align(std::max<std::size_t>(des.max_length_ * char_size, des.data_.size()), 4);
+}
+
+/**
+ * \brief Write a descriptor the server can read back through the usual descriptor helpers.
+ *
+ * Constant arguments are laid out as buf_const, modifiable ones as buf, so a server writing back
+ * up to the recorded max length stays in bounds.
+ */
+static void lay_descriptor(std::uint8_t *dest, const kernel::ipc_trace_descriptor &des, const ipc_arg_type type) {
+    const bool is_16b = (static_cast<int>(type) & static_cast<int>(ipc_arg_type::flag_16b));
+    const bool is_const = (static_cast<int>(type) & static_cast<int>(ipc_arg_type::flag_const));
+
+    const std::uint32_t length = static_cast<std::uint32_t>(des.data_.size() / (is_16b ? 2 : 1));
+    const std::uint32_t des_type = is_const ? epoc::buf_const : epoc::buf;
+    const std::uint32_t info = (length & 0xFFFFFF) | (des_type << 28);
+
+    std::memcpy(dest, &info, 4);
+    dest += 4;
+
+    if (!is_const) {
+        const std::uint32_t max_length = std::max(des.max_length_, length);
+
+        std::memcpy(dest, &max_length, 4);
+        dest += 4;
+    }
+
+    if (!des.data_.empty()) {
+        std::memcpy(dest, des.data_.data(), des.data_.size());
+    }
+}
+
+static bool trace_option_handler(common::arg_parser *parser, void *userdata, std::string *err) {
+    const char *token = parser->next_token();
+
+    if (!token) {
+        *err = "No trace file given to --trace";
+        return false;
+    }
+
+    reinterpret_cast<replay_options *>(userdata)->trace_path_ = token;
+    return true;
+}
+
+static bool server_option_handler(common::arg_parser *parser, void *userdata, std::string *err) {
+    const char *token = parser->next_token();
+
+    if (!token) {
+        *err = "No server name given to --server";
+        return false;
+    }
+
+    reinterpret_cast<replay_options *>(userdata)->server_filter_ = token;
+    return true;
+}
+
+static bool help_option_handler(common::arg_parser *parser, void *userdata, std::string *err) {
+    std::cout << parser->get_help_string();
+    return false;
+}
+
+static bool boot_system(eka2l1::system &sys, config::state &conf) {
+    manager::device_manager *dvcmngr = sys.get_manager_system()->get_device_manager();
+
+    if (dvcmngr->total() == 0) {
+        std::cout << "No device installed, install one with the emulator first" << std::endl;
+        return false;
+    }
+
+    sys.startup();
+
+    if (!sys.set_device(conf.device)) {
+        sys.set_device(0);
+    }
+
+    sys.mount(drive_c, drive_media::physical, eka2l1::add_path(conf.storage, "/drives/c/"), io_attrib_internal);
+    sys.mount(drive_d, drive_media::physical, eka2l1::add_path(conf.storage, "/drives/d/"), io_attrib_internal);
+    sys.mount(drive_e, drive_media::physical, eka2l1::add_path(conf.storage, "/drives/e/"), io_attrib_removeable);
+
+    manager::device *dvc = dvcmngr->get_current();
+
+    if (!sys.load_rom(add_path(conf.storage, add_path("roms", add_path(common::lowercase_string(dvc->firmware_code), "SYM.ROM"))))) {
+        std::cout << "Unable to load the ROM of device " << dvc->model << std::endl;
+        return false;
+    }
+
+    sys.mount(drive_z, drive_media::rom, eka2l1::add_path(conf.storage, "/drives/z/"), io_attrib_internal | io_attrib_write_protected);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    log::setup_log(nullptr);
+
+    replay_options options;
+    common::arg_parser parser(argc, argv);
+
+    parser.add("--help, --h", "Display helps menu", help_option_handler);
+    parser.add("--trace", "IPC trace file recorded by the emulator with --record-ipc.", trace_option_handler);
+    parser.add("--server", "Only replay messages sent to the server with the given name.", server_option_handler);
+
+    if (argc > 1) {
+        std::string err;
+
+        if (!parser.parse(&options, &err)) {
+            if (!err.empty()) {
+                std::cout << err << std::endl;
+                return 1;
+            }
+
+            return 0;
+        }
+    }
+
+    if (options.trace_path_.empty()) {
+        std::cout << parser.get_help_string();
+        return 1;
+    }
+
+    kernel::ipc_trace_reader reader(options.trace_path_);
+
+    if (!reader.is_valid()) {
+        std::cout << "Invalid or unsupported IPC trace: " << options.trace_path_ << std::endl;
+        return 1;
+    }
+
+    config::state conf;
+    conf.deserialize();
+
+    auto sys = std::make_unique<eka2l1::system>(nullptr, nullptr, &conf);
+
+    if (!boot_system(*sys, conf)) {
+        return 1;
+    }
+
+    // Servers such as the window server expect a graphics driver. Nothing is ever displayed.
+    drivers::graphics_driver_ptr driver = drivers::create_graphics_driver(drivers::graphic_api::software);
+    sys->set_graphics_driver(driver.get());
+
+    std::thread driver_thread([&driver]() {
+        driver->run();
+    });
+
+    kernel_system *kern = sys->get_kernel_system();
+    replay_host host(sys.get());
+
+    if (!host.is_valid()) {
+        std::cout << "Unable to create the replay process" << std::endl;
+
+        driver->abort();
+        driver_thread.join();
+
+        return 1;
+    }
+
+    std::map<std::string, std::map<std::int32_t, replay_stats>> stats;
+    std::map<std::uint32_t, replay_request> pending;
+    std::map<std::uint32_t, std::int32_t> completed;
+
+    replay_verify_stats verify;
+    std::uint64_t skipped = 0;
+
+    auto verify_completion = [&](const std::uint32_t seq, const std::int32_t replayed_code, const std::int32_t recorded_code) {
+        if (replayed_code == recorded_code) {
+            verify.matched_++;
+            return;
+        }
+
+        if (verify.mismatched_ < MAX_MISMATCH_REPORTS) {
+            LOG_WARN("Message {} completed with {} in replay, {} when recorded", seq, replayed_code, recorded_code);
+        }
+
+        verify.mismatched_++;
+    };
+
+    // Some servers complete through a timer or another message, so pending requests are checked after
+    // every send, not only when their recorded completion comes up
+    auto collect_completed = [&]() {
+        for (auto ite = pending.begin(); ite != pending.end();) {
+            const std::int32_t replayed_code = ite->second.status_->status;
+
+            if (replayed_code == REQUEST_PENDING) {
+                ite++;
+                continue;
+            }
+
+            if (ite->second.recorded_seen_) {
+                verify.late_++;
+                verify_completion(ite->first, replayed_code, ite->second.recorded_code_);
+            } else {
+                completed.emplace(ite->first, replayed_code);
+            }
+
+            host.allocator_->free(ite->second.memory_);
+            ite = pending.erase(ite);
+        }
+    };
+
+    kernel::ipc_trace_record record;
+
+    while (reader.next(record)) {
+        if (record.type_ == kernel::ipc_trace_record_complete) {
+            const std::uint32_t seq = record.complete_.sequence_;
+
+            collect_completed();
+
+            auto done_ite = completed.find(seq);
+            auto pending_ite = pending.find(seq);
+
+            if (done_ite != completed.end()) {
+                verify_completion(seq, done_ite->second, record.complete_.code_);
+                completed.erase(done_ite);
+            } else if (pending_ite != pending.end()) {
+                // Compared once the replay completes it
+                pending_ite->second.recorded_seen_ = true;
+                pending_ite->second.recorded_code_ = record.complete_.code_;
+            }
+
+            // Otherwise filtered or skipped
+            continue;
+        }
+
+        kernel::ipc_trace_send &send = record.send_;
+        const std::string server_name = reader.server_name(send.server_index_);
+
+        if (!options.server_filter_.empty() && (server_name != options.server_filter_)) {
+            continue;
+        }
+
+        service::server *svr = kern->get_by_name<service::server>(server_name);
+
+        if (!svr || !svr->is_hle()) {
+            skipped++;
+            continue;
+        }
+
+        // Everything in a message goes into one block: the request status first, then descriptors
+        std::size_t total_size = sizeof(epoc::request_status);
+        const bool has_descriptors = (send.args_.flag != -1);
+
+        for (int i = 0; i < 4; i++) {
+            const ipc_arg_type type = send.args_.get_arg_type(i);
+
+            if (has_descriptors && (static_cast<int>(type) & static_cast<int>(ipc_arg_type::flag_des))) {
+                total_size += descriptor_guest_size(send.descriptors_[i], type);
+            }
+        }
+
+        std::uint8_t *memory = reinterpret_cast<std::uint8_t *>(host.allocator_->allocate(total_size));
+
+        if (!memory) {
+            LOG_ERROR("Out of replay memory, skipping message {} to {}", send.sequence_, server_name);
+            skipped++;
+
+            continue;
+        }
+
+        epoc::request_status *status = new (memory) epoc::request_status(REQUEST_PENDING, kern->is_eka1());
+        std::uint8_t *des_ptr = memory + sizeof(epoc::request_status);
+
+        ipc_arg args = send.args_;
+
+        for (int i = 0; i < 4; i++) {
+            const ipc_arg_type type = send.args_.get_arg_type(i);
+
+            if (!has_descriptors || !(static_cast<int>(type) & static_cast<int>(ipc_arg_type::flag_des))) {
+                continue;
+            }
+
+            // Descriptors not captured are replayed empty, the recorded address means nothing here
+            lay_descriptor(des_ptr, send.descriptors_[i], type);
+
+            args.args[i] = static_cast<int>(host.to_guest(des_ptr));
+            des_ptr += descriptor_guest_size(send.descriptors_[i], type);
+        }
+
+        const eka2l1::ptr<epoc::request_status> status_ptr = send.has_status_ ? host.to_guest(memory) : 0;
+        service::session *ss = host.get_session(svr, send.session_id_);
+
+        const auto start = std::chrono::steady_clock::now();
+
+        kern->lock();
+
+        ss->send_receive(send.function_, args, status_ptr, host.thread_);
+        svr->process_accepted_msg();
+
+        kern->unlock();
+
+        const std::uint64_t elapsed = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count());
+
+        replay_stats &stat = stats[server_name][send.function_];
+        stat.messages_++;
+        stat.total_ns_ += elapsed;
+        stat.max_ns_ = std::max(stat.max_ns_, elapsed);
+
+        // The message may have completed earlier ones
+        collect_completed();
+
+        if (!send.has_status_ || (status->status != REQUEST_PENDING)) {
+            if (send.has_status_) {
+                completed.emplace(send.sequence_, status->status);
+            }
+
+            host.allocator_->free(memory);
+            continue;
+        }
+
+        replay_request &request = pending[send.sequence_];
+        request.memory_ = memory;
+        request.status_ = status;
+    }
+
+    collect_completed();
+
+    std::uint64_t never_completed = 0;
+
+    for (auto &[seq, request] : pending) {
+        if (request.recorded_seen_) {
+            never_completed++;
+        }
+
+        host.allocator_->free(request.memory_);
+    }
+
+    std::cout << fmt::format("{:<40} {:>10} {:>10} {:>14} {:>12} {:>12}", "Server", "Function", "Messages", "Total (ms)",
+                     "Avg (us)", "Max (us)")
+              << std::endl;
+
+    for (const auto &[name, functions] : stats) {
+        for (const auto &[function, stat] : functions) {
+            std::cout << fmt::format("{:<40} {:>10} {:>10} {:>14.3f} {:>12.2f} {:>12.2f}", name, function, stat.messages_,
+                             stat.total_ns_ / 1000000.0, stat.total_ns_ / 1000.0 / stat.messages_, stat.max_ns_ / 1000.0)
+                      << std::endl;
+        }
+    }
+
+    std::cout << fmt::format("\nCompletion codes: {} matched, {} mismatched, {} of them completed after the recorded completion",
+                     verify.matched_, verify.mismatched_, verify.late_)
+              << std::endl;
+
+    if (skipped) {
+        std::cout << fmt::format("{} messages skipped, their servers are not HLE, not found, or replay memory ran out", skipped) << std::endl;
+    }
+
+    if (!pending.empty()) {
+        std::cout << fmt::format("{} messages were never completed in replay, {} of them completed when recorded",
+                         pending.size(), never_completed)
+                  << std::endl;
+    }
+
+    // Stop the system first, it still submits to the driver while servers are destroyed
+    sys.reset();
+
+    driver->abort();
+    driver_thread.join();
+
+    return 0;
+}